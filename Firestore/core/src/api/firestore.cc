@@ -43,6 +43,8 @@
 #include "Firestore/core/src/util/hard_assert.h"
 #include "Firestore/core/src/util/json_reader.h"
 #include "Firestore/core/src/util/log.h"
+#include "Firestore/core/src/util/metrics.h"
+#include "Firestore/core/src/util/tracing.h"
 #include "Firestore/core/src/util/status.h"
 #include "Firestore/third_party/nlohmann_json/json.hpp"
 #include "absl/memory/memory.h"
@@ -227,6 +229,22 @@ void Firestore::SetClientLanguage(std::string language_token) {
   GrpcConnection::SetClientLanguage(std::move(language_token));
 }
 
+util::MetricsSnapshot Firestore::GetMetrics() {
+  return util::MetricsRegistry::GetInstance().Snapshot();
+}
+
+void Firestore::EnableTracing(size_t capacity) {
+  util::Tracer::GetInstance().Enable(capacity);
+}
+
+void Firestore::DisableTracing() {
+  util::Tracer::GetInstance().Disable();
+}
+
+std::string Firestore::ExportTrace() {
+  return util::Tracer::GetInstance().ExportChromeTrace();
+}
+
 std::unique_ptr<ListenerRegistration> Firestore::AddSnapshotsInSyncListener(
     std::unique_ptr<core::EventListener<Empty>> listener) {
   EnsureClientConfigured();
@@ -42,6 +42,7 @@ class AsyncQueue;
 class Executor;
 
 struct Empty;
+struct MetricsSnapshot;
 }  // namespace util
 
 namespace api {
@@ -125,6 +126,28 @@ class Firestore : public std::enable_shared_from_this<Firestore> {
    */
   static void SetClientLanguage(std::string language_token);
 
+  /**
+   * Returns the current values of the SDK's internal performance metrics,
+   * which are shared by all `Firestore` instances in the process.
+   */
+  static util::MetricsSnapshot GetMetrics();
+
+  /**
+   * Starts recording the operations run on the worker queue and the SDK's
+   * other executors, along with the persistence transactions they run, into
+   * a ring buffer of `capacity` spans. Discards any previously recorded spans.
+   */
+  static void EnableTracing(size_t capacity);
+
+  /** Stops recording operations; the recorded spans are kept. */
+  static void DisableTracing();
+
+  /**
+   * Returns the recorded spans as JSON in the Chrome trace event format, which
+   * can be loaded into chrome://tracing or Perfetto.
+   */
+  static std::string ExportTrace();
+
  private:
   void EnsureClientConfigured();
   core::DatabaseInfo MakeDatabaseInfo() const;
@@ -31,12 +31,14 @@ constexpr bool Settings::DefaultSslEnabled;
 constexpr bool Settings::DefaultPersistenceEnabled;
 constexpr int64_t Settings::DefaultCacheSizeBytes;
 constexpr int64_t Settings::MinimumCacheSizeBytes;
+constexpr bool Settings::DefaultCompactDocumentsEnabled;
 
 Settings::Settings(const Settings& other)
     : host_(other.host_),
       ssl_enabled_(other.ssl_enabled_),
       persistence_enabled_(other.persistence_enabled_),
-      cache_size_bytes_(other.cache_size_bytes_) {
+      cache_size_bytes_(other.cache_size_bytes_),
+      compact_documents_enabled_(other.compact_documents_enabled_) {
   if (other.cache_settings_ != nullptr) {
     cache_settings_ = CopyCacheSettings(*other.cache_settings_);
   }
@@ -51,6 +53,7 @@ Settings& Settings::operator=(const Settings& other) {
   ssl_enabled_ = other.ssl_enabled_;
   persistence_enabled_ = other.persistence_enabled_;
   cache_size_bytes_ = other.cache_size_bytes_;
+  compact_documents_enabled_ = other.compact_documents_enabled_;
   if (other.cache_settings_ != nullptr) {
     cache_settings_ = CopyCacheSettings(*other.cache_settings_);
   }
@@ -115,13 +118,15 @@ MemoryCacheSettings MemoryCacheSettings::WithMemoryGarbageCollectorSettings(
 
 size_t Settings::Hash() const {
   return util::Hash(host_, ssl_enabled_, persistence_enabled_,
-                    cache_size_bytes_, cache_settings_);
+                    cache_size_bytes_, compact_documents_enabled_,
+                    cache_settings_);
 }
 
 bool operator==(const Settings& lhs, const Settings& rhs) {
   bool eq = lhs.host_ == rhs.host_ && lhs.ssl_enabled_ == rhs.ssl_enabled_ &&
             lhs.persistence_enabled_ == rhs.persistence_enabled_ &&
-            lhs.cache_size_bytes_ == rhs.cache_size_bytes_;
+            lhs.cache_size_bytes_ == rhs.cache_size_bytes_ &&
+            lhs.compact_documents_enabled_ == rhs.compact_documents_enabled_;
   if (!eq) {
     return eq;
   }
@@ -46,6 +46,7 @@ class Settings {
   static constexpr int64_t DefaultCacheSizeBytes = 100 * 1024 * 1024;
   static constexpr int64_t MinimumCacheSizeBytes = 1 * 1024 * 1024;
   static constexpr int64_t CacheSizeUnlimited = -1;
+  static constexpr bool DefaultCompactDocumentsEnabled = false;
 
   Settings() = default;
   Settings(const Settings& other);
@@ -78,6 +79,23 @@ class Settings {
   const LocalCacheSettings* local_cache_settings() const;
   void set_local_cache_settings(const LocalCacheSettings& settings);
 
+  /**
+   * Sets whether the persistent cache stores documents in the compact format,
+   * which refers to field names by IDs scoped to each collection instead of
+   * repeating them in every document.
+   *
+   * SDK versions that predate the format can't read compact documents and
+   * fail with a fatal error on the first one they load. Only enable this for
+   * apps that will never downgrade to such a version while keeping their
+   * cache.
+   */
+  void set_compact_documents_enabled(bool value) {
+    compact_documents_enabled_ = value;
+  }
+  bool compact_documents_enabled() const {
+    return compact_documents_enabled_;
+  }
+
   friend bool operator==(const Settings& lhs, const Settings& rhs);
 
   size_t Hash() const;
@@ -90,6 +108,7 @@ class Settings {
   bool ssl_enabled_ = DefaultSslEnabled;
   bool persistence_enabled_ = DefaultPersistenceEnabled;
   int64_t cache_size_bytes_ = DefaultCacheSizeBytes;
+  bool compact_documents_enabled_ = DefaultCompactDocumentsEnabled;
   std::unique_ptr<LocalCacheSettings> cache_settings_ = nullptr;
 };
 
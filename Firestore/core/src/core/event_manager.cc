@@ -34,6 +34,16 @@ EventManager::EventManager(QueryEventSource* query_event_source)
   query_event_source->SetCallback(this);
 }
 
+EventManager::~EventManager() {
+  // Query listeners can outlive the EventManager, and so can their delayed
+  // operations.
+  for (auto&& kv : queries_) {
+    for (auto&& listener : kv.second.listeners) {
+      listener->SetPendingSnapshotCallback(nullptr);
+    }
+  }
+}
+
 model::TargetId EventManager::AddQueryListener(
     std::shared_ptr<core::QueryListener> listener) {
   const Query& query = listener->query();
@@ -59,6 +69,8 @@ model::TargetId EventManager::AddQueryListener(
   }
 
   query_info.listeners.push_back(listener);
+  listener->SetPendingSnapshotCallback(
+      [this](bool raised_event) { OnPendingSnapshotHandled(raised_event); });
 
   bool raised_event = listener->OnOnlineStateChanged(online_state_);
   HARD_ASSERT(!raised_event,
@@ -99,7 +111,14 @@ void EventManager::RemoveQueryListener(
   auto found_iter = queries_.find(query);
   if (found_iter != queries_.end()) {
     QueryListenersInfo& query_info = found_iter->second;
-    query_info.Erase(listener);
+    if (query_info.Erase(listener)) {
+      listener->SetPendingSnapshotCallback(nullptr);
+      // The removed listener may have been the last one holding back a
+      // snapshot.
+      if (snapshots_in_sync_deferred_) {
+        RaiseSnapshotsInSyncEvent();
+      }
+    }
 
     if (query_info.listeners.empty()) {
       listener_action =
@@ -160,12 +179,35 @@ void EventManager::HandleOnlineStateChange(model::OnlineState online_state) {
 }
 
 void EventManager::RaiseSnapshotsInSyncEvent() {
+  if (HasPendingSnapshots()) {
+    snapshots_in_sync_deferred_ = true;
+    return;
+  }
+
+  snapshots_in_sync_deferred_ = false;
   Empty empty{};
   for (const auto& listener : snapshots_in_sync_listeners_) {
     listener->OnEvent(empty);
   }
 }
 
+void EventManager::OnPendingSnapshotHandled(bool raised_event) {
+  if (raised_event || snapshots_in_sync_deferred_) {
+    RaiseSnapshotsInSyncEvent();
+  }
+}
+
+bool EventManager::HasPendingSnapshots() const {
+  for (const auto& kv : queries_) {
+    for (const auto& listener : kv.second.listeners) {
+      if (listener->has_pending_snapshot()) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
 void EventManager::OnViewSnapshots(
     std::vector<core::ViewSnapshot>&& snapshots) {
   bool raised_event = false;
@@ -196,12 +238,18 @@ void EventManager::OnError(const core::Query& query,
 
   QueryListenersInfo& query_info = found_iter->second;
   for (const auto& listener : query_info.listeners) {
+    listener->SetPendingSnapshotCallback(nullptr);
     listener->OnError(error);
   }
 
   // Remove all listeners. NOTE: We don't need to call
   // `SyncEngine::StopListening()` after an error.
   queries_.erase(found_iter);
+
+  // The removed listeners may have been the ones holding back snapshots.
+  if (snapshots_in_sync_deferred_) {
+    RaiseSnapshotsInSyncEvent();
+  }
 }
 
 bool EventManager::QueryListenersInfo::Erase(
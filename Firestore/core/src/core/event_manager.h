@@ -46,6 +46,8 @@ class EventManager : public SyncEngineCallback {
  public:
   explicit EventManager(QueryEventSource* query_event_source_);
 
+  ~EventManager() override;
+
   /**
    * Adds a query listener that will be called with new snapshots for the query.
    * The EventManager is responsible for multiplexing many listeners to a single
@@ -76,9 +78,19 @@ class EventManager : public SyncEngineCallback {
  private:
   /**
    * Call all global snapshot listeners that have been set.
+   *
+   * While a query listener holds back a coalesced snapshot, the listeners
+   * aren't in sync, so the event is deferred until the last held snapshot has
+   * been handled.
    */
   void RaiseSnapshotsInSyncEvent();
 
+  /** Handles a coalesced snapshot that a query listener delivered late. */
+  void OnPendingSnapshotHandled(bool raised_event);
+
+  /** Returns whether any query listener holds back a coalesced snapshot. */
+  bool HasPendingSnapshots() const;
+
   /**
    * Holds the listeners and the last received ViewSnapshot for a query being
    * tracked by EventManager.
@@ -131,6 +143,9 @@ class EventManager : public SyncEngineCallback {
   std::unordered_map<core::Query, QueryListenersInfo> queries_;
   std::unordered_set<std::shared_ptr<EventListener<util::Empty>>>
       snapshots_in_sync_listeners_;
+
+  /** Whether a snapshots-in-sync event waits for held snapshots. */
+  bool snapshots_in_sync_deferred_ = false;
 };
 
 }  // namespace core
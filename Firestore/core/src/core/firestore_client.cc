@@ -63,6 +63,7 @@
 #include "Firestore/core/src/util/status.h"
 #include "Firestore/core/src/util/statusor.h"
 #include "Firestore/core/src/util/string_apple.h"
+#include "Firestore/core/src/util/tracing.h"
 #include "absl/memory/memory.h"
 
 namespace firebase {
@@ -98,6 +99,7 @@ using remote::Datastore;
 using remote::FirebaseMetadataProvider;
 using remote::RemoteStore;
 using remote::Serializer;
+using remote::WritePipelineSettings;
 using util::AsyncQueue;
 using util::Empty;
 using util::Executor;
@@ -108,6 +110,8 @@ using util::StatusOrCallback;
 using util::ThrowIllegalState;
 using util::TimerId;
 
+using Priority = AsyncQueue::Priority;
+
 namespace {
 
 static const size_t kMaxConcurrentLimboResolutions = 100;
@@ -120,6 +124,41 @@ static const auto kInitialBackfillDelay = std::chrono::seconds(15);
 /** Minimum amount of time between backfill checks, after the first one. */
 static const auto kRegularBackfillDelay = std::chrono::minutes(1);
 
+/**
+ * How long garbage collection and index backfill wait before trying again
+ * when they yield to more urgent operations on the worker queue.
+ */
+static const auto kBackgroundYieldDelay = std::chrono::milliseconds(100);
+/** How many times in a row background work may yield before it runs anyway. */
+static const int kMaxBackgroundYields = 10;
+
+/**
+ * The number of threads that run cache-only queries outside the worker queue
+ * when the persistence layer supports concurrent reads.
+ */
+static const int kLocalReaderThreads = 2;
+
+/** Builds the snapshot of a cache-only query from its local results. */
+QuerySnapshot MakeLocalQuerySnapshot(const api::Query& query,
+                                     const DocumentMap& documents,
+                                     const DocumentKeySet& remote_keys) {
+  View view(query.query(), remote_keys);
+  ViewDocumentChanges view_doc_changes = view.ComputeDocumentChanges(documents);
+  ViewChange view_change = view.ApplyChanges(view_doc_changes);
+  HARD_ASSERT(
+      view_change.limbo_changes().empty(),
+      "View returned limbo documents during local-only query execution.");
+
+  HARD_ASSERT(view_change.snapshot().has_value(), "Expected a snapshot");
+
+  ViewSnapshot snapshot = std::move(view_change.snapshot()).value();
+  SnapshotMetadata metadata(snapshot.has_pending_writes(),
+                            snapshot.from_cache());
+
+  return QuerySnapshot(query.firestore(), query.query(), std::move(snapshot),
+                       std::move(metadata));
+}
+
 }  // namespace
 
 std::shared_ptr<FirestoreClient> FirestoreClient::Create(
@@ -150,16 +189,18 @@ std::shared_ptr<FirestoreClient> FirestoreClient::Create(
       // it is invoked synchronously on the calling thread. This ensures that
       // the first item enqueued on the worker queue is
       // `FirestoreClient::Initialize()`.
-      shared_client->worker_queue_->Enqueue([shared_client, user, settings] {
-        shared_client->Initialize(user, settings);
-      });
+      shared_client->worker_queue_->Enqueue(
+          Priority::kInteractive, [shared_client, user, settings] {
+            shared_client->Initialize(user, settings);
+          });
     } else {
-      shared_client->worker_queue_->Enqueue([shared_client, user] {
-        shared_client->worker_queue_->VerifyIsCurrentQueue();
+      shared_client->worker_queue_->Enqueue(
+          Priority::kInteractive, [shared_client, user] {
+            shared_client->worker_queue_->VerifyIsCurrentQueue();
 
-        LOG_DEBUG("Credential Changed. Current user: %s", user.uid());
-        shared_client->sync_engine_->HandleCredentialChange(user);
-      });
+            LOG_DEBUG("Credential Changed. Current user: %s", user.uid());
+            shared_client->sync_engine_->HandleCredentialChange(user);
+          });
     }
   };
 
@@ -208,7 +249,8 @@ void FirestoreClient::Initialize(const User& user, const Settings& settings) {
     LevelDbOpener opener(database_info_);
 
     auto created =
-        opener.Create(LruParams::WithCacheSize(settings.cache_size_bytes()));
+        opener.Create(LruParams::WithCacheSize(settings.cache_size_bytes()),
+                      settings.compact_documents_enabled());
     // If leveldb fails to start then just throw up our hands: the error is
     // unrecoverable. There's nothing an end-user can do and nearly all
     // failures indicate the developer is doing something grossly wrong so we
@@ -244,6 +286,10 @@ void FirestoreClient::Initialize(const User& user, const Settings& settings) {
   query_engine_ = absl::make_unique<QueryEngine>();
   local_store_ = absl::make_unique<LocalStore>(persistence_.get(),
                                                query_engine_.get(), user);
+  if (persistence_->supports_concurrent_reads()) {
+    local_reader_executor_ = Executor::CreateConcurrent(
+        "com.google.firebase.firestore.local_reader", kLocalReaderThreads);
+  }
   connectivity_monitor_ = ConnectivityMonitor::Create(worker_queue_);
   auto datastore = std::make_shared<Datastore>(
       database_info_, worker_queue_, auth_credentials_provider_,
@@ -252,9 +298,11 @@ void FirestoreClient::Initialize(const User& user, const Settings& settings) {
 
   remote_store_ = absl::make_unique<RemoteStore>(
       local_store_.get(), std::move(datastore), worker_queue_,
-      connectivity_monitor_.get(), [this](OnlineState online_state) {
+      connectivity_monitor_.get(),
+      [this](OnlineState online_state) {
         sync_engine_->HandleOnlineStateChange(online_state);
-      });
+      },
+      WritePipelineSettings::Adaptive());
 
   sync_engine_ =
       absl::make_unique<SyncEngine>(local_store_.get(), remote_store_.get(),
@@ -334,6 +382,12 @@ void FirestoreClient::TerminateInternal() {
   backfiller_callback_.Cancel();
 
   remote_store_->Shutdown();
+
+  // Wait for in-flight cache-only queries, which read from persistence outside
+  // the worker queue.
+  if (local_reader_executor_) {
+    local_reader_executor_->Dispose();
+  }
   persistence_->Shutdown();
 
   local_store_.reset();
@@ -346,10 +400,16 @@ void FirestoreClient::TerminateInternal() {
 
 void FirestoreClient::ScheduleLruGarbageCollection() {
   std::chrono::milliseconds delay =
-      gc_has_run_ ? kRegularGCDelay : kInitialGCDelay;
+      gc_yields_ > 0 ? kBackgroundYieldDelay
+                     : gc_has_run_ ? kRegularGCDelay : kInitialGCDelay;
 
   lru_callback_ = worker_queue_->EnqueueAfterDelay(
       delay, TimerId::GarbageCollectionDelay, [this] {
+        if (ShouldDeferBackgroundWork(&gc_yields_)) {
+          ScheduleLruGarbageCollection();
+          return;
+        }
+
         local_store_->CollectGarbage(lru_delegate_->garbage_collector());
         gc_has_run_ = true;
         ScheduleLruGarbageCollection();
@@ -358,20 +418,38 @@ void FirestoreClient::ScheduleLruGarbageCollection() {
 
 void FirestoreClient::ScheduleIndexBackfiller() {
   std::chrono::milliseconds delay =
-      backfiller_has_run_ ? kRegularBackfillDelay : kInitialBackfillDelay;
+      backfiller_yields_ > 0 ? kBackgroundYieldDelay
+      : backfiller_has_run_  ? kRegularBackfillDelay
+                             : kInitialBackfillDelay;
 
   backfiller_callback_ = worker_queue_->EnqueueAfterDelay(
       delay, TimerId::IndexBackfillDelay, [this] {
+        if (ShouldDeferBackgroundWork(&backfiller_yields_)) {
+          ScheduleIndexBackfiller();
+          return;
+        }
+
         local_store_->Backfill();
         backfiller_has_run_ = true;
         ScheduleIndexBackfiller();
       });
 }
 
+bool FirestoreClient::ShouldDeferBackgroundWork(int* consecutive_yields) {
+  if (*consecutive_yields < kMaxBackgroundYields &&
+      worker_queue_->ShouldYield()) {
+    ++*consecutive_yields;
+    return true;
+  }
+
+  *consecutive_yields = 0;
+  return false;
+}
+
 void FirestoreClient::DisableNetwork(StatusCallback callback) {
   VerifyNotTerminated();
 
-  worker_queue_->Enqueue([this, callback] {
+  worker_queue_->Enqueue(Priority::kInteractive, [this, callback] {
     remote_store_->DisableNetwork();
     if (callback) {
       user_executor_->Execute([=] { callback(Status::OK()); });
@@ -382,7 +460,7 @@ void FirestoreClient::DisableNetwork(StatusCallback callback) {
 void FirestoreClient::EnableNetwork(StatusCallback callback) {
   VerifyNotTerminated();
 
-  worker_queue_->Enqueue([this, callback] {
+  worker_queue_->Enqueue(Priority::kInteractive, [this, callback] {
     remote_store_->EnableNetwork();
     if (callback) {
       user_executor_->Execute([=] { callback(Status::OK()); });
@@ -400,7 +478,7 @@ void FirestoreClient::WaitForPendingWrites(StatusCallback callback) {
     }
   };
 
-  worker_queue_->Enqueue([this, async_callback] {
+  worker_queue_->Enqueue(Priority::kInteractive, [this, async_callback] {
     sync_engine_->RegisterPendingWritesCallback(std::move(async_callback));
   });
 }
@@ -424,10 +502,11 @@ std::shared_ptr<QueryListener> FirestoreClient::ListenToQuery(
     Query query, ListenOptions options, ViewSnapshotSharedListener&& listener) {
   VerifyNotTerminated();
 
-  auto query_listener = QueryListener::Create(
-      std::move(query), std::move(options), std::move(listener));
+  auto query_listener =
+      QueryListener::Create(std::move(query), std::move(options),
+                            std::move(listener), worker_queue_);
 
-  worker_queue_->Enqueue([this, query_listener] {
+  worker_queue_->Enqueue(Priority::kInteractive, [this, query_listener] {
     event_manager_->AddQueryListener(std::move(query_listener));
   });
 
@@ -441,8 +520,9 @@ void FirestoreClient::RemoveListener(
   if (is_terminated()) {
     return;
   }
-  worker_queue_->Enqueue(
-      [this, listener] { event_manager_->RemoveQueryListener(listener); });
+  worker_queue_->Enqueue(Priority::kInteractive, [this, listener] {
+    event_manager_->RemoveQueryListener(listener);
+  });
 }
 
 void FirestoreClient::GetDocumentFromLocalCache(
@@ -451,7 +531,7 @@ void FirestoreClient::GetDocumentFromLocalCache(
 
   // TODO(c++14): move `callback` into lambda.
   auto shared_callback = absl::ShareUniquePtr(std::move(callback));
-  worker_queue_->Enqueue([this, doc, shared_callback] {
+  worker_queue_->Enqueue(Priority::kInteractive, [this, doc, shared_callback] {
     Document document = local_store_->ReadDocument(doc.key());
     StatusOr<DocumentSnapshot> maybe_snapshot;
 
@@ -486,32 +566,39 @@ void FirestoreClient::GetDocumentsFromLocalCache(
 
   // TODO(c++14): move `callback` into lambda.
   auto shared_callback = absl::ShareUniquePtr(std::move(callback));
-  worker_queue_->Enqueue([this, query, shared_callback] {
-    QueryResult query_result = local_store_->ExecuteQuery(
-        query.query(), /* use_previous_results= */ true);
-
-    View view(query.query(), query_result.remote_keys());
-    ViewDocumentChanges view_doc_changes =
-        view.ComputeDocumentChanges(query_result.documents());
-    ViewChange view_change = view.ApplyChanges(view_doc_changes);
-    HARD_ASSERT(
-        view_change.limbo_changes().empty(),
-        "View returned limbo documents during local-only query execution.");
-
-    HARD_ASSERT(view_change.snapshot().has_value(), "Expected a snapshot");
-
-    ViewSnapshot snapshot = std::move(view_change.snapshot()).value();
-    SnapshotMetadata metadata(snapshot.has_pending_writes(),
-                              snapshot.from_cache());
-
-    QuerySnapshot result(query.firestore(), query.query(), std::move(snapshot),
-                         std::move(metadata));
+  worker_queue_->Enqueue(
+      Priority::kInteractive, [this, query, shared_callback] {
+        if (!local_reader_executor_) {
+          QueryResult query_result = local_store_->ExecuteQuery(
+              query.query(), /* use_previous_results= */ true);
+          QuerySnapshot result = MakeLocalQuerySnapshot(
+              query, query_result.documents(), query_result.remote_keys());
+
+          if (shared_callback) {
+            user_executor_->Execute(
+                [=] { shared_callback->OnEvent(std::move(result)); });
+          }
+          return;
+        }
 
-    if (shared_callback) {
-      user_executor_->Execute(
-          [=] { shared_callback->OnEvent(std::move(result)); });
-    }
-  });
+        // Hand the query to a reader only once the worker reaches it, so that
+        // its snapshot includes every write enqueued before this call. The
+        // worker moves on to later events without waiting for the query to
+        // finish.
+        local_reader_executor_->Execute(util::TraceOperation(
+            "executor", "Execute query on snapshot",
+            [this, query, shared_callback] {
+              DocumentMap documents =
+                  local_store_->ExecuteQueryOnSnapshot(query.query());
+              QuerySnapshot result =
+                  MakeLocalQuerySnapshot(query, documents, DocumentKeySet{});
+
+              if (shared_callback) {
+                user_executor_->Execute(
+                    [=] { shared_callback->OnEvent(std::move(result)); });
+              }
+            }));
+      });
 }
 
 void FirestoreClient::WriteMutations(std::vector<Mutation>&& mutations,
@@ -519,21 +606,22 @@ void FirestoreClient::WriteMutations(std::vector<Mutation>&& mutations,
   VerifyNotTerminated();
 
   // TODO(c++14): move `mutations` into lambda (C++14).
-  worker_queue_->Enqueue([this, mutations, callback]() mutable {
-    if (mutations.empty()) {
-      if (callback) {
-        user_executor_->Execute([=] { callback(Status::OK()); });
-      }
-    } else {
-      sync_engine_->WriteMutations(
-          std::move(mutations), [this, callback](Status error) {
-            // Dispatch the result back onto the user dispatch queue.
-            if (callback) {
-              user_executor_->Execute([=] { callback(std::move(error)); });
-            }
-          });
-    }
-  });
+  worker_queue_->Enqueue(
+      Priority::kInteractive, [this, mutations, callback]() mutable {
+        if (mutations.empty()) {
+          if (callback) {
+            user_executor_->Execute([=] { callback(Status::OK()); });
+          }
+        } else {
+          sync_engine_->WriteMutations(
+              std::move(mutations), [this, callback](Status error) {
+                // Dispatch the result back onto the user dispatch queue.
+                if (callback) {
+                  user_executor_->Execute([=] { callback(std::move(error)); });
+                }
+              });
+        }
+      });
 }
 
 void FirestoreClient::Transaction(int max_attempts,
@@ -548,11 +636,13 @@ void FirestoreClient::Transaction(int max_attempts,
     }
   };
 
-  worker_queue_->Enqueue([this, max_attempts, update_callback, async_callback] {
-    sync_engine_->Transaction(max_attempts, worker_queue_,
-                              std::move(update_callback),
-                              std::move(async_callback));
-  });
+  worker_queue_->Enqueue(
+      Priority::kInteractive,
+      [this, max_attempts, update_callback, async_callback] {
+        sync_engine_->Transaction(max_attempts, worker_queue_,
+                                  std::move(update_callback),
+                                  std::move(async_callback));
+      });
 }
 
 void FirestoreClient::RunAggregateQuery(
@@ -569,22 +659,23 @@ void FirestoreClient::RunAggregateQuery(
     }
   };
 
-  worker_queue_->Enqueue([this, query, aggregates, async_callback] {
-    sync_engine_->RunAggregateQuery(query, aggregates,
-                                    std::move(async_callback));
-  });
+  worker_queue_->Enqueue(
+      Priority::kInteractive, [this, query, aggregates, async_callback] {
+        sync_engine_->RunAggregateQuery(query, aggregates,
+                                        std::move(async_callback));
+      });
 }
 
 void FirestoreClient::AddSnapshotsInSyncListener(
     const std::shared_ptr<EventListener<Empty>>& user_listener) {
-  worker_queue_->Enqueue([this, user_listener] {
+  worker_queue_->Enqueue(Priority::kInteractive, [this, user_listener] {
     event_manager_->AddSnapshotsInSyncListener(std::move(user_listener));
   });
 }
 
 void FirestoreClient::RemoveSnapshotsInSyncListener(
     const std::shared_ptr<EventListener<Empty>>& user_listener) {
-  worker_queue_->Enqueue([this, user_listener] {
+  worker_queue_->Enqueue(Priority::kInteractive, [this, user_listener] {
     event_manager_->RemoveSnapshotsInSyncListener(user_listener);
   });
 }
@@ -592,21 +683,22 @@ void FirestoreClient::RemoveSnapshotsInSyncListener(
 void FirestoreClient::ConfigureFieldIndexes(
     std::vector<FieldIndex> parsed_indexes) {
   VerifyNotTerminated();
-  worker_queue_->Enqueue([this, parsed_indexes] {
+  worker_queue_->Enqueue(Priority::kInteractive, [this, parsed_indexes] {
     local_store_->ConfigureFieldIndexes(std::move(parsed_indexes));
   });
 }
 
 void FirestoreClient::SetIndexAutoCreationEnabled(bool is_enabled) const {
   VerifyNotTerminated();
-  worker_queue_->Enqueue([this, is_enabled] {
+  worker_queue_->Enqueue(Priority::kInteractive, [this, is_enabled] {
     local_store_->SetIndexAutoCreationEnabled(is_enabled);
   });
 }
 
 void FirestoreClient::DeleteAllFieldIndexes() {
   VerifyNotTerminated();
-  worker_queue_->Enqueue([this] { local_store_->DeleteAllFieldIndexes(); });
+  worker_queue_->Enqueue(Priority::kInteractive,
+                         [this] { local_store_->DeleteAllFieldIndexes(); });
 }
 
 void FirestoreClient::LoadBundle(
@@ -618,7 +710,7 @@ void FirestoreClient::LoadBundle(
       remote::Serializer(database_info_.database_id()));
   auto reader = std::make_shared<bundle::BundleReader>(
       std::move(bundle_serializer), std::move(bundle_data));
-  worker_queue_->Enqueue([this, reader, result_task] {
+  worker_queue_->Enqueue(Priority::kInteractive, [this, reader, result_task] {
     sync_engine_->LoadBundle(std::move(reader), std::move(result_task));
   });
 }
@@ -647,7 +739,7 @@ void FirestoreClient::GetNamedQuery(const std::string& name,
         }
       };
 
-  worker_queue_->Enqueue([this, name, async_callback] {
+  worker_queue_->Enqueue(Priority::kInteractive, [this, name, async_callback] {
     async_callback(local_store_->GetNamedQuery(name));
   });
 }
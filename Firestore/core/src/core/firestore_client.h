@@ -231,6 +231,13 @@ class FirestoreClient : public std::enable_shared_from_this<FirestoreClient> {
    */
   void ScheduleIndexBackfiller();
 
+  /**
+   * Returns true if background work should be put off because more urgent
+   * operations are waiting on the worker queue, unless it has already been put
+   * off too many times in a row, as counted by `consecutive_yields`.
+   */
+  bool ShouldDeferBackgroundWork(int* consecutive_yields);
+
   DatabaseInfo database_info_;
   std::shared_ptr<credentials::AppCheckCredentialsProvider>
       app_check_credentials_provider_;
@@ -246,6 +253,14 @@ class FirestoreClient : public std::enable_shared_from_this<FirestoreClient> {
   std::shared_ptr<util::AsyncQueue> worker_queue_;
   std::shared_ptr<util::Executor> user_executor_;
 
+  /**
+   * Runs cache-only queries against read-only snapshots of persistence, so
+   * that they do not hold up the worker queue. Null if the persistence layer
+   * does not support concurrent reads, in which case such queries run on the
+   * worker queue.
+   */
+  std::unique_ptr<util::Executor> local_reader_executor_;
+
   std::unique_ptr<remote::FirebaseMetadataProvider> firebase_metadata_provider_;
 
   std::unique_ptr<local::Persistence> persistence_;
@@ -258,6 +273,8 @@ class FirestoreClient : public std::enable_shared_from_this<FirestoreClient> {
 
   bool gc_has_run_ = false;
   bool backfiller_has_run_ = false;
+  int gc_yields_ = 0;
+  int backfiller_yields_ = 0;
   bool credentials_initialized_ = false;
   local::LruDelegate* _Nullable lru_delegate_;
   util::DelayedOperation lru_callback_;
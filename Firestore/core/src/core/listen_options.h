@@ -17,7 +17,9 @@
 #ifndef FIRESTORE_CORE_SRC_CORE_LISTEN_OPTIONS_H_
 #define FIRESTORE_CORE_SRC_CORE_LISTEN_OPTIONS_H_
 
+#include <chrono>  // NOLINT(build/c++11)
 #include <utility>
+
 #include "Firestore/core/src/api/listen_source.h"
 namespace firebase {
 namespace firestore {
@@ -120,11 +122,31 @@ class ListenOptions {
     return source_;
   }
 
+  /**
+   * Returns a copy of these options that raises at most one snapshot per
+   * `interval`. Snapshots that arrive sooner after the previous event are
+   * coalesced into a single snapshot that is raised once the interval has
+   * elapsed. The first snapshot is always raised immediately.
+   *
+   * An interval of zero, the default, raises every snapshot.
+   */
+  ListenOptions WithMinSnapshotInterval(
+      std::chrono::milliseconds interval) const {
+    ListenOptions result = *this;
+    result.min_snapshot_interval_ = interval;
+    return result;
+  }
+
+  std::chrono::milliseconds min_snapshot_interval() const {
+    return min_snapshot_interval_;
+  }
+
  private:
   bool include_query_metadata_changes_ = false;
   bool include_document_metadata_changes_ = false;
   bool wait_for_sync_when_online_ = false;
   ListenSource source_ = ListenSource::Default;
+  std::chrono::milliseconds min_snapshot_interval_{0};
 };
 
 }  // namespace core
@@ -203,6 +203,38 @@ bool Query::Matches(const Document& doc) const {
          MatchesOrderBy(doc) && MatchesFilters(doc) && MatchesBounds(doc);
 }
 
+bool Query::Subsumes(const Query& other) const {
+  if (IsDocumentQuery() || has_limit() || start_at_ || end_at_) {
+    return false;
+  }
+
+  if (path_ != other.path_ ||
+      !util::Equals(collection_group_, other.collection_group_)) {
+    return false;
+  }
+
+  for (const Filter& filter : filters_) {
+    if (!absl::c_linear_search(other.filters_, filter)) {
+      return false;
+    }
+  }
+
+  // Ordering by a field excludes documents that don't contain it, so `other`
+  // must order by (and hence require) each of these fields too.
+  const std::vector<OrderBy>& other_order_bys = other.normalized_order_bys();
+  for (const OrderBy& order_by : normalized_order_bys()) {
+    if (order_by.field() == FieldPath::KeyFieldPath()) continue;
+    bool found = absl::c_any_of(other_order_bys, [&](const OrderBy& other_by) {
+      return other_by.field() == order_by.field();
+    });
+    if (!found) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
 bool Query::MatchesPathAndCollectionGroup(const Document& doc) const {
   const ResourcePath& doc_path = doc->key().path();
   if (collection_group_) {
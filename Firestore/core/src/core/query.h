@@ -232,6 +232,17 @@ class Query {
   /** Returns true if the document matches the constraints of this query. */
   bool Matches(const model::Document& doc) const;
 
+  /**
+   * Returns true if every document that matches `other` is known to match
+   * this query as well, so that the results of `other` can be computed from
+   * the results of this query.
+   *
+   * This is a structural check: it holds if this query has no limit or bounds,
+   * targets the same collection, and `other` contains all of its filters and
+   * orders by all of its fields.
+   */
+  bool Subsumes(const Query& other) const;
+
   /**
    * Returns a comparator that will sort documents according to the order by
    * clauses in this query.
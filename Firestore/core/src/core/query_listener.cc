@@ -16,6 +16,7 @@
 
 #include "Firestore/core/src/core/query_listener.h"
 
+#include <chrono>  // NOLINT(build/c++11)
 #include <utility>
 #include <vector>
 
@@ -30,12 +31,19 @@ namespace core {
 
 using model::OnlineState;
 using model::TargetId;
+using util::AsyncQueue;
+using util::Executor;
 using util::Status;
+using util::TimerId;
 
 std::shared_ptr<QueryListener> QueryListener::Create(
-    Query query, ListenOptions options, ViewSnapshotSharedListener&& listener) {
+    Query query,
+    ListenOptions options,
+    ViewSnapshotSharedListener&& listener,
+    std::shared_ptr<AsyncQueue> worker_queue) {
   return std::make_shared<QueryListener>(std::move(query), std::move(options),
-                                         std::move(listener));
+                                         std::move(listener),
+                                         std::move(worker_queue));
 }
 
 std::shared_ptr<QueryListener> QueryListener::Create(
@@ -62,10 +70,12 @@ std::shared_ptr<QueryListener> QueryListener::Create(
 
 QueryListener::QueryListener(Query query,
                              ListenOptions options,
-                             ViewSnapshotSharedListener&& listener)
+                             ViewSnapshotSharedListener&& listener,
+                             std::shared_ptr<AsyncQueue> worker_queue)
     : query_(std::move(query)),
       options_(std::move(options)),
-      listener_(std::move(listener)) {
+      listener_(std::move(listener)),
+      worker_queue_(std::move(worker_queue)) {
 }
 
 bool QueryListener::OnViewSnapshot(ViewSnapshot snapshot) {
@@ -98,9 +108,31 @@ bool QueryListener::OnViewSnapshot(ViewSnapshot snapshot) {
       RaiseInitialEvent(snapshot);
       raised_event = true;
     }
-  } else if (ShouldRaiseEvent(snapshot)) {
-    listener_->OnEvent(snapshot);
-    raised_event = true;
+  } else if (pending_snapshot_) {
+    // Already waiting for the interval to elapse; fold this snapshot into the
+    // pending one.
+    pending_snapshot_ = ViewSnapshot::Coalesce(*pending_snapshot_, snapshot);
+  } else if (ShouldRaiseEvent(snapshot, snapshot_)) {
+    Executor::TimePoint now =
+        std::chrono::time_point_cast<Executor::Milliseconds>(
+            Executor::Clock::now());
+    Executor::TimePoint next_event_time =
+        last_event_time_ + options_.min_snapshot_interval();
+    if (coalesces_snapshots() && now < next_event_time) {
+      pending_snapshot_ = snapshot;
+      snapshot_before_pending_ = snapshot_;
+
+      std::weak_ptr<QueryListener> weak_this = shared_from_this();
+      pending_snapshot_operation_ = worker_queue_->EnqueueAfterDelay(
+          next_event_time - now, TimerId::ListenerSnapshotDelay, [weak_this] {
+            if (auto strong_this = weak_this.lock()) {
+              strong_this->RaisePendingSnapshot();
+            }
+          });
+    } else {
+      RaiseEvent(snapshot);
+      raised_event = true;
+    }
   }
 
   snapshot_ = std::move(snapshot);
@@ -108,9 +140,40 @@ bool QueryListener::OnViewSnapshot(ViewSnapshot snapshot) {
 }
 
 void QueryListener::OnError(Status error) {
+  ClearPendingSnapshot();
   listener_->OnEvent(std::move(error));
 }
 
+void QueryListener::RaisePendingSnapshot() {
+  if (!pending_snapshot_) {
+    return;
+  }
+
+  ViewSnapshot snapshot = std::move(*pending_snapshot_);
+  absl::optional<ViewSnapshot> previous = std::move(snapshot_before_pending_);
+  pending_snapshot_.reset();
+  snapshot_before_pending_.reset();
+  pending_snapshot_operation_ = {};
+
+  // The coalesced changes may cancel each other out (e.g. a document that was
+  // added and removed again).
+  bool raised_event = ShouldRaiseEvent(snapshot, previous);
+  if (raised_event) {
+    RaiseEvent(std::move(snapshot));
+  }
+
+  if (pending_snapshot_callback_) {
+    pending_snapshot_callback_(raised_event);
+  }
+}
+
+void QueryListener::ClearPendingSnapshot() {
+  pending_snapshot_.reset();
+  snapshot_before_pending_.reset();
+  pending_snapshot_operation_.Cancel();
+  pending_snapshot_operation_ = {};
+}
+
 /**
  * Returns whether a snapshot was raised.
  */
@@ -159,7 +222,9 @@ bool QueryListener::ShouldRaiseInitialEvent(const ViewSnapshot& snapshot,
          online_state == OnlineState::Offline;
 }
 
-bool QueryListener::ShouldRaiseEvent(const ViewSnapshot& snapshot) const {
+bool QueryListener::ShouldRaiseEvent(
+    const ViewSnapshot& snapshot,
+    const absl::optional<ViewSnapshot>& previous) const {
   // We don't need to handle include_document_metadata_changes() here because
   // the Metadata only changes have already been stripped out if needed. At this
   // point the only changes we will see are the ones we should propagate.
@@ -168,8 +233,8 @@ bool QueryListener::ShouldRaiseEvent(const ViewSnapshot& snapshot) const {
   }
 
   bool has_pending_writes_changed =
-      snapshot_.has_value() &&
-      snapshot_.value().has_pending_writes() != snapshot.has_pending_writes();
+      previous.has_value() &&
+      previous.value().has_pending_writes() != snapshot.has_pending_writes();
   if (snapshot.sync_state_changed() || has_pending_writes_changed) {
     return options_.include_query_metadata_changes();
   }
@@ -189,7 +254,13 @@ void QueryListener::RaiseInitialEvent(const ViewSnapshot& snapshot) {
       snapshot.from_cache(), snapshot.excludes_metadata_changes(),
       snapshot.has_cached_results());
   raised_initial_event_ = true;
-  listener_->OnEvent(std::move(modified_snapshot));
+  RaiseEvent(std::move(modified_snapshot));
+}
+
+void QueryListener::RaiseEvent(ViewSnapshot snapshot) {
+  last_event_time_ = std::chrono::time_point_cast<Executor::Milliseconds>(
+      Executor::Clock::now());
+  listener_->OnEvent(std::move(snapshot));
 }
 
 }  // namespace core
@@ -17,6 +17,8 @@
 #ifndef FIRESTORE_CORE_SRC_CORE_QUERY_LISTENER_H_
 #define FIRESTORE_CORE_SRC_CORE_QUERY_LISTENER_H_
 
+#include <chrono>  // NOLINT(build/c++11)
+#include <functional>
 #include <memory>
 #include <utility>
 
@@ -24,6 +26,7 @@
 #include "Firestore/core/src/core/query.h"
 #include "Firestore/core/src/core/view_snapshot.h"
 #include "Firestore/core/src/model/types.h"
+#include "Firestore/core/src/util/async_queue.h"
 #include "Firestore/core/src/util/status_fwd.h"
 #include "absl/types/optional.h"
 
@@ -34,13 +37,18 @@ namespace core {
 /**
  * QueryListener takes a series of internal view snapshots and determines when
  * to raise user-facing events.
+ *
+ * If the options specify a minimum snapshot interval and a worker queue is
+ * given, snapshots that arrive within the interval of the previous event are
+ * coalesced and raised from a delayed operation on the worker queue.
  */
-class QueryListener {
+class QueryListener : public std::enable_shared_from_this<QueryListener> {
  public:
   static std::shared_ptr<QueryListener> Create(
       Query query,
       ListenOptions options,
-      ViewSnapshotSharedListener&& listener);
+      ViewSnapshotSharedListener&& listener,
+      std::shared_ptr<util::AsyncQueue> worker_queue = nullptr);
 
   static std::shared_ptr<QueryListener> Create(
       Query query, ViewSnapshotSharedListener&& listener);
@@ -55,7 +63,8 @@ class QueryListener {
 
   QueryListener(Query query,
                 ListenOptions options,
-                ViewSnapshotSharedListener&& listener);
+                ViewSnapshotSharedListener&& listener,
+                std::shared_ptr<util::AsyncQueue> worker_queue = nullptr);
 
   virtual ~QueryListener() = default;
 
@@ -85,11 +94,38 @@ class QueryListener {
   /** Returns whether a snapshot was raised. */
   virtual bool OnOnlineStateChanged(model::OnlineState online_state);
 
+  /** Returns whether a coalesced snapshot is waiting to be raised. */
+  bool has_pending_snapshot() const {
+    return pending_snapshot_.has_value();
+  }
+
+  /**
+   * Sets the callback that is invoked once the delayed operation has handled
+   * a coalesced snapshot, with whether it raised an event. Such events happen
+   * outside of `OnViewSnapshot`, so its result can't report them.
+   */
+  void SetPendingSnapshotCallback(std::function<void(bool)> callback) {
+    pending_snapshot_callback_ = std::move(callback);
+  }
+
  private:
   bool ShouldRaiseInitialEvent(const ViewSnapshot& snapshot,
                                model::OnlineState online_state) const;
-  bool ShouldRaiseEvent(const ViewSnapshot& snapshot) const;
+  bool ShouldRaiseEvent(const ViewSnapshot& snapshot,
+                        const absl::optional<ViewSnapshot>& previous) const;
   void RaiseInitialEvent(const ViewSnapshot& snapshot);
+  void RaiseEvent(ViewSnapshot snapshot);
+
+  bool coalesces_snapshots() const {
+    return worker_queue_ &&
+           options_.min_snapshot_interval() > std::chrono::milliseconds(0);
+  }
+
+  /** Raises the coalesced snapshot, if it is still pending. */
+  void RaisePendingSnapshot();
+
+  /** Discards the coalesced snapshot and cancels its delayed delivery. */
+  void ClearPendingSnapshot();
 
   Query query_;
   ListenOptions options_;
@@ -111,6 +147,24 @@ class QueryListener {
   model::OnlineState online_state_ = model::OnlineState::Unknown;
 
   absl::optional<ViewSnapshot> snapshot_;
+
+  std::shared_ptr<util::AsyncQueue> worker_queue_;
+
+  /** When the last user-facing event was raised. */
+  util::Executor::TimePoint last_event_time_;
+
+  /**
+   * The snapshots received since the last event, coalesced into one, while
+   * waiting for the minimum snapshot interval to elapse.
+   */
+  absl::optional<ViewSnapshot> pending_snapshot_;
+
+  /** The last received snapshot before `pending_snapshot_` started. */
+  absl::optional<ViewSnapshot> snapshot_before_pending_;
+
+  util::DelayedOperation pending_snapshot_operation_;
+
+  std::function<void(bool)> pending_snapshot_callback_;
 };
 
 }  // namespace core
@@ -16,6 +16,8 @@
 
 #include "Firestore/core/src/core/sync_engine.h"
 
+#include <chrono>  // NOLINT(build/c++11)
+
 #include "Firestore/core/include/firebase/firestore/firestore_errors.h"
 #include "Firestore/core/src/bundle/bundle_element.h"
 #include "Firestore/core/src/bundle/bundle_loader.h"
@@ -36,6 +38,7 @@
 #include "Firestore/core/src/model/mutation_batch_result.h"
 #include "Firestore/core/src/util/async_queue.h"
 #include "Firestore/core/src/util/log.h"
+#include "Firestore/core/src/util/metrics.h"
 #include "Firestore/core/src/util/status.h"
 #include "absl/strings/match.h"
 
@@ -86,6 +89,14 @@ bool ErrorIsInteresting(const Status& error) {
   return missing_index || no_permission;
 }
 
+/** The time spent recomputing views after local or remote changes. */
+util::MetricHistogram& ViewRecomputeMicros() {
+  static util::MetricHistogram& histogram =
+      util::MetricsRegistry::GetInstance().GetHistogram(
+          "sync_engine.view_recompute_micros");
+  return histogram;
+}
+
 }  // namespace
 
 SyncEngine::SyncEngine(LocalStore* local_store,
@@ -129,8 +140,16 @@ TargetId SyncEngine::Listen(Query query, bool should_listen_to_remote) {
 
 ViewSnapshot SyncEngine::InitializeViewAndComputeSnapshot(
     const Query& query, TargetId target_id, nanopb::ByteString resume_token) {
+  // Views are kept up to date with every local and remote change, so a live
+  // view whose query subsumes the new one already holds all of its candidate
+  // results and the local query can be skipped.
+  std::shared_ptr<QueryView> subsuming_view = FindSubsumingQueryView(query);
   QueryResult query_result =
-      local_store_->ExecuteQuery(query, /* use_previous_results= */ true);
+      subsuming_view
+          ? QueryResult(subsuming_view->view().documents().documents_by_key(),
+                        local_store_->GetRemoteDocumentKeys(target_id))
+          : local_store_->ExecuteQuery(query,
+                                       /* use_previous_results= */ true);
 
   // If there are already queries mapped to the target id, create a synthesized
   // target change to apply the sync state from those queries to the new query.
@@ -163,6 +182,16 @@ ViewSnapshot SyncEngine::InitializeViewAndComputeSnapshot(
   return view_change.snapshot().value();
 }
 
+std::shared_ptr<SyncEngine::QueryView> SyncEngine::FindSubsumingQueryView(
+    const Query& query) const {
+  for (const auto& entry : query_views_by_query_) {
+    if (entry.first.Subsumes(query)) {
+      return entry.second;
+    }
+  }
+  return nullptr;
+}
+
 void SyncEngine::ListenToRemoteStore(Query query) {
   AssertCallbackExists("ListenToRemoteStore");
   TargetData target_data = local_store_->AllocateTarget(query.ToTarget());
@@ -508,6 +537,7 @@ void SyncEngine::EmitNewSnapshotsAndNotifyLocalStore(
   std::vector<ViewSnapshot> new_snapshots;
   std::vector<LocalViewChanges> document_changes_in_all_views;
 
+  auto start = std::chrono::steady_clock::now();
   for (const auto& entry : query_views_by_query_) {
     const auto& query_view = entry.second;
     View& view = query_view->view();
@@ -552,6 +582,7 @@ void SyncEngine::EmitNewSnapshotsAndNotifyLocalStore(
       document_changes_in_all_views.push_back(std::move(doc_changes));
     }
   }
+  ViewRecomputeMicros().RecordMicrosSince(start);
 
   sync_engine_callback_->OnViewSnapshots(std::move(new_snapshots));
   local_store_->NotifyLocalViewChanges(document_changes_in_all_views);
@@ -264,6 +264,12 @@ class SyncEngine : public remote::RemoteStoreCallback, public QueryEventSource {
       model::TargetId target_id,
       nanopb::ByteString resume_token);
 
+  /**
+   * Returns the view of an active query that subsumes `query`, or nullptr if
+   * there is none. See `Query::Subsumes()`.
+   */
+  std::shared_ptr<QueryView> FindSubsumingQueryView(const Query& query) const;
+
   void RemoveAndCleanupTarget(model::TargetId target_id, util::Status status);
   void StopListeningAndReleaseTarget(const Query& query,
                                      bool should_stop_remote_listening,
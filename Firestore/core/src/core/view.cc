@@ -63,21 +63,28 @@ ViewDocumentChanges::ViewDocumentChanges(model::DocumentSet new_documents,
 
 namespace {
 
-int GetDocumentViewChangeTypePosition(DocumentViewChange::Type change_type) {
-  switch (change_type) {
-    case DocumentViewChange::Type::Removed:
-      return 0;
-    case DocumentViewChange::Type::Added:
-      return 1;
-    case DocumentViewChange::Type::Modified:
-      return 2;
-    case DocumentViewChange::Type::Metadata:
-      // A metadata change is converted to a modified change at the public API
-      // layer. Since we sort by document key and then change type, metadata and
-      // modified changes must be sorted equivalently.
-      return 2;
+/**
+ * Returns whether the two documents have the same contents, using the cached
+ * content fingerprints to avoid a deep comparison where possible.
+ */
+bool DocumentContentsEqual(const Document& old_doc, const Document& new_doc) {
+  if (&old_doc->data() == &new_doc->data()) {
+    return true;
+  }
+
+  if (old_doc->data().Fingerprint() != new_doc->data().Fingerprint()) {
+    return false;
   }
-  HARD_FAIL("Unknown DocumentViewChange::Type %s", change_type);
+
+  // The backend assigns a new update time whenever a document changes, so
+  // synced documents at the same version hold the same contents and the
+  // matching fingerprint merely confirms it.
+  if (old_doc->version() == new_doc->version() &&
+      !old_doc->has_pending_writes() && !new_doc->has_pending_writes()) {
+    return true;
+  }
+
+  return old_doc->value() == new_doc->value();
 }
 
 }  // namespace
@@ -149,7 +156,7 @@ ViewDocumentChanges View::ComputeDocumentChanges(
     bool change_applied = false;
     // Calculate change
     if (old_doc && new_doc) {
-      bool docs_equal = (*old_doc)->value() == (*new_doc)->value();
+      bool docs_equal = DocumentContentsEqual(*old_doc, *new_doc);
       if (!docs_equal) {
         if (!ShouldWaitForSyncedDocument(*new_doc, *old_doc)) {
           change_set.AddChange(
@@ -258,17 +265,7 @@ ViewChange View::ApplyChanges(const ViewDocumentChanges& doc_changes,
 
   // Sort changes based on type and query comparator.
   std::vector<DocumentViewChange> changes =
-      doc_changes.change_set().GetChanges();
-  std::sort(
-      changes.begin(), changes.end(),
-      [this](const DocumentViewChange& lhs, const DocumentViewChange& rhs) {
-        int pos1 = GetDocumentViewChangeTypePosition(lhs.type());
-        int pos2 = GetDocumentViewChangeTypePosition(rhs.type());
-        if (pos1 != pos2) {
-          return pos1 < pos2;
-        }
-        return util::Ascending(Compare(lhs.document(), rhs.document()));
-      });
+      doc_changes.change_set().GetSortedChanges(document_set_.comparator());
 
   ApplyTargetChange(target_change);
   std::vector<LimboDocumentChange> limbo_changes =
@@ -145,6 +145,11 @@ class View {
     return synced_documents_;
   }
 
+  /** The documents currently in the view, including local changes. */
+  const model::DocumentSet& documents() const {
+    return document_set_;
+  }
+
   /**
    * Iterates over a set of doc changes, applies the query limit, and computes
    * what the new results should be, what the changes were, and whether we may
@@ -16,9 +16,11 @@
 
 #include "Firestore/core/src/core/view_snapshot.h"
 
+#include <algorithm>
 #include <ostream>
 
 #include "Firestore/core/src/model/document_set.h"
+#include "Firestore/core/src/util/comparison.h"
 #include "Firestore/core/src/util/hashing.h"
 #include "Firestore/core/src/util/string_format.h"
 #include "Firestore/core/src/util/to_string.h"
@@ -33,6 +35,27 @@ using model::DocumentKeySet;
 using model::DocumentSet;
 using util::StringFormat;
 
+namespace {
+
+int GetDocumentViewChangeTypePosition(DocumentViewChange::Type change_type) {
+  switch (change_type) {
+    case DocumentViewChange::Type::Removed:
+      return 0;
+    case DocumentViewChange::Type::Added:
+      return 1;
+    case DocumentViewChange::Type::Modified:
+      return 2;
+    case DocumentViewChange::Type::Metadata:
+      // A metadata change is converted to a modified change at the public API
+      // layer. Since we sort by document key and then change type, metadata and
+      // modified changes must be sorted equivalently.
+      return 2;
+  }
+  HARD_FAIL("Unknown DocumentViewChange::Type %s", change_type);
+}
+
+}  // namespace
+
 // DocumentViewChange
 
 DocumentViewChange::DocumentViewChange(Document document, Type type)
@@ -130,6 +153,23 @@ std::vector<DocumentViewChange> DocumentViewChangeSet::GetChanges() const {
   return changes;
 }
 
+std::vector<DocumentViewChange> DocumentViewChangeSet::GetSortedChanges(
+    const model::DocumentComparator& comparator) const {
+  std::vector<DocumentViewChange> changes = GetChanges();
+  std::sort(changes.begin(), changes.end(),
+            [&comparator](const DocumentViewChange& lhs,
+                          const DocumentViewChange& rhs) {
+              int pos1 = GetDocumentViewChangeTypePosition(lhs.type());
+              int pos2 = GetDocumentViewChangeTypePosition(rhs.type());
+              if (pos1 != pos2) {
+                return pos1 < pos2;
+              }
+              return util::Ascending(
+                  comparator.Compare(lhs.document(), rhs.document()));
+            });
+  return changes;
+}
+
 std::string DocumentViewChangeSet::ToString() const {
   return util::ToString(change_map_);
 }
@@ -179,6 +219,34 @@ ViewSnapshot ViewSnapshot::FromInitialDocuments(Query query,
                       has_cached_results};
 }
 
+ViewSnapshot ViewSnapshot::Coalesce(const ViewSnapshot& earlier,
+                                    const ViewSnapshot& later) {
+  DocumentViewChangeSet change_set;
+  for (const DocumentViewChange& change : earlier.document_changes()) {
+    change_set.AddChange(DocumentViewChange{change});
+  }
+  for (const DocumentViewChange& change : later.document_changes()) {
+    change_set.AddChange(DocumentViewChange{change});
+  }
+
+  // `sync_state_changed` is relative to the snapshot preceding `earlier`.
+  bool initial_from_cache = earlier.sync_state_changed()
+                                ? !earlier.from_cache()
+                                : earlier.from_cache();
+  std::vector<DocumentViewChange> changes =
+      change_set.GetSortedChanges(later.documents().comparator());
+
+  return ViewSnapshot{later.query(),
+                      later.documents(),
+                      earlier.old_documents(),
+                      std::move(changes),
+                      later.mutated_keys(),
+                      later.from_cache(),
+                      initial_from_cache != later.from_cache(),
+                      later.excludes_metadata_changes(),
+                      later.has_cached_results()};
+}
+
 const Query& ViewSnapshot::query() const {
   return query_;
 }
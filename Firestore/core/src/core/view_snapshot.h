@@ -84,6 +84,13 @@ class DocumentViewChangeSet {
   /** Returns the set of all changes tracked in this set. */
   std::vector<DocumentViewChange> GetChanges() const;
 
+  /**
+   * Returns the set of all changes tracked in this set, sorted by change type
+   * and then by the given document comparator.
+   */
+  std::vector<DocumentViewChange> GetSortedChanges(
+      const model::DocumentComparator& comparator) const;
+
   std::string ToString() const;
 
  private:
@@ -118,6 +125,14 @@ class ViewSnapshot {
                                            bool excludes_metadata_changes,
                                            bool has_cached_results);
 
+  /**
+   * Returns a single view snapshot that describes the changes of `earlier`
+   * followed by those of `later`, as if the view had only raised the combined
+   * snapshot. `later` must directly follow `earlier` for the same query.
+   */
+  static ViewSnapshot Coalesce(const ViewSnapshot& earlier,
+                               const ViewSnapshot& later);
+
   /** The query this view is tracking the results for. */
   const Query& query() const;
 
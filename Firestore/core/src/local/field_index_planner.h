@@ -0,0 +1,96 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_LOCAL_FIELD_INDEX_PLANNER_H_
+#define FIRESTORE_CORE_SRC_LOCAL_FIELD_INDEX_PLANNER_H_
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/core/target.h"
+#include "Firestore/core/src/index/index_entry.h"
+#include "Firestore/core/src/local/index_manager.h"
+#include "Firestore/core/src/model/field_index.h"
+#include "Firestore/core/src/model/model_fwd.h"
+#include "absl/types/optional.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+// Storage independent parts of field index maintenance and query planning,
+// shared by LevelDbIndexManager and MemoryIndexManager.
+
+/**
+ * A range of index entries of a single index. Entries are compared by array
+ * value and then directional value only: the range contains every entry that
+ * sorts at or after `lower` and before `upper`.
+ */
+struct IndexEntryRange {
+  index::IndexEntry lower;
+  index::IndexEntry upper;
+};
+
+/**
+ * Splits the target into sub-targets, one per term of the disjunctive normal
+ * form of its filters. Targets without OR filters have a single sub-target.
+ */
+std::vector<core::Target> GetDnfSubTargets(const core::Target& target);
+
+/** Returns the collection group whose indexes can serve the given target. */
+std::string GetTargetCollectionGroup(const core::Target& target);
+
+/**
+ * Returns the index among `collection_indexes` with the most segments that can
+ * serve the given (sub-)target, or `nullopt` if none can.
+ */
+absl::optional<model::FieldIndex> SelectFieldIndex(
+    const core::Target& target,
+    const std::vector<model::FieldIndex>& collection_indexes);
+
+/**
+ * Combines the index types of the given sub-targets of `target`, where
+ * `indexes[i]` is the index selected for `sub_targets[i]`.
+ */
+IndexManager::IndexType GetCombinedIndexType(
+    const core::Target& target,
+    const std::vector<core::Target>& sub_targets,
+    const std::vector<absl::optional<model::FieldIndex>>& indexes);
+
+/**
+ * Returns the smallest offset of the given indexes, combined with the largest
+ * batch ID of any of them. `indexes` must not be empty.
+ */
+model::IndexOffset GetMinIndexOffset(
+    const std::vector<model::FieldIndex>& indexes);
+
+/**
+ * Returns the sorted, non-overlapping ranges of `index` that contain the
+ * entries of documents that can match `sub_target`.
+ */
+std::vector<IndexEntryRange> GetIndexEntryRanges(
+    const model::FieldIndex& index, const core::Target& sub_target);
+
+/** Creates the index entries for the given document. */
+std::set<index::IndexEntry> ComputeIndexEntries(
+    const model::Document& document, const model::FieldIndex& index);
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_LOCAL_FIELD_INDEX_PLANNER_H_
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/local/leveldb_collection_path_ids.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "Firestore/core/src/local/leveldb_key.h"
+#include "Firestore/core/src/local/leveldb_transaction.h"
+#include "Firestore/core/src/util/hard_assert.h"
+#include "absl/strings/match.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+using model::ResourcePath;
+
+LevelDbCollectionPathIds LevelDbCollectionPathIds::Load(
+    LevelDbTransaction* transaction) {
+  LevelDbCollectionPathIds result;
+
+  std::string prefix = LevelDbCollectionPathIdKey::KeyPrefix();
+  auto it = transaction->NewIterator();
+  LevelDbCollectionPathIdKey row_key;
+  for (it->Seek(prefix); it->Valid() && absl::StartsWith(it->key(), prefix);
+       it->Next()) {
+    HARD_ASSERT(row_key.Decode(it->key()),
+                "Failed to decode collection path ID key");
+    result.Insert(row_key.collection_path(), row_key.collection_path_id());
+  }
+
+  return result;
+}
+
+absl::optional<int64_t> LevelDbCollectionPathIds::Find(
+    const ResourcePath& collection_path) const {
+  auto found = ids_.find(collection_path.CanonicalString());
+  if (found == ids_.end()) {
+    return absl::nullopt;
+  }
+  return found->second;
+}
+
+int64_t LevelDbCollectionPathIds::Intern(const ResourcePath& collection_path,
+                                         LevelDbTransaction* transaction) {
+  absl::optional<int64_t> existing = Find(collection_path);
+  if (existing) {
+    return *existing;
+  }
+
+  int64_t collection_path_id = next_id_;
+  transaction->Put(
+      LevelDbCollectionPathIdKey::Key(collection_path, collection_path_id),
+      "");
+  Insert(collection_path, collection_path_id);
+  return collection_path_id;
+}
+
+void LevelDbCollectionPathIds::Insert(const ResourcePath& collection_path,
+                                      int64_t collection_path_id) {
+  ids_[collection_path.CanonicalString()] = collection_path_id;
+  next_id_ = std::max(next_id_, collection_path_id + 1);
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
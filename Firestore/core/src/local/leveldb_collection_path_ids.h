@@ -0,0 +1,69 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_LOCAL_LEVELDB_COLLECTION_PATH_IDS_H_
+#define FIRESTORE_CORE_SRC_LOCAL_LEVELDB_COLLECTION_PATH_IDS_H_
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+#include "Firestore/core/src/model/resource_path.h"
+#include "absl/types/optional.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+class LevelDbTransaction;
+
+/**
+ * An in-memory copy of the collection_path_id table, which interns collection
+ * paths as small integer IDs for use in compact keys.
+ *
+ * The table is small (one row per collection that ever held a document), so it
+ * is read once in full and then kept in sync by `Intern()`, which writes new
+ * assignments through the given transaction.
+ */
+class LevelDbCollectionPathIds {
+ public:
+  /** Reads all ID assignments visible to the given transaction. */
+  static LevelDbCollectionPathIds Load(LevelDbTransaction* transaction);
+
+  /** Returns the ID assigned to the given collection path, if any. */
+  absl::optional<int64_t> Find(
+      const model::ResourcePath& collection_path) const;
+
+  /**
+   * Returns the ID assigned to the given collection path, assigning the next
+   * unused ID and writing it to `transaction` if the path has none yet.
+   */
+  int64_t Intern(const model::ResourcePath& collection_path,
+                 LevelDbTransaction* transaction);
+
+ private:
+  void Insert(const model::ResourcePath& collection_path,
+              int64_t collection_path_id);
+
+  std::unordered_map<std::string, int64_t> ids_;
+  int64_t next_id_ = 1;
+};
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_LOCAL_LEVELDB_COLLECTION_PATH_IDS_H_
@@ -0,0 +1,105 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/local/leveldb_field_name_ids.h"
+
+#include <utility>
+
+#include "Firestore/core/src/local/leveldb_key.h"
+#include "Firestore/core/src/local/leveldb_transaction.h"
+#include "Firestore/core/src/util/hard_assert.h"
+#include "Firestore/core/src/util/no_destructor.h"
+#include "absl/strings/match.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+using util::NoDestructor;
+
+constexpr size_t LevelDbFieldNameIds::kMaxFieldNamesPerCollection;
+
+LevelDbFieldNameIds LevelDbFieldNameIds::Load(
+    LevelDbTransaction* transaction) {
+  LevelDbFieldNameIds result;
+
+  std::string prefix = LevelDbFieldNameIdKey::KeyPrefix();
+  auto it = transaction->NewIterator();
+  LevelDbFieldNameIdKey row_key;
+  for (it->Seek(prefix); it->Valid() && absl::StartsWith(it->key(), prefix);
+       it->Next()) {
+    HARD_ASSERT(row_key.Decode(it->key()),
+                "Failed to decode field name ID key");
+    result.Insert(row_key.collection_path_id(), row_key.field_name_id(),
+                  row_key.field_name());
+  }
+
+  return result;
+}
+
+std::shared_ptr<const LevelDbFieldNameIds::FieldNames>
+LevelDbFieldNameIds::Names(int64_t collection_path_id) const {
+  auto found = dictionaries_.find(collection_path_id);
+  if (found == dictionaries_.end()) {
+    static NoDestructor<std::shared_ptr<const FieldNames>> empty(
+        std::make_shared<const FieldNames>());
+    return *empty;
+  }
+  return found->second.names;
+}
+
+absl::optional<int64_t> LevelDbFieldNameIds::Intern(
+    int64_t collection_path_id,
+    absl::string_view field_name,
+    LevelDbTransaction* transaction) {
+  Dictionary& dictionary = dictionaries_[collection_path_id];
+  auto found = dictionary.ids.find(field_name);
+  if (found != dictionary.ids.end()) {
+    return found->second;
+  }
+  if (dictionary.names->size() >= kMaxFieldNamesPerCollection) {
+    return absl::nullopt;
+  }
+
+  auto field_name_id = static_cast<int64_t>(dictionary.names->size());
+  transaction->Put(
+      LevelDbFieldNameIdKey::Key(collection_path_id, field_name_id, field_name),
+      "");
+  Insert(collection_path_id, field_name_id, std::string(field_name));
+  return field_name_id;
+}
+
+void LevelDbFieldNameIds::Insert(int64_t collection_path_id,
+                                 int64_t field_name_id,
+                                 std::string field_name) {
+  Dictionary& dictionary = dictionaries_[collection_path_id];
+  HARD_ASSERT(
+      field_name_id == static_cast<int64_t>(dictionary.names->size()),
+      "Field name ID %s of collection %s does not follow the previous ID",
+      field_name_id, collection_path_id);
+
+  // Snapshots returned by `Names()` must never change, so names are only
+  // appended in place while no snapshot refers to the vector.
+  if (dictionary.names.use_count() > 1) {
+    dictionary.names = std::make_shared<FieldNames>(*dictionary.names);
+  }
+  dictionary.ids[field_name] = field_name_id;
+  dictionary.names->push_back(std::move(field_name));
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
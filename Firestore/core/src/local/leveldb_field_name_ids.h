@@ -0,0 +1,100 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_LOCAL_LEVELDB_FIELD_NAME_IDS_H_
+#define FIRESTORE_CORE_SRC_LOCAL_LEVELDB_FIELD_NAME_IDS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+class LevelDbTransaction;
+
+/**
+ * An in-memory copy of the field_name_id table, which keeps a dictionary of
+ * field names for each collection so that documents in the compact format can
+ * refer to their map keys by small integer IDs.
+ *
+ * Like `LevelDbCollectionPathIds`, the table is read once in full and then
+ * kept in sync by `Intern()`. Each dictionary holds at most
+ * `kMaxFieldNamesPerCollection` names; documents spell out any others.
+ *
+ * Calls must be serialized by the caller, but the snapshots returned by
+ * `Names()` may be read from any thread without synchronization.
+ */
+class LevelDbFieldNameIds {
+ public:
+  /**
+   * The most field names assigned IDs in a single collection. Collections with
+   * a uniform schema need far fewer; the limit keeps collections whose
+   * documents use arbitrary map keys from growing the table without bound.
+   */
+  static constexpr size_t kMaxFieldNamesPerCollection = 4096;
+
+  /** Field names indexed by their ID. */
+  using FieldNames = std::vector<std::string>;
+
+  /** Reads all ID assignments visible to the given transaction. */
+  static LevelDbFieldNameIds Load(LevelDbTransaction* transaction);
+
+  /**
+   * Returns the field names of the given collection, indexed by ID. The
+   * returned names are an immutable snapshot that can be read while further
+   * names are interned.
+   */
+  std::shared_ptr<const FieldNames> Names(int64_t collection_path_id) const;
+
+  /**
+   * Returns the ID assigned to `field_name` in the given collection, assigning
+   * the next unused ID and writing it to `transaction` if the name has none
+   * yet. Returns nullopt if the collection's dictionary is full.
+   */
+  absl::optional<int64_t> Intern(int64_t collection_path_id,
+                                 absl::string_view field_name,
+                                 LevelDbTransaction* transaction);
+
+ private:
+  struct Dictionary {
+    // Looked up by string_view for every map key of every document written.
+    absl::flat_hash_map<std::string, int64_t> ids;
+
+    // Copied before being appended to whenever a snapshot of it is in use.
+    std::shared_ptr<FieldNames> names = std::make_shared<FieldNames>();
+  };
+
+  void Insert(int64_t collection_path_id,
+              int64_t field_name_id,
+              std::string field_name);
+
+  std::unordered_map<int64_t, Dictionary> dictionaries_;
+};
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_LOCAL_LEVELDB_FIELD_NAME_IDS_H_
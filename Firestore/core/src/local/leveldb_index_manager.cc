@@ -25,12 +25,12 @@
 #include <utility>
 #include <vector>
 
-#include "Firestore/core/src/core/composite_filter.h"
 #include "Firestore/core/src/core/query.h"
 #include "Firestore/core/src/credentials/user.h"
 #include "Firestore/core/src/index/firestore_index_value_writer.h"
 #include "Firestore/core/src/index/index_byte_encoder.h"
 #include "Firestore/core/src/index/index_entry.h"
+#include "Firestore/core/src/local/field_index_planner.h"
 #include "Firestore/core/src/local/leveldb_key.h"
 #include "Firestore/core/src/local/leveldb_persistence.h"
 #include "Firestore/core/src/local/leveldb_util.h"
@@ -43,7 +43,6 @@
 #include "Firestore/core/src/util/comparison.h"
 #include "Firestore/core/src/util/hard_assert.h"
 #include "Firestore/core/src/util/log.h"
-#include "Firestore/core/src/util/logic_utils.h"
 #include "Firestore/core/src/util/set_util.h"
 #include "Firestore/core/src/util/string_util.h"
 #include "Firestore/third_party/nlohmann_json/json.hpp"
@@ -54,8 +53,6 @@ namespace firebase {
 namespace firestore {
 namespace local {
 
-using core::CompositeFilter;
-using core::Filter;
 using core::Target;
 using credentials::User;
 using index::DirectionalIndexByteEncoder;
@@ -69,7 +66,6 @@ using model::ResourcePath;
 using model::SnapshotVersion;
 using model::TargetIndexMatcher;
 using nlohmann::json;
-using util::LogicUtils;
 
 namespace {
 
@@ -108,77 +104,6 @@ std::string EncodeIndexState(const IndexState& state) {
       .dump();
 }
 
-bool IsInFilter(const Target& target, const model::FieldPath& field_path) {
-  for (const auto& filter : target.filters()) {
-    if (filter.IsAFieldFilter()) {
-      const core::FieldFilter field_filter(filter);
-      if (field_filter.field() != field_path) {
-        continue;
-      }
-      if (field_filter.op() == core::FieldFilter::Operator::In ||
-          field_filter.op() == core::FieldFilter::Operator::NotIn) {
-        return true;
-      }
-    }
-  }
-
-  return false;
-}
-
-/**
- * Creates a separate encoder buffer for each element of an array.
- *
- * The method appends each value to all existing encoders (e.g. filter("a",
- * "==", "a1").filter("b", "in", ["b1", "b2"]) becomes ["a1,b1", "a1,b2"]). A
- * list of new encoders is returned.
- */
-std::vector<IndexEncodingBuffer> ExpandIndexValues(
-    const std::vector<IndexEncodingBuffer>& buffers,
-    const model::Segment& segment,
-    const google_firestore_v1_Value& value) {
-  std::vector<IndexEncodingBuffer> results;
-  for (size_t idx = 0; idx < value.array_value.values_count; ++idx) {
-    for (const IndexEncodingBuffer& buf : buffers) {
-      IndexEncodingBuffer cloned_buf;
-      cloned_buf.Seed(buf.GetEncodedBytes());
-      WriteIndexValue(value.array_value.values[idx],
-                      cloned_buf.ForKind(segment.kind()));
-      results.push_back(std::move(cloned_buf));
-    }
-  }
-  return results;
-}
-
-/** Returns the byte representation for all encoders. */
-std::vector<std::string> GetEncodedBytes(
-    const std::vector<IndexEncodingBuffer>& buffers) {
-  std::vector<std::string> result;
-  for (const auto& buf : buffers) {
-    result.push_back(buf.GetEncodedBytes());
-  }
-  return result;
-}
-
-/** Generates the lower bound for `arrayValue` and `directionalValue`. */
-IndexEntry GenerateLowerBound(int32_t index_id,
-                              const std::string& array_value,
-                              const std::string& directional_value,
-                              bool inclusive) {
-  IndexEntry entry{index_id, DocumentKey::Empty(), array_value,
-                   directional_value};
-  return inclusive ? entry : entry.Successor();
-}
-
-/** Generates the upper bound for `arrayValue` and `directionalValue`. */
-IndexEntry GenerateUpperBound(int32_t index_id,
-                              const std::string& array_value,
-                              const std::string& directional_value,
-                              bool inclusive) {
-  IndexEntry entry{index_id, DocumentKey::Empty(), array_value,
-                   directional_value};
-  return inclusive ? entry.Successor() : entry;
-}
-
 }  // namespace
 
 LevelDbIndexManager::LevelDbIndexManager(const User& user,
@@ -438,30 +363,8 @@ absl::optional<model::FieldIndex> LevelDbIndexManager::GetFieldIndex(
     const core::Target& target) const {
   HARD_ASSERT(started_, "IndexManager not started");
 
-  TargetIndexMatcher target_index_matcher(target);
-  std::string collection_group = target.collection_group() != nullptr
-                                     ? (*target.collection_group())
-                                     : target.path().last_segment();
-
-  std::vector<FieldIndex> collection_indexes =
-      GetFieldIndexes(collection_group);
-  if (collection_indexes.empty()) {
-    return absl::nullopt;
-  }
-
-  absl::optional<FieldIndex> result;
-  for (FieldIndex index : collection_indexes) {
-    if (target_index_matcher.ServedByIndex(index)) {
-      if (!result.has_value() ||
-          result.value().segments().size() < index.segments().size()) {
-        // `index` serves the target, and it has more segments than the current
-        // `result`.
-        result = std::move(index);
-      }
-    }
-  }
-
-  return result;
+  return SelectFieldIndex(target,
+                          GetFieldIndexes(GetTargetCollectionGroup(target)));
 }
 
 void LevelDbIndexManager::DeleteAllFieldIndexes() {
@@ -497,65 +400,22 @@ model::IndexOffset LevelDbIndexManager::GetMinOffset(
       indexes.push_back(index_opt.value());
     }
   }
-  return GetMinOffset(indexes);
+  return GetMinIndexOffset(indexes);
 }
 
 model::IndexOffset LevelDbIndexManager::GetMinOffset(
     const std::string& collection_group) const {
-  const std::vector<model::FieldIndex> field_indexes =
-      GetFieldIndexes(collection_group);
-  return GetMinOffset(field_indexes);
-}
-
-model::IndexOffset LevelDbIndexManager::GetMinOffset(
-    const std::vector<model::FieldIndex>& indexes) const {
-  HARD_ASSERT(
-      !indexes.empty(),
-      "Found empty index group when looking for least recent index offset.");
-
-  auto it = indexes.cbegin();
-  const model::IndexOffset* min_offset =
-      &((it++)->index_state().index_offset());
-  int max_batch_id = min_offset->largest_batch_id();
-  for (; it != indexes.cend(); it++) {
-    const model::IndexOffset* new_offset = &(it->index_state().index_offset());
-    if (new_offset->CompareTo(*min_offset) ==
-        util::ComparisonResult::Ascending) {
-      min_offset = new_offset;
-    }
-    max_batch_id = std::max(max_batch_id, new_offset->largest_batch_id());
-  }
-
-  return {min_offset->read_time(), min_offset->document_key(), max_batch_id};
+  return GetMinIndexOffset(GetFieldIndexes(collection_group));
 }
 
 IndexManager::IndexType LevelDbIndexManager::GetIndexType(
     const core::Target& target) {
-  IndexManager::IndexType result = IndexManager::IndexType::FULL;
-  const auto sub_targets = GetSubTargets(target);
-
+  std::vector<Target> sub_targets = GetSubTargets(target);
+  std::vector<absl::optional<FieldIndex>> indexes;
   for (const Target& sub_target : sub_targets) {
-    absl::optional<model::FieldIndex> index = GetFieldIndex(sub_target);
-    if (!index) {
-      result = IndexManager::IndexType::NONE;
-      break;
-    }
-
-    if (index.value().segments().size() < sub_target.GetSegmentCount()) {
-      result = IndexManager::IndexType::PARTIAL;
-    }
-  }
-
-  // OR queries have more than one sub-target (one sub-target per DNF term).
-  // We currently consider OR queries that have a `limit` to have a partial
-  // index. For such queries we perform sorting and apply the limit in memory as
-  // a post-processing step.
-  if (target.HasLimit() && sub_targets.size() > 1U &&
-      result == IndexManager::IndexType::FULL) {
-    result = IndexManager::IndexType::PARTIAL;
+    indexes.push_back(GetFieldIndex(sub_target));
   }
-
-  return result;
+  return GetCombinedIndexType(target, sub_targets, indexes);
 }
 
 absl::optional<std::vector<model::DocumentKey>>
@@ -578,24 +438,20 @@ LevelDbIndexManager::GetDocumentsMatchingTarget(const core::Target& target) {
     LOG_DEBUG("Using index %s to execute target %s", index.collection_group(),
               sub_target.CanonicalId());
 
-    auto array_values = sub_target.GetArrayValues(index);
-    auto not_in_values = sub_target.GetNotInValues(index);
-    auto lower_bound = sub_target.GetLowerBound(index);
-    auto upper_bound = sub_target.GetUpperBound(index);
-
-    auto encoded_lower = EncodeBound(index, sub_target, lower_bound);
-    auto encoded_upper = EncodeBound(index, sub_target, upper_bound);
-    auto encoded_not_in = EncodeValues(index, sub_target, not_in_values);
-
-    auto index_ranges = GenerateIndexRanges(
-        index.index_id(), array_values, encoded_lower, lower_bound.inclusive,
-        encoded_upper, upper_bound.inclusive, encoded_not_in);
-
     auto iter = db_->current_transaction()->NewIterator();
-    for (const auto& range : index_ranges) {
+    std::vector<IndexEntryRange> ranges =
+        GetIndexEntryRanges(index, sub_target);
+    for (const IndexEntryRange& range : ranges) {
+      std::string lower = LevelDbIndexEntryKey::KeyPrefix(
+          range.lower.index_id(), uid_, range.lower.array_value(),
+          range.lower.directional_value());
+      std::string upper = LevelDbIndexEntryKey::KeyPrefix(
+          range.upper.index_id(), uid_, range.upper.array_value(),
+          range.upper.directional_value());
+
       int32_t count = 0;
-      for (iter->Seek(range.lower); iter->Valid() && count < target.limit() &&
-                                    iter->key() <= range.upper;
+      for (iter->Seek(lower);
+           iter->Valid() && count < target.limit() && iter->key() <= upper;
            iter->Next()) {
         LevelDbIndexEntryKey entry_key;
         if (!entry_key.Decode(iter->key())) {
@@ -616,139 +472,6 @@ LevelDbIndexManager::GetDocumentsMatchingTarget(const core::Target& target) {
   return result;
 }
 
-std::vector<std::string> LevelDbIndexManager::EncodeBound(
-    const FieldIndex& index,
-    const Target& target,
-    const core::IndexBoundValues& bound) {
-  return EncodeValues(index, target, bound.values);
-}
-
-std::vector<std::string> LevelDbIndexManager::EncodeValues(
-    const FieldIndex& index,
-    const Target& target,
-    core::IndexedValues bound_values) {
-  if (!bound_values.has_value()) {
-    return {};
-  }
-
-  std::vector<IndexEncodingBuffer> buffers = {};
-  buffers.emplace_back();
-
-  size_t bound_idx = 0;
-  for (const auto& segment : index.GetDirectionalSegments()) {
-    const google_firestore_v1_Value& value = bound_values.value()[bound_idx++];
-    if (IsInFilter(target, segment.field_path()) && model::IsArray(value)) {
-      buffers = ExpandIndexValues(buffers, segment, value);
-    } else {
-      for (auto& buffer : buffers) {
-        auto* encoder = buffer.ForKind(segment.kind());
-        WriteIndexValue(value, encoder);
-      }
-    }
-  }
-  return GetEncodedBytes(buffers);
-}
-
-std::vector<LevelDbIndexManager::IndexRange>
-LevelDbIndexManager::GenerateIndexRanges(
-    int32_t index_id,
-    core::IndexedValues array_values,
-    const std::vector<std::string>& lower_bounds,
-    bool lower_bounds_inclusive,
-    const std::vector<std::string>& upper_bounds,
-    bool upper_bounds_inclusive,
-    std::vector<std::string> not_in_values) {
-  // The number of total index scans we union together. This is similar to a
-  // disjunctive normal form, but adapted for array values. We create a single
-  // index range per value in an ARRAY_CONTAINS or ARRAY_CONTAINS_ANY filter
-  // combined with the values from the query bounds.
-  size_t total_scans = (array_values.has_value() ? array_values->size() : 1) *
-                       std::max(lower_bounds.size(), upper_bounds.size());
-  size_t scans_per_array_element =
-      total_scans / (array_values.has_value() ? array_values->size() : 1);
-
-  std::vector<IndexRange> index_ranges;
-  for (size_t i = 0; i < total_scans; ++i) {
-    std::string array_value =
-        array_values.has_value()
-            ? EncodeSingleElement(
-                  array_values.value()[i / scans_per_array_element])
-            : "";
-
-    IndexEntry lower_bound = GenerateLowerBound(
-        index_id, array_value, lower_bounds[i % scans_per_array_element],
-        lower_bounds_inclusive);
-    IndexEntry upper_bound = GenerateUpperBound(
-        index_id, array_value, upper_bounds[i % scans_per_array_element],
-        upper_bounds_inclusive);
-
-    std::vector<IndexEntry> not_in_bounds;
-    for (const auto& not_in : not_in_values) {
-      not_in_bounds.push_back(GenerateLowerBound(index_id, array_value, not_in,
-                                                 /* inclusive= */ true));
-    }
-
-    auto new_range =
-        CreateRange(lower_bound, upper_bound, std::move(not_in_bounds));
-    index_ranges.insert(index_ranges.end(), new_range.begin(), new_range.end());
-  }
-
-  return index_ranges;
-}
-
-std::vector<LevelDbIndexManager::IndexRange> LevelDbIndexManager::CreateRange(
-    const index::IndexEntry& lower_bound,
-    const index::IndexEntry& upper_bound,
-    std::vector<index::IndexEntry> not_in_values) const {
-  // The `not_in_values` need to be sorted and unique so that we can return a
-  // sorted set of non-overlapping ranges.
-  std::sort(not_in_values.begin(), not_in_values.end(),
-            [](const IndexEntry& left, const IndexEntry& right) {
-              return left.CompareTo(right) == util::ComparisonResult::Ascending;
-            });
-  std::vector<index::IndexEntry> sorted_unique_not_in;
-  for (size_t idx = 0; idx < not_in_values.size(); ++idx) {
-    if (idx == 0 || not_in_values[idx].CompareTo(not_in_values[idx - 1]) !=
-                        util::ComparisonResult::Same) {
-      sorted_unique_not_in.push_back(not_in_values[idx]);
-    }
-  }
-
-  std::vector<IndexEntry> bounds;
-  bounds.push_back(lower_bound);
-  for (const auto& not_in_value : sorted_unique_not_in) {
-    auto cmp_to_lower = not_in_value.CompareTo(lower_bound);
-    auto cmp_to_upper = not_in_value.CompareTo(upper_bound);
-
-    if (cmp_to_lower == util::ComparisonResult::Same) {
-      // `notInValue` is the lower bound. We therefore need to raise the bound
-      // to the next value.
-      bounds[0] = lower_bound.Successor();
-    } else if (cmp_to_lower == util::ComparisonResult::Descending &&
-               cmp_to_upper == util::ComparisonResult::Ascending) {
-      // `notInValue` is in the middle of the range
-      bounds.push_back(not_in_value);
-      bounds.push_back(not_in_value.Successor());
-    } else if (cmp_to_upper == util::ComparisonResult::Descending) {
-      // `notInValue` (and all following values) are out of the range
-      break;
-    }
-  }
-  bounds.push_back(upper_bound);
-
-  std::vector<LevelDbIndexManager::IndexRange> ranges;
-  for (size_t i = 0; i < bounds.size(); i += 2) {
-    ranges.push_back(LevelDbIndexManager::IndexRange{
-        LevelDbIndexEntryKey::KeyPrefix(bounds[i].index_id(), uid_,
-                                        bounds[i].array_value(),
-                                        bounds[i].directional_value()),
-        LevelDbIndexEntryKey::KeyPrefix(bounds[i + 1].index_id(), uid_,
-                                        bounds[i + 1].array_value(),
-                                        bounds[i + 1].directional_value())});
-  }
-  return ranges;
-}
-
 absl::optional<std::string>
 LevelDbIndexManager::GetNextCollectionGroupToUpdate() const {
   if (next_index_to_update_.empty()) {
@@ -822,58 +545,6 @@ std::set<IndexEntry> LevelDbIndexManager::GetExistingIndexEntries(
   return index_entries;
 }
 
-std::set<IndexEntry> LevelDbIndexManager::ComputeIndexEntries(
-    const model::Document& document, const FieldIndex& index) {
-  std::set<IndexEntry> results;
-
-  auto directional_value = EncodeDirectionalElements(index, document);
-  if (directional_value == absl::nullopt) {
-    return results;
-  }
-
-  auto array_segment = index.GetArraySegment();
-  if (array_segment.has_value()) {
-    auto field_value = document->field(array_segment->field_path());
-    if (field_value.has_value() &&
-        field_value.value().which_value_type ==
-            google_firestore_v1_Value_array_value_tag) {
-      for (pb_size_t i = 0; i < field_value.value().array_value.values_count;
-           ++i) {
-        results.insert(IndexEntry(
-            index.index_id(), document->key(),
-            EncodeSingleElement(field_value.value().array_value.values[i]),
-            directional_value.value()));
-      }
-    }
-  } else {
-    results.insert(IndexEntry(index.index_id(), document->key(), "",
-                              directional_value.value()));
-  }
-
-  return results;
-}
-
-absl::optional<std::string> LevelDbIndexManager::EncodeDirectionalElements(
-    const FieldIndex& index, const model::Document& document) {
-  IndexEncodingBuffer index_buffer;
-  for (const auto& segment : index.GetDirectionalSegments()) {
-    auto field = document->field(segment.field_path());
-    if (!field.has_value()) {
-      return absl::nullopt;
-    }
-    index::WriteIndexValue(field.value(), index_buffer.ForKind(segment.kind()));
-  }
-  return index_buffer.GetEncodedBytes();
-}
-
-std::string LevelDbIndexManager::EncodeSingleElement(
-    const _google_firestore_v1_Value& value) {
-  IndexEncodingBuffer index_buffer;
-  index::WriteIndexValue(value,
-                         index_buffer.ForKind(model::Segment::kAscending));
-  return index_buffer.GetEncodedBytes();
-}
-
 void LevelDbIndexManager::UpdateEntries(
     const model::Document& document,
     const FieldIndex& index,
@@ -967,27 +638,7 @@ std::vector<Target> LevelDbIndexManager::GetSubTargets(const Target& target) {
     return it->second;
   }
 
-  std::vector<Target> subtargets;
-  if (target.filters().empty()) {
-    subtargets.push_back(target);
-  } else {
-    // There is an implicit AND operation between all the filters stored in the
-    // target.
-    std::vector<Filter> filters;
-    for (const auto& filter : target.filters()) {
-      filters.push_back(filter);
-    }
-    std::vector<Filter> dnf = LogicUtils::GetDnfTerms(CompositeFilter::Create(
-        std::move(filters), CompositeFilter::Operator::And));
-
-    for (const Filter& term : dnf) {
-      subtargets.push_back({target.path(), target.collection_group(),
-                            term.GetFilters(), target.order_bys(),
-                            target.limit(), target.start_at(),
-                            target.end_at()});
-    }
-  }
-  return target_to_dnf_subtargets_[target] = subtargets;
+  return target_to_dnf_subtargets_[target] = GetDnfSubTargets(target);
 }
 
 }  // namespace local
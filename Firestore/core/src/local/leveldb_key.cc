@@ -41,6 +41,7 @@ namespace {
 const char* kVersionGlobalTable = "version";
 const char* kMutationsTable = "mutation";
 const char* kDocumentMutationsTable = "document_mutation";
+const char* kCollectionMutationsTable = "collection_mutation";
 const char* kMutationQueuesTable = "mutation_queue";
 const char* kTargetGlobalTable = "target_global";
 const char* kTargetsTable = "target";
@@ -50,6 +51,9 @@ const char* kDocumentTargetsTable = "document_target";
 const char* kRemoteDocumentsTable = "remote_document";
 const char* kCollectionParentsTable = "collection_parent";
 const char* kRemoteDocumentReadTimeTable = "remote_document_read_time";
+const char* kCollectionPathIdsTable = "collection_path_id";
+const char* kRemoteDocumentCompactReadTimeTable = "read_time";
+const char* kFieldNameIdsTable = "field_name_id";
 const char* kBundlesTable = "bundles";
 const char* kNamedQueriesTable = "named_queries";
 const char* kIndexConfigurationTable = "index_configuration";
@@ -159,6 +163,15 @@ enum ComponentLabel {
    */
   DataMigrationName = 25,
 
+  /** A component containing the interned ID of a collection path. */
+  CollectionPathId = 26,
+
+  /** A component containing the interned ID of a field name. */
+  FieldNameId = 27,
+
+  /** A component containing a field name, i.e. the key of a map entry. */
+  FieldName = 28,
+
   /**
    * A path segment describes just a single segment in a resource path. Path
    * segments that occur sequentially in a key represent successive segments in
@@ -273,6 +286,18 @@ class Reader {
     return ReadLabeledString(ComponentLabel::DataMigrationName);
   }
 
+  int64_t ReadCollectionPathId() {
+    return ReadLabeledInt64(ComponentLabel::CollectionPathId);
+  }
+
+  int64_t ReadFieldNameId() {
+    return ReadLabeledInt64(ComponentLabel::FieldNameId);
+  }
+
+  std::string ReadFieldName() {
+    return ReadLabeledString(ComponentLabel::FieldName);
+  }
+
   /**
    * Reads a snapshot version, encoded as a component label and a pair of
    * seconds (int64) and nanoseconds (int32).
@@ -687,6 +712,22 @@ std::string Reader::Describe() {
         absl::StrAppend(&description,
                         " data_migration_name=", std::move(value));
       }
+    } else if (label == ComponentLabel::CollectionPathId) {
+      int64_t collection_path_id = ReadCollectionPathId();
+      if (ok_) {
+        absl::StrAppend(&description,
+                        " collection_path_id=", collection_path_id);
+      }
+    } else if (label == ComponentLabel::FieldNameId) {
+      int64_t field_name_id = ReadFieldNameId();
+      if (ok_) {
+        absl::StrAppend(&description, " field_name_id=", field_name_id);
+      }
+    } else if (label == ComponentLabel::FieldName) {
+      std::string field_name = ReadFieldName();
+      if (ok_) {
+        absl::StrAppend(&description, " field_name=", std::move(field_name));
+      }
     } else {
       absl::StrAppend(&description, " unknown label=", static_cast<int>(label));
       Fail();
@@ -798,6 +839,18 @@ class Writer {
     WriteLabeledString(ComponentLabel::DataMigrationName, name);
   }
 
+  void WriteCollectionPathId(int64_t collection_path_id) {
+    WriteLabeledInt64(ComponentLabel::CollectionPathId, collection_path_id);
+  }
+
+  void WriteFieldNameId(int64_t field_name_id) {
+    WriteLabeledInt64(ComponentLabel::FieldNameId, field_name_id);
+  }
+
+  void WriteFieldName(absl::string_view field_name) {
+    WriteLabeledString(ComponentLabel::FieldName, field_name);
+  }
+
  private:
   /** Writes a component label to the given key destination. */
   void WriteComponentLabel(ComponentLabel label) {
@@ -934,6 +987,55 @@ bool LevelDbDocumentMutationKey::Decode(absl::string_view key) {
   return reader.ok();
 }
 
+std::string LevelDbCollectionMutationKey::KeyPrefix() {
+  Writer writer;
+  writer.WriteTableName(kCollectionMutationsTable);
+  return writer.result();
+}
+
+std::string LevelDbCollectionMutationKey::KeyPrefix(
+    absl::string_view user_id) {
+  Writer writer;
+  writer.WriteTableName(kCollectionMutationsTable);
+  writer.WriteUserId(user_id);
+  return writer.result();
+}
+
+std::string LevelDbCollectionMutationKey::KeyPrefix(
+    absl::string_view user_id, const ResourcePath& collection_path) {
+  Writer writer;
+  writer.WriteTableName(kCollectionMutationsTable);
+  writer.WriteUserId(user_id);
+  writer.WriteResourcePath(collection_path);
+  return writer.result();
+}
+
+std::string LevelDbCollectionMutationKey::Key(
+    absl::string_view user_id,
+    const ResourcePath& collection_path,
+    model::BatchId batch_id,
+    absl::string_view document_id) {
+  Writer writer;
+  writer.WriteTableName(kCollectionMutationsTable);
+  writer.WriteUserId(user_id);
+  writer.WriteResourcePath(collection_path);
+  writer.WriteBatchId(batch_id);
+  writer.WriteDocumentId(document_id);
+  writer.WriteTerminator();
+  return writer.result();
+}
+
+bool LevelDbCollectionMutationKey::Decode(absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kCollectionMutationsTable);
+  user_id_ = reader.ReadUserId();
+  collection_path_ = reader.ReadResourcePath();
+  batch_id_ = reader.ReadBatchId();
+  document_id_ = reader.ReadDocumentId();
+  reader.ReadTerminator();
+  return reader.ok();
+}
+
 std::string LevelDbMutationQueueKey::KeyPrefix() {
   Writer writer;
   writer.WriteTableName(kMutationQueuesTable);
@@ -1173,6 +1275,12 @@ bool LevelDbCollectionParentKey::Decode(absl::string_view key) {
   return reader.ok();
 }
 
+std::string LevelDbRemoteDocumentReadTimeKey::KeyPrefix() {
+  Writer writer;
+  writer.WriteTableName(kRemoteDocumentReadTimeTable);
+  return writer.result();
+}
+
 std::string LevelDbRemoteDocumentReadTimeKey::KeyPrefix(
     const model::ResourcePath& collection_path,
     model::SnapshotVersion read_time) {
@@ -1206,6 +1314,120 @@ bool LevelDbRemoteDocumentReadTimeKey::Decode(absl::string_view key) {
   return reader.ok();
 }
 
+std::string LevelDbCollectionPathIdKey::KeyPrefix() {
+  Writer writer;
+  writer.WriteTableName(kCollectionPathIdsTable);
+  return writer.result();
+}
+
+std::string LevelDbCollectionPathIdKey::KeyPrefix(
+    const model::ResourcePath& collection_path) {
+  Writer writer;
+  writer.WriteTableName(kCollectionPathIdsTable);
+  writer.WriteResourcePath(collection_path);
+  return writer.result();
+}
+
+std::string LevelDbCollectionPathIdKey::Key(
+    const model::ResourcePath& collection_path, int64_t collection_path_id) {
+  Writer writer;
+  writer.WriteTableName(kCollectionPathIdsTable);
+  writer.WriteResourcePath(collection_path);
+  writer.WriteCollectionPathId(collection_path_id);
+  writer.WriteTerminator();
+  return writer.result();
+}
+
+bool LevelDbCollectionPathIdKey::Decode(absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kCollectionPathIdsTable);
+  collection_path_ = reader.ReadResourcePath();
+  collection_path_id_ = reader.ReadCollectionPathId();
+  reader.ReadTerminator();
+  return reader.ok();
+}
+
+std::string LevelDbRemoteDocumentCompactReadTimeKey::KeyPrefix() {
+  Writer writer;
+  writer.WriteTableName(kRemoteDocumentCompactReadTimeTable);
+  return writer.result();
+}
+
+std::string LevelDbRemoteDocumentCompactReadTimeKey::KeyPrefix(
+    int64_t collection_path_id) {
+  Writer writer;
+  writer.WriteTableName(kRemoteDocumentCompactReadTimeTable);
+  writer.WriteCollectionPathId(collection_path_id);
+  return writer.result();
+}
+
+std::string LevelDbRemoteDocumentCompactReadTimeKey::KeyPrefix(
+    int64_t collection_path_id, model::SnapshotVersion read_time) {
+  Writer writer;
+  writer.WriteTableName(kRemoteDocumentCompactReadTimeTable);
+  writer.WriteCollectionPathId(collection_path_id);
+  writer.WriteSnapshotVersion(read_time);
+  return writer.result();
+}
+
+std::string LevelDbRemoteDocumentCompactReadTimeKey::Key(
+    int64_t collection_path_id,
+    model::SnapshotVersion read_time,
+    absl::string_view document_id) {
+  Writer writer;
+  writer.WriteTableName(kRemoteDocumentCompactReadTimeTable);
+  writer.WriteCollectionPathId(collection_path_id);
+  writer.WriteSnapshotVersion(read_time);
+  writer.WriteDocumentId(document_id);
+  writer.WriteTerminator();
+  return writer.result();
+}
+
+bool LevelDbRemoteDocumentCompactReadTimeKey::Decode(absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kRemoteDocumentCompactReadTimeTable);
+  collection_path_id_ = reader.ReadCollectionPathId();
+  read_time_ = reader.ReadSnapshotVersion();
+  document_id_ = reader.ReadDocumentId();
+  reader.ReadTerminator();
+  return reader.ok();
+}
+
+std::string LevelDbFieldNameIdKey::KeyPrefix() {
+  Writer writer;
+  writer.WriteTableName(kFieldNameIdsTable);
+  return writer.result();
+}
+
+std::string LevelDbFieldNameIdKey::KeyPrefix(int64_t collection_path_id) {
+  Writer writer;
+  writer.WriteTableName(kFieldNameIdsTable);
+  writer.WriteCollectionPathId(collection_path_id);
+  return writer.result();
+}
+
+std::string LevelDbFieldNameIdKey::Key(int64_t collection_path_id,
+                                       int64_t field_name_id,
+                                       absl::string_view field_name) {
+  Writer writer;
+  writer.WriteTableName(kFieldNameIdsTable);
+  writer.WriteCollectionPathId(collection_path_id);
+  writer.WriteFieldNameId(field_name_id);
+  writer.WriteFieldName(field_name);
+  writer.WriteTerminator();
+  return writer.result();
+}
+
+bool LevelDbFieldNameIdKey::Decode(absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kFieldNameIdsTable);
+  collection_path_id_ = reader.ReadCollectionPathId();
+  field_name_id_ = reader.ReadFieldNameId();
+  field_name_ = reader.ReadFieldName();
+  reader.ReadTerminator();
+  return reader.ok();
+}
+
 std::string LevelDbBundleKey::KeyPrefix() {
   Writer writer;
   writer.WriteTableName(kBundlesTable);
@@ -50,6 +50,13 @@ namespace local {
 //   - path: ResourcePath
 //   - batch_id: model::BatchId
 //
+// collection_mutations:
+//   - table_name: string = "collection_mutation"
+//   - user_id: string
+//   - collection: ResourcePath
+//   - batch_id: model::BatchId
+//   - document_id: string
+//
 // mutation_queues:
 //   - table_name: string = "mutation_queue"
 //   - user_id: string
@@ -85,12 +92,30 @@ namespace local {
 //   - collectionId: string
 //   - parent: ResourcePath
 //
-// remote_document_read_time:
+// remote_document_read_time: (replaced by read_times in schema version 10;
+// only read and written by migrations)
 //   - table_name: string = "remote_document_read_time"
 //   - collection: ResourcePath
 //   - read_time: SnapshotVersion
 //   - document_id: string
 //
+// collection_path_ids:
+//   - table_name: string = "collection_path_id"
+//   - collection: ResourcePath
+//   - collection_path_id: int64_t
+//
+// read_times:
+//   - table_name: string = "read_time"
+//   - collection_path_id: int64_t
+//   - read_time: SnapshotVersion
+//   - document_id: string
+//
+// field_name_ids:
+//   - table_name: string = "field_name_id"
+//   - collection_path_id: int64_t
+//   - field_name_id: int64_t
+//   - field_name: string
+//
 // bundles:
 //   - table_name: string = "bundles"
 //   - bundle_id: string
@@ -283,6 +308,92 @@ class LevelDbDocumentMutationKey {
   model::BatchId batch_id_ = model::kBatchIdUnknown;
 };
 
+/**
+ * A key in the collection mutations index, which stores the batches that
+ * mutate documents that are immediate children of a collection.
+ *
+ * Unlike the document mutations index, scanning the entries for a collection
+ * does not visit mutations of documents in nested subcollections: all entries
+ * for a collection sort before any entries of its subcollections because the
+ * BatchId component label sorts before the PathSegment label.
+ */
+class LevelDbCollectionMutationKey {
+ public:
+  /**
+   * Creates a key prefix that points just before the first key in the table.
+   */
+  static std::string KeyPrefix();
+
+  /**
+   * Creates a key prefix that points just before the first key for the given
+   * user_id.
+   */
+  static std::string KeyPrefix(absl::string_view user_id);
+
+  /**
+   * Creates a key prefix that points just before the first key for the user_id
+   * and collection path.
+   */
+  static std::string KeyPrefix(absl::string_view user_id,
+                               const model::ResourcePath& collection_path);
+
+  /**
+   * Creates a complete key that points to a specific user_id, collection path,
+   * batch_id and document ID.
+   */
+  static std::string Key(absl::string_view user_id,
+                         const model::ResourcePath& collection_path,
+                         model::BatchId batch_id,
+                         absl::string_view document_id);
+
+  /**
+   * Creates a complete key for the given user_id, document key and batch_id.
+   */
+  static std::string Key(absl::string_view user_id,
+                         const model::DocumentKey& document_key,
+                         model::BatchId batch_id) {
+    return Key(user_id, document_key.path().PopLast(), batch_id,
+               document_key.path().last_segment());
+  }
+
+  /**
+   * Decodes the given complete key, storing the decoded values in this
+   * instance.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  /** The user that owns the mutation batches. */
+  const std::string& user_id() const {
+    return user_id_;
+  }
+
+  /** The collection containing the mutated document. */
+  const model::ResourcePath& collection_path() const {
+    return collection_path_;
+  }
+
+  /** The batch_id in which the document participates. */
+  model::BatchId batch_id() const {
+    return batch_id_;
+  }
+
+  /** The ID of the mutated document within the collection. */
+  const std::string& document_id() const {
+    return document_id_;
+  }
+
+ private:
+  std::string user_id_;
+  model::ResourcePath collection_path_;
+  model::BatchId batch_id_ = model::kBatchIdUnknown;
+  std::string document_id_;
+};
+
 /**
  * A key in the mutation_queues table.
  *
@@ -652,6 +763,11 @@ class LevelDbCollectionParentKey {
  */
 class LevelDbRemoteDocumentReadTimeKey {
  public:
+  /**
+   * Creates a key prefix that points just before the first key of the table.
+   */
+  static std::string KeyPrefix();
+
   /**
    * Creates a key prefix that points just before the first key for the given
    * collection_path and read_time.
@@ -698,6 +814,192 @@ class LevelDbRemoteDocumentReadTimeKey {
   model::SnapshotVersion read_time_;
 };
 
+/**
+ * A key in the collection path IDs table, which interns each collection path
+ * as a small integer so that compact tables need not repeat every segment of
+ * the path in each of their keys.
+ *
+ * IDs are assigned in increasing order and are never reused, but they carry no
+ * ordering relative to the paths they stand for.
+ */
+class LevelDbCollectionPathIdKey {
+ public:
+  /**
+   * Creates a key prefix that points just before the first key of the table.
+   */
+  static std::string KeyPrefix();
+
+  /**
+   * Creates a key prefix that points just before the key for the given
+   * collection_path. Since the ID component sorts before any further path
+   * segment, the first key at or after this prefix is the one for
+   * collection_path if it has been assigned an ID.
+   */
+  static std::string KeyPrefix(const model::ResourcePath& collection_path);
+
+  /**
+   * Creates a complete key that points to the ID assignment for the given
+   * collection_path.
+   */
+  static std::string Key(const model::ResourcePath& collection_path,
+                         int64_t collection_path_id);
+
+  /**
+   * Decodes the given complete key, storing the decoded values in this
+   * instance.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  /** The collection path for this entry. */
+  const model::ResourcePath& collection_path() const {
+    return collection_path_;
+  }
+
+  /** The ID assigned to the collection path. */
+  int64_t collection_path_id() const {
+    return collection_path_id_;
+  }
+
+ private:
+  model::ResourcePath collection_path_;
+  int64_t collection_path_id_ = 0;
+};
+
+/**
+ * A key in the field name IDs table, which assigns the map keys found in the
+ * documents of a collection small integer IDs. Documents in the compact format
+ * refer to their field names by these IDs (see
+ * `LocalSerializer::EncodeCompactMaybeDocument`).
+ *
+ * IDs are scoped to a collection, start at zero and are never reused. Entries
+ * for one collection sort by ID.
+ */
+class LevelDbFieldNameIdKey {
+ public:
+  /**
+   * Creates a key prefix that points just before the first key of the table.
+   */
+  static std::string KeyPrefix();
+
+  /**
+   * Creates a key prefix that points just before the first key for the given
+   * collection_path_id.
+   */
+  static std::string KeyPrefix(int64_t collection_path_id);
+
+  /**
+   * Creates a complete key that points to the ID assignment for the given
+   * field_name in the collection with the given collection_path_id.
+   */
+  static std::string Key(int64_t collection_path_id,
+                         int64_t field_name_id,
+                         absl::string_view field_name);
+
+  /**
+   * Decodes the given complete key, storing the decoded values in this
+   * instance.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  /** The interned ID of the collection the field name is used in. */
+  int64_t collection_path_id() const {
+    return collection_path_id_;
+  }
+
+  /** The ID assigned to the field name. */
+  int64_t field_name_id() const {
+    return field_name_id_;
+  }
+
+  /** The field name for this entry. */
+  const std::string& field_name() const {
+    return field_name_;
+  }
+
+ private:
+  int64_t collection_path_id_ = 0;
+  int64_t field_name_id_ = 0;
+  std::string field_name_;
+};
+
+/**
+ * A key in the compact read time table, storing the interned collection path
+ * ID, read time and document ID for each entry.
+ *
+ * Entries for one collection sort by read time and then document ID, exactly
+ * like `LevelDbRemoteDocumentReadTimeKey`. Entries of different collections do
+ * not sort by path.
+ */
+class LevelDbRemoteDocumentCompactReadTimeKey {
+ public:
+  /**
+   * Creates a key prefix that points just before the first key of the table.
+   */
+  static std::string KeyPrefix();
+
+  /**
+   * Creates a key prefix that points just before the first key for the given
+   * collection_path_id.
+   */
+  static std::string KeyPrefix(int64_t collection_path_id);
+
+  /**
+   * Creates a key prefix that points just before the first key for the given
+   * collection_path_id and read_time.
+   */
+  static std::string KeyPrefix(int64_t collection_path_id,
+                               model::SnapshotVersion read_time);
+
+  /**
+   * Creates a key that points to the key for the given collection_path_id,
+   * read_time and document_id.
+   */
+  static std::string Key(int64_t collection_path_id,
+                         model::SnapshotVersion read_time,
+                         absl::string_view document_id);
+
+  /**
+   * Decodes the given complete key, storing the decoded values in this
+   * instance.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  /** The interned collection path ID for this entry. */
+  int64_t collection_path_id() const {
+    return collection_path_id_;
+  }
+
+  /** The read time for for this entry. */
+  model::SnapshotVersion read_time() const {
+    return read_time_;
+  }
+
+  /** The document ID for this entry. */
+  const std::string& document_id() const {
+    return document_id_;
+  }
+
+ private:
+  std::string document_id_;
+  int64_t collection_path_id_ = 0;
+  model::SnapshotVersion read_time_;
+};
+
 /**
  * A key in the bundles table, storing the bundle Id for each entry.
  */
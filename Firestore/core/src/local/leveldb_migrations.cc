@@ -17,19 +17,24 @@
 #include "Firestore/core/src/local/leveldb_migrations.h"
 
 #include <string>
+#include <unordered_map>
 #include <utility>
 
 #include "Firestore/Protos/nanopb/firestore/local/mutation.nanopb.h"
 #include "Firestore/Protos/nanopb/firestore/local/target.nanopb.h"
+#include "Firestore/core/src/local/leveldb_collection_path_ids.h"
+#include "Firestore/core/src/local/leveldb_field_name_ids.h"
 #include "Firestore/core/src/local/leveldb_key.h"
 #include "Firestore/core/src/local/memory_index_manager.h"
 #include "Firestore/core/src/local/target_data.h"
 #include "Firestore/core/src/model/document_key.h"
+#include "Firestore/core/src/model/mutable_document.h"
 #include "Firestore/core/src/model/types.h"
 #include "Firestore/core/src/nanopb/message.h"
 #include "Firestore/core/src/nanopb/reader.h"
 #include "Firestore/core/src/nanopb/writer.h"
 #include "Firestore/core/src/util/log.h"
+#include "Firestore/core/src/util/read_context.h"
 #include "Firestore/core/src/util/statusor.h"
 #include "absl/strings/match.h"
 
@@ -40,6 +45,7 @@ namespace {
 
 using leveldb::Status;
 using model::DocumentKey;
+using model::MutableDocument;
 using model::ResourcePath;
 using nanopb::Message;
 using nanopb::StringReader;
@@ -370,6 +376,206 @@ void EnsureOverlayDataMigrationIsRequired(leveldb::DB* db) {
   transaction.Commit();
 }
 
+/**
+ * Migration 9.
+ *
+ * Creates LevelDbCollectionMutationKey rows for every row in the
+ * document_mutation index, so that collection queries can find the mutations
+ * that affect a collection without scanning its subcollections.
+ */
+void EnsureCollectionMutationsIndex(leveldb::DB* db) {
+  // A downgrade followed by an upgrade reruns this migration. Rows written by
+  // the newer client may be stale since older clients don't maintain them.
+  DeleteEverythingWithPrefix(LevelDbCollectionMutationKey::KeyPrefix(), db);
+
+  LevelDbTransaction transaction(db, "Ensure Collection Mutations Index");
+
+  std::string mutations_prefix = LevelDbDocumentMutationKey::KeyPrefix();
+  auto it = transaction.NewIterator();
+  it->Seek(mutations_prefix);
+  LevelDbDocumentMutationKey key;
+  std::string empty_buffer;
+  for (; it->Valid() && absl::StartsWith(it->key(), mutations_prefix);
+       it->Next()) {
+    HARD_ASSERT(key.Decode(it->key()),
+                "Failed to decode document-mutation key");
+
+    transaction.Put(LevelDbCollectionMutationKey::Key(
+                        key.user_id(), key.document_key(), key.batch_id()),
+                    empty_buffer);
+  }
+
+  SaveVersion(9, &transaction);
+  transaction.Commit();
+}
+
+/**
+ * Migration 10.
+ *
+ * Populates the read_time table, whose keys refer to the collection by an
+ * interned ID, from the remote_document_read_time table, whose keys spell out
+ * every segment of the collection path. The legacy rows are left in place and
+ * kept up to date, since older clients only read those.
+ */
+void EnsureCompactReadTimeIndex(leveldb::DB* db) {
+  // A downgrade followed by an upgrade reruns this migration. Rows written by
+  // the newer client may be stale since older clients don't maintain them.
+  // Interned IDs are never stale, so they are kept.
+  DeleteEverythingWithPrefix(
+      LevelDbRemoteDocumentCompactReadTimeKey::KeyPrefix(), db);
+
+  LevelDbTransaction transaction(db, "Ensure compact read time index");
+  LevelDbCollectionPathIds collection_path_ids =
+      LevelDbCollectionPathIds::Load(&transaction);
+
+  std::string read_time_prefix = LevelDbRemoteDocumentReadTimeKey::KeyPrefix();
+  auto it = transaction.NewIterator();
+  it->Seek(read_time_prefix);
+  LevelDbRemoteDocumentReadTimeKey key;
+  for (; it->Valid() && absl::StartsWith(it->key(), read_time_prefix);
+       it->Next()) {
+    HARD_ASSERT(key.Decode(it->key()), "Failed to decode read time key");
+
+    int64_t collection_path_id =
+        collection_path_ids.Intern(key.collection_path(), &transaction);
+    transaction.Put(LevelDbRemoteDocumentCompactReadTimeKey::Key(
+                        collection_path_id, key.read_time(), key.document_id()),
+                    "");
+  }
+
+  SaveVersion(10, &transaction);
+  transaction.Commit();
+}
+
+/**
+ * Migration 11.
+ *
+ * Introduces the compact document format and the field_name_id table that
+ * holds its per-collection field names. Existing rows are left in the full
+ * format, and the remote document cache only writes compact rows once they are
+ * enabled, since older clients can't read them.
+ */
+void AddCompactDocumentFormat(leveldb::DB* db) {
+  LevelDbTransaction transaction(db, "Add compact document format");
+  SaveVersion(11, &transaction);
+  transaction.Commit();
+}
+
+/**
+ * The number of changed keys after which migrations that rewrite many rows
+ * commit and start a new transaction.
+ */
+const size_t kMigrationBatchSize = 1000;
+
+/**
+ * Reverts migration 11 when downgrading, rewriting the remote documents in the
+ * full format that older clients read.
+ *
+ * Rows are rewritten in batches of separate transactions. Rows already in the
+ * full format are skipped, so a downgrade that is interrupted picks up where
+ * it left off. The field names are only deleted once no row refers to them.
+ */
+void RestoreFullDocuments(leveldb::DB* db, const LocalSerializer& serializer) {
+  LevelDbCollectionPathIds collection_path_ids;
+  LevelDbFieldNameIds field_name_ids;
+  {
+    LevelDbTransaction transaction(db, "Load interned IDs");
+    collection_path_ids = LevelDbCollectionPathIds::Load(&transaction);
+    field_name_ids = LevelDbFieldNameIds::Load(&transaction);
+  }
+
+  std::string documents_prefix = LevelDbRemoteDocumentKey::KeyPrefix();
+  std::string start_key = documents_prefix;
+  bool more_documents = true;
+  while (more_documents) {
+    LevelDbTransaction transaction(db, "Restore full documents");
+    auto it = transaction.NewIterator();
+
+    more_documents = false;
+    LevelDbRemoteDocumentKey key;
+    for (it->Seek(start_key);
+         it->Valid() && absl::StartsWith(it->key(), documents_prefix);
+         it->Next()) {
+      if (transaction.changed_keys() >= kMigrationBatchSize) {
+        start_key = it->key();
+        more_documents = true;
+        break;
+      }
+      if (!LocalSerializer::IsCompactMaybeDocument(it->value())) {
+        continue;
+      }
+
+      HARD_ASSERT(key.Decode(it->key()), "Failed to decode document key");
+      absl::optional<int64_t> collection_path_id =
+          collection_path_ids.Find(key.document_key().path().PopLast());
+      auto field_names = field_name_ids.Names(collection_path_id.value_or(0));
+
+      util::ReadContext context;
+      MutableDocument document = serializer.DecodeCompactMaybeDocument(
+          &context, it->value(), *field_names);
+      HARD_ASSERT(context.ok(), "Failed to decode document %s: %s",
+                  key.document_key().ToString(), context.status().ToString());
+      transaction.Put(it->key(), serializer.EncodeMaybeDocument(document));
+    }
+
+    transaction.Commit();
+  }
+
+  DeleteEverythingWithPrefix(LevelDbFieldNameIdKey::KeyPrefix(), db);
+}
+
+/**
+ * Writes the legacy read_time row of every entry in the compact read_time
+ * index. The remote document cache stops maintaining the legacy index once
+ * compact documents are enabled, and older clients need it to be complete.
+ */
+void RestoreLegacyReadTimeIndex(leveldb::DB* db) {
+  std::unordered_map<int64_t, ResourcePath> collection_paths;
+  {
+    LevelDbTransaction transaction(db, "Load collection path IDs");
+    std::string ids_prefix = LevelDbCollectionPathIdKey::KeyPrefix();
+    auto it = transaction.NewIterator();
+    LevelDbCollectionPathIdKey key;
+    for (it->Seek(ids_prefix);
+         it->Valid() && absl::StartsWith(it->key(), ids_prefix); it->Next()) {
+      HARD_ASSERT(key.Decode(it->key()),
+                  "Failed to decode collection path ID key");
+      collection_paths[key.collection_path_id()] = key.collection_path();
+    }
+  }
+
+  std::string read_time_prefix =
+      LevelDbRemoteDocumentCompactReadTimeKey::KeyPrefix();
+  std::string start_key = read_time_prefix;
+  bool more_rows = true;
+  while (more_rows) {
+    LevelDbTransaction transaction(db, "Restore legacy read time index");
+    auto it = transaction.NewIterator();
+
+    more_rows = false;
+    LevelDbRemoteDocumentCompactReadTimeKey key;
+    for (it->Seek(start_key);
+         it->Valid() && absl::StartsWith(it->key(), read_time_prefix);
+         it->Next()) {
+      if (transaction.changed_keys() >= kMigrationBatchSize) {
+        start_key = it->key();
+        more_rows = true;
+        break;
+      }
+
+      HARD_ASSERT(key.Decode(it->key()), "Failed to decode read time key");
+      auto found = collection_paths.find(key.collection_path_id());
+      HARD_ASSERT(found != collection_paths.end(),
+                  "No collection path for ID %s", key.collection_path_id());
+      transaction.Put(LevelDbRemoteDocumentReadTimeKey::Key(
+                          found->second, key.read_time(), key.document_id()),
+                      "");
+    }
+
+    transaction.Commit();
+  }
+}
+
 }  // namespace
 
 LevelDbMigrations::SchemaVersion LevelDbMigrations::ReadSchemaVersion(
@@ -397,10 +603,14 @@ void LevelDbMigrations::RunMigrations(leveldb::DB* db,
                                       SchemaVersion to_version,
                                       const LocalSerializer& serializer) {
   SchemaVersion from_version = ReadSchemaVersion(db);
-  // If this is a downgrade, just save the downgrade version so we can
-  // detect it when we go to upgrade again, allowing us to rerun the
-  // data migrations.
+  // If this is a downgrade, save the downgrade version so we can detect it
+  // when we go to upgrade again, allowing us to rerun the data migrations.
+  // Migrations that change the format of existing data are reverted first.
   if (from_version > to_version) {
+    if (from_version >= 11 && to_version < 11) {
+      RestoreLegacyReadTimeIndex(db);
+      RestoreFullDocuments(db, serializer);
+    }
     LevelDbTransaction transaction(db, "Save downgrade version");
     SaveVersion(to_version, &transaction);
     transaction.Commit();
@@ -433,6 +643,18 @@ void LevelDbMigrations::RunMigrations(leveldb::DB* db,
   if (from_version < 8 && to_version >= 8) {
     EnsureOverlayDataMigrationIsRequired(db);
   }
+
+  if (from_version < 9 && to_version >= 9) {
+    EnsureCollectionMutationsIndex(db);
+  }
+
+  if (from_version < 10 && to_version >= 10) {
+    EnsureCompactReadTimeIndex(db);
+  }
+
+  if (from_version < 11 && to_version >= 11) {
+    AddCompactDocumentFormat(db);
+  }
 }
 
 }  // namespace local
@@ -73,8 +73,18 @@ class LevelDbMigrations {
  *   * Migration 6 populates the collection_parents index.
  *   * Migration 7 rewrites query_targets canonical ids in new format.
  *   * Migration 8 kicks off overlay data migration.
+ *   * Migration 9 populates the collection_mutations index.
+ *   * Migration 10 populates the compact read_time index, keyed by interned
+ *     collection path IDs, from the legacy remote_document_read_time index.
+ *     The legacy index is maintained alongside it so that older clients can
+ *     still read it, unless compact documents are enabled.
+ *   * Migration 11 adds the compact document format, which refers to field
+ *     names by per-collection IDs. Existing documents are not rewritten, and
+ *     compact rows are only written once enabled. Downgrading below version
+ *     11 rewrites any compact rows in the full format and restores the legacy
+ *     read_time index from the compact one.
  */
-const LevelDbMigrations::SchemaVersion kSchemaVersion = 8;
+const LevelDbMigrations::SchemaVersion kSchemaVersion = 11;
 
 }  // namespace local
 }  // namespace firestore
@@ -73,10 +73,12 @@ class LevelDbOpener {
    *   * Actually opening the LevelDB database.
    *
    * @param lru_params The LRU GC configuration to use for the instance.
+   * @param compact_documents_enabled Whether to store documents in the compact
+   *     format, which older SDKs can't read.
    * @return A pointer to the created instance or Status indicating what failed.
    */
   util::StatusOr<std::unique_ptr<LevelDbPersistence>> Create(
-      const LruParams& lru_params);
+      const LruParams& lru_params, bool compact_documents_enabled = false);
 
   /**
    * Finds a suitable directory to serve as the root of all Firestore local
@@ -16,6 +16,7 @@
 
 #include "Firestore/core/src/local/leveldb_persistence.h"
 
+#include <chrono>  // NOLINT(build/c++11)
 #include <limits>
 #include <utility>
 
@@ -33,7 +34,9 @@
 #include "Firestore/core/src/util/filesystem.h"
 #include "Firestore/core/src/util/hard_assert.h"
 #include "Firestore/core/src/util/log.h"
+#include "Firestore/core/src/util/metrics.h"
 #include "Firestore/core/src/util/string_util.h"
+#include "Firestore/core/src/util/tracing.h"
 #include "absl/memory/memory.h"
 #include "absl/strings/match.h"
 
@@ -46,10 +49,19 @@ using credentials::User;
 using leveldb::DB;
 using model::ListenSequenceNumber;
 using util::Filesystem;
+using util::MetricsRegistry;
 using util::Path;
 using util::Status;
 using util::StatusOr;
 using util::StringFormat;
+using util::TraceSpan;
+
+/**
+ * The read-only transaction running on this thread, if any. Read-only
+ * transactions run on arbitrary threads, so unlike the single read-write
+ * transaction they cannot be held by the persistence instance.
+ */
+thread_local LevelDbTransaction* read_only_transaction = nullptr;
 
 /**
  * Finds all user ids in the database based on the existence of a mutation
@@ -80,7 +92,8 @@ StatusOr<std::unique_ptr<LevelDbPersistence>> LevelDbPersistence::Create(
     util::Path dir,
     LevelDbMigrations::SchemaVersion version,
     LocalSerializer serializer,
-    const LruParams& lru_params) {
+    const LruParams& lru_params,
+    bool compact_documents_enabled) {
   auto* fs = Filesystem::Default();
   Status status = EnsureDirectory(dir);
   if (!status.ok()) return status;
@@ -99,23 +112,27 @@ StatusOr<std::unique_ptr<LevelDbPersistence>> LevelDbPersistence::Create(
   transaction.Commit();
 
   // Explicit conversion is required to allow the StatusOr to be created.
-  std::unique_ptr<LevelDbPersistence> result(
-      new LevelDbPersistence(std::move(db), std::move(dir), std::move(users),
-                             std::move(serializer), lru_params));
+  std::unique_ptr<LevelDbPersistence> result(new LevelDbPersistence(
+      std::move(db), std::move(dir), std::move(users), std::move(serializer),
+      lru_params, compact_documents_enabled));
   return {std::move(result)};
 }
 
 StatusOr<std::unique_ptr<LevelDbPersistence>> LevelDbPersistence::Create(
-    util::Path dir, LocalSerializer serializer, const LruParams& lru_params) {
+    util::Path dir,
+    LocalSerializer serializer,
+    const LruParams& lru_params,
+    bool compact_documents_enabled) {
   return Create(std::move(dir), kSchemaVersion, std::move(serializer),
-                lru_params);
+                lru_params, compact_documents_enabled);
 }
 
 LevelDbPersistence::LevelDbPersistence(std::unique_ptr<leveldb::DB> db,
                                        util::Path directory,
                                        std::set<std::string> users,
                                        LocalSerializer serializer,
-                                       const LruParams& lru_params)
+                                       const LruParams& lru_params,
+                                       bool compact_documents_enabled)
     : db_(std::move(db)),
       directory_(std::move(directory)),
       users_(std::move(users)),
@@ -123,6 +140,7 @@ LevelDbPersistence::LevelDbPersistence(std::unique_ptr<leveldb::DB> db,
   target_cache_ = absl::make_unique<LevelDbTargetCache>(this, &serializer_);
   document_cache_ =
       absl::make_unique<LevelDbRemoteDocumentCache>(this, &serializer_);
+  document_cache_->SetCompactDocumentsEnabled(compact_documents_enabled);
   reference_delegate_ =
       absl::make_unique<LevelDbLruReferenceDelegate>(this, lru_params);
   bundle_cache_ = absl::make_unique<LevelDbBundleCache>(this, &serializer_);
@@ -169,6 +187,9 @@ StatusOr<std::unique_ptr<DB>> LevelDbPersistence::OpenDb(const Path& dir) {
 // MARK: - LevelDB utilities
 
 LevelDbTransaction* LevelDbPersistence::current_transaction() {
+  if (read_only_transaction) {
+    return read_only_transaction;
+  }
   HARD_ASSERT(transaction_ != nullptr,
               "Attempting to access transaction before one has started");
   return transaction_.get();
@@ -323,14 +344,47 @@ void LevelDbPersistence::RunInternal(absl::string_view label,
   HARD_ASSERT(transaction_ == nullptr,
               "Starting a transaction while one is already in progress");
 
+  auto start = std::chrono::steady_clock::now();
+  TraceSpan span("persistence", label);
   transaction_ = absl::make_unique<LevelDbTransaction>(db_.get(), label);
   reference_delegate_->OnTransactionStarted(label);
 
   block();
 
   reference_delegate_->OnTransactionCommitted();
-  transaction_->Commit();
+  {
+    TraceSpan commit_span("persistence", "Commit");
+    transaction_->Commit();
+  }
   transaction_.reset();
+
+  MetricsRegistry::GetInstance()
+      .GetHistogram("leveldb.transaction_micros", label)
+      .RecordMicrosSince(start);
+}
+
+void LevelDbPersistence::RunReadOnlyInternal(absl::string_view label,
+                                             std::function<void()> block) {
+  HARD_ASSERT(read_only_transaction == nullptr,
+              "Starting a read-only transaction while one is already in "
+              "progress");
+
+  // Read-only transactions neither write nor change sequence numbers, so the
+  // reference delegate is not involved.
+  std::unique_ptr<LevelDbTransaction> transaction =
+      LevelDbTransaction::ReadOnly(db_.get(), label);
+  read_only_transaction = transaction.get();
+
+  auto start = std::chrono::steady_clock::now();
+  {
+    TraceSpan span("persistence", label);
+    block();
+  }
+
+  read_only_transaction = nullptr;
+  MetricsRegistry::GetInstance()
+      .GetHistogram("leveldb.read_only_transaction_micros", label)
+      .RecordMicrosSince(start);
 }
 
 leveldb::ReadOptions StandardReadOptions() {
@@ -56,12 +56,25 @@ class LevelDbPersistence : public Persistence {
   /**
    * Creates a LevelDB in the given directory and returns it or a Status object
    * containing details of the failure.
+   *
+   * @param compact_documents_enabled Whether the remote document cache writes
+   *     documents in the compact format. Documents written this way can't be
+   *     read by SDKs older than schema version 11; see
+   *     `api::Settings::set_compact_documents_enabled`.
    */
   static util::StatusOr<std::unique_ptr<LevelDbPersistence>> Create(
-      util::Path dir, LocalSerializer serializer, const LruParams& lru_params);
+      util::Path dir,
+      LocalSerializer serializer,
+      const LruParams& lru_params,
+      bool compact_documents_enabled = false);
 
   ~LevelDbPersistence();
 
+  /**
+   * Returns the transaction in progress on the calling thread: the read-only
+   * transaction started by `RunReadOnly` if there is one, otherwise the
+   * transaction started by `Run`.
+   */
   LevelDbTransaction* current_transaction();
 
   leveldb::DB* ptr() {
@@ -80,6 +93,10 @@ class LevelDbPersistence : public Persistence {
 
   model::ListenSequenceNumber current_sequence_number() const override;
 
+  bool supports_concurrent_reads() const override {
+    return true;
+  }
+
   void Shutdown() override;
 
   LevelDbBundleCache* bundle_cache() override;
@@ -106,6 +123,9 @@ class LevelDbPersistence : public Persistence {
   void RunInternal(absl::string_view label,
                    std::function<void()> block) override;
 
+  void RunReadOnlyInternal(absl::string_view label,
+                           std::function<void()> block) override;
+
  private:
   friend class LevelDbOverlayMigrationManagerTest;
   friend class LevelDbLocalStoreTest;
@@ -115,7 +135,8 @@ class LevelDbPersistence : public Persistence {
                      util::Path directory,
                      std::set<std::string> users,
                      LocalSerializer serializer,
-                     const LruParams& lru_params);
+                     const LruParams& lru_params,
+                     bool compact_documents_enabled);
 
   /**
    * The maximum number of operation per transaction.
@@ -135,7 +156,8 @@ class LevelDbPersistence : public Persistence {
       util::Path dir,
       LevelDbMigrations::SchemaVersion schema_version,
       LocalSerializer serializer,
-      const LruParams& lru_params);
+      const LruParams& lru_params,
+      bool compact_documents_enabled = false);
 
   void DeleteAllFieldIndexes() override;
 
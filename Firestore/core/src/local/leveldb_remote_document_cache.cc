@@ -16,14 +16,19 @@
 
 #include "Firestore/core/src/local/leveldb_remote_document_cache.h"
 
+#include <algorithm>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
 #include <string>
 #include <thread>  // NOLINT(build/c++11)
 #include <utility>
+#include <vector>
 
 #include "Firestore/Protos/nanopb/firestore/local/maybe_document.nanopb.h"
 #include "Firestore/core/src/core/query.h"
 #include "Firestore/core/src/local/leveldb_key.h"
 #include "Firestore/core/src/local/leveldb_persistence.h"
+#include "Firestore/core/src/local/leveldb_transaction.h"
 #include "Firestore/core/src/local/local_serializer.h"
 #include "Firestore/core/src/local/query_context.h"
 #include "Firestore/core/src/model/document_key_set.h"
@@ -33,9 +38,11 @@
 #include "Firestore/core/src/nanopb/message.h"
 #include "Firestore/core/src/nanopb/reader.h"
 #include "Firestore/core/src/util/background_queue.h"
+#include "Firestore/core/src/util/comparison.h"
 #include "Firestore/core/src/util/executor.h"
 #include "Firestore/core/src/util/status.h"
 #include "Firestore/core/src/util/string_util.h"
+#include "absl/memory/memory.h"
 #include "leveldb/db.h"
 
 namespace firebase {
@@ -89,6 +96,39 @@ class AsyncResults {
   std::mutex mutex_;
 };
 
+/**
+ * The number of rows each task decodes in `GetAllExisting`. Large enough to
+ * amortize the cost of scheduling a task, small enough to keep every thread
+ * busy on moderately sized collections.
+ */
+constexpr size_t kDecodeChunkSize = 256;
+
+/** A contiguous block of rows read by a scan, decoded by a single task. */
+struct DecodeChunk {
+  struct Row {
+    DocumentKey key;
+    SnapshotVersion read_time;
+    std::string contents;
+  };
+
+  std::vector<Row> rows;
+  std::vector<std::pair<DocumentKey, MutableDocument>> results;
+};
+
+/**
+ * Sorts the given rows by key, unless they already are, which is the case for
+ * documents given in key order.
+ */
+void SortRows(LevelDbTransaction::Rows* rows) {
+  auto by_key = [](const std::pair<std::string, std::string>& lhs,
+                   const std::pair<std::string, std::string>& rhs) {
+    return lhs.first < rhs.first;
+  };
+  if (!std::is_sorted(rows->begin(), rows->end(), by_key)) {
+    std::sort(rows->begin(), rows->end(), by_key);
+  }
+}
+
 }  // namespace
 
 LevelDbRemoteDocumentCache::LevelDbRemoteDocumentCache(
@@ -111,18 +151,110 @@ void LevelDbRemoteDocumentCache::Add(const MutableDocument& document,
   const DocumentKey& key = document.key();
   const ResourcePath& path = key.path();
 
+  int64_t collection_path_id = InternCollectionPathId(path.PopLast());
+
   std::string ldb_document_key = LevelDbRemoteDocumentKey::Key(key);
-  db_->current_transaction()->Put(ldb_document_key,
-                                  serializer_->EncodeMaybeDocument(document));
+  db_->current_transaction()->Put(
+      ldb_document_key, EncodeMaybeDocument(document, collection_path_id));
 
-  std::string ldb_read_time_key = LevelDbRemoteDocumentReadTimeKey::Key(
-      path.PopLast(), read_time, path.last_segment());
+  std::string ldb_read_time_key = LevelDbRemoteDocumentCompactReadTimeKey::Key(
+      collection_path_id, read_time, path.last_segment());
   db_->current_transaction()->Put(ldb_read_time_key, "");
 
+  // Older clients only read the legacy index, so it's kept up to date while
+  // they can still open the database. Compact documents already rule that out.
+  if (!compact_documents_enabled_) {
+    std::string ldb_legacy_read_time_key =
+        LevelDbRemoteDocumentReadTimeKey::Key(path.PopLast(), read_time,
+                                              path.last_segment());
+    db_->current_transaction()->Put(ldb_legacy_read_time_key, "");
+  }
+
   NOT_NULL(index_manager_);
   index_manager_->AddToCollectionParentIndex(document.key().path().PopLast());
 }
 
+void LevelDbRemoteDocumentCache::AddAll(
+    const std::vector<MutableDocument>& documents,
+    const SnapshotVersion& read_time) {
+  LevelDbTransaction* transaction = db_->current_transaction();
+  LevelDbTransaction::Rows document_rows;
+  LevelDbTransaction::Rows read_time_rows;
+  LevelDbTransaction::Rows legacy_read_time_rows;
+  document_rows.reserve(documents.size());
+  read_time_rows.reserve(documents.size());
+  if (!compact_documents_enabled_) {
+    legacy_read_time_rows.reserve(documents.size());
+  }
+  std::vector<ResourcePath> collection_paths;
+
+  {
+    // Everything that needs interned IDs is encoded under a single lock.
+    std::lock_guard<std::mutex> lock(collection_path_ids_mutex_);
+    LevelDbCollectionPathIds& path_ids = collection_path_ids();
+    LevelDbFieldNameIds& field_names = field_name_ids();
+
+    int64_t collection_path_id = 0;
+    LocalSerializer::FieldNameInterner interner =
+        [&](absl::string_view field_name) {
+          return field_names.Intern(collection_path_id, field_name,
+                                    transaction);
+        };
+
+    for (const MutableDocument& document : documents) {
+      const DocumentKey& key = document.key();
+      const ResourcePath& path = key.path();
+
+      // In key order, the documents of a collection are mostly adjacent, so
+      // its ID only needs to be looked up when the collection changes.
+      ResourcePath collection_path = path.PopLast();
+      if (collection_paths.empty() ||
+          collection_paths.back() != collection_path) {
+        collection_path_id = path_ids.Intern(collection_path, transaction);
+        collection_paths.push_back(std::move(collection_path));
+      }
+
+      document_rows.emplace_back(
+          LevelDbRemoteDocumentKey::Key(key),
+          compact_documents_enabled_
+              ? serializer_->EncodeCompactMaybeDocument(document, interner)
+              : nanopb::MakeStdString(
+                    serializer_->EncodeMaybeDocument(document)));
+      read_time_rows.emplace_back(
+          LevelDbRemoteDocumentCompactReadTimeKey::Key(
+              collection_path_id, read_time, path.last_segment()),
+          "");
+      if (!compact_documents_enabled_) {
+        legacy_read_time_rows.emplace_back(
+            LevelDbRemoteDocumentReadTimeKey::Key(
+                collection_paths.back(), read_time, path.last_segment()),
+            "");
+      }
+    }
+  }
+
+  SortRows(&document_rows);
+  SortRows(&read_time_rows);
+  SortRows(&legacy_read_time_rows);
+  transaction->PutAll(std::move(document_rows));
+  transaction->PutAll(std::move(read_time_rows));
+  transaction->PutAll(std::move(legacy_read_time_rows));
+
+  // Subcollections can interrupt the run of a collection, so the same parent
+  // may have been seen more than once.
+  std::sort(collection_paths.begin(), collection_paths.end(),
+            [](const ResourcePath& lhs, const ResourcePath& rhs) {
+              return lhs.CompareTo(rhs) == util::ComparisonResult::Ascending;
+            });
+  collection_paths.erase(
+      std::unique(collection_paths.begin(), collection_paths.end()),
+      collection_paths.end());
+  NOT_NULL(index_manager_);
+  for (const ResourcePath& collection_path : collection_paths) {
+    index_manager_->AddToCollectionParentIndex(collection_path);
+  }
+}
+
 void LevelDbRemoteDocumentCache::Remove(const DocumentKey& key) {
   std::string ldb_key = LevelDbRemoteDocumentKey::Key(key);
   db_->current_transaction()->Delete(ldb_key);
@@ -144,16 +276,23 @@ MutableDocument LevelDbRemoteDocumentCache::Get(const DocumentKey& key) const {
 
 MutableDocumentMap LevelDbRemoteDocumentCache::GetAll(
     const DocumentKeySet& keys) const {
+  LoadInternedIds();
   BackgroundQueue tasks(executor_.get());
   AsyncResults<std::pair<DocumentKey, MutableDocument>> results;
 
-  LevelDbRemoteDocumentKey current_key;
   auto it = db_->current_transaction()->NewIterator();
 
+  // `keys` is sorted, so the rows are read in a single forward pass. After a
+  // row is consumed the iterator is advanced past it; it then rests on the
+  // first row after the previous key, which makes a seek unnecessary whenever
+  // that row is at or beyond the next key.
   for (const DocumentKey& key : keys) {
-    it->Seek(LevelDbRemoteDocumentKey::Key(key));
-    if (!it->Valid() || !current_key.Decode(it->key()) ||
-        current_key.document_key() != key) {
+    std::string row_key = LevelDbRemoteDocumentKey::Key(key);
+    if (!it->Valid() || it->key() < row_key) {
+      it->Seek(row_key);
+    }
+
+    if (!it->Valid() || it->key() != row_key) {
       results.Insert(
           std::make_pair(key, MutableDocument::InvalidDocument(key)));
     } else {
@@ -161,6 +300,7 @@ MutableDocumentMap LevelDbRemoteDocumentCache::GetAll(
       tasks.Execute([this, &results, &key, contents] {
         results.Insert(std::make_pair(key, DecodeMaybeDocument(contents, key)));
       });
+      it->Next();
     }
   }
 
@@ -177,24 +317,71 @@ MutableDocumentMap LevelDbRemoteDocumentCache::GetAllExisting(
     DocumentVersionMap&& remote_map,
     const core::Query& query,
     const model::OverlayByDocumentKeyMap& mutated_docs) const {
+  std::vector<std::pair<DocumentKey, SnapshotVersion>> keys(remote_map.begin(),
+                                                            remote_map.end());
+  std::sort(keys.begin(), keys.end(),
+            [](const std::pair<DocumentKey, SnapshotVersion>& lhs,
+               const std::pair<DocumentKey, SnapshotVersion>& rhs) {
+              return lhs.first < rhs.first;
+            });
+
+  // The rows are read by a single forward scan on this thread and handed to
+  // the executor in chunks. Each task decodes and filters a whole chunk into
+  // the chunk's own buffer, so tasks never contend with each other.
+  LoadInternedIds();
   BackgroundQueue tasks(executor_.get());
-  AsyncResults<std::pair<DocumentKey, MutableDocument>> results;
-  for (const auto& key_version : remote_map) {
-    tasks.Execute([this, &results, &key_version, query, &mutated_docs] {
-      auto document = Get(key_version.first).WithReadTime(key_version.second);
+  std::vector<std::unique_ptr<DecodeChunk>> chunks;
+  auto decode = [this, &query, &mutated_docs](DecodeChunk* chunk) {
+    for (DecodeChunk::Row& row : chunk->rows) {
+      MutableDocument document = DecodeMaybeDocument(row.contents, row.key);
+      document.WithReadTime(row.read_time);
       if (document.is_found_document() &&
           // Either the document matches the given query, or it is mutated.
           (query.Matches(document) ||
-           mutated_docs.find(key_version.first) != mutated_docs.end())) {
-        results.Insert(std::make_pair(key_version.first, std::move(document)));
+           mutated_docs.find(row.key) != mutated_docs.end())) {
+        chunk->results.emplace_back(std::move(row.key), std::move(document));
       }
-    });
+    }
+    chunk->rows.clear();
+    chunk->rows.shrink_to_fit();
+  };
+
+  auto it = db_->current_transaction()->NewIterator();
+  DecodeChunk* chunk = nullptr;
+  for (auto& key_version : keys) {
+    std::string row_key = LevelDbRemoteDocumentKey::Key(key_version.first);
+    if (!it->Valid() || it->key() < row_key) {
+      it->Seek(row_key);
+    }
+    if (!it->Valid() || it->key() != row_key) {
+      continue;
+    }
+
+    if (chunk == nullptr) {
+      chunks.push_back(absl::make_unique<DecodeChunk>());
+      chunk = chunks.back().get();
+      chunk->rows.reserve(kDecodeChunkSize);
+    }
+    chunk->rows.push_back({std::move(key_version.first), key_version.second,
+                           it->value()});
+    it->Next();
+
+    if (chunk->rows.size() == kDecodeChunkSize) {
+      tasks.Execute([decode, chunk] { decode(chunk); });
+      chunk = nullptr;
+    }
+  }
+  if (chunk != nullptr) {
+    tasks.Execute([decode, chunk] { decode(chunk); });
   }
   tasks.AwaitAll();
 
+  // The chunks were filled in key order, so the results are already sorted.
   MutableDocumentMap map;
-  for (const auto& entry : results.Result()) {
-    map = map.insert(entry.first, entry.second);
+  for (const auto& decoded : chunks) {
+    for (auto& entry : decoded->results) {
+      map = map.insert(entry.first, std::move(entry.second));
+    }
   }
   return map;
 }
@@ -245,19 +432,24 @@ MutableDocumentMap LevelDbRemoteDocumentCache::GetDocumentsMatchingQuery(
   // last_limbo_free_snapshot_version (`since_read_time`) have a read time
   // set.
   auto path = query.path();
-  std::string start_key =
-      LevelDbRemoteDocumentReadTimeKey::KeyPrefix(path, offset.read_time());
+  absl::optional<int64_t> collection_path_id = FindCollectionPathId(path);
+  if (!collection_path_id) {
+    // A collection without an interned ID has never held a document.
+    return {};
+  }
+
+  std::string start_key = LevelDbRemoteDocumentCompactReadTimeKey::KeyPrefix(
+      *collection_path_id, offset.read_time());
   auto it = db_->current_transaction()->NewIterator();
   it->Seek(util::ImmediateSuccessor(start_key));
 
   DocumentVersionMap remote_map;
 
-  LevelDbRemoteDocumentReadTimeKey current_key;
+  LevelDbRemoteDocumentCompactReadTimeKey current_key;
   for (; it->Valid() && current_key.Decode(it->key()) &&
          (!limit.has_value() || remote_map.size() < limit);
        it->Next()) {
-    const ResourcePath& collection_path = current_key.collection_path();
-    if (collection_path != path) {
+    if (current_key.collection_path_id() != *collection_path_id) {
       break;
     }
 
@@ -283,13 +475,34 @@ MutableDocumentMap LevelDbRemoteDocumentCache::GetDocumentsMatchingQuery(
                                                     query, mutated_docs);
 }
 
+std::string LevelDbRemoteDocumentCache::EncodeMaybeDocument(
+    const MutableDocument& document, int64_t collection_path_id) {
+  if (!compact_documents_enabled_) {
+    return nanopb::MakeStdString(serializer_->EncodeMaybeDocument(document));
+  }
+
+  std::lock_guard<std::mutex> lock(collection_path_ids_mutex_);
+  LevelDbFieldNameIds& ids = field_name_ids();
+  LevelDbTransaction* transaction = db_->current_transaction();
+  return serializer_->EncodeCompactMaybeDocument(
+      document, [&](absl::string_view field_name) {
+        return ids.Intern(collection_path_id, field_name, transaction);
+      });
+}
+
 MutableDocument LevelDbRemoteDocumentCache::DecodeMaybeDocument(
     absl::string_view encoded, const DocumentKey& key) const {
   StringReader reader{encoded};
 
-  auto message = Message<firestore_client_MaybeDocument>::TryParse(&reader);
-  MutableDocument maybe_document =
-      serializer_->DecodeMaybeDocument(&reader, *message);
+  MutableDocument maybe_document;
+  if (LocalSerializer::IsCompactMaybeDocument(encoded)) {
+    auto field_names = FindFieldNames(key.path().PopLast());
+    maybe_document = serializer_->DecodeCompactMaybeDocument(
+        reader.context(), encoded, *field_names);
+  } else {
+    auto message = Message<firestore_client_MaybeDocument>::TryParse(&reader);
+    maybe_document = serializer_->DecodeMaybeDocument(&reader, *message);
+  }
 
   if (!reader.ok()) {
     HARD_FAIL("MaybeDocument proto failed to parse: %s",
@@ -302,10 +515,65 @@ MutableDocument LevelDbRemoteDocumentCache::DecodeMaybeDocument(
   return maybe_document;
 }
 
+absl::optional<int64_t> LevelDbRemoteDocumentCache::FindCollectionPathId(
+    const ResourcePath& collection_path) const {
+  std::lock_guard<std::mutex> lock(collection_path_ids_mutex_);
+  return collection_path_ids().Find(collection_path);
+}
+
+int64_t LevelDbRemoteDocumentCache::InternCollectionPathId(
+    const ResourcePath& collection_path) {
+  std::lock_guard<std::mutex> lock(collection_path_ids_mutex_);
+  return collection_path_ids().Intern(collection_path,
+                                      db_->current_transaction());
+}
+
+std::shared_ptr<const LevelDbFieldNameIds::FieldNames>
+LevelDbRemoteDocumentCache::FindFieldNames(
+    const ResourcePath& collection_path) const {
+  std::lock_guard<std::mutex> lock(collection_path_ids_mutex_);
+  absl::optional<int64_t> collection_path_id =
+      collection_path_ids().Find(collection_path);
+  // Without an interned collection path there can't be any field names; the
+  // empty dictionary makes decoding fail on the first ID.
+  return field_name_ids().Names(collection_path_id.value_or(0));
+}
+
+void LevelDbRemoteDocumentCache::LoadInternedIds() const {
+  std::lock_guard<std::mutex> lock(collection_path_ids_mutex_);
+  collection_path_ids();
+  field_name_ids();
+}
+
+LevelDbCollectionPathIds& LevelDbRemoteDocumentCache::collection_path_ids()
+    const {
+  if (!collection_path_ids_) {
+    collection_path_ids_ =
+        LevelDbCollectionPathIds::Load(db_->current_transaction());
+  }
+  return *collection_path_ids_;
+}
+
+LevelDbFieldNameIds& LevelDbRemoteDocumentCache::field_name_ids() const {
+  if (!field_name_ids_) {
+    field_name_ids_ = LevelDbFieldNameIds::Load(db_->current_transaction());
+  }
+  return *field_name_ids_;
+}
+
+void LevelDbRemoteDocumentCache::TEST_SetDecodeConcurrency(int threads) {
+  executor_ = Executor::CreateConcurrent("com.google.firebase.firestore.query",
+                                         threads);
+}
+
 void LevelDbRemoteDocumentCache::SetIndexManager(IndexManager* manager) {
   index_manager_ = NOT_NULL(manager);
 }
 
+void LevelDbRemoteDocumentCache::SetCompactDocumentsEnabled(bool enabled) {
+  compact_documents_enabled_ = enabled;
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
@@ -18,11 +18,14 @@
 #define FIRESTORE_CORE_SRC_LOCAL_LEVELDB_REMOTE_DOCUMENT_CACHE_H_
 
 #include <memory>
+#include <mutex>  // NOLINT(build/c++11)
 #include <string>
 #include <thread>  // NOLINT(build/c++11)
 #include <vector>
 
 #include "Firestore/core/src/core/query.h"
+#include "Firestore/core/src/local/leveldb_collection_path_ids.h"
+#include "Firestore/core/src/local/leveldb_field_name_ids.h"
 #include "Firestore/core/src/local/leveldb_index_manager.h"
 #include "Firestore/core/src/local/remote_document_cache.h"
 #include "Firestore/core/src/model/model_fwd.h"
@@ -57,6 +60,8 @@ class LevelDbRemoteDocumentCache : public RemoteDocumentCache {
 
   void Add(const model::MutableDocument& document,
            const model::SnapshotVersion& read_time) override;
+  void AddAll(const std::vector<model::MutableDocument>& documents,
+              const model::SnapshotVersion& read_time) override;
   void Remove(const model::DocumentKey& key) override;
 
   model::MutableDocument Get(const model::DocumentKey& key) const override;
@@ -79,6 +84,25 @@ class LevelDbRemoteDocumentCache : public RemoteDocumentCache {
 
   void SetIndexManager(IndexManager* manager) override;
 
+  /**
+   * Sets whether documents are written in the compact format, which refers to
+   * field names by IDs scoped to the document's collection. Disabled by
+   * default: SDK versions before schema version 11 can't read compact rows, so
+   * a database that holds any can no longer be opened by them. Rows in either
+   * format are always readable. While enabled, the legacy read time index is
+   * no longer written either, since only the compact one is read and older
+   * SDKs can't use the database anyway. Apps opt in through
+   * `api::Settings::set_compact_documents_enabled`.
+   */
+  void SetCompactDocumentsEnabled(bool enabled);
+
+  /**
+   * Replaces the executor that decodes documents with one running `threads`
+   * threads. By default there is one thread per hardware thread. Exposed for
+   * benchmarks.
+   */
+  void TEST_SetDecodeConcurrency(int threads);
+
  private:
   /**
    * Looks up a set of entries in the cache, returning only existing entries of
@@ -89,9 +113,53 @@ class LevelDbRemoteDocumentCache : public RemoteDocumentCache {
       const core::Query& query,
       const model::OverlayByDocumentKeyMap& mutated_docs = {}) const;
 
+  /**
+   * Encodes the given document, in the compact format if enabled. Field names
+   * are interned in the collection with the given ID in the current
+   * transaction.
+   */
+  std::string EncodeMaybeDocument(const model::MutableDocument& document,
+                                  int64_t collection_path_id);
+
   model::MutableDocument DecodeMaybeDocument(
       absl::string_view encoded, const model::DocumentKey& key) const;
 
+  /** Returns the ID interned for the given collection path, if any. */
+  absl::optional<int64_t> FindCollectionPathId(
+      const model::ResourcePath& collection_path) const;
+
+  /**
+   * Returns the ID interned for the given collection path, interning it in the
+   * current transaction if it has none yet.
+   */
+  int64_t InternCollectionPathId(const model::ResourcePath& collection_path);
+
+  /**
+   * Returns a snapshot of the field names interned for the given collection,
+   * indexed by ID.
+   */
+  std::shared_ptr<const LevelDbFieldNameIds::FieldNames> FindFieldNames(
+      const model::ResourcePath& collection_path) const;
+
+  /**
+   * Reads the interned IDs from the database unless they have been read
+   * already. Decode tasks look up field names on other threads, which must not
+   * use the current transaction, so this runs before any are scheduled.
+   */
+  void LoadInternedIds() const;
+
+  /**
+   * Returns the interned collection path IDs, reading them from the database
+   * on first use. Must be called with `collection_path_ids_mutex_` held.
+   */
+  LevelDbCollectionPathIds& collection_path_ids() const;
+
+  /**
+   * Returns the interned field name IDs, reading them from the database on
+   * first use. Must be called with `collection_path_ids_mutex_` held.
+   */
+  LevelDbFieldNameIds& field_name_ids() const;
+
   // The LevelDbRemoteDocumentCache instance is owned by LevelDbPersistence.
   LevelDbPersistence* db_;
   // The LevelDbIndexManager instance is owned by LevelDbPersistence.
@@ -100,6 +168,15 @@ class LevelDbRemoteDocumentCache : public RemoteDocumentCache {
   LocalSerializer* serializer_ = nullptr;
 
   std::unique_ptr<util::Executor> executor_;
+
+  bool compact_documents_enabled_ = false;
+
+  // Loaded lazily because the cache is created before migrations have run.
+  // Guarded by the mutex because read-only transactions and decode tasks look
+  // up IDs from other threads while the worker interns new ones.
+  mutable absl::optional<LevelDbCollectionPathIds> collection_path_ids_;
+  mutable absl::optional<LevelDbFieldNameIds> field_name_ids_;
+  mutable std::mutex collection_path_ids_mutex_;
 };
 
 }  // namespace local
@@ -16,9 +16,11 @@
 
 #include "Firestore/core/src/local/leveldb_target_cache.h"
 
+#include <algorithm>
 #include <string>
 #include <unordered_set>
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/src/local/leveldb_key.h"
 #include "Firestore/core/src/local/leveldb_persistence.h"
@@ -121,6 +123,21 @@ void LevelDbTargetCache::UpdateTarget(const TargetData& target_data) {
   }
 }
 
+void LevelDbTargetCache::UpdateTargets(
+    const std::vector<TargetData>& targets) {
+  bool metadata_updated = false;
+  for (const TargetData& target_data : targets) {
+    Save(target_data);
+    if (UpdateMetadata(target_data)) {
+      metadata_updated = true;
+    }
+  }
+
+  if (metadata_updated) {
+    SaveMetadata();
+  }
+}
+
 void LevelDbTargetCache::RemoveTarget(const TargetData& target_data) {
   TargetId target_id = target_data.target_id();
 
@@ -269,6 +286,56 @@ void LevelDbTargetCache::RemoveMatchingKeys(const DocumentKeySet& keys,
   }
 }
 
+void LevelDbTargetCache::ApplyMatchingKeyChanges(
+    const std::vector<TargetKeyChanges>& changes) {
+  std::vector<std::string> removed_rows;
+  LevelDbTransaction::Rows added_rows;
+  DocumentKeySet removed_keys;
+  DocumentKeySet added_keys;
+
+  for (const TargetKeyChanges& change : changes) {
+    for (const DocumentKey& key : change.removed) {
+      removed_rows.push_back(
+          LevelDbTargetDocumentKey::Key(change.target_id, key));
+      removed_rows.push_back(
+          LevelDbDocumentTargetKey::Key(key, change.target_id));
+      removed_keys = removed_keys.insert(key);
+    }
+    // See AddMatchingKeys() for why the values are empty.
+    for (const DocumentKey& key : change.added) {
+      added_rows.emplace_back(
+          LevelDbTargetDocumentKey::Key(change.target_id, key), "");
+      added_rows.emplace_back(
+          LevelDbDocumentTargetKey::Key(key, change.target_id), "");
+      added_keys = added_keys.insert(key);
+    }
+  }
+
+  // Rows for different targets never collide, so removals can all be applied
+  // before additions without changing the outcome.
+  std::sort(removed_rows.begin(), removed_rows.end());
+  std::sort(added_rows.begin(), added_rows.end());
+
+  auto* transaction = db_->current_transaction();
+  for (const std::string& row : removed_rows) {
+    transaction->Delete(row);
+  }
+
+  transaction->PutAll(std::move(added_rows));
+
+  // A document that moves between targets in the same event is still
+  // referenced, so the reference delegate only needs to hear about it once.
+  auto* reference_delegate = db_->reference_delegate();
+  for (const DocumentKey& key : added_keys) {
+    reference_delegate->AddReference(key);
+  }
+  for (const DocumentKey& key : removed_keys) {
+    if (!added_keys.contains(key)) {
+      reference_delegate->RemoveReference(key);
+    }
+  }
+}
+
 void LevelDbTargetCache::RemoveMatchingKeysForTarget(TargetId target_id) {
   std::string index_prefix = LevelDbTargetDocumentKey::KeyPrefix(target_id);
   auto index_iterator = db_->current_transaction()->NewIterator();
@@ -19,6 +19,7 @@
 
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include "Firestore/Protos/nanopb/firestore/local/target.nanopb.h"
 #include "Firestore/core/src/local/target_cache.h"
@@ -68,6 +69,8 @@ class LevelDbTargetCache : public TargetCache {
 
   void UpdateTarget(const TargetData& target_data) override;
 
+  void UpdateTargets(const std::vector<TargetData>& targets) override;
+
   void RemoveTarget(const TargetData& target_data) override;
 
   absl::optional<TargetData> GetTarget(const core::Target& target) override;
@@ -93,6 +96,13 @@ class LevelDbTargetCache : public TargetCache {
   void RemoveMatchingKeys(const model::DocumentKeySet& keys,
                           model::TargetId target_id) override;
 
+  /**
+   * Applies the key changes of several targets, writing the target-document
+   * and document-target index rows in key order.
+   */
+  void ApplyMatchingKeyChanges(
+      const std::vector<TargetKeyChanges>& changes) override;
+
   /** Removes all document keys in the query results of the given target ID. */
   void RemoveMatchingKeysForTarget(model::TargetId target_id) override;
 
@@ -14,7 +14,9 @@
  * limitations under the License.
  */
 
+#include <iterator>
 #include <type_traits>
+#include <utility>
 
 #include "Firestore/core/src/local/leveldb_transaction.h"
 
@@ -148,6 +150,20 @@ LevelDbTransaction::LevelDbTransaction(DB* db,
       label_(label) {
 }
 
+LevelDbTransaction::~LevelDbTransaction() {
+  if (snapshot_) {
+    db_->ReleaseSnapshot(snapshot_);
+  }
+}
+
+std::unique_ptr<LevelDbTransaction> LevelDbTransaction::ReadOnly(
+    DB* db, absl::string_view label) {
+  auto transaction = absl::make_unique<LevelDbTransaction>(db, label);
+  transaction->snapshot_ = db->GetSnapshot();
+  transaction->read_options_.snapshot = transaction->snapshot_;
+  return transaction;
+}
+
 const ReadOptions& LevelDbTransaction::DefaultReadOptions() {
   static_assert(std::is_trivially_destructible<ReadOptions>::value,
                 "ReadOptions should be trivially-destructible; otherwise, it "
@@ -169,11 +185,40 @@ const WriteOptions& LevelDbTransaction::DefaultWriteOptions() {
 }
 
 void LevelDbTransaction::Put(std::string key, std::string value) {
+  HARD_ASSERT(!read_only(), "Writing to read-only transaction %s", label_);
   deletions_.erase(key);
   mutations_[std::move(key)] = std::move(value);
   version_++;
 }
 
+void LevelDbTransaction::PutAll(Rows rows) {
+  HARD_ASSERT(!read_only(), "Writing to read-only transaction %s", label_);
+  auto hint = mutations_.end();
+  for (auto& row : rows) {
+    if (!deletions_.empty()) {
+      deletions_.erase(row.first);
+    }
+
+    // While the rows are in order, each one belongs right after the previous
+    // one, so the map only has to be searched when that isn't the case.
+    bool hint_is_position =
+        (hint == mutations_.end() || row.first <= hint->first) &&
+        (hint == mutations_.begin() || std::prev(hint)->first < row.first);
+    if (!hint_is_position) {
+      hint = mutations_.lower_bound(row.first);
+    }
+
+    if (hint != mutations_.end() && hint->first == row.first) {
+      hint->second = std::move(row.second);
+    } else {
+      hint = mutations_.emplace_hint(hint, std::move(row.first),
+                                     std::move(row.second));
+    }
+    ++hint;
+  }
+  version_++;
+}
+
 std::unique_ptr<LevelDbTransaction::Iterator>
 LevelDbTransaction::NewIterator() {
   return absl::make_unique<LevelDbTransaction::Iterator>(this);
@@ -195,6 +240,7 @@ Status LevelDbTransaction::Get(absl::string_view key, std::string* value) {
 }
 
 void LevelDbTransaction::Delete(absl::string_view key) {
+  HARD_ASSERT(!read_only(), "Deleting from read-only transaction %s", label_);
   std::string to_delete(key);
   deletions_.insert(to_delete);
   mutations_.erase(to_delete);
@@ -202,6 +248,7 @@ void LevelDbTransaction::Delete(absl::string_view key) {
 }
 
 void LevelDbTransaction::Commit() {
+  HARD_ASSERT(!read_only(), "Committing read-only transaction %s", label_);
   WriteBatch batch;
   for (const auto& deletion : deletions_) {
     batch.Delete(deletion);
@@ -23,6 +23,7 @@
 #include <set>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/src/nanopb/byte_string.h"
 #include "Firestore/core/src/nanopb/message.h"
@@ -44,6 +45,9 @@ class LevelDbTransaction {
   using Mutations = std::map<std::string, std::string>;
 
  public:
+  /** Rows to write, as pairs of keys and values. */
+  using Rows = std::vector<std::pair<std::string, std::string>>;
+
   /**
    * Iterator iterates over a merged view of pending changes from the
    * transaction and any unchanged values in the underlying leveldb instance.
@@ -135,6 +139,19 @@ class LevelDbTransaction {
 
   LevelDbTransaction& operator=(const LevelDbTransaction& other) = delete;
 
+  ~LevelDbTransaction();
+
+  /**
+   * Creates a read-only transaction that reads from a snapshot of `db` taken
+   * now. The snapshot contains every write committed before this call and none
+   * committed after it, so the transaction observes a consistent state even
+   * while other transactions commit concurrently.
+   *
+   * A read-only transaction must not be written to or committed.
+   */
+  static std::unique_ptr<LevelDbTransaction> ReadOnly(leveldb::DB* db,
+                                                      absl::string_view label);
+
   /**
    * Returns a default set of ReadOptions
    */
@@ -145,6 +162,11 @@ class LevelDbTransaction {
    */
   static const leveldb::WriteOptions& DefaultWriteOptions();
 
+  /** Returns true if this transaction reads from a snapshot. */
+  bool read_only() const {
+    return snapshot_ != nullptr;
+  }
+
   size_t changed_keys() const {
     return mutations_.size() + deletions_.size();
   }
@@ -161,6 +183,16 @@ class LevelDbTransaction {
    */
   void Put(std::string key, std::string value);
 
+  /**
+   * Schedules each of the given rows to be set to its value when this
+   * transaction commits, as if by calling `Put()` for each of them.
+   *
+   * Rows given in key order are inserted right after each other instead of
+   * being looked up one by one, which makes this considerably cheaper than
+   * `Put()` for large ordered batches.
+   */
+  void PutAll(Rows rows);
+
   /**
    * Schedules the row identified by `key` to be set to the given protocol
    * buffer message when this transaction commits.
@@ -198,6 +230,8 @@ class LevelDbTransaction {
   Deletions deletions_;
   leveldb::ReadOptions read_options_;
   leveldb::WriteOptions write_options_;
+  // The snapshot read by a read-only transaction, released on destruction.
+  const leveldb::Snapshot* snapshot_ = nullptr;
   int32_t version_ = 0;
   std::string label_;
 };
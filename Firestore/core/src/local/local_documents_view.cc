@@ -173,27 +173,51 @@ DocumentMap LocalDocumentsView::GetDocumentsMatchingCollectionQuery(
       remote_document_cache_->GetDocumentsMatchingQuery(
           query, offset, context, absl::nullopt, overlays);
 
-  // As documents might match the query because of their overlay we need to
-  // include documents for all overlays in the initial document set.
+  // As documents might match the query because of their overlay, every
+  // overlay has to be visited as well. Walk the remote documents and the
+  // overlays together in key order, so that each document is visited once.
+  std::vector<const OverlayByDocumentKeyMap::value_type*> sorted_overlays;
+  sorted_overlays.reserve(overlays.size());
   for (const auto& entry : overlays) {
-    if (remote_documents.find(entry.first) == remote_documents.end()) {
-      remote_documents = remote_documents.insert(
-          entry.first, MutableDocument::InvalidDocument(entry.first));
-    }
+    sorted_overlays.push_back(&entry);
   }
-
-  // Apply the overlays and match against the query.
+  std::sort(sorted_overlays.begin(), sorted_overlays.end(),
+            [](const OverlayByDocumentKeyMap::value_type* lhs,
+               const OverlayByDocumentKeyMap::value_type* rhs) {
+              return lhs->first < rhs->first;
+            });
+
+  // All overlays are applied with the same local write time.
+  Timestamp local_write_time = Timestamp::Now();
   DocumentMap results;
-  for (const auto& entry : remote_documents) {
-    const auto& key = entry.first;
-    MutableDocument doc = entry.second;
-
-    auto overlay_it = overlays.find(key);
-    if (overlay_it != overlays.end()) {
-      (*overlay_it)
-          .second.mutation()
-          .ApplyToLocalView(doc, FieldMask(), Timestamp::Now());
+  auto remote_it = remote_documents.begin();
+  auto remote_end = remote_documents.end();
+  auto overlay_it = sorted_overlays.begin();
+  auto overlay_end = sorted_overlays.end();
+
+  while (remote_it != remote_end || overlay_it != overlay_end) {
+    if (overlay_it == overlay_end ||
+        (remote_it != remote_end && remote_it->first < (*overlay_it)->first)) {
+      // The remote document cache only returns documents without an overlay
+      // if they match the query.
+      results = results.insert(remote_it->first, remote_it->second);
+      ++remote_it;
+      continue;
     }
+
+    const DocumentKey& key = (*overlay_it)->first;
+    MutableDocument doc;
+    if (remote_it != remote_end && remote_it->first == key) {
+      doc = remote_it->second;
+      ++remote_it;
+    } else {
+      doc = MutableDocument::InvalidDocument(key);
+    }
+    (*overlay_it)
+        ->second.mutation()
+        .ApplyToLocalView(doc, FieldMask(), local_write_time);
+    ++overlay_it;
+
     // Finally, insert the documents that still match the query
     if (query.Matches(doc)) {
       results = results.insert(key, std::move(doc));
@@ -315,55 +339,33 @@ model::FieldMaskMap LocalDocumentsView::RecalculateAndSaveOverlays(
   std::vector<MutationBatch> batches =
       mutation_queue_->AllMutationBatchesAffectingDocumentKeys(std::move(keys));
 
+  // Replay the batches in ascending batch id order, remembering for each
+  // document the largest batch that mutates it. That batch id is stored with
+  // the document's overlay.
   model::FieldMaskMap masks;
-  // A reverse lookup map from batch id to the documents within that batch,
-  // ordered by batch id (note that std::map is ordered).
-  std::map<BatchId, DocumentKeySet> documents_by_batch_id;
-
-  // Apply mutations from mutation queue to the documents, collecting batch id
-  // and field masks along the way.
+  std::unordered_map<DocumentKey, BatchId, DocumentKeyHash> largest_batch_ids;
   for (const MutationBatch& batch : batches) {
-    for (const DocumentKey& key : batch.keys()) {
-      auto base_doc_it = docs.find(key);
-      if (base_doc_it == docs.end()) {
-        // If this batch has documents not included in passed in `docs`, skip
-        // them.
-        continue;
-      }
-      MutableDocument* base_doc = base_doc_it->second;
-
-      absl::optional<FieldMask> mask = FieldMask();
-      auto mask_it = masks.find(key);
-      if (mask_it != masks.end()) {
-        mask = mask_it->second;
+    batch.ApplyToLocalViews(docs, masks);
+    for (const Mutation& mutation : batch.mutations()) {
+      if (docs.find(mutation.key()) != docs.end()) {
+        largest_batch_ids[mutation.key()] = batch.batch_id();
       }
-      mask = batch.ApplyToLocalView(*base_doc, std::move(mask));
-      masks[key] = mask;
-      BatchId batch_id = batch.batch_id();
-      DocumentKeySet& documents = documents_by_batch_id[batch_id];
-      documents = documents.insert(key);
     }
   }
 
-  DocumentKeySet processed;
-  // Iterate in descending order of batch ids, skip documents that are already
-  // saved.
-  for (auto it = documents_by_batch_id.rbegin();
-       it != documents_by_batch_id.rend(); ++it) {
-    MutationByDocumentKeyMap overlays;
-    for (const DocumentKey& key : it->second) {
-      if (!processed.contains(key)) {
-        auto docs_it = docs.find(key);
-        HARD_ASSERT(docs_it != docs.end());
-        absl::optional<Mutation> mutation =
-            Mutation::CalculateOverlayMutation(*docs_it->second, masks[key]);
-        if (mutation.has_value()) {
-          overlays[key] = std::move(mutation).value();
-        }
-        processed = processed.insert(key);
-      }
+  // Compute each overlay once and save them grouped by batch id.
+  std::map<BatchId, MutationByDocumentKeyMap> overlays_by_batch_id;
+  for (const auto& entry : largest_batch_ids) {
+    const DocumentKey& key = entry.first;
+    MutationByDocumentKeyMap& overlays = overlays_by_batch_id[entry.second];
+    absl::optional<Mutation> mutation =
+        Mutation::CalculateOverlayMutation(*docs.at(key), masks.at(key));
+    if (mutation.has_value()) {
+      overlays[key] = std::move(mutation).value();
     }
-    document_overlay_cache_->SaveOverlays(it->first, overlays);
+  }
+  for (const auto& entry : overlays_by_batch_id) {
+    document_overlay_cache_->SaveOverlays(entry.first, entry.second);
   }
 
   return masks;
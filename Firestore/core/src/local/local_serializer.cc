@@ -21,6 +21,7 @@
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "Firestore/Protos/nanopb/firestore/bundle.nanopb.h"
 #include "Firestore/Protos/nanopb/firestore/local/maybe_document.nanopb.h"
@@ -40,7 +41,9 @@
 #include "Firestore/core/src/nanopb/byte_string.h"
 #include "Firestore/core/src/nanopb/message.h"
 #include "Firestore/core/src/nanopb/nanopb_util.h"
+#include "Firestore/core/src/nanopb/reader.h"
 #include "Firestore/core/src/util/hard_assert.h"
+#include "Firestore/core/src/util/read_context.h"
 #include "Firestore/core/src/util/statusor.h"
 #include "Firestore/core/src/util/string_format.h"
 #include "absl/types/span.h"
@@ -72,10 +75,144 @@ using nanopb::Reader;
 using nanopb::ReleaseFieldOwnership;
 using nanopb::SafeReadBoolean;
 using nanopb::SetRepeatedField;
+using nanopb::StringReader;
 using nanopb::Writer;
 using util::Status;
 using util::StringFormat;
 
+/**
+ * The first byte of a MaybeDocument in the compact format. A serialized proto
+ * never starts with a zero byte because zero is not a valid field number.
+ */
+constexpr char kCompactFormatMarker = '\0';
+
+/**
+ * The first byte of a field name that is spelled out in the compact format.
+ * Field name IDs are stored as the varint of the ID plus one, whose first byte
+ * is never zero.
+ */
+constexpr char kLiteralFieldNameMarker = '\0';
+
+void AppendVarint(std::string* out, uint64_t value) {
+  while (value >= 0x80) {
+    out->push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  out->push_back(static_cast<char>(value));
+}
+
+bool ReadVarint(absl::string_view* in, uint64_t* value) {
+  *value = 0;
+  for (int shift = 0; shift < 64 && !in->empty(); shift += 7) {
+    auto byte = static_cast<uint8_t>(in->front());
+    in->remove_prefix(1);
+    *value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void CompactFieldNames(google_firestore_v1_Value& value,
+                       const LocalSerializer::FieldNameInterner& intern);
+
+/** Replaces the keys of the given map entries and their values in place. */
+template <typename FieldsEntry>
+void CompactFieldNames(FieldsEntry* fields,
+                       pb_size_t fields_count,
+                       const LocalSerializer::FieldNameInterner& intern) {
+  std::string compact;
+  for (pb_size_t i = 0; i < fields_count; ++i) {
+    FieldsEntry& entry = fields[i];
+    absl::string_view field_name = nanopb::MakeStringView(entry.key);
+
+    compact.clear();
+    absl::optional<int64_t> field_name_id = intern(field_name);
+    if (field_name_id) {
+      AppendVarint(&compact, static_cast<uint64_t>(*field_name_id) + 1);
+    } else {
+      compact.push_back(kLiteralFieldNameMarker);
+      compact.append(field_name.data(), field_name.size());
+    }
+
+    std::free(entry.key);
+    entry.key = nanopb::MakeBytesArray(compact);
+    CompactFieldNames(entry.value, intern);
+  }
+}
+
+void CompactFieldNames(google_firestore_v1_Value& value,
+                       const LocalSerializer::FieldNameInterner& intern) {
+  if (value.which_value_type == google_firestore_v1_Value_map_value_tag) {
+    CompactFieldNames(value.map_value.fields, value.map_value.fields_count,
+                      intern);
+  } else if (value.which_value_type ==
+             google_firestore_v1_Value_array_value_tag) {
+    for (pb_size_t i = 0; i < value.array_value.values_count; ++i) {
+      CompactFieldNames(value.array_value.values[i], intern);
+    }
+  }
+}
+
+bool ExpandFieldNames(google_firestore_v1_Value& value,
+                      const std::vector<std::string>& field_names);
+
+/**
+ * Restores the keys of the given map entries and their values in place.
+ * Returns false if a key is malformed or refers to an unknown ID.
+ */
+template <typename FieldsEntry>
+bool ExpandFieldNames(FieldsEntry* fields,
+                      pb_size_t fields_count,
+                      const std::vector<std::string>& field_names) {
+  for (pb_size_t i = 0; i < fields_count; ++i) {
+    FieldsEntry& entry = fields[i];
+    absl::string_view compact = nanopb::MakeStringView(entry.key);
+    if (compact.empty()) {
+      return false;
+    }
+
+    absl::string_view field_name;
+    if (compact.front() == kLiteralFieldNameMarker) {
+      field_name = compact.substr(1);
+    } else {
+      uint64_t id_plus_one = 0;
+      if (!ReadVarint(&compact, &id_plus_one) || !compact.empty() ||
+          id_plus_one == 0 || id_plus_one > field_names.size()) {
+        return false;
+      }
+      field_name = field_names[id_plus_one - 1];
+    }
+
+    // `field_name` may point into the old key, so copy it before freeing.
+    pb_bytes_array_t* key =
+        nanopb::MakeBytesArray(field_name.data(), field_name.size());
+    std::free(entry.key);
+    entry.key = key;
+    if (!ExpandFieldNames(entry.value, field_names)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ExpandFieldNames(google_firestore_v1_Value& value,
+                      const std::vector<std::string>& field_names) {
+  if (value.which_value_type == google_firestore_v1_Value_map_value_tag) {
+    return ExpandFieldNames(value.map_value.fields,
+                            value.map_value.fields_count, field_names);
+  } else if (value.which_value_type ==
+             google_firestore_v1_Value_array_value_tag) {
+    for (pb_size_t i = 0; i < value.array_value.values_count; ++i) {
+      if (!ExpandFieldNames(value.array_value.values[i], field_names)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
 }  // namespace
 
 Message<firestore_client_MaybeDocument> LocalSerializer::EncodeMaybeDocument(
@@ -106,6 +243,39 @@ Message<firestore_client_MaybeDocument> LocalSerializer::EncodeMaybeDocument(
   UNREACHABLE();
 }
 
+size_t LocalSerializer::EncodedMaybeDocumentSize(
+    const MutableDocument& maybe_doc) const {
+  if (!maybe_doc.is_found_document()) {
+    // Deleted and unknown documents don't have contents to copy.
+    return nanopb::EncodedSize(EncodeMaybeDocument(maybe_doc));
+  }
+
+  // Build a proto that borrows the field keys and values of the document
+  // instead of cloning them like `EncodeDocument` does.
+  google_firestore_v1_MapValue fields_map = maybe_doc.value().map_value;
+  std::vector<google_firestore_v1_Document_FieldsEntry> fields(
+      fields_map.fields_count);
+  for (pb_size_t i = 0; i < fields_map.fields_count; ++i) {
+    fields[i].key = fields_map.fields[i].key;
+    fields[i].value = fields_map.fields[i].value;
+  }
+
+  firestore_client_MaybeDocument proto{};
+  proto.which_document_type = firestore_client_MaybeDocument_document_tag;
+  proto.has_committed_mutations = maybe_doc.has_committed_mutations();
+  proto.document.name = rpc_serializer_.EncodeKey(maybe_doc.key());
+  proto.document.fields_count = fields_map.fields_count;
+  proto.document.fields = fields.data();
+  proto.document.has_update_time = true;
+  proto.document.update_time =
+      rpc_serializer_.EncodeVersion(maybe_doc.version());
+
+  nanopb::SizingWriter writer;
+  writer.Write(firestore_client_MaybeDocument_fields, &proto);
+  std::free(proto.document.name);
+  return writer.size();
+}
+
 MutableDocument LocalSerializer::DecodeMaybeDocument(
     Reader* reader, firestore_client_MaybeDocument& proto) const {
   if (!reader->status().ok()) return {};
@@ -135,6 +305,53 @@ MutableDocument LocalSerializer::DecodeMaybeDocument(
   UNREACHABLE();
 }
 
+std::string LocalSerializer::EncodeCompactMaybeDocument(
+    const MutableDocument& maybe_doc,
+    const FieldNameInterner& intern_field_name) const {
+  Message<firestore_client_MaybeDocument> message =
+      EncodeMaybeDocument(maybe_doc);
+  if (message->which_document_type ==
+      firestore_client_MaybeDocument_document_tag) {
+    CompactFieldNames(message->document.fields,
+                      message->document.fields_count, intern_field_name);
+  }
+
+  std::string result(1, kCompactFormatMarker);
+  result.append(nanopb::MakeStdString(message));
+  return result;
+}
+
+bool LocalSerializer::IsCompactMaybeDocument(absl::string_view encoded) {
+  return !encoded.empty() && encoded.front() == kCompactFormatMarker;
+}
+
+MutableDocument LocalSerializer::DecodeCompactMaybeDocument(
+    util::ReadContext* context,
+    absl::string_view encoded,
+    const std::vector<std::string>& field_names) const {
+  if (!context->ok()) return {};
+  if (!IsCompactMaybeDocument(encoded)) {
+    context->Fail("MaybeDocument is not in the compact format");
+    return {};
+  }
+
+  StringReader reader{encoded.substr(1)};
+  auto message = Message<firestore_client_MaybeDocument>::TryParse(&reader);
+  if (reader.ok() && message->which_document_type ==
+                         firestore_client_MaybeDocument_document_tag) {
+    if (!ExpandFieldNames(message->document.fields,
+                          message->document.fields_count, field_names)) {
+      reader.Fail("Invalid field name in compact MaybeDocument");
+    }
+  }
+
+  MutableDocument result = DecodeMaybeDocument(&reader, *message);
+  if (!reader.ok()) {
+    context->set_status(reader.status());
+  }
+  return result;
+}
+
 google_firestore_v1_Document LocalSerializer::EncodeDocument(
     const MutableDocument& doc) const {
   google_firestore_v1_Document result{};
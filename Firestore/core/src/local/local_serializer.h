@@ -17,7 +17,10 @@
 #ifndef FIRESTORE_CORE_SRC_LOCAL_LOCAL_SERIALIZER_H_
 #define FIRESTORE_CORE_SRC_LOCAL_LOCAL_SERIALIZER_H_
 
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -26,6 +29,8 @@
 #include "Firestore/core/src/model/types.h"
 #include "Firestore/core/src/remote/serializer.h"
 #include "Firestore/core/src/util/status_fwd.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
 
 namespace firebase {
 namespace firestore {
@@ -50,6 +55,10 @@ class Reader;
 class Writer;
 }  // namespace nanopb
 
+namespace util {
+class ReadContext;
+}  // namespace util
+
 namespace bundle {
 
 class BundleMetadata;
@@ -92,6 +101,13 @@ class LocalSerializer {
   nanopb::Message<firestore_client_MaybeDocument> EncodeMaybeDocument(
       const model::MutableDocument& maybe_doc) const;
 
+  /**
+   * Returns the serialized size of `EncodeMaybeDocument(maybe_doc)` without
+   * copying the document contents or encoding them into a buffer.
+   */
+  size_t EncodedMaybeDocumentSize(
+      const model::MutableDocument& maybe_doc) const;
+
   /**
    * @brief Decodes nanopb proto representing a MaybeDocument proto to the
    * equivalent model.
@@ -100,6 +116,41 @@ class LocalSerializer {
   model::MutableDocument DecodeMaybeDocument(
       nanopb::Reader* reader, firestore_client_MaybeDocument& proto) const;
 
+  /**
+   * Returns the ID to store in place of the given field name in the compact
+   * format, or nullopt to store the name itself.
+   */
+  using FieldNameInterner =
+      std::function<absl::optional<int64_t>(absl::string_view field_name)>;
+
+  /**
+   * Encodes a MaybeDocument in the compact format for local storage: a marker
+   * byte followed by the proto that `EncodeMaybeDocument` returns, with the
+   * key of every map entry, at any depth, replaced by the ID that
+   * `intern_field_name` returns for it.
+   *
+   * The marker byte can't start a serialized proto, so `IsCompactMaybeDocument`
+   * tells the formats apart.
+   */
+  std::string EncodeCompactMaybeDocument(
+      const model::MutableDocument& maybe_doc,
+      const FieldNameInterner& intern_field_name) const;
+
+  /** Returns true if `encoded` is a MaybeDocument in the compact format. */
+  static bool IsCompactMaybeDocument(absl::string_view encoded);
+
+  /**
+   * Decodes a MaybeDocument in the compact format, looking up field name IDs
+   * in `field_names`, which holds each name at the index of its ID.
+   *
+   * Unlike the other deserialization methods this parses `encoded` itself;
+   * errors are reported through `context`.
+   */
+  model::MutableDocument DecodeCompactMaybeDocument(
+      util::ReadContext* context,
+      absl::string_view encoded,
+      const std::vector<std::string>& field_names) const;
+
   /**
    * @brief Encodes a TargetData to the equivalent nanopb proto, representing a
    * ::firestore::proto::Target, for local storage.
@@ -16,10 +16,13 @@
 
 #include "Firestore/core/src/local/local_store.h"
 
+#include <algorithm>
+#include <mutex>  // NOLINT(build/c++11)
 #include <set>
 #include <string>
 #include <unordered_set>
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/src/credentials/user.h"
 #include "Firestore/core/src/local/bundle_cache.h"
@@ -35,6 +38,7 @@
 #include "Firestore/core/src/local/reference_delegate.h"
 #include "Firestore/core/src/local/target_cache.h"
 #include "Firestore/core/src/model/document_key.h"
+#include "Firestore/core/src/model/field_index.h"
 #include "Firestore/core/src/model/mutable_document.h"
 #include "Firestore/core/src/model/mutation_batch.h"
 #include "Firestore/core/src/model/mutation_batch_result.h"
@@ -146,6 +150,8 @@ void LocalStore::StartIndexManager() {
 }
 
 DocumentMap LocalStore::HandleUserChange(const User& user) {
+  std::lock_guard<std::shared_timed_mutex> lock(user_components_mutex_);
+
   // Swap out the mutation queue, grabbing the pending mutation batches before
   // and after.
   std::vector<MutationBatch> old_batches = persistence_->Run(
@@ -329,9 +335,19 @@ model::DocumentMap LocalStore::ApplyRemoteEvent(
     ListenSequenceNumber sequence_number =
         persistence_->current_sequence_number();
 
+    // Visit targets in ID order so that the batched writes below do not
+    // depend on hash map iteration order.
+    std::vector<TargetId> target_ids;
+    target_ids.reserve(remote_event.target_changes().size());
     for (const auto& entry : remote_event.target_changes()) {
-      TargetId target_id = entry.first;
-      const TargetChange& change = entry.second;
+      target_ids.push_back(entry.first);
+    }
+    std::sort(target_ids.begin(), target_ids.end());
+
+    std::vector<TargetKeyChanges> key_changes;
+    std::vector<TargetData> targets_to_persist;
+    for (TargetId target_id : target_ids) {
+      const TargetChange& change = remote_event.target_changes().at(target_id);
       const ByteString& resume_token = change.resume_token();
 
       auto found = target_data_by_target_.find(target_id);
@@ -344,8 +360,8 @@ model::DocumentMap LocalStore::ApplyRemoteEvent(
 
       TargetData old_target_data = found->second;
 
-      target_cache_->RemoveMatchingKeys(change.removed_documents(), target_id);
-      target_cache_->AddMatchingKeys(change.added_documents(), target_id);
+      key_changes.push_back({target_id, change.added_documents(),
+                             change.removed_documents()});
 
       TargetData new_target_data =
           old_target_data.WithSequenceNumber(sequence_number);
@@ -365,10 +381,15 @@ model::DocumentMap LocalStore::ApplyRemoteEvent(
       // Update the target data if there are target changes (or if sufficient
       // time has passed since the last update).
       if (ShouldPersistTargetData(new_target_data, old_target_data, change)) {
-        target_cache_->UpdateTarget(new_target_data);
+        targets_to_persist.push_back(std::move(new_target_data));
       }
     }
 
+    // Apply the key changes and target updates of all targets together, so
+    // that large events touching many targets are written in key order.
+    target_cache_->ApplyMatchingKeyChanges(key_changes);
+    target_cache_->UpdateTargets(targets_to_persist);
+
     const DocumentKeySet& limbo_documents =
         remote_event.limbo_document_changes();
     for (const auto& kv : remote_event.document_updates()) {
@@ -573,6 +594,21 @@ QueryResult LocalStore::ExecuteQuery(const Query& query,
   });
 }
 
+DocumentMap LocalStore::ExecuteQueryOnSnapshot(const Query& query) {
+  std::shared_lock<std::shared_timed_mutex> lock(user_components_mutex_);
+
+  return persistence_->RunReadOnly("ExecuteQueryOnSnapshot", [&] {
+    return local_documents_->GetDocumentsMatchingQuery(
+        query, model::IndexOffset::None());
+  });
+}
+
+std::vector<VectorSearchResult> LocalStore::FindNearest(
+    const Query& query, const VectorQuery& vector_query) {
+  QueryResult result = ExecuteQuery(query, /*use_previous_results=*/false);
+  return local::FindNearest(result.documents(), vector_query);
+}
+
 DocumentKeySet LocalStore::GetRemoteDocumentKeys(TargetId target_id) {
   return persistence_->Run("RemoteDocumentKeysForTarget", [&] {
     return target_cache_->GetMatchingKeys(target_id);
@@ -730,13 +766,27 @@ LocalStore::DocumentChangeResult LocalStore::PopulateDocumentChanges(
     updated_keys = updated_keys.insert(kv.first);
   }
   // Each loop iteration only affects its "own" doc, so it's safe to get all
-  // the remote documents in advance in a single call.
+  // the remote documents in advance in a single call. Visiting the updates in
+  // key order lets the cache read and write them in a single ordered pass.
   MutableDocumentMap existing_docs =
       remote_document_cache_->GetAll(updated_keys);
 
-  for (const auto& kv : documents) {
-    const DocumentKey& key = kv.first;
-    const MutableDocument& doc = kv.second;
+  // Additions are handed to the cache in batches of documents that share a
+  // read time, which for a remote event is all of them. For the initial
+  // population of a large target, that lets the cache write every document
+  // row and read time row in one ordered pass.
+  std::vector<MutableDocument> docs_to_add;
+  docs_to_add.reserve(documents.size());
+  SnapshotVersion add_read_time;
+  auto flush_docs_to_add = [&] {
+    if (!docs_to_add.empty()) {
+      remote_document_cache_->AddAll(docs_to_add, add_read_time);
+      docs_to_add.clear();
+    }
+  };
+
+  for (const DocumentKey& key : updated_keys) {
+    const MutableDocument& doc = documents.find(key)->second;
     MutableDocument existing_doc = *existing_docs.get(key);
     auto search_version = document_versions.find(key);
     const SnapshotVersion& read_time = search_version != document_versions.end()
@@ -762,7 +812,11 @@ LocalStore::DocumentChangeResult LocalStore::PopulateDocumentChanges(
                 existing_doc.has_pending_writes())) {
       HARD_ASSERT(read_time != SnapshotVersion::None(),
                   "Cannot add a document when the remote version is zero");
-      remote_document_cache_->Add(doc, read_time);
+      if (read_time != add_read_time) {
+        flush_docs_to_add();
+        add_read_time = read_time;
+      }
+      docs_to_add.push_back(doc);
       changed_docs = changed_docs.insert(key, doc);
     } else {
       LOG_DEBUG(
@@ -772,6 +826,8 @@ LocalStore::DocumentChangeResult LocalStore::PopulateDocumentChanges(
           doc.version().ToString());
     }
   }
+  flush_docs_to_add();
+
   return {std::move(changed_docs), std::move(condition_changed)};
 }
 
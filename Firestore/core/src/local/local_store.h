@@ -18,6 +18,7 @@
 #define FIRESTORE_CORE_SRC_LOCAL_LOCAL_STORE_H_
 
 #include <memory>
+#include <shared_mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -27,6 +28,7 @@
 #include "Firestore/core/src/bundle/named_query.h"
 #include "Firestore/core/src/core/target_id_generator.h"
 #include "Firestore/core/src/local/document_overlay_cache.h"
+#include "Firestore/core/src/local/local_vector_search.h"
 #include "Firestore/core/src/local/overlay_migration_manager.h"
 #include "Firestore/core/src/local/reference_set.h"
 #include "Firestore/core/src/local/target_data.h"
@@ -224,6 +226,25 @@ class LocalStore : public bundle::BundleCallback {
    */
   QueryResult ExecuteQuery(const core::Query& query, bool use_previous_results);
 
+  /**
+   * Runs the specified query against a snapshot of the local store, without
+   * the target cache or indexes, and returns the matching documents.
+   *
+   * If the persistence layer `supports_concurrent_reads()`, this may be called
+   * from any thread while other LocalStore methods run on the worker. The
+   * results then reflect every transaction the worker committed before the
+   * call, and may or may not reflect transactions committed during it.
+   */
+  model::DocumentMap ExecuteQueryOnSnapshot(const core::Query& query);
+
+  /**
+   * Runs the specified query against the local store and returns the (at most
+   * `vector_query.limit`) matching documents whose vectors are nearest to
+   * `vector_query.query_vector`, nearest first.
+   */
+  std::vector<VectorSearchResult> FindNearest(const core::Query& query,
+                                              const VectorQuery& vector_query);
+
   /**
    * Notify the local store of the changed views to locally pin / unpin
    * documents.
@@ -422,6 +443,13 @@ class LocalStore : public bundle::BundleCallback {
    */
   std::unique_ptr<LocalDocumentsView> local_documents_;
 
+  /**
+   * Held exclusively while the user-specific components are replaced, and
+   * shared by `ExecuteQueryOnSnapshot` callers reading through them from other
+   * threads.
+   */
+  std::shared_timed_mutex user_components_mutex_;
+
   /**
    * Implements the steps for backfilling indexes.
    */
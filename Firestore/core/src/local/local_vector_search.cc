@@ -0,0 +1,100 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/local/local_vector_search.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "Firestore/core/src/model/document_key.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+using model::DistanceMeasure;
+using model::Document;
+using model::DocumentKey;
+using model::DocumentMap;
+
+namespace {
+
+bool WithinThreshold(const VectorQuery& query, double distance) {
+  if (!query.distance_threshold) {
+    return true;
+  }
+  return query.distance_measure == DistanceMeasure::kDotProduct
+             ? distance >= *query.distance_threshold
+             : distance <= *query.distance_threshold;
+}
+
+}  // namespace
+
+std::vector<VectorSearchResult> FindNearest(const DocumentMap& candidates,
+                                            const VectorQuery& query) {
+  std::vector<VectorSearchResult> results;
+  if (query.limit == 0 || query.query_vector.empty()) {
+    return results;
+  }
+
+  // Ties are broken by key so that results don't depend on iteration order.
+  DistanceMeasure measure = query.distance_measure;
+  auto nearer = [measure](const VectorSearchResult& lhs,
+                          const VectorSearchResult& rhs) {
+    if (lhs.distance != rhs.distance) {
+      return model::IsNearer(measure, lhs.distance, rhs.distance);
+    }
+    return lhs.document->key() < rhs.document->key();
+  };
+
+  // `results` is kept as a heap with the furthest of the current best
+  // `limit` documents on top, so each candidate costs at most O(log limit).
+  results.reserve(query.limit);
+  std::vector<double> components;
+  components.reserve(query.query_vector.size());
+
+  for (const auto& entry : candidates) {
+    const Document& document = entry.second;
+    absl::optional<google_firestore_v1_Value> value =
+        document->field(query.field);
+    if (!value || !model::GetVectorComponents(*value, &components)) {
+      continue;
+    }
+
+    absl::optional<double> distance =
+        model::ComputeDistance(measure, query.query_vector, components);
+    if (!distance || !WithinThreshold(query, *distance)) {
+      continue;
+    }
+
+    VectorSearchResult result{document, *distance};
+    if (results.size() < query.limit) {
+      results.push_back(std::move(result));
+      std::push_heap(results.begin(), results.end(), nearer);
+    } else if (nearer(result, results.front())) {
+      std::pop_heap(results.begin(), results.end(), nearer);
+      results.back() = std::move(result);
+      std::push_heap(results.begin(), results.end(), nearer);
+    }
+  }
+
+  std::sort_heap(results.begin(), results.end(), nearer);
+  return results;
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
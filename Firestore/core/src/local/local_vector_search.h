@@ -0,0 +1,73 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_LOCAL_LOCAL_VECTOR_SEARCH_H_
+#define FIRESTORE_CORE_SRC_LOCAL_LOCAL_VECTOR_SEARCH_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "Firestore/core/src/model/document.h"
+#include "Firestore/core/src/model/field_path.h"
+#include "Firestore/core/src/model/model_fwd.h"
+#include "Firestore/core/src/model/vector_distance.h"
+#include "absl/types/optional.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/** Describes a nearest-neighbor search over the vectors stored in a field. */
+struct VectorQuery {
+  /** The field containing the VectorValue to compare against. */
+  model::FieldPath field;
+
+  /** The vector to find the nearest neighbors of. */
+  std::vector<double> query_vector;
+
+  model::DistanceMeasure distance_measure = model::DistanceMeasure::kEuclidean;
+
+  /** The maximum number of results to return. */
+  size_t limit = 0;
+
+  /**
+   * If set, documents further away than the threshold are excluded. For
+   * `kDotProduct` the threshold is a lower bound on the dot product instead.
+   */
+  absl::optional<double> distance_threshold;
+};
+
+struct VectorSearchResult {
+  model::Document document;
+  double distance = 0;
+};
+
+/**
+ * Returns the (at most `query.limit`) documents among `candidates` whose
+ * vector in `query.field` is nearest to `query.query_vector`, nearest first.
+ * Documents without a vector in that field, or with a vector of a different
+ * dimension, are skipped.
+ *
+ * This is an exact search: every candidate is scored.
+ */
+std::vector<VectorSearchResult> FindNearest(
+    const model::DocumentMap& candidates, const VectorQuery& query);
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_LOCAL_LOCAL_VECTOR_SEARCH_H_
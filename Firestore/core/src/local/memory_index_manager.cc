@@ -19,19 +19,44 @@
 #include <algorithm>
 #include <set>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "Firestore/core/src/core/target.h"
+#include "Firestore/core/src/local/field_index_planner.h"
+#include "Firestore/core/src/model/document.h"
 #include "Firestore/core/src/model/field_index.h"
 #include "Firestore/core/src/model/model_fwd.h"
 #include "Firestore/core/src/model/resource_path.h"
+#include "Firestore/core/src/model/target_index_matcher.h"
 #include "Firestore/core/src/util/hard_assert.h"
+#include "Firestore/core/src/util/log.h"
 
 namespace firebase {
 namespace firestore {
 namespace local {
 
+using core::Target;
+using index::IndexEntry;
+using model::DocumentKey;
+using model::FieldIndex;
+using model::IndexState;
 using model::ResourcePath;
+using model::TargetIndexMatcher;
+
+namespace {
+
+int CompareValues(absl::string_view lhs_array,
+                  absl::string_view lhs_directional,
+                  absl::string_view rhs_array,
+                  absl::string_view rhs_directional) {
+  int cmp = lhs_array.compare(rhs_array);
+  if (cmp != 0) return cmp;
+  return lhs_directional.compare(rhs_directional);
+}
+
+}  // namespace
 
 bool MemoryCollectionParentIndex::Add(const ResourcePath& collection_path) {
   HARD_ASSERT(collection_path.size() % 2 == 1, "Expected a collection path.");
@@ -55,75 +80,318 @@ std::vector<ResourcePath> MemoryCollectionParentIndex::GetEntries(
   return result;
 }
 
+MemoryIndexManager::MemoryIndexManager(
+    MemoryIndexManagerSharedState* shared_state)
+    : shared_state_(NOT_NULL(shared_state)) {
+}
+
 void MemoryIndexManager::AddToCollectionParentIndex(
     const ResourcePath& collection_path) {
-  collection_parents_index_.Add(collection_path);
+  shared_state_->collection_parents.Add(collection_path);
 }
 
 std::vector<ResourcePath> MemoryIndexManager::GetCollectionParents(
     const std::string& collection_id) {
-  return collection_parents_index_.GetEntries(collection_id);
+  return shared_state_->collection_parents.GetEntries(collection_id);
 }
 
-// Below methods are only stubs because field indices are not supported with
-// memory persistence.
+bool MemoryIndexManager::EntryComparator::operator()(
+    const IndexEntry& lhs, const IndexEntry& rhs) const {
+  int cmp = CompareValues(lhs.array_value(), lhs.directional_value(),
+                          rhs.array_value(), rhs.directional_value());
+  if (cmp != 0) return cmp < 0;
+  return descending_keys_ ? rhs.document_key() < lhs.document_key()
+                          : lhs.document_key() < rhs.document_key();
+}
+
+bool MemoryIndexManager::EntryComparator::operator()(
+    const IndexEntry& lhs, const IndexValue& rhs) const {
+  return CompareValues(lhs.array_value(), lhs.directional_value(),
+                       rhs.array_value, rhs.directional_value) < 0;
+}
+
+bool MemoryIndexManager::EntryComparator::operator()(
+    const IndexValue& lhs, const IndexEntry& rhs) const {
+  return CompareValues(lhs.array_value, lhs.directional_value,
+                       rhs.array_value(), rhs.directional_value()) <= 0;
+}
 
 void MemoryIndexManager::Start() {
+  // Like LevelDbIndexManager, picks up the indexes that were added or deleted
+  // while a different user was signed in. Indexes that this user hasn't seen
+  // yet start in the initial state.
+  std::vector<FieldIndex> deleted_indexes;
+  for (const auto& group : indexes_) {
+    for (const auto& entry : group.second) {
+      if (shared_state_->field_indexes.count(entry.first) == 0) {
+        deleted_indexes.push_back(entry.second);
+      }
+    }
+  }
+  for (const FieldIndex& index : deleted_indexes) {
+    ForgetIndex(index);
+  }
+
+  for (const auto& entry : shared_state_->field_indexes) {
+    if (index_entries_.count(entry.first) == 0) {
+      MemoizeIndex(entry.second);
+    }
+  }
 }
 
-void MemoryIndexManager::AddFieldIndex(const model::FieldIndex& index) {
-  (void)index;
+void MemoryIndexManager::AddFieldIndex(const FieldIndex& index) {
+  int32_t index_id = ++shared_state_->max_index_id;
+  shared_state_->field_indexes.emplace(
+      index_id, FieldIndex(index_id, index.collection_group(),
+                           index.segments(), FieldIndex::InitialState()));
+
+  max_sequence_number_ = std::max(max_sequence_number_,
+                                  index.index_state().sequence_number());
+  MemoizeIndex(FieldIndex(index_id, index.collection_group(), index.segments(),
+                          index.index_state()));
+}
+
+void MemoryIndexManager::DeleteFieldIndex(const FieldIndex& index) {
+  shared_state_->field_indexes.erase(index.index_id());
+  ForgetIndex(index);
+}
+
+void MemoryIndexManager::MemoizeIndex(FieldIndex index) {
+  std::vector<model::Segment> directional_segments =
+      index.GetDirectionalSegments();
+  bool descending_keys =
+      !directional_segments.empty() &&
+      directional_segments.back().kind() == model::Segment::kDescending;
+  index_entries_.emplace(index.index_id(), IndexEntries(descending_keys));
+
+  std::string collection_group = index.collection_group();
+  int32_t index_id = index.index_id();
+  indexes_[collection_group].emplace(index_id, std::move(index));
 }
 
-void MemoryIndexManager::DeleteFieldIndex(const model::FieldIndex& index) {
-  (void)index;
+void MemoryIndexManager::ForgetIndex(const FieldIndex& index) {
+  index_entries_.erase(index.index_id());
+
+  auto group = indexes_.find(index.collection_group());
+  if (group != indexes_.end()) {
+    group->second.erase(index.index_id());
+    if (group->second.empty()) {
+      indexes_.erase(group);
+    }
+  }
 }
 
-std::vector<model::FieldIndex> MemoryIndexManager::GetFieldIndexes(
+std::vector<FieldIndex> MemoryIndexManager::GetFieldIndexes(
     const std::string& collection_group) const {
-  (void)collection_group;
-  return {};
+  std::vector<FieldIndex> result;
+  auto group = indexes_.find(collection_group);
+  if (group != indexes_.end()) {
+    for (const auto& entry : group->second) {
+      result.push_back(entry.second);
+    }
+  }
+  return result;
 }
 
-std::vector<model::FieldIndex> MemoryIndexManager::GetFieldIndexes() const {
-  return {};
+std::vector<FieldIndex> MemoryIndexManager::GetFieldIndexes() const {
+  std::vector<FieldIndex> result;
+  for (const auto& group : indexes_) {
+    for (const auto& entry : group.second) {
+      result.push_back(entry.second);
+    }
+  }
+  return result;
 }
 
 void MemoryIndexManager::DeleteAllFieldIndexes() {
+  shared_state_->field_indexes.clear();
+  indexes_.clear();
+  index_entries_.clear();
 }
 
-void MemoryIndexManager::CreateTargetIndexes(const core::Target&) {
+void MemoryIndexManager::CreateTargetIndexes(const Target& target) {
+  for (const Target& sub_target : GetSubTargets(target)) {
+    IndexManager::IndexType type = GetIndexType(sub_target);
+    if (type == IndexManager::IndexType::NONE ||
+        type == IndexManager::IndexType::PARTIAL) {
+      TargetIndexMatcher target_index_matcher(sub_target);
+      absl::optional<FieldIndex> field_index =
+          target_index_matcher.BuildTargetIndex();
+      if (field_index.has_value()) {
+        AddFieldIndex(field_index.value());
+      }
+    }
+  }
 }
 
-model::IndexOffset MemoryIndexManager::GetMinOffset(const core::Target&) {
-  return model::IndexOffset::None();
+model::IndexOffset MemoryIndexManager::GetMinOffset(const Target& target) {
+  std::vector<FieldIndex> indexes;
+  for (const Target& sub_target : GetSubTargets(target)) {
+    absl::optional<FieldIndex> index = GetFieldIndex(sub_target);
+    if (index.has_value()) {
+      indexes.push_back(std::move(index).value());
+    }
+  }
+  return GetMinIndexOffset(indexes);
 }
 
-model::IndexOffset MemoryIndexManager::GetMinOffset(const std::string&) const {
-  return model::IndexOffset::None();
+model::IndexOffset MemoryIndexManager::GetMinOffset(
+    const std::string& collection_group) const {
+  return GetMinIndexOffset(GetFieldIndexes(collection_group));
 }
 
-IndexManager::IndexType MemoryIndexManager::GetIndexType(const core::Target&) {
-  return IndexManager::IndexType::NONE;
+IndexManager::IndexType MemoryIndexManager::GetIndexType(
+    const Target& target) {
+  std::vector<Target> sub_targets = GetSubTargets(target);
+  std::vector<absl::optional<FieldIndex>> indexes;
+  for (const Target& sub_target : sub_targets) {
+    indexes.push_back(GetFieldIndex(sub_target));
+  }
+  return GetCombinedIndexType(target, sub_targets, indexes);
 }
 
-absl::optional<std::vector<model::DocumentKey>>
-MemoryIndexManager::GetDocumentsMatchingTarget(const core::Target&) {
-  // Field indices are not supported with memory persistence.
-  return absl::nullopt;
+absl::optional<std::vector<DocumentKey>>
+MemoryIndexManager::GetDocumentsMatchingTarget(const Target& target) {
+  std::vector<std::pair<Target, FieldIndex>> indexes;
+  for (const Target& sub_target : GetSubTargets(target)) {
+    absl::optional<FieldIndex> index = GetFieldIndex(sub_target);
+    if (!index.has_value()) {
+      return absl::nullopt;
+    }
+    indexes.emplace_back(sub_target, std::move(index).value());
+  }
+
+  std::vector<DocumentKey> result;
+  std::unordered_set<DocumentKey, model::DocumentKeyHash> existing_keys;
+  for (const auto& entry : indexes) {
+    const Target& sub_target = entry.first;
+    const FieldIndex& index = entry.second;
+
+    LOG_DEBUG("Using index %s to execute target %s", index.collection_group(),
+              sub_target.CanonicalId());
+
+    const auto& entries = index_entries_.at(index.index_id()).entries;
+    std::vector<IndexEntryRange> ranges =
+        GetIndexEntryRanges(index, sub_target);
+    for (const IndexEntryRange& range : ranges) {
+      IndexValue lower{range.lower.array_value(),
+                       range.lower.directional_value()};
+      IndexValue upper{range.upper.array_value(),
+                       range.upper.directional_value()};
+
+      // The range may be empty, with `upper` before `lower`, so the scan stops
+      // on the value rather than on the position of `upper`.
+      int32_t count = 0;
+      for (auto it = entries.lower_bound(lower);
+           it != entries.end() && count < target.limit() &&
+           entries.key_comp()(*it, upper);
+           ++it) {
+        ++count;
+        if (existing_keys.insert(it->document_key()).second) {
+          result.push_back(it->document_key());
+        }
+      }
+    }
+  }
+
+  return result;
 }
 
 absl::optional<std::string> MemoryIndexManager::GetNextCollectionGroupToUpdate()
     const {
-  return absl::nullopt;
+  // Like LevelDbIndexManager, picks the least recently updated index, breaking
+  // ties by collection group.
+  const FieldIndex* next = nullptr;
+  for (const auto& group : indexes_) {
+    for (const auto& entry : group.second) {
+      const FieldIndex& index = entry.second;
+      if (next == nullptr ||
+          index.index_state().sequence_number() <
+              next->index_state().sequence_number() ||
+          (index.index_state().sequence_number() ==
+               next->index_state().sequence_number() &&
+           index.collection_group() < next->collection_group())) {
+        next = &index;
+      }
+    }
+  }
+
+  if (next == nullptr) {
+    return absl::nullopt;
+  }
+  return next->collection_group();
 }
 
-void MemoryIndexManager::UpdateCollectionGroup(const std::string&,
-                                               model::IndexOffset) {
-  // Field indices are not supported with memory persistence.
+void MemoryIndexManager::UpdateCollectionGroup(
+    const std::string& collection_group, model::IndexOffset offset) {
+  auto group = indexes_.find(collection_group);
+  if (group == indexes_.end()) {
+    return;
+  }
+
+  ++max_sequence_number_;
+  for (auto& entry : group->second) {
+    FieldIndex& index = entry.second;
+    index = FieldIndex(index.index_id(), index.collection_group(),
+                       index.segments(),
+                       IndexState(max_sequence_number_, offset));
+  }
+}
+
+void MemoryIndexManager::UpdateIndexEntries(
+    const model::DocumentMap& documents) {
+  for (const auto& kv : documents) {
+    const auto group = kv.first.GetCollectionGroup();
+    HARD_ASSERT(group.has_value(),
+                "Document key is expected to have a collection group");
+
+    auto indexes = indexes_.find(group.value());
+    if (indexes == indexes_.end()) {
+      continue;
+    }
+
+    for (const auto& entry : indexes->second) {
+      const FieldIndex& index = entry.second;
+      UpdateEntries(&index_entries_.at(index.index_id()), kv.first,
+                    ComputeIndexEntries(kv.second, index));
+    }
+  }
+}
+
+void MemoryIndexManager::UpdateEntries(IndexEntries* index_entries,
+                                       const DocumentKey& key,
+                                       std::set<IndexEntry> new_entries) {
+  auto existing = index_entries->entries_by_document.find(key);
+  if (existing != index_entries->entries_by_document.end()) {
+    if (existing->second == new_entries) {
+      return;
+    }
+    for (const IndexEntry& entry : existing->second) {
+      index_entries->entries.erase(entry);
+    }
+    index_entries->entries_by_document.erase(existing);
+  }
+
+  if (new_entries.empty()) {
+    return;
+  }
+  index_entries->entries.insert(new_entries.begin(), new_entries.end());
+  index_entries->entries_by_document.emplace(key, std::move(new_entries));
+}
+
+std::vector<Target> MemoryIndexManager::GetSubTargets(const Target& target) {
+  auto it = target_to_dnf_subtargets_.find(target);
+  if (it != target_to_dnf_subtargets_.end()) {
+    return it->second;
+  }
+
+  return target_to_dnf_subtargets_[target] = GetDnfSubTargets(target);
 }
 
-void MemoryIndexManager::UpdateIndexEntries(const model::DocumentMap&) {
+absl::optional<FieldIndex> MemoryIndexManager::GetFieldIndex(
+    const Target& target) const {
+  return SelectFieldIndex(target,
+                          GetFieldIndexes(GetTargetCollectionGroup(target)));
 }
 
 }  // namespace local
@@ -17,12 +17,18 @@
 #ifndef FIRESTORE_CORE_SRC_LOCAL_MEMORY_INDEX_MANAGER_H_
 #define FIRESTORE_CORE_SRC_LOCAL_MEMORY_INDEX_MANAGER_H_
 
+#include <map>
 #include <set>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+#include "Firestore/core/src/core/target.h"
+#include "Firestore/core/src/index/index_entry.h"
 #include "Firestore/core/src/local/index_manager.h"
+#include "Firestore/core/src/model/document_key.h"
+#include "Firestore/core/src/model/field_index.h"
+#include "absl/strings/string_view.h"
 
 namespace firebase {
 namespace firestore {
@@ -45,10 +51,30 @@ class MemoryCollectionParentIndex {
   std::unordered_map<std::string, std::set<model::ResourcePath>> index_;
 };
 
-/** An in-memory implementation of IndexManager. */
+/**
+ * The parts of the index that the MemoryIndexManagers of all users share, like
+ * the collection-parent and index configuration tables in LevelDB. Index
+ * entries and index states are kept per user.
+ */
+struct MemoryIndexManagerSharedState {
+  MemoryCollectionParentIndex collection_parents;
+
+  /** The configured field indexes, keyed by index ID, in the initial state. */
+  std::map<int32_t, model::FieldIndex> field_indexes;
+
+  int32_t max_index_id = -1;
+};
+
+/**
+ * An in-memory implementation of IndexManager.
+ *
+ * Field index entries are kept per index in a sorted set, ordered the same way
+ * as the LevelDB index entry table, so that targets are served by the same
+ * range scans that LevelDbIndexManager performs.
+ */
 class MemoryIndexManager : public IndexManager {
  public:
-  MemoryIndexManager() = default;
+  explicit MemoryIndexManager(MemoryIndexManagerSharedState* shared_state);
 
   void Start() override;
 
@@ -69,25 +95,106 @@ class MemoryIndexManager : public IndexManager {
 
   void DeleteAllFieldIndexes() override;
 
-  void CreateTargetIndexes(const core::Target&) override;
+  void CreateTargetIndexes(const core::Target& target) override;
 
-  model::IndexOffset GetMinOffset(const core::Target&) override;
+  model::IndexOffset GetMinOffset(const core::Target& target) override;
 
-  model::IndexOffset GetMinOffset(const std::string&) const override;
+  model::IndexOffset GetMinOffset(
+      const std::string& collection_group) const override;
 
-  IndexType GetIndexType(const core::Target&) override;
+  IndexType GetIndexType(const core::Target& target) override;
 
   absl::optional<std::vector<model::DocumentKey>> GetDocumentsMatchingTarget(
-      const core::Target&) override;
+      const core::Target& target) override;
 
   absl::optional<std::string> GetNextCollectionGroupToUpdate() const override;
 
-  void UpdateCollectionGroup(const std::string&, model::IndexOffset) override;
+  void UpdateCollectionGroup(const std::string& collection_group,
+                             model::IndexOffset offset) override;
 
-  void UpdateIndexEntries(const model::DocumentMap&) override;
+  void UpdateIndexEntries(const model::DocumentMap& documents) override;
 
  private:
-  MemoryCollectionParentIndex collection_parents_index_;
+  /** The array and directional value of an index entry, without its key. */
+  struct IndexValue {
+    absl::string_view array_value;
+    absl::string_view directional_value;
+  };
+
+  /**
+   * Orders the entries of one index by array value, then directional value,
+   * then document key. Keys are ordered in the direction of the index's last
+   * directional segment, like the encoded keys in the LevelDB table.
+   *
+   * Entries can also be compared with a bare IndexValue, which sorts before
+   * every entry with that value.
+   */
+  class EntryComparator {
+   public:
+    using is_transparent = void;
+
+    explicit EntryComparator(bool descending_keys)
+        : descending_keys_(descending_keys) {
+    }
+
+    bool operator()(const index::IndexEntry& lhs,
+                    const index::IndexEntry& rhs) const;
+    bool operator()(const index::IndexEntry& lhs, const IndexValue& rhs) const;
+    bool operator()(const IndexValue& lhs, const index::IndexEntry& rhs) const;
+
+   private:
+    bool descending_keys_ = false;
+  };
+
+  /** The entries of a single field index. */
+  struct IndexEntries {
+    explicit IndexEntries(bool descending_keys)
+        : entries(EntryComparator(descending_keys)) {
+    }
+
+    std::set<index::IndexEntry, EntryComparator> entries;
+    std::unordered_map<model::DocumentKey,
+                       std::set<index::IndexEntry>,
+                       model::DocumentKeyHash>
+        entries_by_document;
+  };
+
+  std::vector<core::Target> GetSubTargets(const core::Target& target);
+
+  /** Adds the given index and its (empty) entries to this user's indexes. */
+  void MemoizeIndex(model::FieldIndex index);
+
+  /** Removes the given index and its entries from this user's indexes. */
+  void ForgetIndex(const model::FieldIndex& index);
+
+  /**
+   * Returns an index that can be used to serve the provided target. Returns
+   * `nullopt` if no index is configured.
+   */
+  absl::optional<model::FieldIndex> GetFieldIndex(
+      const core::Target& target) const;
+
+  void UpdateEntries(IndexEntries* index_entries,
+                     const model::DocumentKey& key,
+                     std::set<index::IndexEntry> new_entries);
+
+  MemoryIndexManagerSharedState* shared_state_ = nullptr;
+
+  /** Maps from a target to its sub-targets, see GetDnfSubTargets(). */
+  std::unordered_map<core::Target, std::vector<core::Target>>
+      target_to_dnf_subtargets_;
+
+  /**
+   * A map from collection group to the indexes of the group, keyed by index
+   * ID.
+   */
+  std::unordered_map<std::string, std::map<int32_t, model::FieldIndex>>
+      indexes_;
+
+  /** The entries of each index, keyed by index ID. */
+  std::unordered_map<int32_t, IndexEntries> index_entries_;
+
+  model::ListenSequenceNumber max_sequence_number_ = -1;
 };
 
 }  // namespace local
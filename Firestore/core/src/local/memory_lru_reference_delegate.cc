@@ -176,9 +176,10 @@ bool MemoryLruReferenceDelegate::IsPinnedAtSequenceNumber(
 
 StatusOr<int64_t> MemoryLruReferenceDelegate::CalculateByteSize() {
   // Note that this method is only used for testing because this delegate is
-  // only used for testing. The algorithm here (loop through everything,
-  // serialize it and count bytes) is inefficient and inexact, but won't run in
-  // production.
+  // only used for testing. The algorithm here (loop through everything and
+  // count the bytes it would serialize to) is inexact, but won't run in
+  // production. The remote document cache remembers document sizes, so only
+  // documents changed since the last call are measured again.
   int64_t count = 0;
   count += persistence_->target_cache()->CalculateByteSize(*sizer_);
   count += persistence_->remote_document_cache()->CalculateByteSize(*sizer_);
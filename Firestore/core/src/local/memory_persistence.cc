@@ -29,6 +29,7 @@
 #include "Firestore/core/src/local/reference_delegate.h"
 #include "Firestore/core/src/local/sizer.h"
 #include "Firestore/core/src/local/target_data.h"
+#include "Firestore/core/src/util/tracing.h"
 #include "absl/memory/memory.h"
 
 namespace firebase {
@@ -126,9 +127,18 @@ MemoryRemoteDocumentCache* MemoryPersistence::remote_document_cache() {
   return &remote_document_cache_;
 }
 
-MemoryIndexManager* MemoryPersistence::GetIndexManager(
-    const credentials::User&) {
-  return &index_manager_;
+MemoryIndexManager* MemoryPersistence::GetIndexManager(const User& user) {
+  auto iter = index_managers_.find(user);
+  if (iter == index_managers_.end()) {
+    auto index_manager =
+        absl::make_unique<MemoryIndexManager>(&index_manager_shared_state_);
+    MemoryIndexManager* result = index_manager.get();
+
+    index_managers_.emplace(user, std::move(index_manager));
+    return result;
+  } else {
+    return iter->second.get();
+  }
 }
 
 ReferenceDelegate* MemoryPersistence::reference_delegate() {
@@ -143,6 +153,7 @@ void MemoryPersistence::DeleteAllFieldIndexes() {
 
 void MemoryPersistence::RunInternal(absl::string_view label,
                                     std::function<void()> block) {
+  util::TraceSpan span("persistence", label);
   TransactionGuard guard(reference_delegate_.get(), label);
 
   block();
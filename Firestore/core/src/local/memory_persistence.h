@@ -66,6 +66,11 @@ class MemoryPersistence : public Persistence {
                          std::unique_ptr<MemoryDocumentOverlayCache>,
                          firebase::firestore::credentials::HashUser>;
 
+  using IndexManagers =
+      std::unordered_map<credentials::User,
+                         std::unique_ptr<MemoryIndexManager>,
+                         firebase::firestore::credentials::HashUser>;
+
   static std::unique_ptr<MemoryPersistence> WithEagerGarbageCollector();
 
   static std::unique_ptr<MemoryPersistence> WithLruGarbageCollector(
@@ -134,7 +139,12 @@ class MemoryPersistence : public Persistence {
    */
   MemoryRemoteDocumentCache remote_document_cache_;
 
-  MemoryIndexManager index_manager_;
+  /**
+   * The index managers of each user, which share the collection-parent index
+   * and the field index configurations.
+   */
+  MemoryIndexManagerSharedState index_manager_shared_state_;
+  IndexManagers index_managers_;
 
   MemoryBundleCache bundle_cache_;
 
@@ -36,6 +36,7 @@ using model::DocumentKeySet;
 using model::ListenSequenceNumber;
 using model::MutableDocument;
 using model::MutableDocumentMap;
+using model::ResourcePath;
 using model::SnapshotVersion;
 
 MemoryRemoteDocumentCache::MemoryRemoteDocumentCache(
@@ -45,16 +46,52 @@ MemoryRemoteDocumentCache::MemoryRemoteDocumentCache(
 
 void MemoryRemoteDocumentCache::Add(const MutableDocument& document,
                                     const model::SnapshotVersion& read_time) {
+  auto existing = docs_.find(document.key());
+  if (existing != docs_.end()) {
+    RemoveFromReadTimeIndex(existing->second);
+  }
+
   // Note: We create an explicit copy to prevent further modifications.
   docs_ =
       docs_.insert(document.key(), document.Clone().WithReadTime(read_time));
+  read_time_index_[document.key().path().PopLast()].emplace(read_time,
+                                                            document.key());
+  if (tracks_document_sizes_) {
+    ForgetDocumentSize(document.key());
+    unsized_documents_.insert(document.key());
+  }
 
   NOT_NULL(index_manager_);
   index_manager_->AddToCollectionParentIndex(document.key().path().PopLast());
 }
 
+void MemoryRemoteDocumentCache::AddAll(
+    const std::vector<MutableDocument>& documents,
+    const model::SnapshotVersion& read_time) {
+  for (const MutableDocument& document : documents) {
+    Add(document, read_time);
+  }
+}
+
 void MemoryRemoteDocumentCache::Remove(const DocumentKey& key) {
+  auto existing = docs_.find(key);
+  if (existing != docs_.end()) {
+    RemoveFromReadTimeIndex(existing->second);
+  }
   docs_ = docs_.erase(key);
+  ForgetDocumentSize(key);
+}
+
+void MemoryRemoteDocumentCache::RemoveFromReadTimeIndex(
+    const MutableDocument& document) {
+  auto collection = read_time_index_.find(document.key().path().PopLast());
+  if (collection == read_time_index_.end()) {
+    return;
+  }
+  collection->second.erase({document.read_time(), document.key()});
+  if (collection->second.empty()) {
+    read_time_index_.erase(collection);
+  }
 }
 
 MutableDocument MemoryRemoteDocumentCache::Get(const DocumentKey& key) const {
@@ -76,13 +113,26 @@ MutableDocumentMap MemoryRemoteDocumentCache::GetAll(
   return results;
 }
 
-// This method should only be called from the IndexBackfiller if LevelDB is
-// enabled.
-MutableDocumentMap MemoryRemoteDocumentCache::GetAll(const std::string&,
-                                                     const model::IndexOffset&,
-                                                     size_t) const {
-  util::ThrowInvalidArgument(
-      "getAll(String, IndexOffset, int) is not supported.");
+MutableDocumentMap MemoryRemoteDocumentCache::GetAll(
+    const std::string& collection_group,
+    const model::IndexOffset& offset,
+    size_t limit) const {
+  HARD_ASSERT(limit > 0u, "Limit should be at least 1");
+  NOT_NULL(index_manager_);
+  std::vector<ResourcePath> parents =
+      index_manager_->GetCollectionParents(collection_group);
+
+  MutableDocumentMap result;
+  for (auto parent = parents.cbegin();
+       parent != parents.cend() && result.size() < limit; parent++) {
+    MutableDocumentMap remote_docs =
+        GetDocumentsAfterOffset(Query(parent->Append(collection_group)),
+                                offset, limit - result.size(), {});
+    for (const auto& doc : remote_docs) {
+      result = result.insert(doc.first, doc.second);
+    }
+  }
+  return result;
 }
 
 MutableDocumentMap MemoryRemoteDocumentCache::GetDocumentsMatchingQuery(
@@ -98,8 +148,12 @@ MutableDocumentMap MemoryRemoteDocumentCache::GetDocumentsMatchingQuery(
     const core::Query& query,
     const model::IndexOffset& offset,
     absl::optional<QueryContext>&,
-    absl::optional<size_t>,
+    absl::optional<size_t> limit,
     const model::OverlayByDocumentKeyMap& mutated_docs) const {
+  if (limit.has_value() || offset.read_time() != SnapshotVersion::None()) {
+    return GetDocumentsAfterOffset(query, offset, limit, mutated_docs);
+  }
+
   MutableDocumentMap results;
 
   // Documents are ordered by key, so we can use a prefix scan to narrow down
@@ -136,6 +190,50 @@ MutableDocumentMap MemoryRemoteDocumentCache::GetDocumentsMatchingQuery(
   return results;
 }
 
+MutableDocumentMap MemoryRemoteDocumentCache::GetDocumentsAfterOffset(
+    const core::Query& query,
+    const model::IndexOffset& offset,
+    absl::optional<size_t> limit,
+    const model::OverlayByDocumentKeyMap& mutated_docs) const {
+  MutableDocumentMap results;
+
+  auto collection = read_time_index_.find(query.path());
+  if (collection == read_time_index_.end()) {
+    return results;
+  }
+
+  // Like the LevelDB read time index, the limit applies to the documents read
+  // from the index rather than to the documents that match the query.
+  const auto& entries = collection->second;
+  size_t read_count = 0;
+  auto start = entries.lower_bound({offset.read_time(), offset.document_key()});
+  for (auto it = start;
+       it != entries.end() && (!limit.has_value() || read_count < *limit);
+       ++it) {
+    auto found = docs_.find(it->second);
+    HARD_ASSERT(found != docs_.end(),
+                "Read time index refers to missing document %s",
+                it->second.ToString());
+    const MutableDocument& document = found->second;
+    if (model::IndexOffset::FromDocument(document).CompareTo(offset) !=
+        util::ComparisonResult::Descending) {
+      // The document sorts at the offset.
+      continue;
+    }
+
+    ++read_count;
+    if (mutated_docs.find(document.key()) == mutated_docs.end() &&
+        !query.Matches(document)) {
+      continue;
+    }
+
+    // Note: We create an explicit copy to prevent modifications on the backing
+    // data.
+    results = results.insert(document.key(), document.Clone());
+  }
+  return results;
+}
+
 std::vector<DocumentKey> MemoryRemoteDocumentCache::RemoveOrphanedDocuments(
     MemoryLruReferenceDelegate* reference_delegate,
     ListenSequenceNumber upper_bound) {
@@ -144,6 +242,8 @@ std::vector<DocumentKey> MemoryRemoteDocumentCache::RemoveOrphanedDocuments(
   for (const auto& kv : docs_) {
     const DocumentKey& key = kv.first;
     if (!reference_delegate->IsPinnedAtSequenceNumber(upper_bound, key)) {
+      RemoveFromReadTimeIndex(kv.second);
+      ForgetDocumentSize(key);
       updated_docs = updated_docs.erase(key);
       removed.push_back(key);
     }
@@ -153,12 +253,31 @@ std::vector<DocumentKey> MemoryRemoteDocumentCache::RemoveOrphanedDocuments(
 }
 
 int64_t MemoryRemoteDocumentCache::CalculateByteSize(const Sizer& sizer) {
-  int64_t count = 0;
-  for (const auto& kv : docs_) {
-    const MutableDocument& document = kv.second;
-    count += sizer.CalculateByteSize(document);
+  if (!tracks_document_sizes_) {
+    tracks_document_sizes_ = true;
+    for (const auto& kv : docs_) {
+      unsized_documents_.insert(kv.first);
+    }
+  }
+
+  for (const DocumentKey& key : unsized_documents_) {
+    const auto& document = docs_.get(key);
+    HARD_ASSERT(document, "Missing document %s", key.ToString());
+    int64_t size = sizer.CalculateByteSize(*document);
+    document_sizes_[key] = size;
+    byte_size_ += size;
+  }
+  unsized_documents_.clear();
+  return byte_size_;
+}
+
+void MemoryRemoteDocumentCache::ForgetDocumentSize(const DocumentKey& key) {
+  auto size = document_sizes_.find(key);
+  if (size != document_sizes_.end()) {
+    byte_size_ -= size->second;
+    document_sizes_.erase(size);
   }
-  return count;
+  unsized_documents_.erase(key);
 }
 
 void MemoryRemoteDocumentCache::SetIndexManager(IndexManager* manager) {
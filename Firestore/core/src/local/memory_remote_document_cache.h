@@ -17,7 +17,11 @@
 #ifndef FIRESTORE_CORE_SRC_LOCAL_MEMORY_REMOTE_DOCUMENT_CACHE_H_
 #define FIRESTORE_CORE_SRC_LOCAL_MEMORY_REMOTE_DOCUMENT_CACHE_H_
 
+#include <map>
+#include <set>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -28,6 +32,8 @@
 #include "Firestore/core/src/model/model_fwd.h"
 #include "Firestore/core/src/model/mutable_document.h"
 #include "Firestore/core/src/model/overlay.h"
+#include "Firestore/core/src/model/resource_path.h"
+#include "Firestore/core/src/model/snapshot_version.h"
 #include "Firestore/core/src/model/types.h"
 
 namespace firebase {
@@ -45,6 +51,8 @@ class MemoryRemoteDocumentCache : public RemoteDocumentCache {
 
   void Add(const model::MutableDocument& document,
            const model::SnapshotVersion& read_time) override;
+  void AddAll(const std::vector<model::MutableDocument>& documents,
+              const model::SnapshotVersion& read_time) override;
   void Remove(const model::DocumentKey& key) override;
 
   model::MutableDocument Get(const model::DocumentKey& key) const override;
@@ -71,12 +79,54 @@ class MemoryRemoteDocumentCache : public RemoteDocumentCache {
       MemoryLruReferenceDelegate* reference_delegate,
       model::ListenSequenceNumber upper_bound);
 
+  /**
+   * Returns the total size of the cached documents. The size of each document
+   * is remembered, so subsequent calls only measure the documents that were
+   * added or changed since. All calls must use equivalent sizers.
+   */
   int64_t CalculateByteSize(const Sizer& sizer);
 
  private:
+  using ReadTimeIndex =
+      std::map<model::ResourcePath,
+               std::set<std::pair<model::SnapshotVersion, model::DocumentKey>>>;
+
+  /**
+   * Scans the query's collection in read time order, starting after `offset`.
+   * At most `limit` documents are read.
+   */
+  model::MutableDocumentMap GetDocumentsAfterOffset(
+      const core::Query& query,
+      const model::IndexOffset& offset,
+      absl::optional<size_t> limit,
+      const model::OverlayByDocumentKeyMap& mutated_docs) const;
+
+  void RemoveFromReadTimeIndex(const model::MutableDocument& document);
+
+  /** Drops the remembered size of the document with the given key. */
+  void ForgetDocumentSize(const model::DocumentKey& key);
+
   /** Underlying cache of documents and their read times. */
   immutable::SortedMap<model::DocumentKey, model::MutableDocument> docs_;
 
+  /**
+   * The documents of each collection, ordered by read time and then key. Used
+   * to find the documents that changed after an index offset without scanning
+   * the whole collection.
+   */
+  ReadTimeIndex read_time_index_;
+
+  /**
+   * The sizes of the documents measured by `CalculateByteSize`, and their sum.
+   * Documents are only tracked once `CalculateByteSize` has been called.
+   */
+  bool tracks_document_sizes_ = false;
+  std::unordered_map<model::DocumentKey, int64_t, model::DocumentKeyHash>
+      document_sizes_;
+  std::unordered_set<model::DocumentKey, model::DocumentKeyHash>
+      unsized_documents_;
+  int64_t byte_size_ = 0;
+
   // This instance is owned by MemoryPersistence; avoid a retain cycle.
   MemoryPersistence* persistence_;
   // This instance is also owned by MemoryPersistence.
@@ -58,6 +58,13 @@ void MemoryTargetCache::UpdateTarget(const TargetData& target_data) {
   AddTarget(target_data);
 }
 
+void MemoryTargetCache::UpdateTargets(
+    const std::vector<TargetData>& targets) {
+  for (const TargetData& target_data : targets) {
+    UpdateTarget(target_data);
+  }
+}
+
 void MemoryTargetCache::RemoveTarget(const TargetData& target_data) {
   targets_.erase(target_data.target());
   references_.RemoveReferences(target_data.target_id());
@@ -113,6 +120,14 @@ void MemoryTargetCache::RemoveMatchingKeys(const DocumentKeySet& keys,
   }
 }
 
+void MemoryTargetCache::ApplyMatchingKeyChanges(
+    const std::vector<TargetKeyChanges>& changes) {
+  for (const TargetKeyChanges& change : changes) {
+    RemoveMatchingKeys(change.removed, change.target_id);
+    AddMatchingKeys(change.added, change.target_id);
+  }
+}
+
 DocumentKeySet MemoryTargetCache::GetMatchingKeys(TargetId target_id) {
   return references_.ReferencedKeys(target_id);
 }
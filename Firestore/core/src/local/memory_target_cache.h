@@ -20,6 +20,7 @@
 #include <cstdint>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/src/core/target.h"
 #include "Firestore/core/src/local/reference_set.h"
@@ -45,6 +46,8 @@ class MemoryTargetCache : public TargetCache {
 
   void UpdateTarget(const TargetData& target_data) override;
 
+  void UpdateTargets(const std::vector<TargetData>& targets) override;
+
   void RemoveTarget(const TargetData& target_data) override;
 
   absl::optional<TargetData> GetTarget(const core::Target& target) override;
@@ -63,6 +66,9 @@ class MemoryTargetCache : public TargetCache {
   void RemoveMatchingKeys(const model::DocumentKeySet& keys,
                           model::TargetId target_id) override;
 
+  void ApplyMatchingKeyChanges(
+      const std::vector<TargetKeyChanges>& changes) override;
+
   void RemoveMatchingKeysForTarget(model::TargetId target_id) override;
 
   model::DocumentKeySet GetMatchingKeys(model::TargetId target_id) override;
@@ -190,10 +190,50 @@ class Persistence {
     return result;
   }
 
+  /**
+   * Returns true if `RunReadOnly` may be called from any thread, concurrently
+   * with transactions started by `Run`.
+   */
+  virtual bool supports_concurrent_reads() const {
+    return false;
+  }
+
+  /**
+   * Accepts a function that only reads and runs it within a read-only
+   * transaction.
+   *
+   * If `supports_concurrent_reads()` is true, the block reads a snapshot of all
+   * transactions committed before it started: it observes neither the
+   * uncommitted writes of a transaction running concurrently nor any
+   * transaction that commits while it runs. Otherwise this is equivalent to
+   * `Run` and has the same threading requirements.
+   *
+   * Read-only transactions must not be nested within other transactions.
+   *
+   * @param label A semi-unique name for the transaction, for logging.
+   * @param block A function that reads within the transaction and returns its
+   *     result. The type of the return value must be default constructible and
+   *     copy- or move-assignable.
+   * @return The value returned from the invocation of `block`.
+   */
+  template <typename F>
+  auto RunReadOnly(absl::string_view label, F block) -> decltype(block()) {
+    decltype(block()) result;
+
+    RunReadOnlyInternal(label, [&]() mutable { result = block(); });
+
+    return result;
+  }
+
  private:
   virtual void RunInternal(absl::string_view label,
                            std::function<void()> block) = 0;
 
+  virtual void RunReadOnlyInternal(absl::string_view label,
+                                   std::function<void()> block) {
+    RunInternal(label, std::move(block));
+  }
+
   /**
    * Removes all persistent cache indexes. This feature is implemented in
    * `Persistence` instead of `IndexManager` like other SDKs. The reason for
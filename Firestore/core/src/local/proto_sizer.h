@@ -26,7 +26,8 @@ namespace local {
 
 /**
  * Estimates the stored size of documents and queries by translating to protos
- * and using the serialized sizes to estimate.
+ * and using the serialized sizes to estimate. The sizes are computed without
+ * serializing into a buffer.
  */
 class ProtoSizer : public Sizer {
  public:
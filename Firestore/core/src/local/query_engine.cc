@@ -27,6 +27,7 @@
 #include "Firestore/core/src/model/mutable_document.h"
 #include "Firestore/core/src/model/snapshot_version.h"
 #include "Firestore/core/src/util/log.h"
+#include "Firestore/core/src/util/metrics.h"
 
 namespace firebase {
 namespace firestore {
@@ -44,6 +45,15 @@ static const int kDefaultIndexAutoCreationMinCollectionSize = 100;
  */
 
 static const double KDefaultRelativeIndexReadCostPerDocument = 3.4;
+
+/** The number of documents read by each full collection scan. */
+util::MetricHistogram& FullScanDocumentsRead() {
+  static util::MetricHistogram& histogram =
+      util::MetricsRegistry::GetInstance().GetHistogram(
+          "query_engine.full_scan_documents_read");
+  return histogram;
+}
+
 }  // namespace
 
 using core::LimitType;
@@ -85,6 +95,8 @@ const DocumentMap QueryEngine::GetDocumentsMatchingQuery(
 
   absl::optional<QueryContext> context = QueryContext();
   auto full_scan_result = ExecuteFullCollectionScan(query, context);
+  FullScanDocumentsRead().Record(
+      static_cast<int64_t>(context->GetDocumentReadCount()));
   if (index_auto_creation_enabled_) {
     CreateCacheIndexes(query, context.value(), full_scan_result.size());
   }
@@ -18,6 +18,7 @@
 #define FIRESTORE_CORE_SRC_LOCAL_REMOTE_DOCUMENT_CACHE_H_
 
 #include <string>
+#include <vector>
 
 #include "Firestore/core/src/model/document_key.h"
 #include "Firestore/core/src/model/model_fwd.h"
@@ -59,6 +60,18 @@ class RemoteDocumentCache {
   virtual void Add(const model::MutableDocument& document,
                    const model::SnapshotVersion& read_time) = 0;
 
+  /**
+   * Adds or replaces the entries for all of the given documents, as if by
+   * calling `Add()` for each of them. Lets the cache write large batches, such
+   * as the initial population of a target, in a single ordered pass.
+   *
+   * @param documents Documents or DeletedDocuments to put in the cache, in key
+   *     order.
+   * @param read_time The time at which the documents were read or committed.
+   */
+  virtual void AddAll(const std::vector<model::MutableDocument>& documents,
+                      const model::SnapshotVersion& read_time) = 0;
+
   /** Removes the cached entry for the given key (no-op if no entry exists). */
   virtual void Remove(const model::DocumentKey& key) = 0;
 
@@ -98,8 +111,9 @@ class RemoteDocumentCache {
   /**
    * Executes a query against the cached Document entries
    *
-   * Implementations may return extra documents if convenient. The results
-   * should be re-filtered by the consumer before presenting them to the user.
+   * Documents that are not in `mutated_docs` are only returned if they match
+   * the query, so consumers only need to re-filter the mutated documents
+   * after applying their mutations.
    *
    * Cached DeletedDocument entries have no bearing on query results.
    *
@@ -121,8 +135,9 @@ class RemoteDocumentCache {
   /**
    * Executes a query against the cached Document entries
    *
-   * Implementations may return extra documents if convenient. The results
-   * should be re-filtered by the consumer before presenting them to the user.
+   * Documents that are not in `mutated_docs` are only returned if they match
+   * the query, so consumers only need to re-filter the mutated documents
+   * after applying their mutations.
    *
    * Cached DeletedDocument entries have no bearing on query results.
    *
@@ -19,7 +19,9 @@
 
 #include <functional>
 #include <unordered_map>
+#include <vector>
 
+#include "Firestore/core/src/model/document_key_set.h"
 #include "Firestore/core/src/model/model_fwd.h"
 #include "Firestore/core/src/model/types.h"
 
@@ -39,6 +41,13 @@ using OrphanedDocumentCallback =
 
 using SequenceNumberCallback = std::function<void(model::ListenSequenceNumber)>;
 
+/** The documents added to and removed from a single target. */
+struct TargetKeyChanges {
+  model::TargetId target_id = 0;
+  model::DocumentKeySet added;
+  model::DocumentKeySet removed;
+};
+
 /**
  * Represents cached targets received from the remote backend. This contains
  * both a mapping between targets and the documents that matched them according
@@ -74,6 +83,13 @@ class TargetCache {
    */
   virtual void UpdateTarget(const TargetData& target_data) = 0;
 
+  /**
+   * Updates several entries in the cache at once. Equivalent to calling
+   * `UpdateTarget()` for each entry, but the target metadata is written at
+   * most once.
+   */
+  virtual void UpdateTargets(const std::vector<TargetData>& targets) = 0;
+
   /**
    * Removes the cached entry for the given target data. The entry must already
    * exist in the cache.
@@ -113,6 +129,16 @@ class TargetCache {
   virtual void RemoveMatchingKeys(const model::DocumentKeySet& keys,
                                   model::TargetId target_id) = 0;
 
+  /**
+   * Applies the key changes of several targets at once.
+   *
+   * Equivalent to calling `RemoveMatchingKeys()` and then `AddMatchingKeys()`
+   * for each entry, but allows implementations to write all index rows in key
+   * order and to notify the reference delegate only once per document.
+   */
+  virtual void ApplyMatchingKeyChanges(
+      const std::vector<TargetKeyChanges>& changes) = 0;
+
   /** Removes all document keys in the query results of the given target ID. */
   virtual void RemoveMatchingKeysForTarget(model::TargetId target_id) = 0;
 
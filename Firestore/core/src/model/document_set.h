@@ -81,6 +81,11 @@ class DocumentSet : public immutable::SortedContainer {
   /** Returns true if this set contains a document with the given key. */
   bool ContainsKey(const DocumentKey& key) const;
 
+  /** Returns the documents in this set, indexed by key. */
+  const DocumentMap& documents_by_key() const {
+    return index_;
+  }
+
   const DocumentComparator& comparator() const {
     return sorted_set_.comparator();
   }
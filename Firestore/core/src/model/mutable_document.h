@@ -142,7 +142,11 @@ class MutableDocument {
 
   MutableDocument& WithReadTime(const SnapshotVersion& read_time);
 
-  /** Creates a new document with a copy of the document's data and state. */
+  /**
+   * Creates a new document with a copy of the document's data and state.
+   * The data is shared copy-on-write, so cloning does not copy the document
+   * contents until either document is modified.
+   */
   MutableDocument Clone() const;
 
   const DocumentKey& key() const {
@@ -80,6 +80,30 @@ absl::optional<FieldMask> MutationBatch::ApplyToLocalView(
   return std::move(mutated_fields);
 }
 
+void MutationBatch::ApplyToLocalViews(const MutableDocumentPtrMap& documents,
+                                      FieldMaskMap& mutated_fields) const {
+  auto apply = [&](const Mutation& mutation) {
+    auto document = documents.find(mutation.key());
+    if (document == documents.end()) {
+      return;
+    }
+    absl::optional<FieldMask>& fields =
+        mutated_fields.emplace(mutation.key(), FieldMask()).first->second;
+    fields = mutation.ApplyToLocalView(*document->second, std::move(fields),
+                                       local_write_time_);
+  };
+
+  // As in `ApplyToLocalView`, the base state is applied before the
+  // user-provided mutations. Each document only sees its own mutations, in
+  // batch order.
+  for (const Mutation& mutation : base_mutations_) {
+    apply(mutation);
+  }
+  for (const Mutation& mutation : mutations_) {
+    apply(mutation);
+  }
+}
+
 absl::optional<FieldMask> MutationBatch::ApplyToLocalDocument(
     MutableDocument& document) const {
   return ApplyToLocalDocument(document, FieldMask{});
@@ -113,6 +113,18 @@ class MutationBatch {
       MutableDocument& document,
       absl::optional<FieldMask>&& mutated_fields) const;
 
+  /**
+   * Computes the local view of each document in `documents` that this batch
+   * mutates, visiting each mutation of the batch once. Equivalent to calling
+   * `ApplyToLocalView` on each of those documents.
+   *
+   * @param mutated_fields The fields mutated so far for each document, which
+   *     are updated with the fields mutated by this batch. Documents without
+   *     an entry start with an empty `FieldMask`.
+   */
+  void ApplyToLocalViews(const MutableDocumentPtrMap& documents,
+                         FieldMaskMap& mutated_fields) const;
+
   /**
    * Estimates the latency compensated view of all the mutations in this batch
    * applied to the given MaybeDocument.
@@ -18,6 +18,7 @@
 
 #include <algorithm>
 #include <map>
+#include <memory>
 #include <set>
 
 #include "Firestore/Protos/nanopb/google/firestore/v1/document.nanopb.h"
@@ -187,20 +188,37 @@ void ApplyChanges(
 
 }  // namespace
 
-ObjectValue::ObjectValue() {
-  value_->which_value_type = google_firestore_v1_Value_map_value_tag;
-  value_->map_value = {};
+ObjectValue::ObjectValue()
+    : value_(std::make_shared<Message<google_firestore_v1_Value>>()) {
+  (*value_)->which_value_type = google_firestore_v1_Value_map_value_tag;
+  (*value_)->map_value = {};
 }
 
-ObjectValue::ObjectValue(Message<google_firestore_v1_Value> value)
-    : value_(std::move(value)) {
-  HARD_ASSERT(value_ && IsMap(*value_),
+ObjectValue::ObjectValue(Message<google_firestore_v1_Value> value) {
+  HARD_ASSERT(value && IsMap(*value),
               "ObjectValues should be backed by a MapValue");
-  SortFields(*value_);
+  SortFields(*value);
+  value_ = std::make_shared<Message<google_firestore_v1_Value>>(
+      std::move(value));
+}
+
+ObjectValue::ObjectValue(ObjectValue&& other) noexcept
+    : value_(std::move(other.value_)),
+      fingerprint_(other.fingerprint_.exchange(kNoFingerprint,
+                                               std::memory_order_relaxed)) {
+}
+
+ObjectValue& ObjectValue::operator=(ObjectValue&& other) noexcept {
+  value_ = std::move(other.value_);
+  fingerprint_.store(
+      other.fingerprint_.exchange(kNoFingerprint, std::memory_order_relaxed),
+      std::memory_order_relaxed);
+  return *this;
 }
 
 ObjectValue::ObjectValue(const ObjectValue& other)
-    : value_(DeepClone(*other.value_)) {
+    : value_(other.value_),
+      fingerprint_(other.fingerprint_.load(std::memory_order_relaxed)) {
 }
 
 ObjectValue ObjectValue::FromMapValue(
@@ -259,7 +277,7 @@ ObjectValue ObjectValue::FromAggregateFieldsEntry(
 }
 
 FieldMask ObjectValue::ToFieldMask() const {
-  return ExtractFieldMask(value_->map_value);
+  return ExtractFieldMask(value().map_value);
 }
 
 FieldMask ObjectValue::ExtractFieldMask(
@@ -293,10 +311,10 @@ FieldMask ObjectValue::ExtractFieldMask(
 absl::optional<google_firestore_v1_Value> ObjectValue::Get(
     const FieldPath& path) const {
   if (path.empty()) {
-    return *value_;
+    return value();
   }
 
-  google_firestore_v1_Value nested_value = *value_;
+  google_firestore_v1_Value nested_value = value();
   for (const std::string& segment : path) {
     google_firestore_v1_MapValue_FieldsEntry* entry =
         FindEntry(nested_value, segment);
@@ -308,13 +326,13 @@ absl::optional<google_firestore_v1_Value> ObjectValue::Get(
 
 absl::optional<google_firestore_v1_Value> ObjectValue::Get(
     const std::string& key) const {
-  google_firestore_v1_MapValue_FieldsEntry* entry = FindEntry(*value_, key);
+  google_firestore_v1_MapValue_FieldsEntry* entry = FindEntry(value(), key);
   if (!entry) return absl::nullopt;
   return entry->value;
 }
 
 google_firestore_v1_Value ObjectValue::Get() const {
-  return *value_;
+  return value();
 }
 
 void ObjectValue::Set(const FieldPath& path,
@@ -327,6 +345,7 @@ void ObjectValue::Set(const FieldPath& path,
   upserts[path.last_segment()] = std::move(value);
 
   ApplyChanges(parent_map, std::move(upserts), /*deletes=*/{});
+  InvalidateFingerprint();
 }
 
 void ObjectValue::SetAll(TransformMap data) {
@@ -358,12 +377,16 @@ void ObjectValue::SetAll(TransformMap data) {
 
   google_firestore_v1_MapValue* parent_map = ParentMap(parent);
   ApplyChanges(parent_map, std::move(upserts), std::move(deletes));
+  InvalidateFingerprint();
 }
 
 void ObjectValue::Delete(const FieldPath& path) {
   HARD_ASSERT(!path.empty(), "Cannot delete field with empty path");
 
-  google_firestore_v1_Value* nested_value = value_.get();
+  // Avoid unsharing the data if there is nothing to delete.
+  if (!Get(path)) return;
+
+  google_firestore_v1_Value* nested_value = MutableValue();
   for (const std::string& segment : path.PopLast()) {
     auto* entry = FindEntry(*nested_value, segment);
     // If the entry is not found, exit early. There is nothing to delete.
@@ -375,19 +398,41 @@ void ObjectValue::Delete(const FieldPath& path) {
   if (IsMap(*nested_value)) {
     std::set<std::string> deletes{path.last_segment()};
     ApplyChanges(&nested_value->map_value, /*upserts=*/{}, deletes);
+    InvalidateFingerprint();
   }
 }
 
 std::string ObjectValue::ToString() const {
-  return CanonicalId(*value_);
+  return CanonicalId(value());
 }
 
 size_t ObjectValue::Hash() const {
-  return util::Hash(CanonicalId(*value_));
+  return util::Hash(CanonicalId(value()));
+}
+
+size_t ObjectValue::Fingerprint() const {
+  size_t fingerprint = fingerprint_.load(std::memory_order_relaxed);
+  if (fingerprint == kNoFingerprint) {
+    fingerprint = model::Fingerprint(value());
+    // Reserve zero for "not yet computed".
+    if (fingerprint == kNoFingerprint) fingerprint = 1;
+    fingerprint_.store(fingerprint, std::memory_order_relaxed);
+  }
+  return fingerprint;
+}
+
+google_firestore_v1_Value* ObjectValue::MutableValue() {
+  // A use count of one cannot race with a new copy, since copying requires
+  // access to this ObjectValue.
+  if (value_.use_count() > 1) {
+    value_ = std::make_shared<Message<google_firestore_v1_Value>>(
+        DeepClone(value()));
+  }
+  return value_->get();
 }
 
 google_firestore_v1_MapValue* ObjectValue::ParentMap(const FieldPath& path) {
-  google_firestore_v1_Value* parent = value_.get();
+  google_firestore_v1_Value* parent = MutableValue();
 
   // Find a or create a parent map entry for `path`.
   for (const std::string& segment : path) {
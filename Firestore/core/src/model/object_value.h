@@ -17,7 +17,9 @@
 #ifndef FIRESTORE_CORE_SRC_MODEL_OBJECT_VALUE_H_
 #define FIRESTORE_CORE_SRC_MODEL_OBJECT_VALUE_H_
 
+#include <atomic>
 #include <map>
+#include <memory>
 #include <ostream>
 #include <set>
 #include <string>
@@ -39,7 +41,13 @@ namespace firestore {
 
 namespace model {
 
-/** A structured object value stored in Firestore. */
+/**
+ * A structured object value stored in Firestore.
+ *
+ * Copies of an ObjectValue share the underlying Protobuf data, which is only
+ * cloned when one of the copies is mutated. Copying is therefore cheap, and
+ * documents that are only read never duplicate their contents.
+ */
 class ObjectValue {
  public:
   ObjectValue();
@@ -47,8 +55,8 @@ class ObjectValue {
   /** Creates a new ObjectValue */
   explicit ObjectValue(nanopb::Message<google_firestore_v1_Value> value);
 
-  ObjectValue(ObjectValue&& other) noexcept = default;
-  ObjectValue& operator=(ObjectValue&& other) noexcept = default;
+  ObjectValue(ObjectValue&& other) noexcept;
+  ObjectValue& operator=(ObjectValue&& other) noexcept;
   ObjectValue(const ObjectValue& other);
 
   ObjectValue& operator=(const ObjectValue&) = delete;
@@ -138,6 +146,16 @@ class ObjectValue {
 
   size_t Hash() const;
 
+  /**
+   * Returns a fingerprint of this object's contents, as computed by
+   * `model::Fingerprint()`.
+   *
+   * The fingerprint is computed on first use and cached until the next
+   * mutation, so repeated calls on an unchanged value are O(1). Equal objects
+   * always have equal fingerprints.
+   */
+  size_t Fingerprint() const;
+
   friend bool operator==(const ObjectValue& lhs, const ObjectValue& rhs);
   friend std::ostream& operator<<(std::ostream& out,
                                   const ObjectValue& object_value);
@@ -152,11 +170,34 @@ class ObjectValue {
    */
   google_firestore_v1_MapValue* ParentMap(const FieldPath& path);
 
-  nanopb::Message<google_firestore_v1_Value> value_;
+  const google_firestore_v1_Value& value() const {
+    return **value_;
+  }
+
+  /**
+   * Returns the Protobuf data for modification, first cloning it if it is
+   * shared with other copies of this ObjectValue.
+   */
+  google_firestore_v1_Value* MutableValue();
+
+  /** Discards the cached fingerprint after a mutation. */
+  void InvalidateFingerprint() {
+    fingerprint_.store(kNoFingerprint, std::memory_order_relaxed);
+  }
+
+  static constexpr size_t kNoFingerprint = 0;
+
+  // Never modified while shared: mutations go through `MutableValue()`.
+  std::shared_ptr<nanopb::Message<google_firestore_v1_Value>> value_;
+
+  // Documents are read concurrently from several threads, so the lazily
+  // computed fingerprint is cached in an atomic. Racing readers compute the
+  // same value.
+  mutable std::atomic<size_t> fingerprint_{kNoFingerprint};
 };
 
 inline bool operator==(const ObjectValue& lhs, const ObjectValue& rhs) {
-  return *lhs.value_ == *rhs.value_;
+  return lhs.value_ == rhs.value_ || lhs.value() == rhs.value();
 }
 
 inline bool operator!=(const ObjectValue& lhs, const ObjectValue& rhs) {
@@ -165,7 +206,7 @@ inline bool operator!=(const ObjectValue& lhs, const ObjectValue& rhs) {
 
 inline std::ostream& operator<<(std::ostream& out,
                                 const ObjectValue& object_value) {
-  return out << "ObjectValue(" << *object_value.value_ << ")";
+  return out << "ObjectValue(" << object_value.value() << ")";
 }
 
 }  // namespace model
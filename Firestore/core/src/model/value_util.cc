@@ -18,6 +18,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstring>
 #include <limits>
 #include <memory>
 #include <type_traits>
@@ -192,21 +193,47 @@ ComparisonResult CompareBlobs(const google_firestore_v1_Value& left,
   }
 }
 
+namespace {
+
+/**
+ * Removes the next non-empty '/'-separated segment from the front of `path`
+ * and returns it, or returns an empty view if `path` has no more segments.
+ */
+absl::string_view ConsumeSegment(absl::string_view* path) {
+  size_t start = path->find_first_not_of('/');
+  if (start == absl::string_view::npos) {
+    *path = absl::string_view();
+    return absl::string_view();
+  }
+  size_t end = std::min(path->find('/', start), path->size());
+  absl::string_view segment = path->substr(start, end - start);
+  path->remove_prefix(end);
+  return segment;
+}
+
+}  // namespace
+
 ComparisonResult CompareReferences(const google_firestore_v1_Value& left,
                                    const google_firestore_v1_Value& right) {
-  std::vector<std::string> left_segments = absl::StrSplit(
-      nanopb::MakeStringView(left.reference_value), '/', absl::SkipEmpty());
-  std::vector<std::string> right_segments = absl::StrSplit(
-      nanopb::MakeStringView(right.reference_value), '/', absl::SkipEmpty());
-
-  size_t min_length = std::min(left_segments.size(), right_segments.size());
-  for (size_t i = 0; i < min_length; ++i) {
-    ComparisonResult cmp = util::Compare(left_segments[i], right_segments[i]);
+  absl::string_view left_path = nanopb::MakeStringView(left.reference_value);
+  absl::string_view right_path = nanopb::MakeStringView(right.reference_value);
+  if (left_path == right_path) {
+    return ComparisonResult::Same;
+  }
+
+  while (true) {
+    absl::string_view left_segment = ConsumeSegment(&left_path);
+    absl::string_view right_segment = ConsumeSegment(&right_path);
+    if (left_segment.empty() || right_segment.empty()) {
+      // A path that runs out of segments first sorts before the other.
+      return util::Compare(!left_segment.empty(), !right_segment.empty());
+    }
+
+    ComparisonResult cmp = util::Compare(left_segment, right_segment);
     if (cmp != ComparisonResult::Same) {
       return cmp;
     }
   }
-  return util::Compare(left_segments.size(), right_segments.size());
 }
 
 ComparisonResult CompareGeoPoints(const google_firestore_v1_Value& left,
@@ -220,46 +247,112 @@ ComparisonResult CompareGeoPoints(const google_firestore_v1_Value& left,
                        right.geo_point_value.longitude);
 }
 
-ComparisonResult CompareArrays(const google_firestore_v1_Value& left,
-                               const google_firestore_v1_Value& right) {
-  int min_length =
-      std::min(left.array_value.values_count, right.array_value.values_count);
-  for (int i = 0; i < min_length; ++i) {
-    ComparisonResult cmp =
-        Compare(left.array_value.values[i], right.array_value.values[i]);
+namespace {
+
+/**
+ * Visits the fields of a MapValue in key order without copying or sorting it.
+ *
+ * Maps held by ObjectValues are already sorted, and are visited in place.
+ * Fields of any other map are visited by repeatedly selecting the smallest
+ * key larger than the last one visited.
+ */
+class SortedFieldIterator {
+ public:
+  explicit SortedFieldIterator(const google_firestore_v1_MapValue& map)
+      : map_(map),
+        sorted_(std::is_sorted(
+            map.fields, map.fields + map.fields_count,
+            [](const google_firestore_v1_MapValue_FieldsEntry& lhs,
+               const google_firestore_v1_MapValue_FieldsEntry& rhs) {
+              return nanopb::MakeStringView(lhs.key) <
+                     nanopb::MakeStringView(rhs.key);
+            })) {
+  }
+
+  /** Returns the next field in key order, or nullptr after the last one. */
+  const google_firestore_v1_MapValue_FieldsEntry* Next() {
+    if (sorted_) {
+      return position_ < map_.fields_count ? &map_.fields[position_++]
+                                           : nullptr;
+    }
+
+    const google_firestore_v1_MapValue_FieldsEntry* next = nullptr;
+    for (pb_size_t i = 0; i < map_.fields_count; ++i) {
+      absl::string_view key = nanopb::MakeStringView(map_.fields[i].key);
+      if (last_ && key <= nanopb::MakeStringView(last_->key)) continue;
+      if (!next || key < nanopb::MakeStringView(next->key)) {
+        next = &map_.fields[i];
+      }
+    }
+    last_ = next;
+    return next;
+  }
+
+ private:
+  const google_firestore_v1_MapValue& map_;
+  bool sorted_ = false;
+  pb_size_t position_ = 0;
+  const google_firestore_v1_MapValue_FieldsEntry* last_ = nullptr;
+};
+
+/**
+ * Returns the array stored under the "value" key of a vector value, or nullptr
+ * if there is none.
+ */
+const google_firestore_v1_ArrayValue* GetVectorArray(
+    const google_firestore_v1_Value& value) {
+  absl::optional<pb_size_t> index = IndexOfKey(
+      value.map_value, kRawVectorValueFieldKey, kVectorValueFieldKey);
+  if (!index.has_value()) {
+    return nullptr;
+  }
+  return &value.map_value.fields[index.value()].value.array_value;
+}
+
+ComparisonResult CompareArrayValues(
+    const google_firestore_v1_ArrayValue& left,
+    const google_firestore_v1_ArrayValue& right) {
+  pb_size_t min_length = std::min(left.values_count, right.values_count);
+  for (pb_size_t i = 0; i < min_length; ++i) {
+    ComparisonResult cmp = Compare(left.values[i], right.values[i]);
     if (cmp != ComparisonResult::Same) {
       return cmp;
     }
   }
-  return util::Compare(left.array_value.values_count,
-                       right.array_value.values_count);
+  return util::Compare(left.values_count, right.values_count);
+}
+
+}  // namespace
+
+ComparisonResult CompareArrays(const google_firestore_v1_Value& left,
+                               const google_firestore_v1_Value& right) {
+  return CompareArrayValues(left.array_value, right.array_value);
 }
 
 ComparisonResult CompareMaps(const google_firestore_v1_MapValue& left,
                              const google_firestore_v1_MapValue& right) {
-  // Sort the given MapValues
-  auto left_map = DeepClone(left);
-  auto right_map = DeepClone(right);
-  SortFields(*left_map);
-  SortFields(*right_map);
-
-  for (pb_size_t i = 0;
-       i < left_map->fields_count && i < right_map->fields_count; ++i) {
+  SortedFieldIterator left_fields(left);
+  SortedFieldIterator right_fields(right);
+
+  const google_firestore_v1_MapValue_FieldsEntry* left_field;
+  const google_firestore_v1_MapValue_FieldsEntry* right_field;
+  while ((left_field = left_fields.Next()) &&
+         (right_field = right_fields.Next())) {
     const ComparisonResult key_cmp =
-        util::Compare(nanopb::MakeStringView(left_map->fields[i].key),
-                      nanopb::MakeStringView(right_map->fields[i].key));
+        util::Compare(nanopb::MakeStringView(left_field->key),
+                      nanopb::MakeStringView(right_field->key));
     if (key_cmp != ComparisonResult::Same) {
       return key_cmp;
     }
 
     const ComparisonResult value_cmp =
-        Compare(left_map->fields[i].value, right_map->fields[i].value);
+        Compare(left_field->value, right_field->value);
     if (value_cmp != ComparisonResult::Same) {
       return value_cmp;
     }
   }
 
-  return util::Compare(left_map->fields_count, right_map->fields_count);
+  return util::Compare(left.fields_count, right.fields_count);
 }
 
 ComparisonResult CompareVectors(const google_firestore_v1_Value& left,
@@ -267,36 +360,18 @@ ComparisonResult CompareVectors(const google_firestore_v1_Value& left,
   HARD_ASSERT(IsVectorValue(left) && IsVectorValue(right),
               "Cannot compare non-vector values as vectors.");
 
-  absl::optional<pb_size_t> leftIndex =
-      IndexOfKey(left.map_value, kRawVectorValueFieldKey, kVectorValueFieldKey);
-  absl::optional<pb_size_t> rightIndex = IndexOfKey(
-      right.map_value, kRawVectorValueFieldKey, kVectorValueFieldKey);
-
-  pb_size_t leftArrayLength = 0;
-  google_firestore_v1_Value leftArray;
-  if (leftIndex.has_value()) {
-    leftArray = left.map_value.fields[leftIndex.value()].value;
-    leftArrayLength = leftArray.array_value.values_count;
-  }
+  const google_firestore_v1_ArrayValue* left_array = GetVectorArray(left);
+  const google_firestore_v1_ArrayValue* right_array = GetVectorArray(right);
+  pb_size_t left_length = left_array ? left_array->values_count : 0;
+  pb_size_t right_length = right_array ? right_array->values_count : 0;
 
-  pb_size_t rightArrayLength = 0;
-  google_firestore_v1_Value rightArray;
-  if (leftIndex.has_value()) {
-    rightArray = right.map_value.fields[rightIndex.value()].value;
-    rightArrayLength = rightArray.array_value.values_count;
-  }
-
-  if (leftArrayLength == 0 && rightArrayLength == 0) {
-    return ComparisonResult::Same;
+  // Shorter vectors sort first, regardless of their contents.
+  ComparisonResult length_cmp = util::Compare(left_length, right_length);
+  if (length_cmp != ComparisonResult::Same || left_length == 0) {
+    return length_cmp;
   }
 
-  ComparisonResult lengthCompare =
-      util::Compare(leftArrayLength, rightArrayLength);
-  if (lengthCompare != ComparisonResult::Same) {
-    return lengthCompare;
-  }
-
-  return CompareArrays(leftArray, rightArray);
+  return CompareArrayValues(*left_array, *right_array);
 }
 
 ComparisonResult Compare(const google_firestore_v1_Value& left,
@@ -491,6 +566,157 @@ bool Equals(const google_firestore_v1_ArrayValue& lhs,
   return ArrayEquals(lhs, rhs);
 }
 
+namespace {
+
+constexpr uint64_t kFingerprintSeed = 0x9e3779b97f4a7c15ULL;
+
+/** Mixes `value` into `state` using the SplitMix64 finalizer. */
+uint64_t MixFingerprint(uint64_t state, uint64_t value) {
+  uint64_t z = state ^ (value + kFingerprintSeed + (state << 6) + (state >> 2));
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+uint64_t FingerprintBytes(uint64_t state, absl::string_view bytes) {
+  const char* data = bytes.data();
+  size_t size = bytes.size();
+  for (; size >= sizeof(uint64_t); size -= sizeof(uint64_t)) {
+    uint64_t word;
+    std::memcpy(&word, data, sizeof(word));
+    state = MixFingerprint(state, word);
+    data += sizeof(uint64_t);
+  }
+
+  uint64_t tail = 0;
+  if (size > 0) {
+    std::memcpy(&tail, data, size);
+  }
+  return MixFingerprint(MixFingerprint(state, tail), bytes.size());
+}
+
+uint64_t FingerprintDouble(uint64_t state, double value) {
+  // Adding zero turns -0.0 into 0.0, which compares the same.
+  return MixFingerprint(state, util::DoubleBits(value + 0.0));
+}
+
+uint64_t FingerprintNumber(uint64_t state,
+                           const google_firestore_v1_Value& value) {
+  if (value.which_value_type == google_firestore_v1_Value_integer_value_tag) {
+    return MixFingerprint(state, static_cast<uint64_t>(value.integer_value));
+  }
+
+  // Doubles that hold an integral value in the int64_t range compare the same
+  // as the equivalent integer, so they must share its fingerprint.
+  double double_value = value.double_value;
+  if (double_value >= -9223372036854775808.0 &&
+      double_value < 9223372036854775808.0 &&
+      double_value == std::trunc(double_value)) {
+    return MixFingerprint(
+        state, static_cast<uint64_t>(static_cast<int64_t>(double_value)));
+  }
+  return FingerprintDouble(state, double_value);
+}
+
+uint64_t FingerprintTimestamp(uint64_t state,
+                              const google_protobuf_Timestamp& timestamp) {
+  state = MixFingerprint(state, static_cast<uint64_t>(timestamp.seconds));
+  return MixFingerprint(state, static_cast<uint64_t>(timestamp.nanos));
+}
+
+uint64_t FingerprintValue(const google_firestore_v1_Value& value);
+
+uint64_t FingerprintArray(uint64_t state,
+                          const google_firestore_v1_ArrayValue& array_value) {
+  for (pb_size_t i = 0; i < array_value.values_count; ++i) {
+    state = MixFingerprint(state, FingerprintValue(array_value.values[i]));
+  }
+  return MixFingerprint(state, array_value.values_count);
+}
+
+uint64_t FingerprintMap(uint64_t state,
+                        const google_firestore_v1_MapValue& map_value) {
+  // Combine entries with a commutative sum so that the result does not depend
+  // on whether the fields are sorted.
+  uint64_t entries = 0;
+  for (pb_size_t i = 0; i < map_value.fields_count; ++i) {
+    const google_firestore_v1_MapValue_FieldsEntry& entry = map_value.fields[i];
+    uint64_t key = FingerprintBytes(0, nanopb::MakeStringView(entry.key));
+    entries += MixFingerprint(key, FingerprintValue(entry.value));
+  }
+  return MixFingerprint(MixFingerprint(state, entries), map_value.fields_count);
+}
+
+uint64_t FingerprintValue(const google_firestore_v1_Value& value) {
+  TypeOrder type = GetTypeOrder(value);
+  uint64_t state = MixFingerprint(0, static_cast<uint64_t>(type));
+
+  switch (type) {
+    case TypeOrder::kNull:
+    case TypeOrder::kMaxValue:
+      return state;
+
+    case TypeOrder::kBoolean:
+      return MixFingerprint(state, value.boolean_value ? 1 : 0);
+
+    case TypeOrder::kNumber:
+      return FingerprintNumber(state, value);
+
+    case TypeOrder::kTimestamp:
+      return FingerprintTimestamp(state, value.timestamp_value);
+
+    case TypeOrder::kServerTimestamp:
+      return FingerprintTimestamp(state, GetLocalWriteTime(value));
+
+    case TypeOrder::kString:
+      return FingerprintBytes(state,
+                              nanopb::MakeStringView(value.string_value));
+
+    case TypeOrder::kBlob:
+      return FingerprintBytes(state, nanopb::MakeStringView(value.bytes_value));
+
+    case TypeOrder::kReference: {
+      // References compare segment by segment, ignoring empty segments.
+      for (absl::string_view segment :
+           absl::StrSplit(nanopb::MakeStringView(value.reference_value), '/',
+                          absl::SkipEmpty())) {
+        state = FingerprintBytes(state, segment);
+      }
+      return state;
+    }
+
+    case TypeOrder::kGeoPoint:
+      state = FingerprintDouble(state, value.geo_point_value.latitude);
+      return FingerprintDouble(state, value.geo_point_value.longitude);
+
+    case TypeOrder::kArray:
+      return FingerprintArray(state, value.array_value);
+
+    case TypeOrder::kVector: {
+      // Vectors compare only by the contents of their "value" array.
+      absl::optional<pb_size_t> index = IndexOfKey(
+          value.map_value, kRawVectorValueFieldKey, kVectorValueFieldKey);
+      if (!index) {
+        return state;
+      }
+      return FingerprintArray(
+          state, value.map_value.fields[*index].value.array_value);
+    }
+
+    case TypeOrder::kMap:
+      return FingerprintMap(state, value.map_value);
+
+    default:
+      HARD_FAIL("Invalid type value: %s", type);
+  }
+}
+
+}  // namespace
+
+size_t Fingerprint(const google_firestore_v1_Value& value) {
+  return static_cast<size_t>(FingerprintValue(value));
+}
+
 std::string CanonifyTimestamp(const google_firestore_v1_Value& value) {
   return absl::StrFormat("time(%d,%d)", value.timestamp_value.seconds,
                          value.timestamp_value.nanos);
@@ -103,6 +103,17 @@ bool Equals(const google_firestore_v1_Value& left,
 bool Equals(const google_firestore_v1_ArrayValue& left,
             const google_firestore_v1_ArrayValue& right);
 
+/**
+ * Returns a fingerprint of the given value's contents.
+ *
+ * Values that are equal according to `Equals()` or that compare as the same
+ * according to `Compare()` always have the same fingerprint. Different values
+ * have different fingerprints with high probability, so a fingerprint mismatch
+ * proves two values differ without a deep comparison. Fingerprints are not
+ * stable across processes and must not be persisted.
+ */
+size_t Fingerprint(const google_firestore_v1_Value& value);
+
 /**
  * Generates the canonical ID for the provided field value (as used in Target
  * serialization).
@@ -0,0 +1,287 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/model/vector_distance.h"
+
+#include <cmath>
+
+#include "Firestore/core/src/model/value_util.h"
+
+// SSE2 and NEON are part of the baseline instruction set of x86-64 and
+// AArch64 respectively, so they are selected at compile time. AVX2 and FMA
+// are only available on some x86-64 CPUs and are selected at run time.
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FIRESTORE_VECTOR_DISTANCE_SSE2 1
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define FIRESTORE_VECTOR_DISTANCE_NEON 1
+#endif
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define FIRESTORE_VECTOR_DISTANCE_AVX2_DISPATCH 1
+#endif
+
+namespace firebase {
+namespace firestore {
+namespace model {
+
+namespace {
+
+// Each kernel returns the sum over `i` of `Term(lhs[i], rhs[i])`, where the
+// term is either the product or the squared difference of the components.
+// Kernels keep several independent accumulators so that consecutive
+// additions don't wait on each other.
+
+double DotProductPortable(const double* lhs, const double* rhs, size_t size) {
+  double sum0 = 0, sum1 = 0, sum2 = 0, sum3 = 0;
+  size_t i = 0;
+  for (; i + 4 <= size; i += 4) {
+    sum0 += lhs[i] * rhs[i];
+    sum1 += lhs[i + 1] * rhs[i + 1];
+    sum2 += lhs[i + 2] * rhs[i + 2];
+    sum3 += lhs[i + 3] * rhs[i + 3];
+  }
+  for (; i < size; ++i) {
+    sum0 += lhs[i] * rhs[i];
+  }
+  return (sum0 + sum1) + (sum2 + sum3);
+}
+
+double SquaredEuclideanDistancePortable(const double* lhs,
+                                        const double* rhs,
+                                        size_t size) {
+  double sum0 = 0, sum1 = 0, sum2 = 0, sum3 = 0;
+  size_t i = 0;
+  for (; i + 4 <= size; i += 4) {
+    double d0 = lhs[i] - rhs[i];
+    double d1 = lhs[i + 1] - rhs[i + 1];
+    double d2 = lhs[i + 2] - rhs[i + 2];
+    double d3 = lhs[i + 3] - rhs[i + 3];
+    sum0 += d0 * d0;
+    sum1 += d1 * d1;
+    sum2 += d2 * d2;
+    sum3 += d3 * d3;
+  }
+  for (; i < size; ++i) {
+    double d = lhs[i] - rhs[i];
+    sum0 += d * d;
+  }
+  return (sum0 + sum1) + (sum2 + sum3);
+}
+
+#if defined(FIRESTORE_VECTOR_DISTANCE_AVX2_DISPATCH)
+// The AVX2 kernels process whole blocks of 8 components and return the
+// number of components they consumed through `processed`.
+__attribute__((target("avx2,fma"))) static double DotProductAvx2(
+    const double* lhs, const double* rhs, size_t size, size_t* processed) {
+  __m256d sum0 = _mm256_setzero_pd();
+  __m256d sum1 = _mm256_setzero_pd();
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    sum0 = _mm256_fmadd_pd(_mm256_loadu_pd(lhs + i), _mm256_loadu_pd(rhs + i),
+                           sum0);
+    sum1 = _mm256_fmadd_pd(_mm256_loadu_pd(lhs + i + 4),
+                           _mm256_loadu_pd(rhs + i + 4), sum1);
+  }
+  __m256d sum = _mm256_add_pd(sum0, sum1);
+  __m128d half = _mm_add_pd(_mm256_castpd256_pd128(sum),
+                            _mm256_extractf128_pd(sum, 1));
+  *processed = i;
+  return _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+}
+
+__attribute__((target("avx2,fma"))) static double SquaredEuclideanDistanceAvx2(
+    const double* lhs, const double* rhs, size_t size, size_t* processed) {
+  __m256d sum0 = _mm256_setzero_pd();
+  __m256d sum1 = _mm256_setzero_pd();
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    __m256d d0 =
+        _mm256_sub_pd(_mm256_loadu_pd(lhs + i), _mm256_loadu_pd(rhs + i));
+    __m256d d1 = _mm256_sub_pd(_mm256_loadu_pd(lhs + i + 4),
+                               _mm256_loadu_pd(rhs + i + 4));
+    sum0 = _mm256_fmadd_pd(d0, d0, sum0);
+    sum1 = _mm256_fmadd_pd(d1, d1, sum1);
+  }
+  __m256d sum = _mm256_add_pd(sum0, sum1);
+  __m128d half = _mm_add_pd(_mm256_castpd256_pd128(sum),
+                            _mm256_extractf128_pd(sum, 1));
+  *processed = i;
+  return _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+}
+
+static bool CpuSupportsAvx2AndFma() {
+  static const bool supported =
+      __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+  return supported;
+}
+#endif  // FIRESTORE_VECTOR_DISTANCE_AVX2_DISPATCH
+
+}  // namespace
+
+bool GetVectorComponents(const google_firestore_v1_Value& value,
+                         std::vector<double>* components) {
+  components->clear();
+  if (!IsVectorValue(value)) {
+    return false;
+  }
+
+  absl::optional<pb_size_t> index = IndexOfKey(
+      value.map_value, kRawVectorValueFieldKey, kVectorValueFieldKey);
+  if (!index) {
+    return false;
+  }
+
+  const google_firestore_v1_ArrayValue& array =
+      value.map_value.fields[*index].value.array_value;
+  components->reserve(array.values_count);
+  for (pb_size_t i = 0; i < array.values_count; ++i) {
+    const google_firestore_v1_Value& element = array.values[i];
+    switch (element.which_value_type) {
+      case google_firestore_v1_Value_double_value_tag:
+        components->push_back(element.double_value);
+        break;
+      case google_firestore_v1_Value_integer_value_tag:
+        components->push_back(static_cast<double>(element.integer_value));
+        break;
+      default:
+        components->clear();
+        return false;
+    }
+  }
+  return true;
+}
+
+double DotProduct(const double* lhs, const double* rhs, size_t size) {
+  double sum = 0;
+  size_t i = 0;
+
+#if defined(FIRESTORE_VECTOR_DISTANCE_AVX2_DISPATCH)
+  if (size >= 8 && CpuSupportsAvx2AndFma()) {
+    sum = DotProductAvx2(lhs, rhs, size, &i);
+  }
+#endif
+
+#if defined(FIRESTORE_VECTOR_DISTANCE_SSE2)
+  __m128d sum0 = _mm_setzero_pd();
+  __m128d sum1 = _mm_setzero_pd();
+  for (; i + 4 <= size; i += 4) {
+    sum0 = _mm_add_pd(
+        sum0, _mm_mul_pd(_mm_loadu_pd(lhs + i), _mm_loadu_pd(rhs + i)));
+    sum1 = _mm_add_pd(sum1, _mm_mul_pd(_mm_loadu_pd(lhs + i + 2),
+                                       _mm_loadu_pd(rhs + i + 2)));
+  }
+  __m128d pair = _mm_add_pd(sum0, sum1);
+  sum += _mm_cvtsd_f64(_mm_add_sd(pair, _mm_unpackhi_pd(pair, pair)));
+#elif defined(FIRESTORE_VECTOR_DISTANCE_NEON)
+  float64x2_t sum0 = vdupq_n_f64(0);
+  float64x2_t sum1 = vdupq_n_f64(0);
+  for (; i + 4 <= size; i += 4) {
+    sum0 = vfmaq_f64(sum0, vld1q_f64(lhs + i), vld1q_f64(rhs + i));
+    sum1 = vfmaq_f64(sum1, vld1q_f64(lhs + i + 2), vld1q_f64(rhs + i + 2));
+  }
+  sum += vaddvq_f64(vaddq_f64(sum0, sum1));
+#endif
+
+  return sum + DotProductPortable(lhs + i, rhs + i, size - i);
+}
+
+double SquaredEuclideanDistance(const double* lhs,
+                                const double* rhs,
+                                size_t size) {
+  double sum = 0;
+  size_t i = 0;
+
+#if defined(FIRESTORE_VECTOR_DISTANCE_AVX2_DISPATCH)
+  if (size >= 8 && CpuSupportsAvx2AndFma()) {
+    sum = SquaredEuclideanDistanceAvx2(lhs, rhs, size, &i);
+  }
+#endif
+
+#if defined(FIRESTORE_VECTOR_DISTANCE_SSE2)
+  __m128d sum0 = _mm_setzero_pd();
+  __m128d sum1 = _mm_setzero_pd();
+  for (; i + 4 <= size; i += 4) {
+    __m128d d0 = _mm_sub_pd(_mm_loadu_pd(lhs + i), _mm_loadu_pd(rhs + i));
+    __m128d d1 =
+        _mm_sub_pd(_mm_loadu_pd(lhs + i + 2), _mm_loadu_pd(rhs + i + 2));
+    sum0 = _mm_add_pd(sum0, _mm_mul_pd(d0, d0));
+    sum1 = _mm_add_pd(sum1, _mm_mul_pd(d1, d1));
+  }
+  __m128d pair = _mm_add_pd(sum0, sum1);
+  sum += _mm_cvtsd_f64(_mm_add_sd(pair, _mm_unpackhi_pd(pair, pair)));
+#elif defined(FIRESTORE_VECTOR_DISTANCE_NEON)
+  float64x2_t sum0 = vdupq_n_f64(0);
+  float64x2_t sum1 = vdupq_n_f64(0);
+  for (; i + 4 <= size; i += 4) {
+    float64x2_t d0 = vsubq_f64(vld1q_f64(lhs + i), vld1q_f64(rhs + i));
+    float64x2_t d1 =
+        vsubq_f64(vld1q_f64(lhs + i + 2), vld1q_f64(rhs + i + 2));
+    sum0 = vfmaq_f64(sum0, d0, d0);
+    sum1 = vfmaq_f64(sum1, d1, d1);
+  }
+  sum += vaddvq_f64(vaddq_f64(sum0, sum1));
+#endif
+
+  return sum + SquaredEuclideanDistancePortable(lhs + i, rhs + i, size - i);
+}
+
+absl::optional<double> ComputeDistance(DistanceMeasure measure,
+                                       const std::vector<double>& lhs,
+                                       const std::vector<double>& rhs) {
+  if (lhs.size() != rhs.size()) {
+    return absl::nullopt;
+  }
+
+  switch (measure) {
+    case DistanceMeasure::kEuclidean:
+      return std::sqrt(
+          SquaredEuclideanDistance(lhs.data(), rhs.data(), lhs.size()));
+
+    case DistanceMeasure::kCosine: {
+      double lhs_norm = DotProduct(lhs.data(), lhs.data(), lhs.size());
+      double rhs_norm = DotProduct(rhs.data(), rhs.data(), rhs.size());
+      if (lhs_norm == 0 || rhs_norm == 0) {
+        return absl::nullopt;
+      }
+      double dot = DotProduct(lhs.data(), rhs.data(), lhs.size());
+      return 1 - dot / std::sqrt(lhs_norm * rhs_norm);
+    }
+
+    case DistanceMeasure::kDotProduct:
+      return DotProduct(lhs.data(), rhs.data(), lhs.size());
+  }
+  return absl::nullopt;
+}
+
+double TEST_DotProductPortable(const double* lhs,
+                               const double* rhs,
+                               size_t size) {
+  return DotProductPortable(lhs, rhs, size);
+}
+
+double TEST_SquaredEuclideanDistancePortable(const double* lhs,
+                                             const double* rhs,
+                                             size_t size) {
+  return SquaredEuclideanDistancePortable(lhs, rhs, size);
+}
+
+}  // namespace model
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,87 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_MODEL_VECTOR_DISTANCE_H_
+#define FIRESTORE_CORE_SRC_MODEL_VECTOR_DISTANCE_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "Firestore/Protos/nanopb/google/firestore/v1/document.nanopb.h"
+#include "absl/types/optional.h"
+
+namespace firebase {
+namespace firestore {
+namespace model {
+
+/** The distance measures supported by vector nearest-neighbor search. */
+enum class DistanceMeasure {
+  /** Euclidean distance. Smaller distances are nearer. */
+  kEuclidean,
+
+  /** One minus the cosine similarity. Smaller distances are nearer. */
+  kCosine,
+
+  /** The dot product. Unlike the others, larger values are nearer. */
+  kDotProduct
+};
+
+/**
+ * Copies the components of the given VectorValue into `components`, reusing
+ * its storage. Returns false if `value` is not a VectorValue or contains
+ * non-numeric components.
+ */
+bool GetVectorComponents(const google_firestore_v1_Value& value,
+                         std::vector<double>* components);
+
+/** Returns the dot product of the `size` element vectors `lhs` and `rhs`. */
+double DotProduct(const double* lhs, const double* rhs, size_t size);
+
+/**
+ * Returns the squared Euclidean distance between the `size` element vectors
+ * `lhs` and `rhs`.
+ */
+double SquaredEuclideanDistance(const double* lhs,
+                                const double* rhs,
+                                size_t size);
+
+/**
+ * Returns the distance between `lhs` and `rhs` under `measure`, or `nullopt`
+ * if it is undefined because the vectors differ in size or, for the cosine
+ * distance, one of them is zero.
+ */
+absl::optional<double> ComputeDistance(DistanceMeasure measure,
+                                       const std::vector<double>& lhs,
+                                       const std::vector<double>& rhs);
+
+/** Returns true if distance `lhs` is nearer than `rhs` under `measure`. */
+inline bool IsNearer(DistanceMeasure measure, double lhs, double rhs) {
+  return measure == DistanceMeasure::kDotProduct ? lhs > rhs : lhs < rhs;
+}
+
+// Scalar versions of the SIMD kernels, exposed for testing.
+double TEST_DotProductPortable(const double* lhs,
+                               const double* rhs,
+                               size_t size);
+double TEST_SquaredEuclideanDistancePortable(const double* lhs,
+                                             const double* rhs,
+                                             size_t size);
+
+}  // namespace model
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_MODEL_VECTOR_DISTANCE_H_
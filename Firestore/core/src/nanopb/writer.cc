@@ -123,6 +123,12 @@ std::string StringWriter::Release() {
   return std::move(buffer_);
 }
 
+SizingWriter::SizingWriter() {
+  // Without a callback, Nanopb only advances `bytes_written`.
+  stream_.callback = nullptr;
+  stream_.max_size = SIZE_MAX;
+}
+
 }  // namespace nanopb
 }  // namespace firestore
 }  // namespace firebase
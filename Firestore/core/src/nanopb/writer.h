@@ -140,6 +140,22 @@ class StringWriter : public Writer {
   std::string buffer_;
 };
 
+/**
+ * A `Writer` that discards the encoded bytes and only counts them, for
+ * measuring the encoded size of a proto without allocating a buffer.
+ *
+ * This is roughly equivalent to the Nanopb macro `PB_OSTREAM_SIZING`.
+ */
+class SizingWriter : public Writer {
+ public:
+  SizingWriter();
+
+  /** Returns the number of bytes written so far. */
+  size_t size() const {
+    return stream_.bytes_written;
+  }
+};
+
 }  // namespace nanopb
 }  // namespace firestore
 }  // namespace firebase
@@ -80,6 +80,12 @@ void GrpcCompletion::EnsureValidFuture() {
 }
 
 void GrpcCompletion::Complete(bool ok) {
+  // Runs before the completion is marked as off the queue, so that anything
+  // the step refers to stays valid while `GrpcStream` waits for it.
+  if (ok && off_queue_step_) {
+    off_queue_step_(this);
+  }
+
   // This mechanism allows `GrpcStream` to know when the completion is off the
   // gRPC completion queue (and thus no longer requires the underlying gRPC
   // objects to be valid).
@@ -74,6 +74,13 @@ class GrpcCompletion : public std::enable_shared_from_this<GrpcCompletion> {
   using Callback =
       std::function<void(bool, const std::shared_ptr<GrpcCompletion>&)>;
 
+  /**
+   * Work done on the thread that takes the completion off the gRPC completion
+   * queue, before the callback is scheduled on the worker queue. Only runs if
+   * the operation completed successfully.
+   */
+  using OffQueueStep = std::function<void(GrpcCompletion*)>;
+
   static std::shared_ptr<GrpcCompletion> Create(
       Type type,
       const std::shared_ptr<util::AsyncQueue>& worker_queue,
@@ -93,6 +100,15 @@ class GrpcCompletion : public std::enable_shared_from_this<GrpcCompletion> {
 
   void Cancel();
 
+  /**
+   * Sets work that `Complete` does off the worker queue, e.g. decoding a
+   * message that was read. Must be called before the completion is submitted
+   * to gRPC.
+   */
+  void set_off_queue_step(OffQueueStep step) {
+    off_queue_step_ = std::move(step);
+  }
+
   /**
    * Blocks until the `GrpcCompletion` comes back from the gRPC completion
    * queue. It is important to only call this function when the `GrpcCompletion`
@@ -127,6 +143,7 @@ class GrpcCompletion : public std::enable_shared_from_this<GrpcCompletion> {
 
   std::shared_ptr<util::AsyncQueue> worker_queue_;
   Callback callback_;
+  OffQueueStep off_queue_step_;
 
   // Ownership of the GrpcCompletion is shared between the Firestore gRPC
   // wrapper object that initiated the operation (e.g., a `GrpcStream`) and gRPC
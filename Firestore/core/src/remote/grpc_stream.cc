@@ -128,9 +128,17 @@ void GrpcStream::Read() {
     return;
   }
 
+  // Filled in off the worker queue when the read completes.
+  auto prepared = std::make_shared<GrpcStreamObserver::PreparedRead>();
   auto completion = NewCompletion(
-      Type::Read, [this](const std::shared_ptr<GrpcCompletion>& completion) {
-        OnRead(*completion->message());
+      Type::Read,
+      [this, prepared](const std::shared_ptr<GrpcCompletion>& completion) {
+        OnRead(*completion->message(), *prepared);
+      });
+  GrpcStreamObserver* observer = observer_;
+  completion->set_off_queue_step(
+      [observer, prepared](GrpcCompletion* completion) {
+        *prepared = observer->PrepareStreamRead(*completion->message());
       });
   call_->Read(completion->message(), completion.get());
 }
@@ -291,14 +299,19 @@ GrpcStream::Metadata GrpcStream::GetResponseHeaders() const {
 
 // Callbacks
 
-void GrpcStream::OnRead(const grpc::ByteBuffer& message) {
+void GrpcStream::OnRead(const grpc::ByteBuffer& message,
+                        const GrpcStreamObserver::PreparedRead& prepared) {
   if (observer_) {
     // Continue waiting for new messages indefinitely as long as there is an
     // interested observer.
     // Order is important here -- any call to observer can potentially end this
     // stream's lifetime, so call `Read` before notifying.
     Read();
-    observer_->OnStreamRead(message);
+    if (prepared) {
+      prepared();
+    } else {
+      observer_->OnStreamRead(message);
+    }
   }
 }
 
@@ -193,7 +193,8 @@ class GrpcStream : public GrpcCall {
   void MaybeUnregister();
 
   void OnStart();
-  void OnRead(const grpc::ByteBuffer& message);
+  void OnRead(const grpc::ByteBuffer& message,
+              const GrpcStreamObserver::PreparedRead& prepared);
   void OnWrite();
   void OnOperationFailed();
   void RemoveCompletion(const std::shared_ptr<GrpcCompletion>& to_remove);
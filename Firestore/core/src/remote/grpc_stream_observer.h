@@ -17,6 +17,8 @@
 #ifndef FIRESTORE_CORE_SRC_REMOTE_GRPC_STREAM_OBSERVER_H_
 #define FIRESTORE_CORE_SRC_REMOTE_GRPC_STREAM_OBSERVER_H_
 
+#include <functional>
+
 #include "Firestore/core/src/util/status_fwd.h"
 #include "grpcpp/support/byte_buffer.h"
 
@@ -27,10 +29,20 @@ namespace remote {
 /** Observer that gets notified of events on a gRPC stream. */
 class GrpcStreamObserver {
  public:
+  // The rest of the handling of a message prepared by `PrepareStreamRead`.
+  using PreparedRead = std::function<void()>;
+
   virtual ~GrpcStreamObserver() = default;
 
   // Stream has been successfully established.
   virtual void OnStreamStart() = 0;
+  // A message has been received from the server. Called off the worker queue,
+  // on the thread that takes reads off the gRPC completion queue, in the order
+  // messages arrive; must only touch thread-safe state. If a function is
+  // returned, it runs on the worker queue in place of `OnStreamRead`.
+  virtual PreparedRead PrepareStreamRead(const grpc::ByteBuffer&) {
+    return {};
+  }
   // A message has been received from the server.
   virtual void OnStreamRead(const grpc::ByteBuffer& message) = 0;
   // Connection has been broken, perhaps by the server.
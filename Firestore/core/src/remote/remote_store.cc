@@ -42,7 +42,7 @@ using local::TargetData;
 using model::AggregateField;
 using model::BatchId;
 using model::DocumentKeySet;
-using model::kBatchIdUnknown;
+using model::Mutation;
 using model::MutationBatch;
 using model::MutationBatchResult;
 using model::MutationResult;
@@ -53,22 +53,18 @@ using nanopb::ByteString;
 using util::AsyncQueue;
 using util::Status;
 
-/**
- * The maximum number of pending writes to allow.
- * TODO(b/35853402): Negotiate this value with the backend.
- */
-constexpr int kMaxPendingWrites = 10;
-
 RemoteStore::RemoteStore(
     LocalStore* local_store,
     std::shared_ptr<Datastore> datastore,
     const std::shared_ptr<util::AsyncQueue>& worker_queue,
     ConnectivityMonitor* connectivity_monitor,
-    std::function<void(model::OnlineState)> online_state_handler)
+    std::function<void(model::OnlineState)> online_state_handler,
+    WritePipelineSettings write_pipeline_settings)
     : local_store_{local_store},
       datastore_{std::move(datastore)},
       online_state_tracker_{worker_queue, std::move(online_state_handler)},
-      connectivity_monitor_{NOT_NULL(connectivity_monitor)} {
+      connectivity_monitor_{NOT_NULL(connectivity_monitor)},
+      write_pipeline_{write_pipeline_settings} {
   datastore_->Start();
 
   // Create streams (but note they're not started yet)
@@ -132,7 +128,7 @@ void RemoteStore::DisableNetworkInternal() {
   if (!write_pipeline_.empty()) {
     LOG_DEBUG("Stopping write stream with %s pending writes",
               write_pipeline_.size());
-    write_pipeline_.clear();
+    write_pipeline_.Clear();
   }
 
   CleanUpWatchStreamState();
@@ -393,9 +389,7 @@ void RemoteStore::RunAggregateQuery(
 // Write Stream
 
 void RemoteStore::FillWritePipeline() {
-  BatchId last_batch_id_retrieved = write_pipeline_.empty()
-                                        ? kBatchIdUnknown
-                                        : write_pipeline_.back().batch_id();
+  BatchId last_batch_id_retrieved = write_pipeline_.last_batch_id();
   while (CanAddToWritePipeline()) {
     absl::optional<MutationBatch> batch =
         local_store_->GetNextMutationBatch(last_batch_id_retrieved);
@@ -409,24 +403,30 @@ void RemoteStore::FillWritePipeline() {
     last_batch_id_retrieved = batch->batch_id();
   }
 
+  if (write_stream_->IsOpen() && write_stream_->handshake_complete()) {
+    SendWritePipeline();
+  }
+
   if (ShouldStartWriteStream()) {
     StartWriteStream();
   }
 }
 
 bool RemoteStore::CanAddToWritePipeline() const {
-  return CanUseNetwork() && write_pipeline_.size() < kMaxPendingWrites;
+  return CanUseNetwork() && !write_pipeline_.full();
 }
 
 void RemoteStore::AddToWritePipeline(const MutationBatch& batch) {
   HARD_ASSERT(CanAddToWritePipeline(),
               "AddToWritePipeline called when pipeline is full");
 
-  write_pipeline_.push_back(batch);
+  write_pipeline_.Add(batch);
+}
 
-  if (write_stream_->IsOpen() && write_stream_->handshake_complete()) {
-    write_stream_->WriteMutations(batch.mutations());
-  }
+void RemoteStore::SendWritePipeline() {
+  write_pipeline_.SendPending([this](const std::vector<Mutation>& mutations) {
+    write_stream_->WriteMutations(mutations);
+  });
 }
 
 bool RemoteStore::ShouldStartWriteStream() const {
@@ -441,6 +441,8 @@ void RemoteStore::StartWriteStream() {
 }
 
 void RemoteStore::OnWriteStreamOpen() {
+  // Nothing has been sent on the new stream yet.
+  write_pipeline_.ResetStream();
   write_stream_->WriteHandshake();
 }
 
@@ -449,25 +451,20 @@ void RemoteStore::OnWriteStreamHandshakeComplete() {
   local_store_->SetLastStreamToken(write_stream_->last_stream_token());
 
   // Send the write pipeline now that the stream is established.
-  for (const MutationBatch& write : write_pipeline_) {
-    write_stream_->WriteMutations(write.mutations());
-  }
+  SendWritePipeline();
 }
 
 void RemoteStore::OnWriteStreamMutationResult(
     SnapshotVersion commit_version,
     std::vector<MutationResult> mutation_results) {
   // This is a response to a write containing mutations and should be correlated
-  // to the first write in our write pipeline.
-  HARD_ASSERT(!write_pipeline_.empty(), "Got result for empty write pipeline");
-
-  MutationBatch batch = write_pipeline_.front();
-  write_pipeline_.erase(write_pipeline_.begin());
-
-  MutationBatchResult batch_result(std::move(batch), commit_version,
-                                   std::move(mutation_results),
-                                   write_stream_->last_stream_token());
-  sync_engine_->HandleSuccessfulWrite(std::move(batch_result));
+  // to the oldest outstanding request, which may carry several batches.
+  std::vector<MutationBatchResult> batch_results = write_pipeline_.Acknowledge(
+      commit_version, std::move(mutation_results),
+      write_stream_->last_stream_token());
+  for (MutationBatchResult& batch_result : batch_results) {
+    sync_engine_->HandleSuccessfulWrite(std::move(batch_result));
+  }
 
   // It's possible that with the completion of this mutation another slot has
   // freed up.
@@ -536,15 +533,17 @@ void RemoteStore::HandleWriteError(const Status& status) {
   }
 
   // If this was a permanent error, the request itself was the problem so it's
-  // not going to succeed if we resend it.
-  MutationBatch batch = write_pipeline_.front();
-  write_pipeline_.erase(write_pipeline_.begin());
+  // not going to succeed if we resend it. If the request carried several
+  // batches, they are resent one by one to find the batch that failed.
+  absl::optional<MutationBatch> batch = write_pipeline_.Reject();
 
   // In this case it's also unlikely that the server itself is melting
   // down--this was just a bad request so inhibit backoff on the next restart.
   write_stream_->InhibitBackoff();
 
-  sync_engine_->HandleRejectedWrite(batch.batch_id(), status);
+  if (batch) {
+    sync_engine_->HandleRejectedWrite(batch->batch_id(), status);
+  }
 
   // It's possible that with the completion of this mutation another slot has
   // freed up.
@@ -31,6 +31,7 @@
 #include "Firestore/core/src/remote/remote_event.h"
 #include "Firestore/core/src/remote/watch_change.h"
 #include "Firestore/core/src/remote/watch_stream.h"
+#include "Firestore/core/src/remote/write_pipeline.h"
 #include "Firestore/core/src/remote/write_stream.h"
 #include "Firestore/core/src/util/async_queue.h"
 #include "Firestore/core/src/util/status_fwd.h"
@@ -116,7 +117,8 @@ class RemoteStore : public TargetMetadataProvider,
               std::shared_ptr<Datastore> datastore,
               const std::shared_ptr<util::AsyncQueue>& worker_queue,
               ConnectivityMonitor* connectivity_monitor,
-              std::function<void(model::OnlineState)> online_state_handler);
+              std::function<void(model::OnlineState)> online_state_handler,
+              WritePipelineSettings write_pipeline_settings = {});
 
   void set_sync_engine(RemoteStoreCallback* sync_engine) {
     sync_engine_ = sync_engine;
@@ -183,8 +185,8 @@ class RemoteStore : public TargetMetadataProvider,
   void FillWritePipeline();
 
   /**
-   * Queues additional writes to be sent to the write stream, sending them
-   * immediately if the write stream is established.
+   * Queues additional writes to be sent to the write stream. They are sent by
+   * the next call to `FillWritePipeline` once the write stream is established.
    */
   void AddToWritePipeline(const model::MutationBatch& batch);
 
@@ -238,6 +240,9 @@ class RemoteStore : public TargetMetadataProvider,
    */
   bool CanAddToWritePipeline() const;
 
+  /** Sends the batches in the pipeline that were not sent on this stream. */
+  void SendWritePipeline();
+
   void StartWriteStream();
 
   /**
@@ -296,13 +301,14 @@ class RemoteStore : public TargetMetadataProvider,
   std::unique_ptr<WatchChangeAggregator> watch_change_aggregator_;
 
   /**
-   * A list of up to `kMaxPendingWrites` writes that we have fetched from the
-   * `LocalStore` via `FillWritePipeline` and have or will send to the write
-   * stream.
+   * The writes that we have fetched from the `LocalStore` via
+   * `FillWritePipeline` and have or will send to the write stream, up to the
+   * pipeline's depth.
    *
    * Whenever `write_pipeline_` is not empty, the `RemoteStore` will attempt to
    * start or restart the write stream. When the stream is established, the
-   * writes in the pipeline will be sent in order.
+   * writes in the pipeline will be sent in order, possibly several batches to
+   * a request.
    *
    * Writes remain in `write_pipeline_` until they are acknowledged by the
    * backend and thus will automatically be re-sent if the stream is interrupted
@@ -312,7 +318,7 @@ class RemoteStore : public TargetMetadataProvider,
    * purely based on order, and so we can just remove writes from the front of
    * the `write_pipeline_` as we receive responses.
    */
-  std::vector<model::MutationBatch> write_pipeline_;
+  WritePipeline write_pipeline_;
 };
 
 }  // namespace remote
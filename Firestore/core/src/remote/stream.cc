@@ -25,6 +25,7 @@
 #include "Firestore/core/src/util/error_apple.h"
 #include "Firestore/core/src/util/hard_assert.h"
 #include "Firestore/core/src/util/log.h"
+#include "Firestore/core/src/util/metrics.h"
 #include "Firestore/core/src/util/string_format.h"
 
 namespace firebase {
@@ -56,6 +57,13 @@ const AsyncQueue::Milliseconds kIdleTimeout{std::chrono::seconds(60)};
 /** The time a stream stays open until we consider it healthy. */
 const AsyncQueue::Milliseconds kHealthyTimeout{std::chrono::seconds(10)};
 
+/** The size of the messages read from all streams. */
+util::MetricCounter& BytesReceived() {
+  static util::MetricCounter& counter =
+      util::MetricsRegistry::GetInstance().GetCounter("stream.bytes_received");
+  return counter;
+}
+
 }  // namespace
 
 Stream::Stream(const std::shared_ptr<AsyncQueue>& worker_queue,
@@ -247,7 +255,22 @@ void Stream::CancelIdleCheck() {
 
 // Read/write
 
+GrpcStreamObserver::PreparedRead Stream::PrepareStreamRead(
+    const grpc::ByteBuffer& message) {
+  BytesReceived().Increment(static_cast<int64_t>(message.Length()));
+
+  std::function<Status()> notify = PrepareStreamResponse(message);
+  if (!notify) {
+    return {};
+  }
+  return [this, notify] { HandleStreamResponse(notify); };
+}
+
 void Stream::OnStreamRead(const grpc::ByteBuffer& message) {
+  HandleStreamResponse([&] { return NotifyStreamResponse(message); });
+}
+
+void Stream::HandleStreamResponse(const std::function<Status()>& notify) {
   EnsureOnQueue();
 
   HARD_ASSERT(IsStarted(), "OnStreamRead called for a stopped stream.");
@@ -258,7 +281,7 @@ void Stream::OnStreamRead(const grpc::ByteBuffer& message) {
                   grpc_stream_->GetResponseHeaders()));
   }
 
-  Status read_status = NotifyStreamResponse(message);
+  Status read_status = notify();
   if (!read_status.ok()) {
     grpc_stream_->FinishImmediately();
     // Don't expect gRPC to produce status -- since the error happened on the
@@ -17,6 +17,7 @@
 #ifndef FIRESTORE_CORE_SRC_REMOTE_STREAM_H_
 #define FIRESTORE_CORE_SRC_REMOTE_STREAM_H_
 
+#include <functional>
 #include <memory>
 #include <string>
 
@@ -200,6 +201,7 @@ class Stream : public GrpcStreamObserver,
 
   // `GrpcStreamObserver` interface -- do not use.
   void OnStreamStart() override;
+  PreparedRead PrepareStreamRead(const grpc::ByteBuffer& message) override;
   void OnStreamRead(const grpc::ByteBuffer& message) override;
   void OnStreamFinish(const util::Status& status) override;
 
@@ -228,12 +230,24 @@ class Stream : public GrpcStreamObserver,
   virtual void NotifyStreamOpen() = 0;
   virtual util::Status NotifyStreamResponse(
       const grpc::ByteBuffer& message) = 0;
+  /**
+   * Optionally decodes a response off the worker queue (see
+   * `GrpcStreamObserver::PrepareStreamRead`), so it must not touch state owned
+   * by the queue. The returned function is then run on the worker queue in
+   * place of `NotifyStreamResponse`. By default, all of the work is left to
+   * `NotifyStreamResponse`.
+   */
+  virtual std::function<util::Status()> PrepareStreamResponse(
+      const grpc::ByteBuffer&) {
+    return {};
+  }
   virtual void NotifyStreamClose(const util::Status& status) = 0;
   // PORTING NOTE: C++ cannot rely on RTTI, unlike other platforms.
   virtual std::string GetDebugName() const = 0;
 
   void Close(const util::Status& status);
   void HandleErrorStatus(const util::Status& status);
+  void HandleStreamResponse(const std::function<util::Status()>& notify);
 
   void RequestCredentials();
   void ResumeStartWithCredentials(
@@ -17,6 +17,7 @@
 #ifndef FIRESTORE_CORE_SRC_REMOTE_WATCH_STREAM_H_
 #define FIRESTORE_CORE_SRC_REMOTE_WATCH_STREAM_H_
 
+#include <functional>
 #include <memory>
 #include <string>
 
@@ -117,6 +118,8 @@ class WatchStream : public Stream {
 
   void NotifyStreamOpen() override;
   util::Status NotifyStreamResponse(const grpc::ByteBuffer& message) override;
+  std::function<util::Status()> PrepareStreamResponse(
+      const grpc::ByteBuffer& message) override;
   void NotifyStreamClose(const util::Status& status) override;
 
   std::string GetDebugName() const override {
@@ -0,0 +1,212 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/remote/write_pipeline.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <utility>
+
+#include "Firestore/core/src/model/mutation_batch_result.h"
+#include "Firestore/core/src/util/hard_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+using model::BatchId;
+using model::Mutation;
+using model::MutationBatch;
+using model::MutationBatchResult;
+using model::MutationResult;
+using model::SnapshotVersion;
+using nanopb::ByteString;
+
+namespace {
+
+/**
+ * The pipeline grows by one batch for each response that arrives within this
+ * multiple of the fastest round trip seen...
+ */
+constexpr int kGrowLatencyFactor = 2;
+
+/**
+ * ...and halves when a response takes longer than this multiple, which
+ * indicates that requests are queueing up on the way to the backend.
+ */
+constexpr int kShrinkLatencyFactor = 4;
+
+}  // namespace
+
+WritePipelineSettings WritePipelineSettings::Adaptive() {
+  WritePipelineSettings settings;
+  settings.max_batches_per_request = 50;
+  settings.max_mutations_per_request = 500;
+  settings.min_depth = 10;
+  settings.max_depth = 100;
+  return settings;
+}
+
+WritePipeline::WritePipeline(WritePipelineSettings settings,
+                             std::function<Clock::time_point()> clock)
+    : settings_{settings},
+      clock_{std::move(clock)},
+      depth_{settings.min_depth} {
+  HARD_ASSERT(settings_.max_batches_per_request > 0,
+              "A write request must carry at least one batch");
+  HARD_ASSERT(settings_.min_depth > 0 &&
+                  settings_.min_depth <= settings_.max_depth,
+              "Invalid write pipeline depth bounds");
+}
+
+BatchId WritePipeline::last_batch_id() const {
+  return batches_.empty() ? model::kBatchIdUnknown
+                          : batches_.back().batch_id();
+}
+
+void WritePipeline::Add(MutationBatch batch) {
+  batches_.push_back(std::move(batch));
+}
+
+void WritePipeline::SendPending(
+    const std::function<void(const std::vector<Mutation>&)>& send) {
+  while (sent_batches_ < batches_.size()) {
+    auto first = batches_.begin() + sent_batches_;
+    auto last = std::next(first);
+    size_t mutation_count = first->mutations().size();
+
+    if (first->batch_id() > unpack_through_batch_id_) {
+      for (; last != batches_.end(); ++last) {
+        size_t batch_count = static_cast<size_t>(last - first);
+        size_t next_count = mutation_count + last->mutations().size();
+        if (batch_count == settings_.max_batches_per_request ||
+            next_count > settings_.max_mutations_per_request) {
+          break;
+        }
+        mutation_count = next_count;
+      }
+    }
+
+    size_t batch_count = static_cast<size_t>(last - first);
+    if (batch_count == 1) {
+      send(first->mutations());
+    } else {
+      std::vector<Mutation> mutations;
+      mutations.reserve(mutation_count);
+      for (auto batch = first; batch != last; ++batch) {
+        mutations.insert(mutations.end(), batch->mutations().begin(),
+                         batch->mutations().end());
+      }
+      send(mutations);
+    }
+
+    requests_.push_back(Request{batch_count, clock_()});
+    sent_batches_ += batch_count;
+  }
+}
+
+void WritePipeline::ResetStream() {
+  requests_.clear();
+  sent_batches_ = 0;
+}
+
+std::vector<MutationBatchResult> WritePipeline::Acknowledge(
+    const SnapshotVersion& commit_version,
+    std::vector<MutationResult> mutation_results,
+    const ByteString& stream_token) {
+  HARD_ASSERT(!requests_.empty() && !batches_.empty(),
+              "Got result for empty write pipeline");
+
+  Request request = requests_.front();
+  requests_.pop_front();
+  sent_batches_ -= request.batch_count;
+  UpdateDepth(clock_() - request.sent_at);
+
+  std::vector<MutationBatchResult> batch_results;
+  batch_results.reserve(request.batch_count);
+
+  if (request.batch_count == 1) {
+    batch_results.emplace_back(std::move(batches_.front()), commit_version,
+                               std::move(mutation_results), stream_token);
+    batches_.pop_front();
+    return batch_results;
+  }
+
+  auto results = mutation_results.begin();
+  for (size_t i = 0; i < request.batch_count; ++i) {
+    MutationBatch batch = std::move(batches_.front());
+    batches_.pop_front();
+
+    auto count = static_cast<std::ptrdiff_t>(batch.mutations().size());
+    HARD_ASSERT(mutation_results.end() - results >= count,
+                "Write response is missing mutation results");
+    std::vector<MutationResult> batch_mutation_results(
+        std::make_move_iterator(results),
+        std::make_move_iterator(results + count));
+    results += count;
+
+    batch_results.emplace_back(std::move(batch), commit_version,
+                               std::move(batch_mutation_results),
+                               stream_token);
+  }
+  HARD_ASSERT(results == mutation_results.end(),
+              "Write response has more mutation results than mutations");
+  return batch_results;
+}
+
+absl::optional<MutationBatch> WritePipeline::Reject() {
+  HARD_ASSERT(!batches_.empty(), "Got error for empty write pipeline");
+
+  size_t batch_count = requests_.empty() ? 1 : requests_.front().batch_count;
+  if (batch_count > 1) {
+    unpack_through_batch_id_ = batches_[batch_count - 1].batch_id();
+    return absl::nullopt;
+  }
+
+  if (!requests_.empty()) {
+    requests_.pop_front();
+    --sent_batches_;
+  }
+  MutationBatch batch = std::move(batches_.front());
+  batches_.pop_front();
+  return batch;
+}
+
+void WritePipeline::Clear() {
+  batches_.clear();
+  ResetStream();
+}
+
+void WritePipeline::UpdateDepth(Clock::duration latency) {
+  if (settings_.min_depth == settings_.max_depth) {
+    return;
+  }
+
+  if (!min_latency_ || latency < *min_latency_) {
+    min_latency_ = latency;
+  }
+
+  if (latency <= *min_latency_ * kGrowLatencyFactor) {
+    depth_ = std::min(depth_ + 1, settings_.max_depth);
+  } else if (latency > *min_latency_ * kShrinkLatencyFactor) {
+    depth_ = std::max(depth_ / 2, settings_.min_depth);
+  }
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
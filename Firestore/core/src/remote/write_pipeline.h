@@ -0,0 +1,180 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_REMOTE_WRITE_PIPELINE_H_
+#define FIRESTORE_CORE_SRC_REMOTE_WRITE_PIPELINE_H_
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <vector>
+
+#include "Firestore/core/src/model/model_fwd.h"
+#include "Firestore/core/src/model/mutation_batch.h"
+#include "Firestore/core/src/model/types.h"
+#include "Firestore/core/src/nanopb/byte_string.h"
+#include "absl/types/optional.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+/** Limits that control how the `WritePipeline` talks to the backend. */
+struct WritePipelineSettings {
+  /**
+   * Returns settings that pack consecutive batches into shared requests and
+   * let the pipeline grow while the backend keeps up.
+   */
+  static WritePipelineSettings Adaptive();
+
+  /**
+   * The maximum number of batches sent in one write request. With the default
+   * of 1 every batch is sent in a request of its own.
+   */
+  size_t max_batches_per_request = 1;
+
+  /**
+   * The maximum number of mutations in a request that carries more than one
+   * batch. A single batch is always sent, however large it is.
+   */
+  size_t max_mutations_per_request = 500;
+
+  /**
+   * The bounds on the number of batches fetched from the `LocalStore` and not
+   * yet acknowledged. When they differ the depth adapts to the round-trip time
+   * of write requests; the pipeline starts at `min_depth`.
+   */
+  size_t min_depth = 10;
+  size_t max_depth = 10;
+};
+
+/**
+ * The mutation batches that the `RemoteStore` has fetched from the
+ * `LocalStore` and has sent or will send to the write stream, together with
+ * the requests that are awaiting a response.
+ *
+ * The backend applies the writes of one request atomically and in order and
+ * answers requests in the order they were sent, so consecutive batches may
+ * share a request: the response carries one result per mutation, which is
+ * split back into per-batch results by mutation count.
+ *
+ * `WritePipeline` is not thread-safe; it is used on the worker queue.
+ */
+class WritePipeline {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit WritePipeline(
+      WritePipelineSettings settings = {},
+      std::function<Clock::time_point()> clock = Clock::now);
+
+  bool empty() const {
+    return batches_.empty();
+  }
+
+  size_t size() const {
+    return batches_.size();
+  }
+
+  /** The number of batches the pipeline currently allows. */
+  size_t depth() const {
+    return depth_;
+  }
+
+  /** Whether the pipeline holds as many batches as its depth allows. */
+  bool full() const {
+    return batches_.size() >= depth_;
+  }
+
+  /**
+   * The ID of the most recently added batch, or `kBatchIdUnknown` if the
+   * pipeline is empty.
+   */
+  model::BatchId last_batch_id() const;
+
+  /** Appends a batch; it is sent by the next call to `SendPending`. */
+  void Add(model::MutationBatch batch);
+
+  /**
+   * Packs the batches not yet sent on the current stream into requests and
+   * passes the mutations of each request to `send`, in order.
+   */
+  void SendPending(
+      const std::function<void(const std::vector<model::Mutation>&)>& send);
+
+  /**
+   * Forgets which batches were sent, so that all of them are sent again on
+   * the next stream.
+   */
+  void ResetStream();
+
+  /**
+   * Removes the batches answered by a successful write response, which
+   * belongs to the oldest outstanding request, and returns their results.
+   */
+  std::vector<model::MutationBatchResult> Acknowledge(
+      const model::SnapshotVersion& commit_version,
+      std::vector<model::MutationResult> mutation_results,
+      const nanopb::ByteString& stream_token);
+
+  /**
+   * Handles a permanent error for the oldest outstanding request.
+   *
+   * If the request carried a single batch, that batch is removed and returned
+   * so that it can be rejected. Otherwise the failing batch is not known: all
+   * batches stay in the pipeline and the ones from the failed request are
+   * resent one per request, so that the next failure identifies the batch.
+   */
+  absl::optional<model::MutationBatch> Reject();
+
+  /** Removes all batches, e.g. because the network was disabled. */
+  void Clear();
+
+ private:
+  /** A request that was sent and has not been answered yet. */
+  struct Request {
+    size_t batch_count;
+    Clock::time_point sent_at;
+  };
+
+  /** Adjusts the depth after a request was answered after `latency`. */
+  void UpdateDepth(Clock::duration latency);
+
+  WritePipelineSettings settings_;
+  std::function<Clock::time_point()> clock_;
+
+  std::deque<model::MutationBatch> batches_;
+  std::deque<Request> requests_;
+
+  /** The number of batches at the front of `batches_` that were sent. */
+  size_t sent_batches_ = 0;
+
+  /**
+   * Batches up to and including this ID are sent one per request because a
+   * request that carried them failed.
+   */
+  model::BatchId unpack_through_batch_id_ = model::kBatchIdUnknown;
+
+  size_t depth_ = 0;
+  absl::optional<Clock::duration> min_latency_;
+};
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_REMOTE_WRITE_PIPELINE_H_
@@ -16,10 +16,14 @@
 
 #include "Firestore/core/src/util/async_queue.h"
 
+#include <array>
+#include <chrono>  // NOLINT(build/c++11)
 #include <utility>
 
 #include "Firestore/core/src/util/hard_assert.h"
+#include "Firestore/core/src/util/metrics.h"
 #include "Firestore/core/src/util/task.h"
+#include "Firestore/core/src/util/tracing.h"
 #include "absl/algorithm/container.h"
 #include "absl/memory/memory.h"
 
@@ -27,6 +31,66 @@ namespace firebase {
 namespace firestore {
 namespace util {
 
+namespace {
+
+constexpr size_t kNumTimerIds =
+    static_cast<size_t>(TimerId::ListenerSnapshotDelay) + 1;
+
+const char* TimerName(TimerId timer_id) {
+  switch (timer_id) {
+    case TimerId::All:
+      return "immediate";
+    case TimerId::ListenStreamIdle:
+      return "listen_stream_idle";
+    case TimerId::ListenStreamConnectionBackoff:
+      return "listen_stream_connection_backoff";
+    case TimerId::WriteStreamIdle:
+      return "write_stream_idle";
+    case TimerId::WriteStreamConnectionBackoff:
+      return "write_stream_connection_backoff";
+    case TimerId::HealthCheckTimeout:
+      return "health_check_timeout";
+    case TimerId::OnlineStateTimeout:
+      return "online_state_timeout";
+    case TimerId::GarbageCollectionDelay:
+      return "garbage_collection_delay";
+    case TimerId::RetryTransaction:
+      return "retry_transaction";
+    case TimerId::IndexBackfillDelay:
+      return "index_backfill_delay";
+    case TimerId::ListenerSnapshotDelay:
+      return "listener_snapshot_delay";
+  }
+  UNREACHABLE();
+}
+
+/**
+ * The metrics of operations tagged with each `TimerId`, looked up once so that
+ * wrapping an operation doesn't take the registry lock.
+ */
+struct OperationMetrics {
+  MetricHistogram* queue_latency_micros = nullptr;
+  MetricHistogram* run_micros = nullptr;
+};
+
+const OperationMetrics& MetricsFor(TimerId timer_id) {
+  static const std::array<OperationMetrics, kNumTimerIds> metrics = [] {
+    std::array<OperationMetrics, kNumTimerIds> result;
+    MetricsRegistry& registry = MetricsRegistry::GetInstance();
+    for (size_t i = 0; i < kNumTimerIds; ++i) {
+      const char* name = TimerName(static_cast<TimerId>(i));
+      result[i].queue_latency_micros =
+          &registry.GetHistogram("async_queue.queue_latency_micros", name);
+      result[i].run_micros =
+          &registry.GetHistogram("async_queue.run_micros", name);
+    }
+    return result;
+  }();
+  return metrics[static_cast<size_t>(timer_id)];
+}
+
+}  // namespace
+
 std::shared_ptr<AsyncQueue> AsyncQueue::Create(
     std::unique_ptr<Executor> executor) {
   // Use new because make_shared cannot access a private constructor.
@@ -57,6 +121,15 @@ void AsyncQueue::Dispose() {
   }
 
   executor_->Dispose();
+
+  // Like the executor, discard the operations that will never run. They are
+  // destroyed outside of the lock because their destructors may try to
+  // enqueue.
+  decltype(lanes_) discarded;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    discarded.swap(lanes_);
+  }
 }
 
 void AsyncQueue::VerifyIsCurrentExecutor() const {
@@ -91,15 +164,21 @@ void AsyncQueue::ExecuteBlocking(const Operation& operation) {
 }
 
 bool AsyncQueue::Enqueue(const Operation& operation) {
+  return Enqueue(Priority::kSync, operation);
+}
+
+bool AsyncQueue::Enqueue(Priority priority, const Operation& operation) {
   VerifySequentialOrder();
-  return EnqueueRelaxed(operation);
+  return EnqueueRelaxed(priority, operation);
 }
 
 bool AsyncQueue::EnqueueEvenWhileRestricted(const Operation& operation) {
   std::lock_guard<std::mutex> lock(mutex_);
   if (mode_ == Mode::kDisposed) return false;
 
-  executor_->Execute(Wrap(operation));
+  // The least urgent lane runs last, so the operation runs after everything
+  // enqueued before it.
+  EnqueueLocked(Priority::kBackground, operation);
   return true;
 }
 
@@ -109,13 +188,50 @@ bool AsyncQueue::is_running() const {
 }
 
 bool AsyncQueue::EnqueueRelaxed(const Operation& operation) {
+  return EnqueueRelaxed(Priority::kSync, operation);
+}
+
+bool AsyncQueue::EnqueueRelaxed(Priority priority,
+                                const Operation& operation) {
   std::lock_guard<std::mutex> lock(mutex_);
   if (mode_ != Mode::kRunning) return false;
 
-  executor_->Execute(Wrap(operation));
+  EnqueueLocked(priority, operation);
   return true;
 }
 
+bool AsyncQueue::ShouldYield() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return !lanes_[static_cast<size_t>(Priority::kInteractive)].empty() ||
+         !lanes_[static_cast<size_t>(Priority::kSync)].empty();
+}
+
+void AsyncQueue::EnqueueLocked(Priority priority, const Operation& operation) {
+  lanes_[static_cast<size_t>(priority)].push_back(Wrap(operation));
+
+  // Every operation gets its own call, so the executor still runs exactly as
+  // many operations as were enqueued; each call just picks the most urgent.
+  executor_->Execute([this] { RunNextOperation(); });
+}
+
+void AsyncQueue::RunNextOperation() {
+  Operation operation;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& lane : lanes_) {
+      if (!lane.empty()) {
+        operation = std::move(lane.front());
+        lane.pop_front();
+        break;
+      }
+    }
+  }
+
+  if (operation) {
+    operation();
+  }
+}
+
 DelayedOperation AsyncQueue::EnqueueAfterDelay(Milliseconds delay,
                                                const TimerId timer_id,
                                                const Operation& operation) {
@@ -132,16 +248,32 @@ DelayedOperation AsyncQueue::EnqueueAfterDelay(Milliseconds delay,
   }
 
   auto tag = static_cast<Executor::Tag>(timer_id);
-  return executor_->Schedule(delay, tag, Wrap(operation));
+  return executor_->Schedule(delay, tag, Wrap(operation, timer_id, delay));
 }
 
-AsyncQueue::Operation AsyncQueue::Wrap(const Operation& operation) {
+AsyncQueue::Operation AsyncQueue::Wrap(const Operation& operation,
+                                       TimerId timer_id,
+                                       Milliseconds delay) {
   // Decorator pattern: wrap `operation` into a call to `ExecuteBlocking` to
   // ensure that it doesn't spawn any nested operations.
 
+  // Queue latency is measured from the time the operation became due, so that
+  // delayed operations only count the time they were held up past `delay`.
+  const OperationMetrics& metrics = MetricsFor(timer_id);
+  auto enqueued = std::chrono::steady_clock::now();
+  auto due = enqueued + delay;
+
   // The Executor guarantees that this operation will either execute before
   // `Dispose` completes or not at all.
-  return [this, operation] { this->ExecuteBlocking(operation); };
+  return [this, operation, timer_id, &metrics, enqueued, due] {
+    metrics.queue_latency_micros->RecordMicrosSince(due);
+    auto start = std::chrono::steady_clock::now();
+    {
+      TraceSpan span("async_queue", TimerName(timer_id), enqueued);
+      this->ExecuteBlocking(operation);
+    }
+    metrics.run_micros->RecordMicrosSince(start);
+  };
 }
 
 void AsyncQueue::VerifySequentialOrder() const {
@@ -17,8 +17,10 @@
 #ifndef FIRESTORE_CORE_SRC_UTIL_ASYNC_QUEUE_H_
 #define FIRESTORE_CORE_SRC_UTIL_ASYNC_QUEUE_H_
 
+#include <array>
 #include <atomic>
 #include <chrono>  // NOLINT(build/c++11)
+#include <deque>
 #include <functional>
 #include <memory>
 #include <mutex>  // NOLINT(build/c++11)
@@ -73,13 +75,25 @@ enum class TimerId {
   /**
    * A timer used to periodically attempt Index Backfill
    */
-  IndexBackfillDelay
+  IndexBackfillDelay,
+
+  /**
+   * A timer used by `QueryListener` to raise coalesced snapshots once the
+   * minimum snapshot interval of the listener has elapsed. There can be one
+   * such timer per listener.
+   */
+  ListenerSnapshotDelay
 };
 
 // A serial queue that executes given operations asynchronously, one at a time.
 // Operations may be scheduled to be executed as soon as possible or in the
 // future. Operations scheduled for the same time are FIFO-ordered.
 //
+// Operations enqueued for immediate execution belong to a `Priority` class:
+// whenever the queue picks the next operation to run, it picks the oldest one
+// of the most urgent class. Operations of the same class always run in FIFO
+// order.
+//
 // `AsyncQueue` wraps a platform-specific executor, adding checks that enforce
 // sequential ordering of operations: an enqueued operation, while being run,
 // normally cannot enqueue other operations for immediate execution (but see
@@ -117,6 +131,26 @@ class AsyncQueue : public std::enable_shared_from_this<AsyncQueue> {
     kDisposed,
   };
 
+  /** The classes of operations enqueued for immediate execution. */
+  enum class Priority {
+    /**
+     * Operations that a user is waiting on, such as API calls. All
+     * operations that must run in the order the user issued them belong to
+     * this class.
+     */
+    kInteractive,
+
+    /** The default: keeping the local state in sync with the backend. */
+    kSync,
+
+    /**
+     * Work that may be put off, such as maintenance. Background work should
+     * also check `ShouldYield` at safe points and defer the rest of its work
+     * if more urgent operations are waiting.
+     */
+    kBackground,
+  };
+
   static std::shared_ptr<AsyncQueue> Create(std::unique_ptr<Executor> executor);
 
   ~AsyncQueue();
@@ -139,7 +173,7 @@ class AsyncQueue : public std::enable_shared_from_this<AsyncQueue> {
   // Enqueue methods
 
   // Puts the `operation` on the queue to be executed as soon as possible, while
-  // maintaining FIFO order.
+  // maintaining FIFO order among operations of `Priority::kSync`.
   //
   // Precondition: `Enqueue` calls cannot be nested; that is, `Enqueue` may not
   // be called by a previously enqueued operation when it is run (as a special
@@ -154,8 +188,15 @@ class AsyncQueue : public std::enable_shared_from_this<AsyncQueue> {
   //     restricted mode or been disposed.
   bool Enqueue(const Operation& operation);
 
+  // Like `Enqueue`, but runs the `operation` ahead of any operations of less
+  // urgent `priority` that are waiting to run. `Enqueue` uses
+  // `Priority::kSync`.
+  bool Enqueue(Priority priority, const Operation& operation);
+
   // Like `Enqueue`, but it will proceed scheduling the requested operation
-  // regardless of whether the queue is in restricted mode or not.
+  // regardless of whether the queue is in restricted mode or not. The
+  // `operation` runs after every operation enqueued before it, whatever their
+  // priority.
   //
   // @return true if the operation was successfully enqueued or false if the
   //     operation was not enqueued because the `AsyncQueue` has already been
@@ -164,6 +205,11 @@ class AsyncQueue : public std::enable_shared_from_this<AsyncQueue> {
 
   // Like `Enqueue`, but without applying any prerequisite checks.
   bool EnqueueRelaxed(const Operation& operation);
+  bool EnqueueRelaxed(Priority priority, const Operation& operation);
+
+  // Returns true if interactive or sync operations are waiting to run.
+  // Background work checks this at safe points to yield to them.
+  bool ShouldYield() const;
 
   // Returns true if the queue is still in the main kRunning mode (i.e. not
   // restricted or disposed).
@@ -231,7 +277,20 @@ class AsyncQueue : public std::enable_shared_from_this<AsyncQueue> {
  private:
   explicit AsyncQueue(std::unique_ptr<Executor> executor);
 
-  Operation Wrap(const Operation& operation);
+  // Decorates `operation` to run through `ExecuteBlocking` and to record, in
+  // the metrics of `timer_id`, how long it waited past `delay` and how long it
+  // ran. Operations that are not delayed use `TimerId::All`. When tracing is
+  // enabled, the operation is also recorded as a span named after `timer_id`.
+  Operation Wrap(const Operation& operation,
+                 TimerId timer_id = TimerId::All,
+                 Milliseconds delay = Milliseconds(0));
+
+  // Adds `operation` to the lane of `priority` and has the executor run the
+  // next operation. Must be called with `mutex_` held.
+  void EnqueueLocked(Priority priority, const Operation& operation);
+
+  // Runs the most urgent operation waiting in the lanes, if any.
+  void RunNextOperation();
 
   // Asserts that the current invocation happens asynchronously on the queue.
   void VerifyIsCurrentExecutor() const;
@@ -243,6 +302,10 @@ class AsyncQueue : public std::enable_shared_from_this<AsyncQueue> {
   mutable std::mutex mutex_;
   Mode mode_ = Mode::kRunning;
 
+  // Operations enqueued for immediate execution, by priority. The executor
+  // holds one `RunNextOperation` call for each of them.
+  std::array<std::deque<Operation>, 3> lanes_;
+
   std::vector<TimerId> timer_ids_to_skip_;
 };
 
@@ -17,6 +17,7 @@
 #include "Firestore/core/src/util/background_queue.h"
 
 #include "Firestore/core/src/util/executor.h"
+#include "Firestore/core/src/util/tracing.h"
 
 namespace firebase {
 namespace firestore {
@@ -31,7 +32,7 @@ void BackgroundQueue::Execute(std::function<void()>&& operation) {
     pending_tasks_ += 1;
   }
 
-  executor_->Execute([this, operation]() {
+  Executor::Operation task = [this, operation]() {
     operation();
 
     std::lock_guard<std::mutex> lock(mutex_);
@@ -39,7 +40,11 @@ void BackgroundQueue::Execute(std::function<void()>&& operation) {
     if (pending_tasks_ == 0) {
       done_.notify_all();
     }
-  });
+  };
+  if (Tracer::GetInstance().enabled()) {
+    task = TraceOperation("executor", executor_->Name(), std::move(task));
+  }
+  executor_->Execute(std::move(task));
 }
 
 void BackgroundQueue::AwaitAll() {
@@ -0,0 +1,190 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/util/metrics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+#include "Firestore/core/src/util/bits.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+namespace {
+
+template <typename T, typename Map>
+T& GetOrCreate(Map& metrics, absl::string_view name, absl::string_view label) {
+  auto by_name = metrics.find(name);
+  if (by_name == metrics.end()) {
+    by_name =
+        metrics.emplace(std::string(name), typename Map::mapped_type{}).first;
+  }
+
+  auto& by_label = by_name->second;
+  auto found = by_label.find(label);
+  if (found == by_label.end()) {
+    found = by_label.emplace(std::string(label), absl::make_unique<T>()).first;
+  }
+  return *found->second;
+}
+
+std::string MetricName(const std::string& name, const std::string& label) {
+  return label.empty() ? name : absl::StrCat(name, "[", label, "]");
+}
+
+}  // namespace
+
+double HistogramSnapshot::mean() const {
+  return count == 0 ? 0 : static_cast<double>(sum) / count;
+}
+
+int64_t HistogramSnapshot::Percentile(double percentile) const {
+  if (count == 0) {
+    return 0;
+  }
+
+  auto rank = static_cast<int64_t>(std::ceil(count * percentile / 100));
+  rank = std::max<int64_t>(rank, 1);
+
+  int64_t seen = 0;
+  for (size_t i = 0; i < buckets.size(); ++i) {
+    seen += buckets[i];
+    if (seen >= rank) {
+      if (i == 0) {
+        return 0;
+      }
+      int64_t upper_bound = i >= 63 ? std::numeric_limits<int64_t>::max()
+                                    : (int64_t{1} << i) - 1;
+      return std::min(upper_bound, max);
+    }
+  }
+  return max;
+}
+
+std::string HistogramSnapshot::ToString() const {
+  return absl::StrCat("count: ", count, ", mean: ", mean(),
+                      ", p50: ", Percentile(50), ", p90: ", Percentile(90),
+                      ", p99: ", Percentile(99), ", max: ", max);
+}
+
+void MetricHistogram::Record(int64_t value) {
+  int bucket = value < 1 ? 0
+                         : Bits::Log2FloorNonZero64(
+                               static_cast<uint64_t>(value)) + 1;
+  bucket = std::min(bucket, kNumBuckets - 1);
+
+  count_.fetch_add(1, std::memory_order_relaxed);
+  sum_.fetch_add(value, std::memory_order_relaxed);
+  buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+
+  int64_t max = max_.load(std::memory_order_relaxed);
+  while (value > max &&
+         !max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+  }
+}
+
+HistogramSnapshot MetricHistogram::Snapshot() const {
+  HistogramSnapshot snapshot;
+  snapshot.count = count_.load(std::memory_order_relaxed);
+  snapshot.sum = sum_.load(std::memory_order_relaxed);
+  snapshot.max = max_.load(std::memory_order_relaxed);
+  snapshot.buckets.reserve(kNumBuckets);
+  for (const auto& bucket : buckets_) {
+    snapshot.buckets.push_back(bucket.load(std::memory_order_relaxed));
+  }
+  return snapshot;
+}
+
+void MetricHistogram::Reset() {
+  count_.store(0, std::memory_order_relaxed);
+  sum_.store(0, std::memory_order_relaxed);
+  max_.store(0, std::memory_order_relaxed);
+  for (auto& bucket : buckets_) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+}
+
+std::string MetricsSnapshot::ToString() const {
+  std::string result;
+  for (const auto& counter : counters) {
+    absl::StrAppend(&result, counter.first, ": ", counter.second, "\n");
+  }
+  for (const auto& histogram : histograms) {
+    absl::StrAppend(&result, histogram.first, ": ",
+                    histogram.second.ToString(), "\n");
+  }
+  return result;
+}
+
+MetricsRegistry& MetricsRegistry::GetInstance() {
+  static NoDestructor<MetricsRegistry> instance;
+  return *instance;
+}
+
+MetricCounter& MetricsRegistry::GetCounter(absl::string_view name,
+                                           absl::string_view label) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return GetOrCreate<MetricCounter>(counters_, name, label);
+}
+
+MetricHistogram& MetricsRegistry::GetHistogram(absl::string_view name,
+                                               absl::string_view label) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return GetOrCreate<MetricHistogram>(histograms_, name, label);
+}
+
+MetricsSnapshot MetricsRegistry::Snapshot() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  MetricsSnapshot snapshot;
+  for (const auto& by_name : counters_) {
+    for (const auto& by_label : by_name.second) {
+      snapshot.counters.emplace(MetricName(by_name.first, by_label.first),
+                                by_label.second->value());
+    }
+  }
+  for (const auto& by_name : histograms_) {
+    for (const auto& by_label : by_name.second) {
+      snapshot.histograms.emplace(MetricName(by_name.first, by_label.first),
+                                  by_label.second->Snapshot());
+    }
+  }
+  return snapshot;
+}
+
+void MetricsRegistry::Reset() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto& by_name : counters_) {
+    for (const auto& by_label : by_name.second) {
+      by_label.second->Reset();
+    }
+  }
+  for (const auto& by_name : histograms_) {
+    for (const auto& by_label : by_name.second) {
+      by_label.second->Reset();
+    }
+  }
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,180 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_UTIL_METRICS_H_
+#define FIRESTORE_CORE_SRC_UTIL_METRICS_H_
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/util/no_destructor.h"
+#include "absl/strings/string_view.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+/** A count that only goes up. Safe to use from any thread. */
+class MetricCounter {
+ public:
+  void Increment(int64_t amount = 1) {
+    value_.fetch_add(amount, std::memory_order_relaxed);
+  }
+
+  int64_t value() const {
+    return value_.load(std::memory_order_relaxed);
+  }
+
+  void Reset() {
+    value_.store(0, std::memory_order_relaxed);
+  }
+
+ private:
+  std::atomic<int64_t> value_{0};
+};
+
+/** The values recorded by a `MetricHistogram` at some point in time. */
+struct HistogramSnapshot {
+  int64_t count = 0;
+  int64_t sum = 0;
+  int64_t max = 0;
+
+  /**
+   * `buckets[0]` counts values less than 1; `buckets[i]` counts values in
+   * `[2^(i-1), 2^i)`.
+   */
+  std::vector<int64_t> buckets;
+
+  double mean() const;
+
+  /**
+   * Returns an upper bound of the given percentile (between 0 and 100) of the
+   * recorded values: the upper end of the bucket that contains it, capped at
+   * `max`.
+   */
+  int64_t Percentile(double percentile) const;
+
+  std::string ToString() const;
+};
+
+/**
+ * The distribution of recorded values in power-of-two buckets. Safe to use
+ * from any thread; recording costs a few relaxed atomic operations.
+ */
+class MetricHistogram {
+ public:
+  static constexpr int kNumBuckets = 64;
+
+  void Record(int64_t value);
+
+  /**
+   * Records the time elapsed since `start` in microseconds, or 0 if `start`
+   * is in the future.
+   */
+  void RecordMicrosSince(std::chrono::steady_clock::time_point start) {
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+    Record(std::max<int64_t>(elapsed.count(), 0));
+  }
+
+  /**
+   * Returns the recorded values. Values recorded concurrently may be partially
+   * reflected.
+   */
+  HistogramSnapshot Snapshot() const;
+
+  void Reset();
+
+ private:
+  std::atomic<int64_t> count_{0};
+  std::atomic<int64_t> sum_{0};
+  std::atomic<int64_t> max_{0};
+  std::array<std::atomic<int64_t>, kNumBuckets> buckets_{};
+};
+
+/** The values of all metrics at some point in time, keyed by metric name. */
+struct MetricsSnapshot {
+  std::map<std::string, int64_t> counters;
+  std::map<std::string, HistogramSnapshot> histograms;
+
+  std::string ToString() const;
+};
+
+/**
+ * Counters and histograms that describe where the SDK spends its time, shared
+ * by all Firestore instances in the process.
+ *
+ * Metrics are always recorded and never removed. Looking one up takes a lock,
+ * so code on hot paths looks its metrics up once and keeps the reference.
+ * Metrics that are broken down by a dynamic label, such as the label of a
+ * persistence transaction, are looked up by `name` and `label` without
+ * allocating and are exported as "name[label]".
+ */
+class MetricsRegistry final {
+ public:
+  /** Returns the singleton instance of this class. */
+  static MetricsRegistry& GetInstance();
+
+  MetricCounter& GetCounter(absl::string_view name,
+                            absl::string_view label = {});
+  MetricHistogram& GetHistogram(absl::string_view name,
+                                absl::string_view label = {});
+
+  /** Returns the current values of all metrics that were looked up. */
+  MetricsSnapshot Snapshot() const;
+
+  /** Resets all metrics to zero; mostly useful for tests and benchmarks. */
+  void Reset();
+
+ private:
+  template <typename T>
+  using LabeledMetrics = std::map<std::string,
+                                  std::map<std::string, std::unique_ptr<T>,
+                                           std::less<>>,
+                                  std::less<>>;
+
+  MetricsRegistry() = default;
+
+  // Delete the destructor so that the singleton instance of this class can
+  // never be deleted.
+  ~MetricsRegistry() = delete;
+
+  MetricsRegistry(const MetricsRegistry&) = delete;
+  MetricsRegistry(MetricsRegistry&&) = delete;
+  MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+  MetricsRegistry& operator=(MetricsRegistry&&) = delete;
+
+  friend class NoDestructor<MetricsRegistry>;
+
+  mutable std::mutex mutex_;
+  LabeledMetrics<MetricCounter> counters_;
+  LabeledMetrics<MetricHistogram> histograms_;
+};
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_UTIL_METRICS_H_
@@ -28,6 +28,23 @@
 #include "absl/base/port.h"
 #include "absl/strings/internal/resize_uninitialized.h"
 
+// SSE2 and NEON are part of the baseline instruction set of x86-64 and
+// AArch64 respectively, so they are selected at compile time. AVX2 is only
+// available on some x86-64 CPUs and is selected at run time.
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FIRESTORE_ORDERED_CODE_SSE2 1
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define FIRESTORE_ORDERED_CODE_NEON 1
+#endif
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define FIRESTORE_ORDERED_CODE_AVX2_DISPATCH 1
+#endif
+
 #if !defined(ABSL_IS_LITTLE_ENDIAN) && !defined(ABSL_IS_BIG_ENDIAN)
 #error \
     "Unsupported byte order: Either ABSL_IS_BIG_ENDIAN or " \
@@ -266,7 +283,12 @@ inline int AdvanceIfNoSpecialBytes(uint32_t v_32, const char* p) {
 // Return a pointer to the first byte in the range "[start..limit)"
 // whose value is 0 or 255 (kEscape1 or kEscape2).  If no such byte
 // exists in the range, returns "limit".
-inline const char* SkipToNextSpecialByte(const char* start, const char* limit) {
+//
+// This is the portable implementation, which scans 8 bytes at a time
+// using ordinary integer arithmetic. SkipToNextSpecialByte uses vector
+// instructions where available and falls back to this for the tail.
+inline const char* SkipToNextSpecialBytePortable(const char* start,
+                                                 const char* limit) {
   // If these constants were ever changed, this routine needs to change
   static_assert(kEscape1 == 0, "bit fiddling needs readjusting");
   static_assert((kEscape2 & 0xff) == 255, "bit fiddling needs readjusting");
@@ -321,12 +343,104 @@ inline const char* SkipToNextSpecialByte(const char* start, const char* limit) {
   return p;
 }
 
+// The vector implementations below use the same test as the portable one,
+// (x + 1) < 2, evaluated on every lane at once as min(x + 1, 1) == x + 1
+// (unsigned). Each returns a bit mask with one bit set per special byte in
+// the block, so the first special byte is at the lowest set bit.
+
+inline int LowestSetBit(uint32_t mask) {
+  return Bits::Log2FloorNonZero(mask & (0u - mask));
+}
+
+#if defined(FIRESTORE_ORDERED_CODE_AVX2_DISPATCH)
+// Scans whole 32-byte blocks only, returning either the first special byte or
+// the start of the final partial block.
+__attribute__((target("avx2"))) static const char* SkipToNextSpecialByteAvx2(
+    const char* start, const char* limit) {
+  const __m256i one = _mm256_set1_epi8(1);
+  const char* p = start;
+  while (p + 32 <= limit) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    __m256i t = _mm256_add_epi8(v, one);
+    __m256i special = _mm256_cmpeq_epi8(_mm256_min_epu8(t, one), t);
+    auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(special));
+    if (mask != 0) {
+      return p + LowestSetBit(mask);
+    }
+    p += 32;
+  }
+  return p;
+}
+
+// AVX2 is not part of the x86-64 baseline, so whether to use it is decided
+// once at run time.
+static bool CpuSupportsAvx2() {
+  static const bool supported = __builtin_cpu_supports("avx2");
+  return supported;
+}
+#endif  // FIRESTORE_ORDERED_CODE_AVX2_DISPATCH
+
+// Return a pointer to the first byte in the range "[start..limit)"
+// whose value is 0 or 255 (kEscape1 or kEscape2).  If no such byte
+// exists in the range, returns "limit".
+//
+// Blocks of 32 bytes are scanned with AVX2 when the CPU supports it, blocks
+// of 16 bytes with SSE2 or NEON (which are part of the baseline of every
+// 64-bit target that has them), and anything left over by
+// SkipToNextSpecialBytePortable.
+inline const char* SkipToNextSpecialByte(const char* start, const char* limit) {
+  const char* p = start;
+
+#if defined(FIRESTORE_ORDERED_CODE_AVX2_DISPATCH)
+  if (limit - p >= 32 && CpuSupportsAvx2()) {
+    p = SkipToNextSpecialByteAvx2(p, limit);
+    if (p < limit && IsSpecialByte(*p)) return p;
+  }
+#endif
+
+#if defined(FIRESTORE_ORDERED_CODE_SSE2)
+  const __m128i one = _mm_set1_epi8(1);
+  while (p + 16 <= limit) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i t = _mm_add_epi8(v, one);
+    __m128i special = _mm_cmpeq_epi8(_mm_min_epu8(t, one), t);
+    auto mask = static_cast<uint32_t>(_mm_movemask_epi8(special));
+    if (mask != 0) {
+      return p + LowestSetBit(mask);
+    }
+    p += 16;
+  }
+#elif defined(FIRESTORE_ORDERED_CODE_NEON)
+  const uint8x16_t one = vdupq_n_u8(1);
+  while (p + 16 <= limit) {
+    uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(p));
+    uint8x16_t special = vcleq_u8(vaddq_u8(v, one), one);
+    // Narrow each 0x00/0xff lane to 4 bits, giving a 64-bit mask with a
+    // nibble per byte.
+    uint64_t mask = vget_lane_u64(
+        vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(special), 4)),
+        0);
+    if (mask != 0) {
+      return p + Bits::Log2FloorNonZero64(mask & (0ull - mask)) / 4;
+    }
+    p += 16;
+  }
+#endif
+
+  return SkipToNextSpecialBytePortable(p, limit);
+}
+
 // Expose SkipToNextSpecialByte for testing purposes
 const char* OrderedCode::TEST_SkipToNextSpecialByte(const char* start,
                                                     const char* limit) {
   return SkipToNextSpecialByte(start, limit);
 }
 
+const char* OrderedCode::TEST_SkipToNextSpecialBytePortable(
+    const char* start, const char* limit) {
+  return SkipToNextSpecialBytePortable(start, limit);
+}
+
 // Helper routine to encode "s" and append to "*dest", escaping special
 // characters.  Invert the output iff INVERT is true.
 template <bool INVERT>
@@ -147,6 +147,14 @@ class OrderedCode {
   static const char* TEST_SkipToNextSpecialByte(const char* start,
                                                 const char* limit);
 
+  /**
+   * Helper for testing and benchmarking. Same as TEST_SkipToNextSpecialByte,
+   * but always uses the portable implementation rather than any vectorized
+   * one the platform supports.
+   */
+  static const char* TEST_SkipToNextSpecialBytePortable(const char* start,
+                                                        const char* limit);
+
   // Not an instantiable class, but the class exists to make it easy to
   // use with a single using statement.
   OrderedCode() = delete;
@@ -0,0 +1,186 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/util/tracing.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+namespace {
+
+using TimePoint = TraceEvent::TimePoint;
+
+int CurrentThreadId() {
+  static std::atomic<int> next_thread_id{1};
+  thread_local int thread_id =
+      next_thread_id.fetch_add(1, std::memory_order_relaxed);
+  return thread_id;
+}
+
+int64_t Micros(TimePoint time) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             time.time_since_epoch())
+      .count();
+}
+
+void AppendJsonString(std::string* out, absl::string_view value) {
+  out->push_back('"');
+  for (char c : value) {
+    switch (c) {
+      case '"':
+        out->append("\\\"");
+        break;
+      case '\\':
+        out->append("\\\\");
+        break;
+      case '\n':
+        out->append("\\n");
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          absl::StrAppendFormat(out, "\\u%04x", static_cast<int>(c));
+        } else {
+          out->push_back(c);
+        }
+    }
+  }
+  out->push_back('"');
+}
+
+}  // namespace
+
+Tracer& Tracer::GetInstance() {
+  static NoDestructor<Tracer> instance;
+  return *instance;
+}
+
+void Tracer::Enable(size_t capacity) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  events_.clear();
+  events_.shrink_to_fit();
+  capacity_ = std::max<size_t>(capacity, 1);
+  next_ = 0;
+  enabled_.store(true, std::memory_order_relaxed);
+}
+
+void Tracer::Disable() {
+  enabled_.store(false, std::memory_order_relaxed);
+}
+
+void Tracer::Record(TraceEvent event) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (capacity_ == 0) {
+    return;
+  }
+
+  if (events_.size() < capacity_) {
+    events_.push_back(std::move(event));
+  } else {
+    events_[next_] = std::move(event);
+  }
+  next_ = (next_ + 1) % capacity_;
+}
+
+std::vector<TraceEvent> Tracer::Events() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (events_.size() < capacity_) {
+    return events_;
+  }
+
+  // The buffer is full, so the oldest event is the one to be overwritten next.
+  std::vector<TraceEvent> result;
+  result.reserve(events_.size());
+  result.insert(result.end(), events_.begin() + next_, events_.end());
+  result.insert(result.end(), events_.begin(), events_.begin() + next_);
+  return result;
+}
+
+std::string Tracer::ExportChromeTrace() const {
+  std::string result = R"({"displayTimeUnit":"ms","traceEvents":[)";
+  bool first = true;
+  for (const TraceEvent& event : Events()) {
+    if (!first) {
+      result.push_back(',');
+    }
+    first = false;
+
+    result.append(R"({"ph":"X","pid":1,"name":)");
+    AppendJsonString(&result, event.name);
+    result.append(R"(,"cat":)");
+    AppendJsonString(&result, event.category);
+    absl::StrAppend(&result, R"(,"tid":)", event.thread_id,
+                    R"(,"ts":)", Micros(event.start),
+                    R"(,"dur":)", Micros(event.end) - Micros(event.start),
+                    R"(,"args":{"queued_us":)",
+                    Micros(event.start) - Micros(event.enqueued), "}}");
+  }
+  result.append("]}");
+  return result;
+}
+
+TraceSpan::TraceSpan(const char* category, absl::string_view name)
+    : TraceSpan(category, name, TimePoint{}) {
+}
+
+TraceSpan::TraceSpan(const char* category,
+                     absl::string_view name,
+                     TimePoint enqueued)
+    : enabled_(Tracer::GetInstance().enabled()) {
+  if (!enabled_) {
+    return;
+  }
+
+  event_.category = category;
+  event_.name = std::string(name);
+  event_.thread_id = CurrentThreadId();
+  event_.start = std::chrono::steady_clock::now();
+  event_.enqueued = enqueued == TimePoint{} ? event_.start : enqueued;
+}
+
+TraceSpan::~TraceSpan() {
+  if (!enabled_) {
+    return;
+  }
+
+  event_.end = std::chrono::steady_clock::now();
+  Tracer::GetInstance().Record(std::move(event_));
+}
+
+std::function<void()> TraceOperation(const char* category,
+                                     absl::string_view name,
+                                     std::function<void()>&& operation) {
+  if (!Tracer::GetInstance().enabled()) {
+    return std::move(operation);
+  }
+
+  TimePoint enqueued = std::chrono::steady_clock::now();
+  std::string label(name);
+  return [category, label, enqueued, operation] {
+    TraceSpan span(category, label, enqueued);
+    operation();
+  };
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
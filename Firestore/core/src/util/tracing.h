@@ -0,0 +1,155 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_UTIL_TRACING_H_
+#define FIRESTORE_CORE_SRC_UTIL_TRACING_H_
+
+#include <atomic>
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/util/no_destructor.h"
+#include "absl/strings/string_view.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+/** A span of time spent on one operation on one thread. */
+struct TraceEvent {
+  using TimePoint = std::chrono::steady_clock::time_point;
+
+  /** What kind of code recorded the span, e.g. "async_queue". */
+  const char* category = "";
+  std::string name;
+
+  /** A small number that identifies the thread the span ran on. */
+  int thread_id = 0;
+
+  /**
+   * When the operation was handed to its queue or executor. Equal to `start`
+   * for spans that weren't enqueued.
+   */
+  TimePoint enqueued;
+  TimePoint start;
+  TimePoint end;
+};
+
+/**
+ * Records `TraceEvent`s into a fixed-size ring buffer, shared by all Firestore
+ * instances in the process, and exports them in the Chrome trace event format
+ * understood by chrome://tracing and Perfetto.
+ *
+ * Tracing is disabled by default. While it is disabled, spans cost a single
+ * relaxed atomic load and record nothing.
+ */
+class Tracer final {
+ public:
+  static constexpr size_t kDefaultCapacity = 16 * 1024;
+
+  /** Returns the singleton instance of this class. */
+  static Tracer& GetInstance();
+
+  /**
+   * Starts recording events, keeping at most the `capacity` most recent ones.
+   * Discards any events recorded before.
+   */
+  void Enable(size_t capacity = kDefaultCapacity);
+
+  /** Stops recording events; the recorded events are kept for export. */
+  void Disable();
+
+  bool enabled() const {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  void Record(TraceEvent event);
+
+  /** Returns the recorded events, oldest first. */
+  std::vector<TraceEvent> Events() const;
+
+  /**
+   * Returns the recorded events as a JSON object in the Chrome trace event
+   * format. Spans are exported as complete ("X") events, with the time each
+   * operation spent waiting in its queue as the "queued_us" argument.
+   */
+  std::string ExportChromeTrace() const;
+
+ private:
+  Tracer() = default;
+
+  // Delete the destructor so that the singleton instance of this class can
+  // never be deleted.
+  ~Tracer() = delete;
+
+  Tracer(const Tracer&) = delete;
+  Tracer(Tracer&&) = delete;
+  Tracer& operator=(const Tracer&) = delete;
+  Tracer& operator=(Tracer&&) = delete;
+
+  friend class NoDestructor<Tracer>;
+
+  std::atomic<bool> enabled_{false};
+
+  mutable std::mutex mutex_;
+  std::vector<TraceEvent> events_;
+  size_t capacity_ = 0;
+  size_t next_ = 0;
+};
+
+/**
+ * Records the time between its construction and destruction as a
+ * `TraceEvent`, if tracing is enabled when it is constructed. Spans created
+ * while another span is open on the same thread are shown nested in it.
+ */
+class TraceSpan {
+ public:
+  TraceSpan(const char* category, absl::string_view name);
+
+  /** Creates a span for an operation that was enqueued at `enqueued`. */
+  TraceSpan(const char* category,
+            absl::string_view name,
+            std::chrono::steady_clock::time_point enqueued);
+
+  ~TraceSpan();
+
+  TraceSpan(const TraceSpan&) = delete;
+  TraceSpan& operator=(const TraceSpan&) = delete;
+
+ private:
+  bool enabled_ = false;
+  TraceEvent event_;
+};
+
+/**
+ * Returns `operation` decorated to record a span, including the time spent
+ * waiting to run, when it's run. If tracing is disabled, returns `operation`
+ * unchanged.
+ */
+std::function<void()> TraceOperation(const char* category,
+                                     absl::string_view name,
+                                     std::function<void()>&& operation);
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_UTIL_TRACING_H_
@@ -33,6 +33,7 @@ TEST(Settings, CopyConstructor) {
     settings.set_ssl_enabled(true);
     settings.set_persistence_enabled(true);
     settings.set_cache_size_bytes(100);
+    settings.set_compact_documents_enabled(true);
 
     Settings copy(settings);
 
@@ -40,6 +41,8 @@ TEST(Settings, CopyConstructor) {
     EXPECT_EQ(settings.ssl_enabled(), copy.ssl_enabled());
     EXPECT_EQ(settings.persistence_enabled(), copy.persistence_enabled());
     EXPECT_EQ(settings.cache_size_bytes(), copy.cache_size_bytes());
+    EXPECT_EQ(settings.compact_documents_enabled(),
+              copy.compact_documents_enabled());
     EXPECT_EQ(settings.local_cache_settings(), copy.local_cache_settings());
   }
   {
@@ -149,6 +152,15 @@ TEST(Settings, EqualityAndHash) {
     EXPECT_NE(settings1, settings2);
     EXPECT_NE(settings1.Hash(), settings2.Hash());
   }
+  {
+    Settings settings1;
+    Settings settings2;
+    settings2.set_compact_documents_enabled(true);
+
+    EXPECT_FALSE(settings1.compact_documents_enabled());
+    EXPECT_NE(settings1, settings2);
+    EXPECT_NE(settings1.Hash(), settings2.Hash());
+  }
   {
     Settings settings1;
     settings1.set_host("host");
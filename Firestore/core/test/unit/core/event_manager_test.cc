@@ -16,18 +16,24 @@
 
 #include "Firestore/core/src/core/event_manager.h"
 
+#include <chrono>  // NOLINT(build/c++11)
 #include <memory>
 #include <utility>
 #include <vector>
 
 #include "Firestore/core/src/core/query_listener.h"
 #include "Firestore/core/src/core/sync_engine.h"
+#include "Firestore/core/src/core/view.h"
 #include "Firestore/core/src/core/view_snapshot.h"
 #include "Firestore/core/src/model/document_key_set.h"
 #include "Firestore/core/src/model/document_set.h"
 #include "Firestore/core/src/model/types.h"
+#include "Firestore/core/src/util/async_queue.h"
+#include "Firestore/core/src/util/empty.h"
 #include "Firestore/core/src/util/statusor.h"
+#include "Firestore/core/test/unit/testutil/async_testing.h"
 #include "Firestore/core/test/unit/testutil/testutil.h"
+#include "Firestore/core/test/unit/testutil/view_testing.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
@@ -42,9 +48,15 @@ using model::OnlineState;
 using testing::_;
 using testing::ElementsAre;
 using testing::StrictMock;
+using testutil::ApplyChanges;
+using testutil::Doc;
+using testutil::Map;
 using testutil::Query;
+using util::AsyncQueue;
+using util::Empty;
 using util::StatusOr;
 using util::StatusOrCallback;
+using util::TimerId;
 
 ViewSnapshotListener NoopViewSnapshotHandler() {
   return EventListener<ViewSnapshot>::Create(
@@ -205,6 +217,81 @@ TEST(EventManagerTest, WillForwardOnlineStateChanges) {
               ElementsAre(OnlineState::Unknown, OnlineState::Online));
 }
 
+TEST(EventManagerTest, RaisesSnapshotsInSyncAfterDelayedSnapshots) {
+  std::shared_ptr<AsyncQueue> queue = testutil::AsyncQueueForTesting();
+  core::Query rooms = Query("rooms");
+  core::Query users = Query("users");
+
+  std::vector<ViewSnapshot> room_events;
+  ListenOptions options =
+      ListenOptions::FromIncludeMetadataChanges(true).WithMinSnapshotInterval(
+          std::chrono::hours(1));
+  auto rooms_listener = QueryListener::Create(
+      rooms, options,
+      EventListener<ViewSnapshot>::Create(
+          [&](const StatusOr<ViewSnapshot>& maybe_snapshot) {
+            room_events.push_back(maybe_snapshot.ValueOrDie());
+          }),
+      queue);
+  auto users_listener = NoopQueryListener(users);
+
+  int in_sync_events = 0;
+  auto in_sync_listener = EventListener<Empty>::Create(
+      [&](const StatusOr<Empty>&) { ++in_sync_events; });
+
+  View rooms_view(rooms, model::DocumentKeySet{});
+  View users_view(users, model::DocumentKeySet{});
+  ViewSnapshot rooms1 =
+      ApplyChanges(&rooms_view, {Doc("rooms/a", 1, Map("n", 1))}, absl::nullopt)
+          .value();
+  ViewSnapshot rooms2 =
+      ApplyChanges(&rooms_view, {Doc("rooms/b", 2, Map("n", 2))}, absl::nullopt)
+          .value();
+  ViewSnapshot rooms3 =
+      ApplyChanges(&rooms_view, {Doc("rooms/c", 3, Map("n", 3))}, absl::nullopt)
+          .value();
+  ViewSnapshot users1 =
+      ApplyChanges(&users_view, {Doc("users/a", 1, Map("n", 1))}, absl::nullopt)
+          .value();
+  ViewSnapshot users2 =
+      ApplyChanges(&users_view, {Doc("users/b", 2, Map("n", 2))}, absl::nullopt)
+          .value();
+
+  MockEventSource mock_event_source;
+  EventManager event_manager(&mock_event_source);
+  queue->EnqueueBlocking([&] {
+    event_manager.AddSnapshotsInSyncListener(in_sync_listener);
+    event_manager.AddQueryListener(rooms_listener);
+    event_manager.AddQueryListener(users_listener);
+    EXPECT_EQ(in_sync_events, 1);
+
+    event_manager.OnViewSnapshots({rooms1, users1});
+    EXPECT_EQ(in_sync_events, 2);
+
+    // The rooms listener holds back its snapshot, so the listeners aren't in
+    // sync until it's raised.
+    event_manager.OnViewSnapshots({rooms2, users2});
+    EXPECT_EQ(room_events.size(), 1u);
+    EXPECT_EQ(in_sync_events, 2);
+  });
+
+  queue->RunScheduledOperationsUntil(TimerId::ListenerSnapshotDelay);
+  queue->EnqueueBlocking([&] {
+    EXPECT_EQ(room_events.size(), 2u);
+    EXPECT_EQ(in_sync_events, 3);
+
+    // A held snapshot that is the only change raises the event on its own.
+    event_manager.OnViewSnapshots({rooms3});
+    EXPECT_EQ(in_sync_events, 3);
+  });
+
+  queue->RunScheduledOperationsUntil(TimerId::ListenerSnapshotDelay);
+  queue->EnqueueBlocking([&] {
+    EXPECT_EQ(room_events.size(), 3u);
+    EXPECT_EQ(in_sync_events, 4);
+  });
+}
+
 }  // namespace
 }  // namespace core
 }  // namespace firestore
@@ -16,6 +16,7 @@
 
 #include "Firestore/core/src/core/query_listener.h"
 
+#include <chrono>  // NOLINT(build/c++11)
 #include <future>  // NOLINT(build/c++11)
 #include <memory>
 #include <utility>
@@ -29,6 +30,7 @@
 #include "Firestore/core/src/model/document_set.h"
 #include "Firestore/core/src/model/types.h"
 #include "Firestore/core/src/remote/remote_event.h"
+#include "Firestore/core/src/util/async_queue.h"
 #include "Firestore/core/src/util/delayed_constructor.h"
 #include "Firestore/core/src/util/executor.h"
 #include "Firestore/core/src/util/status.h"
@@ -48,15 +50,18 @@ using model::DocumentSet;
 using model::MutableDocument;
 using model::OnlineState;
 using remote::TargetChange;
+using util::AsyncQueue;
 using util::DelayedConstructor;
 using util::Executor;
 using util::Status;
 using util::StatusOr;
+using util::TimerId;
 
 using testing::ElementsAre;
 using testing::IsEmpty;
 using testutil::AckTarget;
 using testutil::ApplyChanges;
+using testutil::DeletedDoc;
 using testutil::Doc;
 using testutil::Expectation;
 using testutil::Map;
@@ -518,6 +523,105 @@ TEST_F(QueryListenerTest,
   ASSERT_THAT(events, ElementsAre(expected_snap));
 }
 
+TEST_F(QueryListenerTest, CoalescesSnapshotsWithinMinSnapshotInterval) {
+  std::vector<ViewSnapshot> accum;
+  std::shared_ptr<AsyncQueue> queue = testutil::AsyncQueueForTesting();
+
+  Query query = testutil::Query("rooms");
+  MutableDocument doc1 = Doc("rooms/Eros", 1, Map("name", "Eros"));
+  MutableDocument doc2 = Doc("rooms/Hades", 2, Map("name", "Hades"));
+  MutableDocument doc2prime =
+      Doc("rooms/Hades", 3, Map("name", "Hades", "owner", "Jonny"));
+  MutableDocument doc3 = Doc("rooms/Other", 3, Map("name", "Other"));
+
+  ListenOptions options = include_metadata_changes_.WithMinSnapshotInterval(
+      std::chrono::hours(1));
+  auto listener =
+      QueryListener::Create(query, options, Accumulating(&accum), queue);
+
+  View view(query, DocumentKeySet{});
+  ViewSnapshot snap1 = ApplyChanges(&view, {doc1, doc2}, absl::nullopt).value();
+  ViewSnapshot snap2 = ApplyChanges(&view, {doc2prime}, absl::nullopt).value();
+  ViewSnapshot snap3 = ApplyChanges(&view, {doc3}, absl::nullopt).value();
+
+  queue->EnqueueBlocking([&] {
+    EXPECT_TRUE(listener->OnViewSnapshot(snap1));
+    EXPECT_FALSE(listener->OnViewSnapshot(snap2));
+    EXPECT_FALSE(listener->OnViewSnapshot(snap3));
+  });
+  ASSERT_THAT(accum, ElementsAre(snap1));
+  ASSERT_TRUE(queue->IsScheduled(TimerId::ListenerSnapshotDelay));
+
+  queue->RunScheduledOperationsUntil(TimerId::ListenerSnapshotDelay);
+
+  DocumentViewChange added{doc3, DocumentViewChange::Type::Added};
+  DocumentViewChange modified{doc2prime, DocumentViewChange::Type::Modified};
+  ViewSnapshot expected_snap{snap3.query(),
+                             snap3.documents(),
+                             /*old_documents=*/snap1.documents(),
+                             /*document_changes=*/{added, modified},
+                             snap3.mutated_keys(),
+                             snap3.from_cache(),
+                             /*sync_state_changed=*/false,
+                             /*excludes_metadata_changes=*/false,
+                             snap3.has_cached_results()};
+  ASSERT_THAT(accum, ElementsAre(snap1, expected_snap));
+}
+
+TEST_F(QueryListenerTest, DropsCoalescedSnapshotWhenChangesCancelOut) {
+  std::vector<ViewSnapshot> accum;
+  std::shared_ptr<AsyncQueue> queue = testutil::AsyncQueueForTesting();
+
+  Query query = testutil::Query("rooms");
+  MutableDocument doc1 = Doc("rooms/Eros", 1, Map("name", "Eros"));
+  MutableDocument doc2 = Doc("rooms/Hades", 2, Map("name", "Hades"));
+
+  ListenOptions options = include_metadata_changes_.WithMinSnapshotInterval(
+      std::chrono::hours(1));
+  auto listener =
+      QueryListener::Create(query, options, Accumulating(&accum), queue);
+
+  View view(query, DocumentKeySet{});
+  ViewSnapshot snap1 = ApplyChanges(&view, {doc1}, absl::nullopt).value();
+  ViewSnapshot snap2 = ApplyChanges(&view, {doc2}, absl::nullopt).value();
+  ViewSnapshot snap3 =
+      ApplyChanges(&view, {DeletedDoc("rooms/Hades", 3)}, absl::nullopt)
+          .value();
+
+  queue->EnqueueBlocking([&] {
+    listener->OnViewSnapshot(snap1);
+    listener->OnViewSnapshot(snap2);
+    listener->OnViewSnapshot(snap3);
+  });
+  queue->RunScheduledOperationsUntil(TimerId::ListenerSnapshotDelay);
+
+  ASSERT_THAT(accum, ElementsAre(snap1));
+}
+
+TEST_F(QueryListenerTest, RaisesEverySnapshotWithoutMinSnapshotInterval) {
+  std::vector<ViewSnapshot> accum;
+  std::shared_ptr<AsyncQueue> queue = testutil::AsyncQueueForTesting();
+
+  Query query = testutil::Query("rooms");
+  MutableDocument doc1 = Doc("rooms/Eros", 1, Map("name", "Eros"));
+  MutableDocument doc2 = Doc("rooms/Hades", 2, Map("name", "Hades"));
+
+  auto listener = QueryListener::Create(query, include_metadata_changes_,
+                                        Accumulating(&accum), queue);
+
+  View view(query, DocumentKeySet{});
+  ViewSnapshot snap1 = ApplyChanges(&view, {doc1}, absl::nullopt).value();
+  ViewSnapshot snap2 = ApplyChanges(&view, {doc2}, absl::nullopt).value();
+
+  queue->EnqueueBlocking([&] {
+    listener->OnViewSnapshot(snap1);
+    listener->OnViewSnapshot(snap2);
+  });
+
+  ASSERT_FALSE(queue->IsScheduled(TimerId::ListenerSnapshotDelay));
+  ASSERT_THAT(accum, ElementsAre(snap1, snap2));
+}
+
 }  // namespace core
 }  // namespace firestore
 }  // namespace firebase
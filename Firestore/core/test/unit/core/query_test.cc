@@ -1039,6 +1039,39 @@ TEST(QueryTest, MatchesAllDocuments) {
   EXPECT_FALSE(query.MatchesAllDocuments());
 }
 
+TEST(QueryTest, Subsumes) {
+  auto base_query = testutil::Query("coll");
+  auto filtered = base_query.AddingFilter(testutil::Filter("a", "==", 1));
+  auto refined = filtered.AddingFilter(testutil::Filter("b", ">", 2))
+                     .AddingOrderBy(testutil::OrderBy("b", "desc"))
+                     .WithLimitToFirst(10);
+
+  EXPECT_TRUE(base_query.Subsumes(filtered));
+  EXPECT_TRUE(base_query.Subsumes(refined));
+  EXPECT_TRUE(filtered.Subsumes(refined));
+  EXPECT_TRUE(filtered.Subsumes(filtered));
+  EXPECT_FALSE(refined.Subsumes(filtered));
+  EXPECT_FALSE(filtered.Subsumes(base_query));
+
+  // Queries with a limit or bounds don't contain all matching documents.
+  EXPECT_FALSE(base_query.WithLimitToFirst(10).Subsumes(refined));
+  EXPECT_FALSE(base_query.StartingAt(Bound::FromValue(Array(1), true))
+                   .Subsumes(refined));
+
+  // Different collections.
+  EXPECT_FALSE(base_query.Subsumes(testutil::Query("other")));
+  EXPECT_FALSE(CollectionGroupQuery("coll").Subsumes(filtered));
+
+  // Ordering by a field excludes documents without that field.
+  auto ordered = base_query.AddingOrderBy(testutil::OrderBy("a"));
+  EXPECT_FALSE(ordered.Subsumes(filtered));
+  EXPECT_TRUE(ordered.Subsumes(
+      base_query.AddingFilter(testutil::Filter("a", ">", 1))));
+  EXPECT_TRUE(
+      base_query.AddingOrderBy(testutil::OrderBy("__name__")).Subsumes(
+          filtered));
+}
+
 TEST(QueryTest, OrderByForAggregateAndNonAggregate) {
   auto col = testutil::Query("coll");
 
@@ -0,0 +1,136 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/core/query.h"
+#include "Firestore/core/src/core/view.h"
+#include "Firestore/core/src/model/document.h"
+#include "Firestore/core/src/model/document_key_set.h"
+#include "Firestore/core/src/model/mutable_document.h"
+#include "Firestore/core/src/model/object_value.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+namespace {
+
+using model::DocumentKeySet;
+using model::DocumentMap;
+using model::MutableDocument;
+using model::ObjectValue;
+
+/**
+ * Creates a document with `num_fields` string fields, with `revision` mixed
+ * into the value of the last field.
+ */
+MutableDocument LargeDoc(int index, int num_fields, int revision) {
+  ObjectValue data;
+  for (int i = 0; i < num_fields; ++i) {
+    std::string value = absl::StrCat("value-", index, "-", i);
+    if (i == num_fields - 1) absl::StrAppend(&value, "-", revision);
+    data.Set(testutil::Field(absl::StrCat("field", i)), testutil::Value(value));
+  }
+  return MutableDocument::FoundDocument(
+      testutil::Key(absl::StrCat("coll/doc", index)),
+      testutil::Version(revision), std::move(data));
+}
+
+DocumentMap LargeDocs(int num_docs, int num_fields, int revision) {
+  DocumentMap docs;
+  for (int i = 0; i < num_docs; ++i) {
+    model::Document doc = LargeDoc(i, num_fields, revision);
+    docs = docs.insert(doc->key(), doc);
+  }
+  return docs;
+}
+
+std::vector<std::unique_ptr<View>> MakeViews(int num_views,
+                                             const DocumentMap& docs) {
+  std::vector<std::unique_ptr<View>> views;
+  for (int i = 0; i < num_views; ++i) {
+    auto view =
+        absl::make_unique<View>(testutil::Query("coll"), DocumentKeySet{});
+    view->ApplyChanges(view->ComputeDocumentChanges(docs));
+    views.push_back(std::move(view));
+  }
+  return views;
+}
+
+/**
+ * Delivers a snapshot whose documents are decoded anew but unchanged to many
+ * views, as happens when several listeners share a collection and Watch
+ * resends documents (e.g. after a resume or an existence filter mismatch).
+ */
+void BM_ViewUnchangedSnapshot(benchmark::State& state) {
+  int num_views = static_cast<int>(state.range(0));
+  int num_docs = static_cast<int>(state.range(1));
+  int num_fields = static_cast<int>(state.range(2));
+
+  auto views = MakeViews(num_views, LargeDocs(num_docs, num_fields, 1));
+  DocumentMap snapshot = LargeDocs(num_docs, num_fields, 1);
+
+  for (auto _ : state) {
+    for (const auto& view : views) {
+      ViewDocumentChanges changes = view->ComputeDocumentChanges(snapshot);
+      benchmark::DoNotOptimize(changes);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * num_views * num_docs);
+}
+BENCHMARK(BM_ViewUnchangedSnapshot)
+    ->Args({1, 1000, 50})
+    ->Args({10, 1000, 50})
+    ->Args({50, 1000, 50})
+    ->Args({10, 100, 500});
+
+/**
+ * Delivers a snapshot in which every document changed in its last field to
+ * many views.
+ */
+void BM_ViewModifiedSnapshot(benchmark::State& state) {
+  int num_views = static_cast<int>(state.range(0));
+  int num_docs = static_cast<int>(state.range(1));
+  int num_fields = static_cast<int>(state.range(2));
+
+  auto views = MakeViews(num_views, LargeDocs(num_docs, num_fields, 1));
+  DocumentMap snapshot = LargeDocs(num_docs, num_fields, 2);
+
+  for (auto _ : state) {
+    for (const auto& view : views) {
+      ViewDocumentChanges changes = view->ComputeDocumentChanges(snapshot);
+      benchmark::DoNotOptimize(changes);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * num_views * num_docs);
+}
+BENCHMARK(BM_ViewModifiedSnapshot)
+    ->Args({1, 1000, 50})
+    ->Args({10, 1000, 50})
+    ->Args({50, 1000, 50})
+    ->Args({10, 100, 500});
+
+}  // namespace
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
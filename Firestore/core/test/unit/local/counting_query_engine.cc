@@ -155,6 +155,12 @@ void WrappedRemoteDocumentCache::Add(const model::MutableDocument& document,
   subject_->Add(document, read_time);
 }
 
+void WrappedRemoteDocumentCache::AddAll(
+    const std::vector<model::MutableDocument>& documents,
+    const model::SnapshotVersion& read_time) {
+  subject_->AddAll(documents, read_time);
+}
+
 void WrappedRemoteDocumentCache::Remove(const model::DocumentKey& key) {
   subject_->Remove(key);
 }
@@ -185,6 +185,9 @@ class WrappedRemoteDocumentCache : public RemoteDocumentCache {
   void Add(const model::MutableDocument& document,
            const model::SnapshotVersion& read_time) override;
 
+  void AddAll(const std::vector<model::MutableDocument>& documents,
+              const model::SnapshotVersion& read_time) override;
+
   void Remove(const model::DocumentKey& key) override;
 
   model::MutableDocument Get(const model::DocumentKey& key) const override;
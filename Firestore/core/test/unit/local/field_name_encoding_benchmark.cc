@@ -0,0 +1,230 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Firestore/Protos/nanopb/firestore/local/maybe_document.nanopb.h"
+#include "Firestore/core/src/core/query.h"
+#include "Firestore/core/src/credentials/user.h"
+#include "Firestore/core/src/local/leveldb_key.h"
+#include "Firestore/core/src/local/leveldb_persistence.h"
+#include "Firestore/core/src/local/leveldb_remote_document_cache.h"
+#include "Firestore/core/src/local/leveldb_transaction.h"
+#include "Firestore/core/src/local/local_serializer.h"
+#include "Firestore/core/src/model/field_index.h"
+#include "Firestore/core/src/model/field_path.h"
+#include "Firestore/core/src/model/mutable_document.h"
+#include "Firestore/core/src/model/object_value.h"
+#include "Firestore/core/src/nanopb/message.h"
+#include "Firestore/core/src/nanopb/reader.h"
+#include "Firestore/core/src/util/read_context.h"
+#include "Firestore/core/test/unit/local/persistence_testing.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+namespace {
+
+using model::FieldPath;
+using model::IndexOffset;
+using model::MutableDocument;
+using model::ObjectValue;
+using nanopb::Message;
+using nanopb::StringReader;
+
+// Benchmarks compare the full MaybeDocument format, which repeats every field
+// name in every row, with the compact format, which refers to field names by
+// per-collection IDs.
+enum Format { kFull = 0, kCompact = 1 };
+
+/**
+ * Creates a document with `num_fields` top-level fields plus a nested map, with
+ * field names as long as those of a typical application schema. All documents
+ * share the same schema.
+ */
+MutableDocument MakeDocument(int index, int num_fields) {
+  ObjectValue value;
+  for (int i = 0; i < num_fields; ++i) {
+    std::string field = absl::StrCat("customer_attribute_", i);
+    if (i % 3 == 0) {
+      value.Set(FieldPath::FromDotSeparatedString(field),
+                testutil::Value(absl::StrCat("value", index + i)));
+    } else if (i % 3 == 1) {
+      value.Set(FieldPath::FromDotSeparatedString(field),
+                testutil::Value(index * 31 + i));
+    } else {
+      value.Set(FieldPath::FromDotSeparatedString(field),
+                testutil::Value(i % 2 == 0));
+    }
+  }
+  value.Set(FieldPath::FromDotSeparatedString("shipping_address.street_name"),
+            testutil::Value("1600 Amphitheatre Parkway"));
+  value.Set(FieldPath::FromDotSeparatedString("shipping_address.postal_code"),
+            testutil::Value("94043"));
+
+  return MutableDocument::FoundDocument(
+      testutil::Key(absl::StrCat("coll/doc", index)), testutil::Version(1),
+      std::move(value));
+}
+
+/** Interns field names like a single collection's dictionary would. */
+class Dictionary {
+ public:
+  LocalSerializer::FieldNameInterner Interner() {
+    return [this](absl::string_view field_name) {
+      for (size_t i = 0; i < names_.size(); ++i) {
+        if (names_[i] == field_name) {
+          return absl::optional<int64_t>(i);
+        }
+      }
+      names_.emplace_back(field_name);
+      return absl::optional<int64_t>(names_.size() - 1);
+    };
+  }
+
+  const std::vector<std::string>& names() const {
+    return names_;
+  }
+
+ private:
+  std::vector<std::string> names_;
+};
+
+std::string Encode(const LocalSerializer& serializer,
+                   Format format,
+                   const MutableDocument& document,
+                   Dictionary* dictionary) {
+  if (format == kFull) {
+    return nanopb::MakeStdString(serializer.EncodeMaybeDocument(document));
+  }
+  return serializer.EncodeCompactMaybeDocument(document,
+                                               dictionary->Interner());
+}
+
+void BM_EncodeDocument(benchmark::State& state) {
+  auto format = static_cast<Format>(state.range(0));
+  int num_fields = static_cast<int>(state.range(1));
+
+  LocalSerializer serializer = MakeLocalSerializer();
+  Dictionary dictionary;
+  MutableDocument document = MakeDocument(1, num_fields);
+
+  size_t document_bytes = 0;
+  for (auto _ : state) {
+    std::string encoded = Encode(serializer, format, document, &dictionary);
+    document_bytes = encoded.size();
+    benchmark::DoNotOptimize(encoded);
+  }
+  state.counters["document_bytes"] = static_cast<double>(document_bytes);
+  state.SetItemsProcessed(state.iterations());
+}
+
+void BM_DecodeDocument(benchmark::State& state) {
+  auto format = static_cast<Format>(state.range(0));
+  int num_fields = static_cast<int>(state.range(1));
+
+  LocalSerializer serializer = MakeLocalSerializer();
+  Dictionary dictionary;
+  std::string encoded = Encode(serializer, format,
+                               MakeDocument(1, num_fields), &dictionary);
+
+  for (auto _ : state) {
+    if (format == kFull) {
+      StringReader reader{encoded};
+      auto message = Message<firestore_client_MaybeDocument>::TryParse(&reader);
+      benchmark::DoNotOptimize(
+          serializer.DecodeMaybeDocument(&reader, *message));
+    } else {
+      util::ReadContext context;
+      benchmark::DoNotOptimize(serializer.DecodeCompactMaybeDocument(
+          &context, encoded, dictionary.names()));
+    }
+  }
+  state.counters["document_bytes"] = static_cast<double>(encoded.size());
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * encoded.size());
+}
+
+void DocumentSizes(benchmark::internal::Benchmark* benchmark) {
+  for (int num_fields : {10, 50, 100}) {
+    benchmark->Args({kFull, num_fields});
+    benchmark->Args({kCompact, num_fields});
+  }
+}
+BENCHMARK(BM_EncodeDocument)->Apply(DocumentSizes);
+BENCHMARK(BM_DecodeDocument)->Apply(DocumentSizes);
+
+/**
+ * Fills the remote document cache with `num_docs` documents of `num_fields`
+ * fields in the given format, and then measures a scan of the whole collection
+ * through `GetDocumentsMatchingQuery`, which decodes either format. The
+ * `table_bytes` counter is the size of all remote document rows.
+ */
+void BM_ScanCollection(benchmark::State& state) {
+  auto format = static_cast<Format>(state.range(0));
+  int num_docs = static_cast<int>(state.range(1));
+  int num_fields = static_cast<int>(state.range(2));
+
+  std::unique_ptr<LevelDbPersistence> persistence =
+      LevelDbPersistenceForTesting();
+  LevelDbRemoteDocumentCache* cache = persistence->remote_document_cache();
+  cache->SetIndexManager(
+      persistence->GetIndexManager(credentials::User::Unauthenticated()));
+  cache->SetCompactDocumentsEnabled(format == kCompact);
+
+  size_t table_bytes = 0;
+  persistence->Run("PopulateCache", [&] {
+    LevelDbTransaction* transaction = persistence->current_transaction();
+    for (int i = 0; i < num_docs; ++i) {
+      cache->Add(MakeDocument(i, num_fields), testutil::Version(1));
+    }
+
+    std::string prefix = LevelDbRemoteDocumentKey::KeyPrefix();
+    auto it = transaction->NewIterator();
+    for (it->Seek(prefix); it->Valid() && absl::StartsWith(it->key(), prefix);
+         it->Next()) {
+      table_bytes += it->key().size() + it->value().size();
+    }
+  });
+
+  core::Query query = testutil::Query("coll");
+  for (auto _ : state) {
+    persistence->Run("Scan", [&] {
+      benchmark::DoNotOptimize(
+          cache->GetDocumentsMatchingQuery(query, IndexOffset::None()));
+    });
+  }
+  state.counters["table_bytes"] = static_cast<double>(table_bytes);
+  state.SetItemsProcessed(state.iterations() * num_docs);
+}
+BENCHMARK(BM_ScanCollection)
+    ->Args({kFull, 10000, 60})
+    ->Args({kCompact, 10000, 60})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
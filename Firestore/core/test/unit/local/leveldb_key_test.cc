@@ -50,6 +50,13 @@ std::string DocMutationKey(absl::string_view user_id,
   return LevelDbDocumentMutationKey::Key(user_id, testutil::Key(key), batch_id);
 }
 
+std::string CollectionMutationKey(absl::string_view user_id,
+                                  absl::string_view key,
+                                  BatchId batch_id) {
+  return LevelDbCollectionMutationKey::Key(user_id, testutil::Key(key),
+                                           batch_id);
+}
+
 std::string TargetDocKey(TargetId target_id, absl::string_view key) {
   return LevelDbTargetDocumentKey::Key(target_id, testutil::Key(key));
 }
@@ -72,6 +79,32 @@ std::string RemoteDocumentReadTimeKey(absl::string_view collection_path,
       document_id);
 }
 
+std::string CollectionPathIdKey(absl::string_view collection_path,
+                                int64_t collection_path_id) {
+  return LevelDbCollectionPathIdKey::Key(testutil::Resource(collection_path),
+                                         collection_path_id);
+}
+
+std::string CompactReadTimeKeyPrefix(int64_t collection_path_id,
+                                     int64_t version) {
+  return LevelDbRemoteDocumentCompactReadTimeKey::KeyPrefix(
+      collection_path_id, testutil::Version(version));
+}
+
+std::string CompactReadTimeKey(int64_t collection_path_id,
+                               int64_t version,
+                               absl::string_view document_id) {
+  return LevelDbRemoteDocumentCompactReadTimeKey::Key(
+      collection_path_id, testutil::Version(version), document_id);
+}
+
+std::string FieldNameIdKey(int64_t collection_path_id,
+                           int64_t field_name_id,
+                           absl::string_view field_name) {
+  return LevelDbFieldNameIdKey::Key(collection_path_id, field_name_id,
+                                    field_name);
+}
+
 }  // namespace
 
 /**
@@ -226,6 +259,65 @@ TEST(LevelDbDocumentMutationKeyTest, Description) {
       "[document_mutation: user_id=user1 path=foo/bar batch_id=42]", key);
 }
 
+TEST(LevelDbCollectionMutationKeyTest, EncodeDecodeCycle) {
+  LevelDbCollectionMutationKey key;
+  std::string user("foo");
+
+  std::vector<DocumentKey> document_keys{testutil::Key("a/b"),
+                                         testutil::Key("a/b/c/d")};
+
+  std::vector<BatchId> batch_ids{0, 1, 100, INT_MAX - 1, INT_MAX};
+
+  for (BatchId batch_id : batch_ids) {
+    for (auto&& document_key : document_keys) {
+      auto encoded =
+          LevelDbCollectionMutationKey::Key(user, document_key, batch_id);
+
+      bool ok = key.Decode(encoded);
+      ASSERT_TRUE(ok);
+      ASSERT_EQ(user, key.user_id());
+      ASSERT_EQ(document_key.path().PopLast(), key.collection_path());
+      ASSERT_EQ(batch_id, key.batch_id());
+      ASSERT_EQ(document_key.path().last_segment(), key.document_id());
+    }
+  }
+}
+
+TEST(LevelDbCollectionMutationKeyTest, Ordering) {
+  // Different user:
+  ASSERT_LT(CollectionMutationKey("1", "foo/bar", 0),
+            CollectionMutationKey("2", "foo/bar", 0));
+
+  // Different batch_id:
+  ASSERT_LT(CollectionMutationKey("1", "foo/baz", 0),
+            CollectionMutationKey("1", "foo/bar", 1));
+
+  // Different document IDs:
+  ASSERT_LT(CollectionMutationKey("1", "foo/bar", 0),
+            CollectionMutationKey("1", "foo/baz", 0));
+
+  // Immediate children sort before documents in subcollections:
+  ASSERT_LT(CollectionMutationKey("1", "foo/bar", 100),
+            CollectionMutationKey("1", "foo/bar/suffix/key", 0));
+  ASSERT_LT(CollectionMutationKey("1", "foo/bar/suffix/key", 0),
+            CollectionMutationKey("1", "foo2/bar", 0));
+}
+
+TEST(LevelDbCollectionMutationKeyTest, Description) {
+  AssertExpectedKeyDescription("[collection_mutation: incomplete key]",
+                               LevelDbCollectionMutationKey::KeyPrefix());
+
+  AssertExpectedKeyDescription(
+      "[collection_mutation: user_id=user1 path=foo incomplete key]",
+      LevelDbCollectionMutationKey::KeyPrefix("user1",
+                                              testutil::Resource("foo")));
+
+  AssertExpectedKeyDescription(
+      "[collection_mutation: user_id=user1 path=foo batch_id=42 "
+      "document_id=bar]",
+      CollectionMutationKey("user1", "foo/bar", 42));
+}
+
 TEST(LevelDbTargetGlobalKeyTest, EncodeDecodeCycle) {
   LevelDbTargetGlobalKey key;
 
@@ -427,6 +519,126 @@ TEST(RemoteDocumentReadTimeKeyTest, Description) {
       RemoteDocumentReadTimeKey("coll", 1000001, "doc"));
 }
 
+TEST(CollectionPathIdKeyTest, PrefixFindsExactPath) {
+  // The ID of a path sorts before the IDs of its subcollections, so seeking to
+  // the prefix of a path lands on the path's own entry.
+  std::string prefix =
+      LevelDbCollectionPathIdKey::KeyPrefix(testutil::Resource("foo"));
+  ASSERT_TRUE(absl::StartsWith(CollectionPathIdKey("foo", 7), prefix));
+  ASSERT_LT(CollectionPathIdKey("foo", 7),
+            CollectionPathIdKey("foo/doc/bar", 1));
+  ASSERT_LT(prefix, CollectionPathIdKey("foo", 1));
+}
+
+TEST(CollectionPathIdKeyTest, EncodeDecodeCycle) {
+  LevelDbCollectionPathIdKey key;
+
+  std::vector<std::string> collection_paths{"foo", "foo/doc/bar",
+                                            "foo/doc/bar/doc/baz"};
+  std::vector<int64_t> ids{1, 1000, 1LL << 40};
+
+  for (const auto& collection_path : collection_paths) {
+    for (auto id : ids) {
+      auto encoded = CollectionPathIdKey(collection_path, id);
+      bool ok = key.Decode(encoded);
+      ASSERT_TRUE(ok);
+      ASSERT_EQ(testutil::Resource(collection_path), key.collection_path());
+      ASSERT_EQ(id, key.collection_path_id());
+    }
+  }
+}
+
+TEST(CollectionPathIdKeyTest, Description) {
+  AssertExpectedKeyDescription(
+      "[collection_path_id: path=foo/doc/bar collection_path_id=3]",
+      CollectionPathIdKey("foo/doc/bar", 3));
+}
+
+TEST(RemoteDocumentCompactReadTimeKeyTest, Ordering) {
+  // Different collection path IDs:
+  ASSERT_LT(CompactReadTimeKeyPrefix(1, 2), CompactReadTimeKeyPrefix(2, 1));
+
+  // Different read times:
+  ASSERT_LT(CompactReadTimeKeyPrefix(1, 1), CompactReadTimeKeyPrefix(1, 2));
+  ASSERT_LT(CompactReadTimeKeyPrefix(1, 1),
+            CompactReadTimeKeyPrefix(1, 1000000));
+  ASSERT_LT(CompactReadTimeKeyPrefix(1, 1000000),
+            CompactReadTimeKeyPrefix(1, 1000001));
+
+  // Different document ids:
+  ASSERT_LT(CompactReadTimeKey(1, 1, "a"), CompactReadTimeKey(1, 1, "b"));
+}
+
+TEST(RemoteDocumentCompactReadTimeKeyTest, IsSmallerThanLegacyKey) {
+  std::string path = "tenants/x/projects/y/items";
+  ASSERT_LT(CompactReadTimeKey(1, 1000001, "doc").size(),
+            RemoteDocumentReadTimeKey(path, 1000001, "doc").size());
+}
+
+TEST(RemoteDocumentCompactReadTimeKeyTest, EncodeDecodeCycle) {
+  LevelDbRemoteDocumentCompactReadTimeKey key;
+
+  std::vector<int64_t> ids{1, 1000, 1LL << 40};
+  std::vector<int64_t> versions{1, 1000000, 1000001};
+  std::vector<std::string> document_ids{"docA", "docB"};
+
+  for (auto id : ids) {
+    for (auto version : versions) {
+      for (const auto& document_id : document_ids) {
+        auto encoded = CompactReadTimeKey(id, version, document_id);
+        bool ok = key.Decode(encoded);
+        ASSERT_TRUE(ok);
+        ASSERT_EQ(id, key.collection_path_id());
+        ASSERT_EQ(testutil::Version(version), key.read_time());
+        ASSERT_EQ(document_id, key.document_id());
+      }
+    }
+  }
+}
+
+TEST(RemoteDocumentCompactReadTimeKeyTest, Description) {
+  AssertExpectedKeyDescription(
+      "[read_time: collection_path_id=4 "
+      "snapshot_version=Timestamp(seconds=1, nanoseconds=1000) "
+      "document_id=doc]",
+      CompactReadTimeKey(4, 1000001, "doc"));
+}
+
+TEST(FieldNameIdKeyTest, Ordering) {
+  // Different collection path IDs:
+  ASSERT_LT(FieldNameIdKey(1, 2, "b"), FieldNameIdKey(2, 1, "a"));
+  ASSERT_TRUE(absl::StartsWith(FieldNameIdKey(1, 2, "b"),
+                               LevelDbFieldNameIdKey::KeyPrefix(1)));
+
+  // Different field name IDs sort by ID rather than by name:
+  ASSERT_LT(FieldNameIdKey(1, 1, "z"), FieldNameIdKey(1, 2, "a"));
+  ASSERT_LT(FieldNameIdKey(1, 2, "a"), FieldNameIdKey(1, 1000, "a"));
+}
+
+TEST(FieldNameIdKeyTest, EncodeDecodeCycle) {
+  LevelDbFieldNameIdKey key;
+
+  std::vector<int64_t> ids{0, 1, 1000, 1LL << 40};
+  std::vector<std::string> field_names{"a", "", "with.dot", "\xe2\x9c\x93"};
+
+  for (auto id : ids) {
+    for (const auto& field_name : field_names) {
+      auto encoded = FieldNameIdKey(id + 1, id, field_name);
+      bool ok = key.Decode(encoded);
+      ASSERT_TRUE(ok);
+      ASSERT_EQ(id + 1, key.collection_path_id());
+      ASSERT_EQ(id, key.field_name_id());
+      ASSERT_EQ(field_name, key.field_name());
+    }
+  }
+}
+
+TEST(FieldNameIdKeyTest, Description) {
+  AssertExpectedKeyDescription(
+      "[field_name_id: collection_path_id=4 field_name_id=2 field_name=foo]",
+      FieldNameIdKey(4, 2, "foo"));
+}
+
 TEST(BundleKeyTest, Prefixing) {
   auto table_key = LevelDbBundleKey::KeyPrefix();
 
@@ -14,6 +14,8 @@
  * limitations under the License.
  */
 
+#include <thread>  // NOLINT(build/c++11)
+
 #include "Firestore/core/src/core/filter.h"
 #include "Firestore/core/src/core/query.h"
 #include "Firestore/core/src/local/leveldb_persistence.h"
@@ -801,6 +803,34 @@ TEST_F(LevelDbLocalStoreTest,
   FSTAssertQueryReturned("coll/a", "coll/e");
 }
 
+TEST_F(LevelDbLocalStoreTest, ExecuteQueryOnSnapshotReadsCommittedState) {
+  core::Query query = testutil::Query("coll");
+  int target_id = AllocateQuery(query);
+  ApplyRemoteEvent(
+      AddedRemoteEvent(Doc("coll/a", 10, Map("foo", "bar")), {target_id}));
+  WriteMutation(SetMutation("coll/b", Map("foo", "baz")));
+
+  model::DocumentMap documents = local_store_.ExecuteQueryOnSnapshot(query);
+  EXPECT_EQ(documents.size(), 2u);
+  EXPECT_TRUE(documents.contains(Key("coll/a")));
+  EXPECT_TRUE(documents.contains(Key("coll/b")));
+
+  // A read on another thread does not observe the worker's uncommitted writes.
+  persistence_->Run("Uncommitted write", [&] {
+    persistence_->remote_document_cache()->Add(
+        Doc("coll/c", 11, Map("foo", "qux")), Version(11));
+    std::thread reader(
+        [&] { documents = local_store_.ExecuteQueryOnSnapshot(query); });
+    reader.join();
+  });
+  EXPECT_EQ(documents.size(), 2u);
+  EXPECT_FALSE(documents.contains(Key("coll/c")));
+
+  documents = local_store_.ExecuteQueryOnSnapshot(query);
+  EXPECT_EQ(documents.size(), 3u);
+  EXPECT_TRUE(documents.contains(Key("coll/c")));
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
@@ -21,18 +21,25 @@
 #include <string>
 #include <vector>
 
+#include "Firestore/Protos/nanopb/firestore/local/maybe_document.nanopb.h"
 #include "Firestore/Protos/nanopb/firestore/local/mutation.nanopb.h"
 #include "Firestore/core/src/core/field_filter.h"
 #include "Firestore/core/src/core/query.h"
+#include "Firestore/core/src/local/leveldb_collection_path_ids.h"
+#include "Firestore/core/src/local/leveldb_field_name_ids.h"
 #include "Firestore/core/src/local/leveldb_key.h"
 #include "Firestore/core/src/local/leveldb_target_cache.h"
 #include "Firestore/core/src/local/target_data.h"
+#include "Firestore/core/src/model/mutable_document.h"
 #include "Firestore/core/src/nanopb/message.h"
+#include "Firestore/core/src/nanopb/reader.h"
 #include "Firestore/core/src/util/ordered_code.h"
 #include "Firestore/core/src/util/path.h"
+#include "Firestore/core/src/util/read_context.h"
 #include "Firestore/core/test/unit/local/persistence_testing.h"
 #include "Firestore/core/test/unit/testutil/testutil.h"
 #include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "leveldb/db.h"
@@ -48,10 +55,14 @@ using leveldb::Status;
 using model::BatchId;
 using model::DocumentKey;
 using model::ListenSequenceNumber;
+using model::MutableDocument;
 using model::TargetId;
 using nanopb::Message;
+using nanopb::StringReader;
 using testutil::Filter;
+using testutil::Doc;
 using testutil::Key;
+using testutil::Map;
 using testutil::Query;
 using util::OrderedCode;
 using util::Path;
@@ -77,6 +88,13 @@ class LevelDbMigrationsTest : public testing::Test {
  protected:
   void SetUp() override;
 
+  /** Writes the given documents in the compact or the full format. */
+  void WriteDocuments(const std::vector<MutableDocument>& documents,
+                      bool compact);
+
+  /** Reads every remote document row, asserting the format of each. */
+  std::vector<MutableDocument> ReadDocuments(bool compact);
+
   std::unique_ptr<DB> db_ = nullptr;
   std::unique_ptr<LocalSerializer> serializer_ = nullptr;
 };
@@ -96,6 +114,67 @@ void LevelDbMigrationsTest::SetUp() {
   serializer_ = absl::make_unique<LocalSerializer>(MakeLocalSerializer());
 }
 
+void LevelDbMigrationsTest::WriteDocuments(
+    const std::vector<MutableDocument>& documents, bool compact) {
+  LevelDbTransaction transaction(db_.get(), "Write documents");
+  LevelDbFieldNameIds field_name_ids = LevelDbFieldNameIds::Load(&transaction);
+  LevelDbCollectionPathIds collection_path_ids =
+      LevelDbCollectionPathIds::Load(&transaction);
+
+  for (const MutableDocument& document : documents) {
+    std::string key = LevelDbRemoteDocumentKey::Key(document.key());
+    if (!compact) {
+      transaction.Put(key, serializer_->EncodeMaybeDocument(document));
+      continue;
+    }
+
+    int64_t collection_path_id = collection_path_ids.Intern(
+        document.key().path().PopLast(), &transaction);
+    transaction.Put(key, serializer_->EncodeCompactMaybeDocument(
+                             document, [&](absl::string_view field_name) {
+                               return field_name_ids.Intern(collection_path_id,
+                                                            field_name,
+                                                            &transaction);
+                             }));
+  }
+  transaction.Commit();
+}
+
+std::vector<MutableDocument> LevelDbMigrationsTest::ReadDocuments(
+    bool compact) {
+  LevelDbTransaction transaction(db_.get(), "Read documents");
+  LevelDbFieldNameIds field_name_ids = LevelDbFieldNameIds::Load(&transaction);
+  LevelDbCollectionPathIds collection_path_ids =
+      LevelDbCollectionPathIds::Load(&transaction);
+
+  std::vector<MutableDocument> result;
+  std::string prefix = LevelDbRemoteDocumentKey::KeyPrefix();
+  auto it = transaction.NewIterator();
+  LevelDbRemoteDocumentKey key;
+  for (it->Seek(prefix); it->Valid() && absl::StartsWith(it->key(), prefix);
+       it->Next()) {
+    EXPECT_TRUE(key.Decode(it->key()));
+    EXPECT_EQ(LocalSerializer::IsCompactMaybeDocument(it->value()), compact);
+
+    if (compact) {
+      absl::optional<int64_t> collection_path_id =
+          collection_path_ids.Find(key.document_key().path().PopLast());
+      EXPECT_TRUE(collection_path_id.has_value());
+      util::ReadContext context;
+      result.push_back(serializer_->DecodeCompactMaybeDocument(
+          &context, it->value(),
+          *field_name_ids.Names(collection_path_id.value_or(0))));
+      EXPECT_TRUE(context.ok()) << context.status().ToString();
+    } else {
+      StringReader reader{it->value()};
+      auto message = Message<firestore_client_MaybeDocument>::TryParse(&reader);
+      result.push_back(serializer_->DecodeMaybeDocument(&reader, *message));
+      EXPECT_TRUE(reader.ok()) << reader.status().ToString();
+    }
+  }
+  return result;
+}
+
 TEST_F(LevelDbMigrationsTest, AddsTargetGlobal) {
   auto metadata = LevelDbTargetCache::TryReadMetadata(db_.get());
   ASSERT_TRUE(!metadata)
@@ -467,6 +546,279 @@ TEST_F(LevelDbMigrationsTest, CreateCollectionParentsIndex) {
   }
 }
 
+TEST_F(LevelDbMigrationsTest, CreateCollectionMutationsIndex) {
+  std::vector<std::string> write_paths{"coll/a", "coll/b", "coll/a/sub/c",
+                                       "other/d"};
+
+  std::string empty_buffer;
+  LevelDbMigrations::RunMigrations(db_.get(), 8, *serializer_);
+  {
+    LevelDbTransaction transaction(db_.get(), "Write Mutations");
+    BatchId batch_id = 1;
+    for (const auto& write_path : write_paths) {
+      // Only the DbDocumentMutation index entries are used by the migration.
+      DocumentKey key = DocumentKey::FromPathString(write_path);
+      transaction.Put(LevelDbDocumentMutationKey::Key("uid", key, batch_id++),
+                      empty_buffer);
+    }
+    transaction.Commit();
+  }
+
+  LevelDbMigrations::RunMigrations(db_.get(), 9, *serializer_);
+  {
+    LevelDbTransaction transaction(db_.get(), "Verify");
+
+    std::vector<std::string> actual_docs;
+    std::string index_prefix = LevelDbCollectionMutationKey::KeyPrefix(
+        "uid", testutil::Resource("coll"));
+    LevelDbCollectionMutationKey row_key;
+    auto it = transaction.NewIterator();
+    for (it->Seek(index_prefix);
+         it->Valid() && absl::StartsWith(it->key(), index_prefix); it->Next()) {
+      ASSERT_TRUE(row_key.Decode(it->key()));
+      model::ResourcePath path =
+          row_key.collection_path().Append(row_key.document_id());
+      actual_docs.push_back(path.CanonicalString());
+    }
+
+    // Rows for subcollections follow the rows for the collection itself.
+    std::vector<std::string> expected_docs{"coll/a", "coll/b", "coll/a/sub/c"};
+    ASSERT_EQ(actual_docs, expected_docs);
+  }
+}
+
+TEST_F(LevelDbMigrationsTest, CreatesCompactReadTimeIndex) {
+  std::vector<std::string> doc_paths{"coll/a", "coll/b", "coll/a/sub/c"};
+
+  LevelDbMigrations::RunMigrations(db_.get(), 9, *serializer_);
+  {
+    LevelDbTransaction transaction(db_.get(), "Write read times");
+    int64_t version = 1;
+    for (const auto& doc_path : doc_paths) {
+      DocumentKey key = DocumentKey::FromPathString(doc_path);
+      transaction.Put(LevelDbRemoteDocumentReadTimeKey::Key(
+                          key.path().PopLast(), testutil::Version(version++),
+                          key.path().last_segment()),
+                      "");
+    }
+    transaction.Commit();
+  }
+
+  LevelDbMigrations::RunMigrations(db_.get(), 10, *serializer_);
+  {
+    LevelDbTransaction transaction(db_.get(), "Verify");
+    auto it = transaction.NewIterator();
+
+    // The legacy rows are kept for older clients.
+    size_t legacy_rows = 0;
+    std::string legacy_prefix = LevelDbRemoteDocumentReadTimeKey::KeyPrefix();
+    for (it->Seek(legacy_prefix);
+         it->Valid() && absl::StartsWith(it->key(), legacy_prefix);
+         it->Next()) {
+      ++legacy_rows;
+    }
+    ASSERT_EQ(legacy_rows, doc_paths.size());
+
+    // IDs are assigned in the order of the legacy index, which is sorted by
+    // collection path.
+    std::map<int64_t, std::string> paths_by_id;
+    std::string ids_prefix = LevelDbCollectionPathIdKey::KeyPrefix();
+    LevelDbCollectionPathIdKey id_key;
+    for (it->Seek(ids_prefix);
+         it->Valid() && absl::StartsWith(it->key(), ids_prefix); it->Next()) {
+      ASSERT_TRUE(id_key.Decode(it->key()));
+      paths_by_id[id_key.collection_path_id()] =
+          id_key.collection_path().CanonicalString();
+    }
+    std::map<int64_t, std::string> expected_paths{{1, "coll"},
+                                                  {2, "coll/a/sub"}};
+    ASSERT_EQ(paths_by_id, expected_paths);
+
+    std::vector<std::string> actual_docs;
+    std::string read_time_prefix =
+        LevelDbRemoteDocumentCompactReadTimeKey::KeyPrefix();
+    LevelDbRemoteDocumentCompactReadTimeKey row_key;
+    for (it->Seek(read_time_prefix);
+         it->Valid() && absl::StartsWith(it->key(), read_time_prefix);
+         it->Next()) {
+      ASSERT_TRUE(row_key.Decode(it->key()));
+      actual_docs.push_back(absl::StrCat(
+          paths_by_id[row_key.collection_path_id()], "/",
+          row_key.document_id(), "@", row_key.read_time().ToString()));
+    }
+    std::vector<std::string> expected_docs{
+        absl::StrCat("coll/a@", testutil::Version(1).ToString()),
+        absl::StrCat("coll/b@", testutil::Version(2).ToString()),
+        absl::StrCat("coll/a/sub/c@", testutil::Version(3).ToString())};
+    ASSERT_EQ(actual_docs, expected_docs);
+  }
+}
+
+TEST_F(LevelDbMigrationsTest, RerunRebuildsCompactReadTimeIndex) {
+  model::ResourcePath coll = testutil::Resource("coll");
+  LevelDbMigrations::RunMigrations(db_.get(), 10, *serializer_);
+  {
+    // Written by this client: both indexes agree.
+    LevelDbTransaction transaction(db_.get(), "Write read times");
+    transaction.Put(LevelDbCollectionPathIdKey::Key(coll, 1), "");
+    transaction.Put(LevelDbRemoteDocumentCompactReadTimeKey::Key(
+                        1, testutil::Version(5), "a"),
+                    "");
+    transaction.Put(
+        LevelDbRemoteDocumentReadTimeKey::Key(coll, testutil::Version(5), "a"),
+        "");
+    // A compact row without a legacy counterpart is stale.
+    transaction.Put(LevelDbRemoteDocumentCompactReadTimeKey::Key(
+                        1, testutil::Version(4), "z"),
+                    "");
+    transaction.Commit();
+  }
+
+  // An older client only reads and writes the legacy index.
+  LevelDbMigrations::RunMigrations(db_.get(), 9, *serializer_);
+  ASSERT_EQ(LevelDbMigrations::ReadSchemaVersion(db_.get()), 9);
+  {
+    LevelDbTransaction transaction(db_.get(), "Write legacy read times");
+    transaction.Put(
+        LevelDbRemoteDocumentReadTimeKey::Key(coll, testutil::Version(6), "a"),
+        "");
+    transaction.Put(LevelDbRemoteDocumentReadTimeKey::Key(
+                        testutil::Resource("other"), testutil::Version(7), "b"),
+                    "");
+    transaction.Commit();
+  }
+
+  // Upgrading again rebuilds the compact index from the legacy one, dropping
+  // stale rows and keeping the IDs interned before.
+  LevelDbMigrations::RunMigrations(db_.get(), 10, *serializer_);
+  {
+    LevelDbTransaction transaction(db_.get(), "Verify");
+    std::vector<std::string> actual_keys;
+    std::string read_time_prefix =
+        LevelDbRemoteDocumentCompactReadTimeKey::KeyPrefix();
+    auto it = transaction.NewIterator();
+    for (it->Seek(read_time_prefix);
+         it->Valid() && absl::StartsWith(it->key(), read_time_prefix);
+         it->Next()) {
+      actual_keys.push_back(it->key());
+    }
+    std::vector<std::string> expected_keys{
+        LevelDbRemoteDocumentCompactReadTimeKey::Key(1, testutil::Version(5),
+                                                     "a"),
+        LevelDbRemoteDocumentCompactReadTimeKey::Key(1, testutil::Version(6),
+                                                     "a"),
+        LevelDbRemoteDocumentCompactReadTimeKey::Key(2, testutil::Version(7),
+                                                     "b")};
+    ASSERT_EQ(actual_keys, expected_keys);
+  }
+}
+
+TEST_F(LevelDbMigrationsTest, LeavesDocumentsInFullFormat) {
+  std::vector<MutableDocument> documents{
+      Doc("coll/a", 1, Map("name", "a", "nested", Map("name", 1))),
+      Doc("coll/b", 2, Map("name", "b", "other", true)),
+      testutil::DeletedDoc("other/d", 4)};
+
+  LevelDbMigrations::RunMigrations(db_.get(), 10, *serializer_);
+  WriteDocuments(documents, /*compact=*/false);
+
+  // Older clients can't read compact rows, so existing rows aren't rewritten.
+  LevelDbMigrations::RunMigrations(db_.get(), 11, *serializer_);
+  ASSERT_EQ(LevelDbMigrations::ReadSchemaVersion(db_.get()), 11);
+  ASSERT_EQ(ReadDocuments(/*compact=*/false), documents);
+
+  LevelDbTransaction transaction(db_.get(), "Verify");
+  auto it = transaction.NewIterator();
+  std::string ids_prefix = LevelDbFieldNameIdKey::KeyPrefix();
+  it->Seek(ids_prefix);
+  ASSERT_FALSE(it->Valid() && absl::StartsWith(it->key(), ids_prefix));
+}
+
+TEST_F(LevelDbMigrationsTest, DowngradeRestoresFullDocuments) {
+  std::vector<MutableDocument> documents{
+      Doc("coll/a", 1, Map("name", "a", "nested", Map("name", 1))),
+      Doc("coll/a/sub/b", 2, Map("name", "b"))};
+
+  LevelDbMigrations::RunMigrations(db_.get(), 11, *serializer_);
+  WriteDocuments(documents, /*compact=*/true);
+  ASSERT_EQ(ReadDocuments(/*compact=*/true), documents);
+
+  LevelDbMigrations::RunMigrations(db_.get(), 9, *serializer_);
+  ASSERT_EQ(LevelDbMigrations::ReadSchemaVersion(db_.get()), 9);
+  ASSERT_EQ(ReadDocuments(/*compact=*/false), documents);
+  {
+    LevelDbTransaction transaction(db_.get(), "Verify");
+    auto it = transaction.NewIterator();
+    std::string ids_prefix = LevelDbFieldNameIdKey::KeyPrefix();
+    it->Seek(ids_prefix);
+    ASSERT_FALSE(it->Valid() && absl::StartsWith(it->key(), ids_prefix));
+  }
+
+  // Upgrading again leaves the documents in the full format.
+  LevelDbMigrations::RunMigrations(db_.get(), 11, *serializer_);
+  ASSERT_EQ(ReadDocuments(/*compact=*/false), documents);
+}
+
+TEST_F(LevelDbMigrationsTest, DowngradeRestoresManyDocumentsInBatches) {
+  std::vector<MutableDocument> documents;
+  for (int i = 0; i < 2500; ++i) {
+    documents.push_back(
+        Doc(absl::StrCat("coll/", 10000 + i), 1, Map("index", i)));
+  }
+
+  LevelDbMigrations::RunMigrations(db_.get(), 11, *serializer_);
+  WriteDocuments(documents, /*compact=*/true);
+
+  LevelDbMigrations::RunMigrations(db_.get(), 10, *serializer_);
+  ASSERT_EQ(LevelDbMigrations::ReadSchemaVersion(db_.get()), 10);
+  ASSERT_EQ(ReadDocuments(/*compact=*/false), documents);
+}
+
+TEST_F(LevelDbMigrationsTest, DowngradeRestoresLegacyReadTimeIndex) {
+  model::ResourcePath coll = testutil::Resource("coll");
+  model::ResourcePath sub = testutil::Resource("coll/a/sub");
+  LevelDbMigrations::RunMigrations(db_.get(), 11, *serializer_);
+  {
+    // With compact documents enabled, only the compact index is written.
+    LevelDbTransaction transaction(db_.get(), "Write read times");
+    transaction.Put(LevelDbCollectionPathIdKey::Key(coll, 1), "");
+    transaction.Put(LevelDbCollectionPathIdKey::Key(sub, 2), "");
+    transaction.Put(LevelDbRemoteDocumentCompactReadTimeKey::Key(
+                        1, testutil::Version(5), "a"),
+                    "");
+    transaction.Put(LevelDbRemoteDocumentCompactReadTimeKey::Key(
+                        2, testutil::Version(6), "b"),
+                    "");
+    // Rows written while compact documents were disabled already exist.
+    transaction.Put(LevelDbRemoteDocumentCompactReadTimeKey::Key(
+                        1, testutil::Version(4), "c"),
+                    "");
+    transaction.Put(
+        LevelDbRemoteDocumentReadTimeKey::Key(coll, testutil::Version(4), "c"),
+        "");
+    transaction.Commit();
+  }
+
+  LevelDbMigrations::RunMigrations(db_.get(), 9, *serializer_);
+  {
+    LevelDbTransaction transaction(db_.get(), "Verify");
+    std::vector<std::string> actual_keys;
+    std::string read_time_prefix =
+        LevelDbRemoteDocumentReadTimeKey::KeyPrefix();
+    auto it = transaction.NewIterator();
+    for (it->Seek(read_time_prefix);
+         it->Valid() && absl::StartsWith(it->key(), read_time_prefix);
+         it->Next()) {
+      actual_keys.push_back(it->key());
+    }
+    std::vector<std::string> expected_keys{
+        LevelDbRemoteDocumentReadTimeKey::Key(coll, testutil::Version(4), "c"),
+        LevelDbRemoteDocumentReadTimeKey::Key(coll, testutil::Version(5), "a"),
+        LevelDbRemoteDocumentReadTimeKey::Key(sub, testutil::Version(6), "b")};
+    ASSERT_EQ(actual_keys, expected_keys);
+  }
+}
+
 TEST_F(LevelDbMigrationsTest, RewritesCanonicalIds) {
   LevelDbMigrations::RunMigrations(db_.get(), 6, *serializer_);
   auto query = Query("collection").AddingFilter(Filter("foo", "==", "bar"));
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+
+#include "Firestore/core/src/core/query.h"
+#include "Firestore/core/src/credentials/user.h"
+#include "Firestore/core/src/local/leveldb_persistence.h"
+#include "Firestore/core/src/local/leveldb_remote_document_cache.h"
+#include "Firestore/core/src/model/field_index.h"
+#include "Firestore/core/src/model/mutable_document.h"
+#include "Firestore/core/test/unit/local/persistence_testing.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+namespace {
+
+using model::IndexOffset;
+using model::MutableDocument;
+
+MutableDocument MakeDocument(int index) {
+  return testutil::Doc(
+      absl::StrCat("coll/doc", index), 1,
+      testutil::Map(
+          "name", absl::StrCat("user", index), "age", index % 100, "tags",
+          testutil::Array("alpha", "beta", "gamma"), "address",
+          testutil::Map("street", "1600 Amphitheatre Parkway", "city",
+                        "Mountain View", "zip", "94043")));
+}
+
+/**
+ * Scans a whole collection of `num_docs` documents with a filter that matches
+ * half of them, decoding on `threads` threads. Comparing thread counts shows
+ * how the decoding scales with cores.
+ */
+void BM_LevelDbCollectionScan(benchmark::State& state) {
+  int num_docs = static_cast<int>(state.range(0));
+  int threads = static_cast<int>(state.range(1));
+
+  std::unique_ptr<LevelDbPersistence> persistence =
+      LevelDbPersistenceForTesting();
+  LevelDbRemoteDocumentCache* cache = persistence->remote_document_cache();
+  cache->SetIndexManager(
+      persistence->GetIndexManager(credentials::User::Unauthenticated()));
+  cache->TEST_SetDecodeConcurrency(threads);
+
+  persistence->Run("PopulateCache", [&] {
+    for (int i = 0; i < num_docs; ++i) {
+      cache->Add(MakeDocument(i), testutil::Version(1));
+    }
+  });
+
+  core::Query query = testutil::Query("coll").AddingFilter(
+      testutil::Filter("age", ">=", 50));
+
+  for (auto _ : state) {
+    persistence->Run("Scan", [&] {
+      benchmark::DoNotOptimize(
+          cache->GetDocumentsMatchingQuery(query, IndexOffset::None()));
+    });
+  }
+  state.SetItemsProcessed(state.iterations() * num_docs);
+}
+void ScanSizes(benchmark::internal::Benchmark* benchmark) {
+  for (int num_docs : {10000, 100000}) {
+    for (int threads : {1, 2, 4, 8}) {
+      benchmark->Args({num_docs, threads});
+    }
+  }
+}
+BENCHMARK(BM_LevelDbCollectionScan)
+    ->Apply(ScanSizes)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -19,6 +19,7 @@
 #include <string>
 
 #include "Firestore/core/src/local/leveldb_persistence.h"
+#include "Firestore/core/src/local/lru_garbage_collector.h"
 #include "Firestore/core/src/local/remote_document_cache.h"
 #include "Firestore/core/src/util/ordered_code.h"
 #include "Firestore/core/test/unit/local/persistence_testing.h"
@@ -78,11 +79,21 @@ std::unique_ptr<Persistence> PersistenceFactory() {
   return persistence;
 }
 
+std::unique_ptr<Persistence> CompactDocumentsPersistenceFactory() {
+  auto created =
+      LevelDbPersistence::Create(LevelDbDir(), MakeLocalSerializer(),
+                                 LruParams::Default(),
+                                 /* compact_documents_enabled= */ true);
+  EXPECT_TRUE(created.ok());
+  return std::move(created).ValueOrDie();
+}
+
 }  // namespace
 
 INSTANTIATE_TEST_SUITE_P(LevelDbRemoteDocumentCacheTest,
                          RemoteDocumentCacheTest,
-                         testing::Values(PersistenceFactory));
+                         testing::Values(PersistenceFactory,
+                                         CompactDocumentsPersistenceFactory));
 
 }  // namespace local
 }  // namespace firestore
@@ -115,6 +115,40 @@ TEST_F(LevelDbTransactionTest, CanReadCommittedAndMutations) {
   ASSERT_EQ(value, mutation_value2);
 }
 
+TEST_F(LevelDbTransactionTest, ReadOnlyReadsSnapshot) {
+  const WriteOptions& write_options = LevelDbTransaction::DefaultWriteOptions();
+  ASSERT_TRUE(db_->Put(write_options, "key1", "value1").ok());
+
+  std::unique_ptr<LevelDbTransaction> snapshot =
+      LevelDbTransaction::ReadOnly(db_.get(), "ReadOnlyReadsSnapshot");
+  ASSERT_TRUE(snapshot->read_only());
+
+  // Commit changes after the snapshot was taken.
+  LevelDbTransaction transaction(db_.get(), "ReadOnlyReadsSnapshot");
+  transaction.Put("key1", "value2");
+  transaction.Put("key2", "value2");
+  transaction.Commit();
+
+  std::string value;
+  ASSERT_TRUE(snapshot->Get("key1", &value).ok());
+  ASSERT_EQ("value1", value);
+  ASSERT_TRUE(snapshot->Get("key2", &value).IsNotFound());
+
+  auto iter = snapshot->NewIterator();
+  iter->Seek("key");
+  ASSERT_TRUE(iter->Valid());
+  ASSERT_EQ("key1", iter->key());
+  ASSERT_EQ("value1", iter->value());
+  iter->Next();
+  ASSERT_FALSE(iter->Valid());
+
+  // A new snapshot observes the committed changes.
+  std::unique_ptr<LevelDbTransaction> later =
+      LevelDbTransaction::ReadOnly(db_.get(), "ReadOnlyReadsSnapshot");
+  ASSERT_TRUE(later->Get("key2", &value).ok());
+  ASSERT_EQ("value2", value);
+}
+
 TEST_F(LevelDbTransactionTest, DeleteCommitted) {
   // add something committed, delete it, verify you can't read it
   for (int i = 0; i < 3; ++i) {
@@ -196,6 +230,32 @@ TEST_F(LevelDbTransactionTest, MutateDeleted) {
   ASSERT_TRUE(status.IsNotFound());
 }
 
+TEST_F(LevelDbTransactionTest, PutAll) {
+  LevelDbTransaction transaction(db_.get(), "PutAll");
+  transaction.Put("key_2", "old_value");
+  transaction.Put("key_5", "value_5");
+  transaction.Delete("key_3");
+
+  // Mostly ordered, with an existing key, a deleted key and one key out of
+  // order.
+  transaction.PutAll({{"key_1", "value_1"},
+                      {"key_2", "value_2"},
+                      {"key_3", "value_3"},
+                      {"key_6", "value_6"},
+                      {"key_4", "value_4"}});
+
+  LevelDbTransaction::Iterator iter(&transaction);
+  iter.Seek("");
+  for (int i = 1; i <= 6; ++i) {
+    ASSERT_TRUE(iter.Valid());
+    ASSERT_EQ(iter.key(), "key_" + std::to_string(i));
+    ASSERT_EQ(iter.value(), "value_" + std::to_string(i));
+    iter.Next();
+  }
+  ASSERT_FALSE(iter.Valid());
+  ASSERT_EQ(transaction.changed_keys(), 6u);
+}
+
 TEST_F(LevelDbTransactionTest, ProtobufSupport) {
   LevelDbTransaction transaction(db_.get(), "ProtobufSupport");
 
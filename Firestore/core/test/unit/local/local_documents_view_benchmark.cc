@@ -0,0 +1,107 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/core/query.h"
+#include "Firestore/core/src/credentials/user.h"
+#include "Firestore/core/src/local/local_store.h"
+#include "Firestore/core/src/local/memory_persistence.h"
+#include "Firestore/core/src/local/query_engine.h"
+#include "Firestore/core/src/model/mutation.h"
+#include "Firestore/core/test/unit/local/persistence_testing.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+namespace {
+
+using credentials::User;
+using model::Mutation;
+
+constexpr size_t kMutationsPerBatch = 100;
+
+/**
+ * Runs a filtered collection query over `num_docs` cached documents while
+ * `num_pending` of them have pending writes. Half of the writes patch cached
+ * documents and half create new ones.
+ */
+void BM_CollectionQueryWithPendingWrites(benchmark::State& state) {
+  int num_docs = static_cast<int>(state.range(0));
+  int num_pending = static_cast<int>(state.range(1));
+
+  std::unique_ptr<MemoryPersistence> persistence =
+      MemoryPersistenceWithEagerGcForTesting();
+  QueryEngine query_engine;
+  LocalStore local_store(persistence.get(), &query_engine,
+                         User::Unauthenticated());
+  local_store.Start();
+
+  persistence->Run("PopulateCache", [&] {
+    for (int i = 0; i < num_docs; ++i) {
+      persistence->remote_document_cache()->Add(
+          testutil::Doc(absl::StrCat("coll/doc", i), 1,
+                        testutil::Map("score", i % 100, "name",
+                                      absl::StrCat("user", i))),
+          testutil::Version(1));
+    }
+  });
+
+  std::vector<Mutation> mutations;
+  for (int i = 0; i < num_pending; ++i) {
+    if (i % 2 == 0) {
+      int target = static_cast<int>(static_cast<int64_t>(i) * num_docs /
+                                    std::max(num_pending, 1));
+      mutations.push_back(testutil::PatchMutation(
+          absl::StrCat("coll/doc", target), testutil::Map("score", i % 100)));
+    } else {
+      mutations.push_back(testutil::SetMutation(
+          absl::StrCat("coll/new", i),
+          testutil::Map("score", i % 100, "name", absl::StrCat("new", i))));
+    }
+    if (mutations.size() == kMutationsPerBatch || i == num_pending - 1) {
+      local_store.WriteLocally(std::move(mutations));
+      mutations.clear();
+    }
+  }
+
+  core::Query query = testutil::Query("coll").AddingFilter(
+      testutil::Filter("score", ">=", 50));
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        local_store.ExecuteQuery(query, /*use_previous_results=*/false));
+  }
+  state.SetItemsProcessed(state.iterations() * (num_docs + num_pending / 2));
+}
+BENCHMARK(BM_CollectionQueryWithPendingWrites)
+    ->Args({10000, 0})
+    ->Args({10000, 1000})
+    ->Args({10000, 10000})
+    ->Args({100000, 10000})
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
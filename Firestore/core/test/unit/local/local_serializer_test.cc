@@ -16,6 +16,10 @@
 
 #include "Firestore/core/src/local/local_serializer.h"
 
+#include <algorithm>
+#include <string>
+#include <vector>
+
 #include "Firestore/Protos/cpp/firestore/bundle.pb.h"
 #include "Firestore/Protos/cpp/firestore/local/maybe_document.pb.h"
 #include "Firestore/Protos/cpp/firestore/local/mutation.pb.h"
@@ -42,6 +46,7 @@
 #include "Firestore/core/src/nanopb/reader.h"
 #include "Firestore/core/src/nanopb/writer.h"
 #include "Firestore/core/src/remote/serializer.h"
+#include "Firestore/core/src/util/read_context.h"
 #include "Firestore/core/src/util/status.h"
 #include "Firestore/core/test/unit/nanopb/nanopb_testing.h"
 #include "Firestore/core/test/unit/testutil/status_testing.h"
@@ -251,6 +256,7 @@ class LocalSerializerTest : public ::testing::Test {
     ByteString bytes = EncodeMaybeDocument(&serializer, model);
     auto actual = ProtobufParse<::firestore::client::MaybeDocument>(bytes);
     EXPECT_TRUE(msg_diff.Compare(proto, actual)) << message_differences;
+    EXPECT_EQ(serializer.EncodedMaybeDocumentSize(model), bytes.size());
   }
 
   void ExpectDeserializationRoundTrip(
@@ -461,6 +467,104 @@ TEST_F(LocalSerializerTest, EncodesUnknownDocumentAsMaybeDocument) {
   ExpectRoundTrip(unknown_doc, maybe_doc_proto);
 }
 
+TEST_F(LocalSerializerTest, CalculatesEncodedSizeOfNestedDocument) {
+  MutableDocument doc = Doc(
+      "some/path", /*version=*/42,
+      Map("string", "bar", "array", testutil::Array(1, 2.5, "three"), "map",
+          Map("nested", Map("deeper", true), "empty", Map())));
+
+  EXPECT_EQ(serializer.EncodedMaybeDocumentSize(doc),
+            MakeByteString(serializer.EncodeMaybeDocument(doc)).size());
+
+  doc = Doc("some/path", /*version=*/42, Map());
+  EXPECT_EQ(serializer.EncodedMaybeDocumentSize(doc),
+            MakeByteString(serializer.EncodeMaybeDocument(doc)).size());
+}
+
+TEST_F(LocalSerializerTest, EncodesDocumentInCompactFormat) {
+  MutableDocument doc = Doc(
+      "some/path", /*version=*/42,
+      Map("string", "bar", "array", testutil::Array(Map("map", 1), "three"),
+          "map", Map("string", Map("deeper", true), "empty", Map())));
+
+  std::vector<std::string> field_names;
+  auto intern = [&](absl::string_view field_name) {
+    auto found =
+        std::find(field_names.begin(), field_names.end(), field_name);
+    if (found == field_names.end()) {
+      found = field_names.emplace(found, field_name);
+    }
+    return absl::optional<int64_t>(found - field_names.begin());
+  };
+
+  std::string encoded = serializer.EncodeCompactMaybeDocument(doc, intern);
+  std::string full = MakeStdString(serializer.EncodeMaybeDocument(doc));
+  EXPECT_TRUE(LocalSerializer::IsCompactMaybeDocument(encoded));
+  EXPECT_FALSE(LocalSerializer::IsCompactMaybeDocument(full));
+  EXPECT_LT(encoded.size(), full.size());
+
+  // Names used at several depths, including inside arrays, are interned once.
+  std::vector<std::string> expected_names{"array", "map", "deeper", "empty",
+                                          "string"};
+  std::sort(field_names.begin(), field_names.end());
+  std::sort(expected_names.begin(), expected_names.end());
+  EXPECT_EQ(field_names, expected_names);
+
+  util::ReadContext context;
+  MutableDocument decoded =
+      serializer.DecodeCompactMaybeDocument(&context, encoded, field_names);
+  EXPECT_TRUE(context.ok()) << context.status().ToString();
+  EXPECT_EQ(decoded, doc);
+}
+
+TEST_F(LocalSerializerTest, EncodesFieldNamesWithoutIdsInCompactFormat) {
+  MutableDocument doc =
+      Doc("some/path", /*version=*/42, Map("a", Map("\x01", 1, "b", 2), "c", 3))
+          .SetHasCommittedMutations();
+
+  // Only "a" gets an ID, as if the dictionary filled up after it. The name
+  // "\x01" is spelled out even though it reads like an ID.
+  std::vector<std::string> field_names{"a"};
+  auto intern = [](absl::string_view field_name) {
+    return field_name == "a" ? absl::optional<int64_t>(0) : absl::nullopt;
+  };
+  std::string encoded = serializer.EncodeCompactMaybeDocument(doc, intern);
+
+  util::ReadContext context;
+  MutableDocument decoded =
+      serializer.DecodeCompactMaybeDocument(&context, encoded, field_names);
+  EXPECT_TRUE(context.ok()) << context.status().ToString();
+  EXPECT_EQ(decoded, doc);
+  EXPECT_TRUE(decoded.has_committed_mutations());
+}
+
+TEST_F(LocalSerializerTest, EncodesNoDocumentInCompactFormat) {
+  MutableDocument no_doc = DeletedDoc("some/path", /*version=*/42);
+  std::string encoded = serializer.EncodeCompactMaybeDocument(
+      no_doc, [](absl::string_view) { return absl::optional<int64_t>(0); });
+
+  util::ReadContext context;
+  EXPECT_EQ(serializer.DecodeCompactMaybeDocument(&context, encoded, {}),
+            no_doc);
+  EXPECT_TRUE(context.ok()) << context.status().ToString();
+}
+
+TEST_F(LocalSerializerTest, HandlesUnknownFieldNameIdInCompactFormat) {
+  MutableDocument doc = Doc("some/path", /*version=*/42, Map("foo", "bar"));
+  std::string encoded = serializer.EncodeCompactMaybeDocument(
+      doc, [](absl::string_view) { return absl::optional<int64_t>(3); });
+
+  util::ReadContext context;
+  serializer.DecodeCompactMaybeDocument(&context, encoded, {"a", "b", "c"});
+  EXPECT_FALSE(context.ok());
+
+  util::ReadContext full_format_context;
+  serializer.DecodeCompactMaybeDocument(
+      &full_format_context, MakeStdString(serializer.EncodeMaybeDocument(doc)),
+      {});
+  EXPECT_FALSE(full_format_context.ok());
+}
+
 TEST_F(LocalSerializerTest, EncodesTargetData) {
   core::Query query = Query("room");
   TargetId target_id = 42;
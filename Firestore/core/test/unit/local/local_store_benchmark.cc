@@ -0,0 +1,365 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/bundle/bundle_metadata.h"
+#include "Firestore/core/src/bundle/bundled_query.h"
+#include "Firestore/core/src/bundle/named_query.h"
+#include "Firestore/core/src/core/query.h"
+#include "Firestore/core/src/credentials/user.h"
+#include "Firestore/core/src/local/local_store.h"
+#include "Firestore/core/src/local/lru_garbage_collector.h"
+#include "Firestore/core/src/local/persistence.h"
+#include "Firestore/core/src/local/query_engine.h"
+#include "Firestore/core/src/local/query_result.h"
+#include "Firestore/core/src/local/target_data.h"
+#include "Firestore/core/src/model/document_key_set.h"
+#include "Firestore/core/src/model/field_index.h"
+#include "Firestore/core/src/model/mutable_document.h"
+#include "Firestore/core/src/model/mutation.h"
+#include "Firestore/core/test/unit/local/persistence_testing.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+namespace {
+
+using bundle::BundledQuery;
+using bundle::BundleMetadata;
+using bundle::NamedQuery;
+using credentials::User;
+using model::DocumentKeySet;
+using model::MutableDocument;
+using model::MutableDocumentMap;
+using model::Mutation;
+using model::TargetId;
+
+/** The persistence layer a `LocalStore` runs on. */
+enum PersistenceKind {
+  kMemory = 0,
+  kLevelDb = 1,
+};
+
+/** The number of distinct values of the "score" field. */
+constexpr int kNumScores = 100;
+
+/** The number of documents that belong to each target in the GC benchmark. */
+constexpr int kDocsPerTarget = 100;
+
+/**
+ * Runs a benchmark for each persistence layer over collections of 100, 1000
+ * and 10000 documents.
+ */
+void PersistenceAndSizes(benchmark::internal::Benchmark* b) {
+  for (int kind : {kMemory, kLevelDb}) {
+    for (int num_docs : {100, 1000, 10000}) {
+      b->Args({kind, num_docs});
+    }
+  }
+}
+
+MutableDocument MakeDoc(const std::string& collection, int i, int64_t version) {
+  return testutil::Doc(
+      absl::StrCat(collection, "/doc", i), version,
+      testutil::Map("score", i % kNumScores, "name", absl::StrCat("user", i)));
+}
+
+std::vector<MutableDocument> MakeDocs(const std::string& collection,
+                                      int num_docs,
+                                      int64_t version) {
+  std::vector<MutableDocument> docs;
+  docs.reserve(num_docs);
+  for (int i = 0; i < num_docs; ++i) {
+    docs.push_back(MakeDoc(collection, i, version));
+  }
+  return docs;
+}
+
+/** A started `LocalStore` together with the persistence it runs on. */
+class LocalStoreHarness {
+ public:
+  explicit LocalStoreHarness(PersistenceKind kind,
+                             LruParams lru_params = LruParams::Default()) {
+    if (kind == kMemory) {
+      persistence_ = MemoryPersistenceWithLruGcForTesting(lru_params);
+    } else {
+      persistence_ = LevelDbPersistenceForTesting(lru_params);
+    }
+    local_store_ = absl::make_unique<LocalStore>(
+        persistence_.get(), &query_engine_, User::Unauthenticated());
+    local_store_->Start();
+  }
+
+  LocalStore* local_store() {
+    return local_store_.get();
+  }
+
+  LruGarbageCollector* garbage_collector() {
+    return static_cast<LruDelegate*>(persistence_->reference_delegate())
+        ->garbage_collector();
+  }
+
+  /**
+   * Listens to the given collection and applies a remote event that adds
+   * `num_docs` documents to it. Returns the ID of the listen target.
+   */
+  TargetId AddRemoteDocuments(const std::string& collection,
+                              int num_docs,
+                              int64_t version = 1) {
+    core::Query query = testutil::Query(collection);
+    TargetId target_id =
+        local_store_->AllocateTarget(query.ToTarget()).target_id();
+    local_store_->ApplyRemoteEvent(testutil::AddedRemoteEvent(
+        MakeDocs(collection, num_docs, version), {target_id}));
+    return target_id;
+  }
+
+ private:
+  std::unique_ptr<Persistence> persistence_;
+  QueryEngine query_engine_;
+  std::unique_ptr<LocalStore> local_store_;
+};
+
+void SetPersistenceLabel(benchmark::State& state) {
+  state.SetLabel(state.range(0) == kMemory ? "memory" : "leveldb");
+}
+
+/**
+ * Applies remote events that update every document of a collection listened
+ * to by one target, as when a large query is resumed after the documents
+ * changed on the backend.
+ */
+void BM_ApplyRemoteEvent(benchmark::State& state) {
+  SetPersistenceLabel(state);
+  auto kind = static_cast<PersistenceKind>(state.range(0));
+  int num_docs = static_cast<int>(state.range(1));
+
+  LocalStoreHarness harness{kind};
+  TargetId target_id = harness.AddRemoteDocuments("coll", num_docs);
+
+  int64_t version = 1;
+  for (auto _ : state) {
+    state.PauseTiming();
+    remote::RemoteEvent event = testutil::AddedRemoteEvent(
+        MakeDocs("coll", num_docs, ++version), {target_id});
+    state.ResumeTiming();
+
+    benchmark::DoNotOptimize(harness.local_store()->ApplyRemoteEvent(event));
+  }
+  state.SetItemsProcessed(state.iterations() * num_docs);
+}
+BENCHMARK(BM_ApplyRemoteEvent)
+    ->Apply(PersistenceAndSizes)
+    ->Unit(benchmark::kMillisecond);
+
+/** Runs a query that matches every document of a cached collection. */
+void BM_CollectionScan(benchmark::State& state) {
+  SetPersistenceLabel(state);
+  auto kind = static_cast<PersistenceKind>(state.range(0));
+  int num_docs = static_cast<int>(state.range(1));
+
+  LocalStoreHarness harness{kind};
+  harness.AddRemoteDocuments("coll", num_docs);
+  core::Query query = testutil::Query("coll");
+
+  for (auto _ : state) {
+    QueryResult result = harness.local_store()->ExecuteQuery(
+        query, /*use_previous_results=*/false);
+    benchmark::DoNotOptimize(result.documents().size());
+  }
+  state.SetItemsProcessed(state.iterations() * num_docs);
+}
+BENCHMARK(BM_CollectionScan)
+    ->Apply(PersistenceAndSizes)
+    ->Unit(benchmark::kMillisecond);
+
+/**
+ * Runs an equality query that matches one in `kNumScores` documents, with a
+ * backfilled field index on the filtered field. Memory persistence does not
+ * support field indexes and scans the collection instead.
+ */
+void BM_IndexedQuery(benchmark::State& state) {
+  SetPersistenceLabel(state);
+  auto kind = static_cast<PersistenceKind>(state.range(0));
+  int num_docs = static_cast<int>(state.range(1));
+
+  LocalStoreHarness harness{kind};
+  harness.AddRemoteDocuments("coll", num_docs);
+  harness.local_store()->ConfigureFieldIndexes({testutil::MakeFieldIndex(
+      "coll", "score", model::Segment::kAscending)});
+  while (harness.local_store()->Backfill() > 0) {
+  }
+  core::Query query =
+      testutil::Query("coll").AddingFilter(testutil::Filter("score", "==", 7));
+
+  for (auto _ : state) {
+    QueryResult result = harness.local_store()->ExecuteQuery(
+        query, /*use_previous_results=*/false);
+    benchmark::DoNotOptimize(result.documents().size());
+  }
+  state.SetItemsProcessed(state.iterations() * num_docs / kNumScores);
+}
+BENCHMARK(BM_IndexedQuery)
+    ->Apply(PersistenceAndSizes)
+    ->Unit(benchmark::kMicrosecond);
+
+/** Runs a query for the ten lowest-scoring documents of a collection. */
+void BM_LimitQuery(benchmark::State& state) {
+  SetPersistenceLabel(state);
+  auto kind = static_cast<PersistenceKind>(state.range(0));
+  int num_docs = static_cast<int>(state.range(1));
+
+  LocalStoreHarness harness{kind};
+  harness.AddRemoteDocuments("coll", num_docs);
+  core::Query query = testutil::Query("coll")
+                          .AddingOrderBy(testutil::OrderBy("score"))
+                          .WithLimitToFirst(10);
+
+  for (auto _ : state) {
+    QueryResult result = harness.local_store()->ExecuteQuery(
+        query, /*use_previous_results=*/false);
+    benchmark::DoNotOptimize(result.documents().size());
+  }
+}
+BENCHMARK(BM_LimitQuery)
+    ->Apply(PersistenceAndSizes)
+    ->Unit(benchmark::kMillisecond);
+
+/**
+ * Runs a collection query after a local patch was written, in a batch of its
+ * own, to every fourth document, so that the query has to apply overlays to a
+ * quarter of its results.
+ */
+void BM_OverlayQuery(benchmark::State& state) {
+  SetPersistenceLabel(state);
+  auto kind = static_cast<PersistenceKind>(state.range(0));
+  int num_docs = static_cast<int>(state.range(1));
+
+  LocalStoreHarness harness{kind};
+  harness.AddRemoteDocuments("coll", num_docs);
+  for (int i = 0; i < num_docs; i += 4) {
+    std::vector<Mutation> mutations{testutil::PatchMutation(
+        absl::StrCat("coll/doc", i), testutil::Map("pending", true))};
+    harness.local_store()->WriteLocally(std::move(mutations));
+  }
+  core::Query query = testutil::Query("coll");
+
+  for (auto _ : state) {
+    QueryResult result = harness.local_store()->ExecuteQuery(
+        query, /*use_previous_results=*/false);
+    benchmark::DoNotOptimize(result.documents().size());
+  }
+  state.SetItemsProcessed(state.iterations() * num_docs);
+}
+BENCHMARK(BM_OverlayQuery)
+    ->Apply(PersistenceAndSizes)
+    ->Unit(benchmark::kMillisecond);
+
+/**
+ * Collects garbage after every target was released, removing all targets and
+ * the documents that belonged to them (`kDocsPerTarget` each).
+ */
+void BM_LruGarbageCollection(benchmark::State& state) {
+  SetPersistenceLabel(state);
+  auto kind = static_cast<PersistenceKind>(state.range(0));
+  int num_docs = static_cast<int>(state.range(1));
+  int num_targets = num_docs / kDocsPerTarget;
+
+  // Collects everything that is not in use, regardless of the cache size.
+  LruParams lru_params = LruParams::Default();
+  lru_params.min_bytes_threshold = 0;
+  lru_params.percentile_to_collect = 100;
+  lru_params.maximum_sequence_numbers_to_collect = num_docs + num_targets;
+
+  LocalStoreHarness harness{kind, lru_params};
+  int64_t documents_removed = 0;
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    for (int t = 0; t < num_targets; ++t) {
+      TargetId target_id =
+          harness.AddRemoteDocuments(absl::StrCat("coll", t), kDocsPerTarget);
+      harness.local_store()->ReleaseTarget(target_id);
+    }
+    state.ResumeTiming();
+
+    LruResults results =
+        harness.local_store()->CollectGarbage(harness.garbage_collector());
+    documents_removed += results.documents_removed;
+  }
+
+  state.counters["documents_removed"] =
+      benchmark::Counter(static_cast<double>(documents_removed),
+                         benchmark::Counter::kAvgIterations);
+  state.SetItemsProcessed(state.iterations() * num_docs);
+}
+BENCHMARK(BM_LruGarbageCollection)
+    ->Apply(PersistenceAndSizes)
+    ->Unit(benchmark::kMillisecond);
+
+/**
+ * Loads a bundle that carries a new version of every document of a collection
+ * and a named query over them, as `BundleLoader` does once it has read the
+ * whole bundle.
+ */
+void BM_BundleLoad(benchmark::State& state) {
+  SetPersistenceLabel(state);
+  auto kind = static_cast<PersistenceKind>(state.range(0));
+  int num_docs = static_cast<int>(state.range(1));
+
+  LocalStoreHarness harness{kind};
+  core::Query query = testutil::Query("coll");
+
+  int64_t version = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    ++version;
+    std::string bundle_id = absl::StrCat("bundle", version);
+    MutableDocumentMap documents;
+    DocumentKeySet keys;
+    for (MutableDocument& doc : MakeDocs("coll", num_docs, version)) {
+      keys = keys.insert(doc.key());
+      documents = documents.insert(doc.key(), std::move(doc));
+    }
+    state.ResumeTiming();
+
+    LocalStore* local_store = harness.local_store();
+    local_store->ApplyBundledDocuments(documents, bundle_id);
+    BundledQuery bundled_query(query.ToTarget(), core::LimitType::None);
+    NamedQuery named_query("query", std::move(bundled_query),
+                           testutil::Version(version));
+    local_store->SaveNamedQuery(named_query, keys);
+    local_store->SaveBundle(
+        BundleMetadata(bundle_id, 1, testutil::Version(version)));
+  }
+  state.SetItemsProcessed(state.iterations() * num_docs);
+}
+BENCHMARK(BM_BundleLoad)
+    ->Apply(PersistenceAndSizes)
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
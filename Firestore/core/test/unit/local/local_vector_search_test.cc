@@ -0,0 +1,151 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/local/local_vector_search.h"
+
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/model/document_key.h"
+#include "Firestore/core/src/model/mutable_document.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+namespace {
+
+using model::DistanceMeasure;
+using model::DocumentMap;
+using model::MutableDocument;
+using testutil::Doc;
+using testutil::Field;
+using testutil::Key;
+using testutil::Map;
+using testutil::VectorType;
+
+DocumentMap Documents(const std::vector<MutableDocument>& docs) {
+  DocumentMap result;
+  for (const auto& doc : docs) {
+    result = result.insert(doc.key(), doc);
+  }
+  return result;
+}
+
+VectorQuery MakeVectorQuery(std::vector<double> query_vector,
+                            DistanceMeasure measure,
+                            size_t limit) {
+  VectorQuery query;
+  query.field = Field("embedding");
+  query.query_vector = std::move(query_vector);
+  query.distance_measure = measure;
+  query.limit = limit;
+  return query;
+}
+
+std::vector<std::string> Keys(const std::vector<VectorSearchResult>& results) {
+  std::vector<std::string> keys;
+  for (const auto& result : results) {
+    keys.push_back(result.document->key().ToString());
+  }
+  return keys;
+}
+
+const DocumentMap& TestDocuments() {
+  static const DocumentMap documents = Documents({
+      Doc("coll/a", 1, Map("embedding", VectorType(1.0, 0.0))),
+      Doc("coll/b", 1, Map("embedding", VectorType(0.0, 3.0))),
+      Doc("coll/c", 1, Map("embedding", VectorType(2.0, 2.0))),
+      Doc("coll/d", 1, Map("embedding", VectorType(-1.0, 0.0))),
+      Doc("coll/e", 1, Map("embedding", VectorType(1.0, 1.0, 1.0))),
+      Doc("coll/f", 1, Map("embedding", "not a vector")),
+      Doc("coll/g", 1, Map("other", VectorType(1.0, 0.0))),
+  });
+  return documents;
+}
+
+TEST(LocalVectorSearchTest, EuclideanReturnsNearestFirst) {
+  auto results = FindNearest(
+      TestDocuments(), MakeVectorQuery({1, 0}, DistanceMeasure::kEuclidean, 3));
+
+  EXPECT_EQ(Keys(results),
+            (std::vector<std::string>{"coll/a", "coll/d", "coll/c"}));
+  EXPECT_DOUBLE_EQ(results[0].distance, 0);
+  EXPECT_DOUBLE_EQ(results[1].distance, 2);
+}
+
+TEST(LocalVectorSearchTest, CosineIgnoresMagnitude) {
+  auto results = FindNearest(
+      TestDocuments(), MakeVectorQuery({4, 2}, DistanceMeasure::kCosine, 2));
+
+  EXPECT_EQ(Keys(results), (std::vector<std::string>{"coll/c", "coll/a"}));
+}
+
+TEST(LocalVectorSearchTest, DotProductPrefersLargerValues) {
+  auto results =
+      FindNearest(TestDocuments(),
+                  MakeVectorQuery({0, 1}, DistanceMeasure::kDotProduct, 2));
+
+  EXPECT_EQ(Keys(results), (std::vector<std::string>{"coll/b", "coll/c"}));
+  EXPECT_DOUBLE_EQ(results[0].distance, 3);
+}
+
+TEST(LocalVectorSearchTest, AppliesDistanceThreshold) {
+  VectorQuery euclidean =
+      MakeVectorQuery({1, 0}, DistanceMeasure::kEuclidean, 10);
+  euclidean.distance_threshold = 2;
+  EXPECT_EQ(Keys(FindNearest(TestDocuments(), euclidean)),
+            (std::vector<std::string>{"coll/a", "coll/d"}));
+
+  VectorQuery dot_product =
+      MakeVectorQuery({1, 0}, DistanceMeasure::kDotProduct, 10);
+  dot_product.distance_threshold = 1;
+  EXPECT_EQ(Keys(FindNearest(TestDocuments(), dot_product)),
+            (std::vector<std::string>{"coll/c", "coll/a"}));
+}
+
+TEST(LocalVectorSearchTest, SkipsDocumentsWithoutMatchingVectors) {
+  auto results =
+      FindNearest(TestDocuments(),
+                  MakeVectorQuery({1, 1, 1}, DistanceMeasure::kCosine, 10));
+
+  EXPECT_EQ(Keys(results), (std::vector<std::string>{"coll/e"}));
+}
+
+TEST(LocalVectorSearchTest, BreaksTiesByKey) {
+  DocumentMap documents = Documents({
+      Doc("coll/b", 1, Map("embedding", VectorType(0.0, 1.0))),
+      Doc("coll/c", 1, Map("embedding", VectorType(1.0, 0.0))),
+      Doc("coll/a", 1, Map("embedding", VectorType(0.0, -1.0))),
+  });
+  auto results = FindNearest(
+      documents, MakeVectorQuery({0, 0}, DistanceMeasure::kEuclidean, 2));
+
+  EXPECT_EQ(Keys(results), (std::vector<std::string>{"coll/a", "coll/b"}));
+}
+
+TEST(LocalVectorSearchTest, ZeroLimitReturnsNothing) {
+  EXPECT_TRUE(
+      FindNearest(TestDocuments(),
+                  MakeVectorQuery({1, 0}, DistanceMeasure::kEuclidean, 0))
+          .empty());
+}
+
+}  // namespace
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -16,10 +16,18 @@
 
 #include "Firestore/core/test/unit/local/index_manager_test.h"
 
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/core/bound.h"
+#include "Firestore/core/src/core/query.h"
+#include "Firestore/core/src/credentials/user.h"
 #include "Firestore/core/src/local/memory_index_manager.h"
 #include "Firestore/core/src/local/memory_persistence.h"
 #include "Firestore/core/src/local/reference_delegate.h"
+#include "Firestore/core/src/model/field_index.h"
 #include "Firestore/core/test/unit/local/persistence_testing.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
 #include "absl/memory/memory.h"
 #include "gtest/gtest.h"
 
@@ -29,6 +37,20 @@ namespace local {
 
 namespace {
 
+using core::Bound;
+using credentials::User;
+using model::IndexOffset;
+using testutil::Array;
+using testutil::DeletedDoc;
+using testutil::Doc;
+using testutil::Filter;
+using testutil::Key;
+using testutil::MakeFieldIndex;
+using testutil::Map;
+using testutil::OrderBy;
+using testutil::OrFilters;
+using testutil::Query;
+
 std::unique_ptr<Persistence> PersistenceFactory() {
   return MemoryPersistenceWithEagerGcForTesting();
 }
@@ -39,6 +61,251 @@ INSTANTIATE_TEST_SUITE_P(MemoryIndexManagerTest,
                          IndexManagerTest,
                          ::testing::Values(PersistenceFactory));
 
+class MemoryIndexManagerTest : public ::testing::Test {
+ public:
+  MemoryIndexManagerTest() : persistence_{PersistenceFactory()} {
+    index_manager_ = persistence_->GetIndexManager(User::Unauthenticated());
+    index_manager_->Start();
+  }
+
+  void AddDocs(const std::vector<model::MutableDocument>& docs) const {
+    model::DocumentMap map;
+    for (const auto& doc : docs) {
+      map = map.insert(doc.key(), doc);
+    }
+    index_manager_->UpdateIndexEntries(std::move(map));
+  }
+
+  void AddDoc(const std::string& key,
+              nanopb::Message<google_firestore_v1_Value> data) const {
+    AddDocs({Doc(key, 1, std::move(data))});
+  }
+
+  void SetUpSingleValueFilter() const {
+    index_manager_->AddFieldIndex(
+        MakeFieldIndex("coll", "count", model::Segment::kAscending));
+    AddDoc("coll/val1", Map("count", 1));
+    AddDoc("coll/val2", Map("count", 2));
+    AddDoc("coll/val3", Map("count", 3));
+  }
+
+  void VerifyResults(const core::Query& query,
+                     const std::vector<std::string>& documents) const {
+    absl::optional<std::vector<model::DocumentKey>> results =
+        index_manager_->GetDocumentsMatchingTarget(query.ToTarget());
+    ASSERT_TRUE(results.has_value()) << "Target cannot be served from index.";
+    std::vector<model::DocumentKey> expected;
+    for (const auto& key : documents) {
+      expected.push_back(Key(key));
+    }
+    EXPECT_EQ(expected, results.value())
+        << "Query returned unexpected documents.";
+  }
+
+  std::unique_ptr<Persistence> persistence_;
+  IndexManager* index_manager_;
+};
+
+TEST_F(MemoryIndexManagerTest, OrderByKeyFilter) {
+  index_manager_->AddFieldIndex(
+      MakeFieldIndex("coll", "count", model::Segment::kAscending));
+  index_manager_->AddFieldIndex(
+      MakeFieldIndex("coll", "count", model::Segment::kDescending));
+  AddDoc("coll/val1", Map("count", 1));
+  AddDoc("coll/val2", Map("count", 1));
+  AddDoc("coll/val3", Map("count", 3));
+
+  {
+    SCOPED_TRACE("Verifying OrderByKey ASC");
+    auto query = Query("coll").AddingOrderBy(OrderBy("count"));
+    VerifyResults(query, {"coll/val1", "coll/val2", "coll/val3"});
+  }
+
+  {
+    SCOPED_TRACE("Verifying OrderByKey DESC");
+    auto query = Query("coll").AddingOrderBy(OrderBy("count", "desc"));
+    VerifyResults(query, {"coll/val3", "coll/val2", "coll/val1"});
+  }
+}
+
+TEST_F(MemoryIndexManagerTest, RangeWithBoundFilter) {
+  SetUpSingleValueFilter();
+  auto query =
+      Query("coll")
+          .AddingFilter(Filter("count", ">=", 1))
+          .AddingFilter(Filter("count", "<=", 3))
+          .AddingOrderBy(OrderBy("count"))
+          .StartingAt(Bound::FromValue(Array(1), /* inclusive= */ false))
+          .EndingAt(Bound::FromValue(Array(2), /* inclusive= */ true));
+  VerifyResults(query, {"coll/val2"});
+}
+
+TEST_F(MemoryIndexManagerTest, InAndNotInFilters) {
+  SetUpSingleValueFilter();
+  VerifyResults(Query("coll").AddingFilter(Filter("count", "in", Array(1, 3))),
+                {"coll/val1", "coll/val3"});
+  VerifyResults(
+      Query("coll").AddingFilter(Filter("count", "not-in", Array(1, 2))),
+      {"coll/val3"});
+}
+
+TEST_F(MemoryIndexManagerTest, EmptyRangeReturnsNoDocuments) {
+  SetUpSingleValueFilter();
+  auto query = Query("coll")
+                   .AddingFilter(Filter("count", ">", 2))
+                   .AddingFilter(Filter("count", "<", 2));
+  VerifyResults(query, {});
+}
+
+TEST_F(MemoryIndexManagerTest, ArrayContainsFilter) {
+  index_manager_->AddFieldIndex(
+      MakeFieldIndex("coll", "values", model::Segment::kContains));
+  AddDoc("coll/arr1", Map("values", Array(1, 2, 3)));
+  AddDoc("coll/arr2", Map("values", Array(4, 5, 6)));
+  AddDoc("coll/arr3", Map("values", Array(7, 8, 9)));
+  VerifyResults(Query("coll").AddingFilter(
+                    Filter("values", "array-contains-any", Array(1, 7))),
+                {"coll/arr1", "coll/arr3"});
+}
+
+TEST_F(MemoryIndexManagerTest, LimitAppliesOrdering) {
+  index_manager_->AddFieldIndex(
+      MakeFieldIndex("coll", "value", model::Segment::kContains, "value",
+                     model::Segment::kAscending));
+  AddDoc("coll/doc1", Map("value", Array(1, "foo")));
+  AddDoc("coll/doc2", Map("value", Array(3, "foo")));
+  AddDoc("coll/doc3", Map("value", Array(2, "foo")));
+  auto query = Query("coll")
+                   .AddingFilter(Filter("value", "array-contains", "foo"))
+                   .AddingOrderBy(OrderBy("value"))
+                   .WithLimitToFirst(2);
+  VerifyResults(query, {"coll/doc1", "coll/doc3"});
+}
+
+TEST_F(MemoryIndexManagerTest, IndexEntriesAreUpdated) {
+  index_manager_->AddFieldIndex(
+      MakeFieldIndex("coll", "value", model::Segment::kAscending));
+  auto query = Query("coll").AddingOrderBy(OrderBy("value"));
+
+  AddDoc("coll/doc1", Map("value", 2));
+  AddDoc("coll/doc2", Map("value", 1));
+  VerifyResults(query, {"coll/doc2", "coll/doc1"});
+
+  AddDoc("coll/doc2", Map("value", 3));
+  VerifyResults(query, {"coll/doc1", "coll/doc2"});
+
+  AddDocs({DeletedDoc("coll/doc1", 2)});
+  VerifyResults(query, {"coll/doc2"});
+}
+
+TEST_F(MemoryIndexManagerTest, OrQueryUsesIndexPerTerm) {
+  index_manager_->AddFieldIndex(
+      MakeFieldIndex("coll", "a", model::Segment::kAscending));
+  index_manager_->AddFieldIndex(
+      MakeFieldIndex("coll", "b", model::Segment::kAscending));
+  AddDoc("coll/doc1", Map("a", 1, "b", 0));
+  AddDoc("coll/doc2", Map("a", 2, "b", 1));
+  AddDoc("coll/doc3", Map("a", 3, "b", 2));
+
+  auto query = Query("coll").AddingFilter(
+      OrFilters({Filter("a", "==", 1), Filter("b", "==", 1)}));
+  EXPECT_EQ(index_manager_->GetIndexType(query.ToTarget()),
+            IndexManager::IndexType::FULL);
+  VerifyResults(query, {"coll/doc1", "coll/doc2"});
+
+  auto unindexed = Query("coll").AddingFilter(
+      OrFilters({Filter("a", "==", 1), Filter("c", "==", 1)}));
+  EXPECT_EQ(index_manager_->GetIndexType(unindexed.ToTarget()),
+            IndexManager::IndexType::NONE);
+  EXPECT_EQ(index_manager_->GetDocumentsMatchingTarget(unindexed.ToTarget()),
+            absl::nullopt);
+}
+
+TEST_F(MemoryIndexManagerTest, CreateTargetIndexes) {
+  auto query = Query("coll").AddingFilter(Filter("a", "==", 1));
+  EXPECT_EQ(index_manager_->GetIndexType(query.ToTarget()),
+            IndexManager::IndexType::NONE);
+
+  index_manager_->CreateTargetIndexes(query.ToTarget());
+  EXPECT_EQ(index_manager_->GetIndexType(query.ToTarget()),
+            IndexManager::IndexType::FULL);
+  EXPECT_EQ(index_manager_->GetFieldIndexes("coll").size(), 1u);
+}
+
+TEST_F(MemoryIndexManagerTest, DeleteFieldIndexRemovesEntries) {
+  SetUpSingleValueFilter();
+  auto query = Query("coll").AddingFilter(Filter("count", "==", 2));
+  VerifyResults(query, {"coll/val2"});
+
+  index_manager_->DeleteFieldIndex(index_manager_->GetFieldIndexes("coll")[0]);
+  EXPECT_TRUE(index_manager_->GetFieldIndexes().empty());
+  EXPECT_EQ(index_manager_->GetDocumentsMatchingTarget(query.ToTarget()),
+            absl::nullopt);
+}
+
+TEST_F(MemoryIndexManagerTest,
+       NextCollectionGroupAdvancesWhenCollectionIsUpdated) {
+  EXPECT_EQ(index_manager_->GetNextCollectionGroupToUpdate(), absl::nullopt);
+
+  index_manager_->AddFieldIndex(MakeFieldIndex("coll1"));
+  index_manager_->AddFieldIndex(MakeFieldIndex("coll2"));
+  EXPECT_EQ(index_manager_->GetNextCollectionGroupToUpdate(), "coll1");
+
+  IndexOffset offset{testutil::Version(20), Key("coll1/doc"), 42};
+  index_manager_->UpdateCollectionGroup("coll1", offset);
+  EXPECT_EQ(index_manager_->GetNextCollectionGroupToUpdate(), "coll2");
+  EXPECT_EQ(index_manager_->GetMinOffset("coll1").CompareTo(offset),
+            util::ComparisonResult::Same);
+
+  index_manager_->UpdateCollectionGroup("coll2", IndexOffset::None());
+  EXPECT_EQ(index_manager_->GetNextCollectionGroupToUpdate(), "coll1");
+}
+
+TEST_F(MemoryIndexManagerTest, CanChangeUser) {
+  SetUpSingleValueFilter();
+  index_manager_->AddToCollectionParentIndex(testutil::Resource("coll/a/sub"));
+  IndexOffset offset{testutil::Version(20), Key("coll/val3"), 3};
+  index_manager_->UpdateCollectionGroup("coll", offset);
+  auto query = Query("coll").AddingFilter(Filter("count", "==", 2));
+
+  // A new user sees the existing field indexes in their initial state, but
+  // none of the entries. The collection-parent index is shared.
+  index_manager_ = persistence_->GetIndexManager(User("authenticated"));
+  index_manager_->Start();
+  std::vector<model::FieldIndex> indexes =
+      index_manager_->GetFieldIndexes("coll");
+  ASSERT_EQ(indexes.size(), 1u);
+  EXPECT_EQ(indexes[0].index_state().sequence_number(), 0);
+  EXPECT_EQ(index_manager_->GetMinOffset("coll").CompareTo(
+                IndexOffset::None()),
+            util::ComparisonResult::Same);
+  VerifyResults(query, {});
+  EXPECT_EQ(index_manager_->GetCollectionParents("sub"),
+            std::vector<model::ResourcePath>{testutil::Resource("coll/a")});
+
+  index_manager_->AddFieldIndex(MakeFieldIndex("coll2"));
+  AddDoc("coll/val4", Map("count", 2));
+  VerifyResults(query, {"coll/val4"});
+
+  // The original user keeps its entries and state, and sees the new index.
+  index_manager_ = persistence_->GetIndexManager(User::Unauthenticated());
+  index_manager_->Start();
+  EXPECT_EQ(index_manager_->GetFieldIndexes().size(), 2u);
+  EXPECT_EQ(index_manager_->GetMinOffset("coll").CompareTo(offset),
+            util::ComparisonResult::Same);
+  EXPECT_EQ(index_manager_->GetFieldIndexes("coll2")[0]
+                .index_state()
+                .sequence_number(),
+            0);
+  VerifyResults(query, {"coll/val2"});
+
+  // Deleting an index removes it for every user.
+  index_manager_->DeleteFieldIndex(index_manager_->GetFieldIndexes("coll2")[0]);
+  index_manager_ = persistence_->GetIndexManager(User("authenticated"));
+  index_manager_->Start();
+  EXPECT_TRUE(index_manager_->GetFieldIndexes("coll2").empty());
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
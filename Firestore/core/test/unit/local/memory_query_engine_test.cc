@@ -14,9 +14,16 @@
  * limitations under the License.
  */
 
+#include <vector>
+
+#include "Firestore/core/src/core/query.h"
 #include "Firestore/core/src/local/memory_persistence.h"
+#include "Firestore/core/src/model/document_set.h"
+#include "Firestore/core/src/model/field_index.h"
+#include "Firestore/core/src/model/mutable_document.h"
 #include "Firestore/core/test/unit/local/persistence_testing.h"
 #include "Firestore/core/test/unit/local/query_engine_test.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
 #include "gtest/gtest.h"
 
 namespace firebase {
@@ -24,16 +31,96 @@ namespace firestore {
 namespace local {
 namespace {
 
+using model::DocumentSet;
+using model::SnapshotVersion;
+using testutil::Doc;
+using testutil::DocSet;
+using testutil::Filter;
+using testutil::MakeFieldIndex;
+using testutil::Map;
+using testutil::OrderBy;
+using testutil::Query;
+using testutil::SetMutation;
+
 std::unique_ptr<Persistence> PersistenceFactory() {
   return MemoryPersistenceWithEagerGcForTesting();
 }
 
+model::DocumentMap DocumentMap(
+    const std::vector<model::MutableDocument>& docs) {
+  model::DocumentMap doc_map;
+  for (const auto& doc : docs) {
+    doc_map = doc_map.insert(doc.key(), doc);
+  }
+  return doc_map;
+}
+
 }  // namespace
 
 INSTANTIATE_TEST_SUITE_P(MemoryQueryEngineTest,
                          QueryEngineTest,
                          testing::Values(PersistenceFactory));
 
+class MemoryQueryEngineTest : public QueryEngineTestBase {
+ public:
+  MemoryQueryEngineTest() : QueryEngineTestBase(PersistenceFactory()) {
+  }
+};
+
+TEST_F(MemoryQueryEngineTest, CombinesIndexedWithNonIndexedResults) {
+  persistence_->Run("CombinesIndexedWithNonIndexedResults", [&] {
+    mutation_queue_->Start();
+    index_manager_->Start();
+
+    auto doc1 = Doc("coll/a", 1, Map("foo", true));
+    auto doc2 = Doc("coll/b", 2, Map("foo", true));
+    auto doc3 = Doc("coll/c", 3, Map("foo", true));
+    auto doc4 = Doc("coll/d", 3, Map("foo", true)).SetHasLocalMutations();
+
+    index_manager_->AddFieldIndex(
+        MakeFieldIndex("coll", "foo", model::Segment::kAscending));
+
+    AddDocuments({doc1, doc2});
+    index_manager_->UpdateIndexEntries(DocumentMap({doc1, doc2}));
+    index_manager_->UpdateCollectionGroup(
+        "coll", model::IndexOffset::FromDocument(doc2));
+
+    AddDocuments({doc3});
+    AddMutation(SetMutation("coll/d", Map("foo", true)));
+
+    core::Query query = Query("coll").AddingFilter(Filter("foo", "==", true));
+
+    DocumentSet docs = ExpectOptimizedCollectionScan(
+        [&] { return RunQuery(query, SnapshotVersion::None()); });
+    EXPECT_EQ(docs, DocSet(query.Comparator(), {doc1, doc2, doc3, doc4}));
+  });
+}
+
+TEST_F(MemoryQueryEngineTest, UsesIndexForLimitQueries) {
+  persistence_->Run("UsesIndexForLimitQueries", [&] {
+    mutation_queue_->Start();
+    index_manager_->Start();
+
+    auto doc1 = Doc("coll/1", 1, Map("a", 3));
+    auto doc2 = Doc("coll/2", 1, Map("a", 1));
+    auto doc3 = Doc("coll/3", 1, Map("a", 2));
+    AddDocuments({doc1, doc2, doc3});
+
+    index_manager_->AddFieldIndex(
+        MakeFieldIndex("coll", "a", model::Segment::kAscending));
+    index_manager_->UpdateIndexEntries(DocumentMap({doc1, doc2, doc3}));
+    index_manager_->UpdateCollectionGroup(
+        "coll", model::IndexOffset::FromDocument(doc3));
+
+    core::Query query =
+        Query("coll").AddingOrderBy(OrderBy("a")).WithLimitToFirst(2);
+
+    DocumentSet docs = ExpectOptimizedCollectionScan(
+        [&] { return RunQuery(query, SnapshotVersion::None()); });
+    EXPECT_EQ(docs, DocSet(query.Comparator(), {doc2, doc3}));
+  });
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
@@ -0,0 +1,185 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/core/query.h"
+#include "Firestore/core/src/credentials/user.h"
+#include "Firestore/core/src/local/local_store.h"
+#include "Firestore/core/src/local/memory_persistence.h"
+#include "Firestore/core/src/local/query_engine.h"
+#include "Firestore/core/src/local/query_result.h"
+#include "Firestore/core/src/model/document_key.h"
+#include "Firestore/core/src/model/field_index.h"
+#include "Firestore/core/src/model/mutable_document.h"
+#include "Firestore/core/test/unit/local/persistence_testing.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace {
+
+// Counts heap allocations made by the benchmarked code, so that the results
+// show whether reads copy document contents.
+std::atomic<size_t> allocation_count{0};
+
+}  // namespace
+
+void* operator new(std::size_t size) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  if (void* ptr = std::malloc(size == 0 ? 1 : size)) return ptr;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
+
+namespace firebase {
+namespace firestore {
+namespace local {
+namespace {
+
+using credentials::User;
+using model::DocumentKey;
+using model::IndexOffset;
+using model::MutableDocument;
+
+/** Creates a document whose contents resemble a typical user profile. */
+MutableDocument MakeDocument(int index) {
+  return testutil::Doc(
+      absl::StrCat("coll/doc", index), 1,
+      testutil::Map(
+          "name", absl::StrCat("user", index), "email",
+          absl::StrCat("user", index, "@example.com"), "age", index % 100,
+          "active", index % 2 == 0, "tags",
+          testutil::Array("alpha", "beta", "gamma", "delta"), "address",
+          testutil::Map("street", "1600 Amphitheatre Parkway", "city",
+                        "Mountain View", "zip", "94043"),
+          "stats",
+          testutil::Map("followers", index * 3, "following", index * 2,
+                        "posts", index % 50)));
+}
+
+std::vector<DocumentKey> PopulateCache(MemoryPersistence* persistence,
+                                       int num_docs) {
+  std::vector<DocumentKey> keys;
+  persistence->remote_document_cache()->SetIndexManager(
+      persistence->GetIndexManager(User::Unauthenticated()));
+  persistence->Run("PopulateCache", [&] {
+    for (int i = 0; i < num_docs; ++i) {
+      MutableDocument doc = MakeDocument(i);
+      keys.push_back(doc.key());
+      persistence->remote_document_cache()->Add(doc, testutil::Version(1));
+    }
+  });
+  return keys;
+}
+
+void ReportAllocations(benchmark::State& state,
+                       size_t allocations,
+                       int num_docs) {
+  state.counters["allocs_per_doc"] = benchmark::Counter(
+      static_cast<double>(allocations) /
+      static_cast<double>(state.iterations() * num_docs));
+  state.SetItemsProcessed(state.iterations() * num_docs);
+}
+
+/** Looks up every document of the collection by key. */
+void BM_MemoryCacheGet(benchmark::State& state) {
+  int num_docs = static_cast<int>(state.range(0));
+  std::unique_ptr<MemoryPersistence> persistence =
+      MemoryPersistenceWithEagerGcForTesting();
+  std::vector<DocumentKey> keys = PopulateCache(persistence.get(), num_docs);
+  RemoteDocumentCache* cache = persistence->remote_document_cache();
+
+  size_t allocations_before = allocation_count.load();
+  for (auto _ : state) {
+    for (const DocumentKey& key : keys) {
+      MutableDocument doc = cache->Get(key);
+      benchmark::DoNotOptimize(doc.data());
+    }
+  }
+  ReportAllocations(state, allocation_count.load() - allocations_before,
+                    num_docs);
+}
+BENCHMARK(BM_MemoryCacheGet)->Arg(1000)->Arg(10000)->Arg(100000);
+
+/** Reads the whole collection with a collection query. */
+void BM_MemoryCacheCollectionQuery(benchmark::State& state) {
+  int num_docs = static_cast<int>(state.range(0));
+  std::unique_ptr<MemoryPersistence> persistence =
+      MemoryPersistenceWithEagerGcForTesting();
+  PopulateCache(persistence.get(), num_docs);
+  RemoteDocumentCache* cache = persistence->remote_document_cache();
+  core::Query query = testutil::Query("coll");
+
+  size_t allocations_before = allocation_count.load();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        cache->GetDocumentsMatchingQuery(query, IndexOffset::None()));
+  }
+  ReportAllocations(state, allocation_count.load() - allocations_before,
+                    num_docs);
+}
+BENCHMARK(BM_MemoryCacheCollectionQuery)
+    ->Arg(1000)
+    ->Arg(10000)
+    ->Arg(100000)
+    ->Unit(benchmark::kMillisecond);
+
+/**
+ * Runs a collection query through LocalStore, which reads the documents via
+ * LocalDocumentsView.
+ */
+void BM_LocalStoreExecuteQuery(benchmark::State& state) {
+  int num_docs = static_cast<int>(state.range(0));
+  std::unique_ptr<MemoryPersistence> persistence =
+      MemoryPersistenceWithEagerGcForTesting();
+  QueryEngine query_engine;
+  LocalStore local_store(persistence.get(), &query_engine,
+                         User::Unauthenticated());
+  local_store.Start();
+  PopulateCache(persistence.get(), num_docs);
+  core::Query query = testutil::Query("coll");
+
+  size_t allocations_before = allocation_count.load();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        local_store.ExecuteQuery(query, /* use_previous_results= */ false));
+  }
+  ReportAllocations(state, allocation_count.load() - allocations_before,
+                    num_docs);
+}
+BENCHMARK(BM_LocalStoreExecuteQuery)
+    ->Arg(1000)
+    ->Arg(10000)
+    ->Arg(100000)
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -19,10 +19,12 @@
 #include <memory>
 
 #include "Firestore/core/src/local/memory_persistence.h"
+#include "Firestore/core/src/local/proto_sizer.h"
 #include "Firestore/core/src/local/reference_delegate.h"
 #include "Firestore/core/src/local/remote_document_cache.h"
 #include "Firestore/core/test/unit/local/persistence_testing.h"
 #include "Firestore/core/test/unit/local/remote_document_cache_test.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
 #include "absl/memory/memory.h"
 #include "gtest/gtest.h"
 
@@ -31,6 +33,11 @@ namespace firestore {
 namespace local {
 namespace {
 
+using model::MutableDocument;
+using testutil::Doc;
+using testutil::Map;
+using testutil::Version;
+
 std::unique_ptr<Persistence> PersistenceFactory() {
   return MemoryPersistenceWithEagerGcForTesting();
 }
@@ -41,6 +48,38 @@ INSTANTIATE_TEST_SUITE_P(MemoryRemoteDocumentCacheTest,
                          RemoteDocumentCacheTest,
                          testing::Values(PersistenceFactory));
 
+TEST(MemoryRemoteDocumentCacheTest, CalculateByteSizeTracksChanges) {
+  std::unique_ptr<MemoryPersistence> persistence =
+      MemoryPersistenceWithEagerGcForTesting();
+  ProtoSizer sizer(MakeLocalSerializer());
+
+  persistence->Run("CalculateByteSizeTracksChanges", [&] {
+    MemoryRemoteDocumentCache* cache = persistence->remote_document_cache();
+    MutableDocument small = Doc("coll/a", 1, Map("a", 1));
+    MutableDocument large = Doc("coll/a", 2, Map("a", "a longer value"));
+    MutableDocument other = Doc("coll/b", 1, Map("b", 2));
+
+    cache->Add(small, Version(1));
+    EXPECT_EQ(cache->CalculateByteSize(sizer),
+              sizer.CalculateByteSize(cache->Get(small.key())));
+
+    cache->Add(other, Version(1));
+    int64_t both = cache->CalculateByteSize(sizer);
+    EXPECT_EQ(both, sizer.CalculateByteSize(cache->Get(small.key())) +
+                        sizer.CalculateByteSize(cache->Get(other.key())));
+
+    cache->Add(large, Version(2));
+    EXPECT_GT(cache->CalculateByteSize(sizer), both);
+
+    cache->Remove(large.key());
+    EXPECT_EQ(cache->CalculateByteSize(sizer),
+              sizer.CalculateByteSize(cache->Get(other.key())));
+
+    cache->Remove(other.key());
+    EXPECT_EQ(cache->CalculateByteSize(sizer), 0);
+  });
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
@@ -0,0 +1,237 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/credentials/user.h"
+#include "Firestore/core/src/local/leveldb_key.h"
+#include "Firestore/core/src/local/leveldb_persistence.h"
+#include "Firestore/core/src/local/leveldb_remote_document_cache.h"
+#include "Firestore/core/src/local/leveldb_transaction.h"
+#include "Firestore/core/src/model/mutable_document.h"
+#include "Firestore/core/src/model/resource_path.h"
+#include "Firestore/core/src/util/string_util.h"
+#include "Firestore/core/test/unit/local/persistence_testing.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+namespace {
+
+using model::MutableDocument;
+using model::ResourcePath;
+
+// Benchmarks compare the legacy remote_document_read_time format, which
+// repeats every collection path segment, with the compact read_time format,
+// which refers to collections by interned ID.
+enum Format { kLegacy = 0, kCompact = 1 };
+
+ResourcePath DeepCollection(int index) {
+  return testutil::Resource(
+      absl::StrCat("tenants/tenant", index, "/projects/project", index,
+                   "/items/item", index, "/revisions"));
+}
+
+std::string ReadTimeKey(Format format,
+                        int collection,
+                        int64_t version,
+                        const std::string& document_id) {
+  if (format == kLegacy) {
+    return LevelDbRemoteDocumentReadTimeKey::Key(
+        DeepCollection(collection), testutil::Version(version), document_id);
+  }
+  return LevelDbRemoteDocumentCompactReadTimeKey::Key(
+      collection + 1, testutil::Version(version), document_id);
+}
+
+std::string ReadTimeKeyPrefix(Format format, int collection, int64_t version) {
+  if (format == kLegacy) {
+    return LevelDbRemoteDocumentReadTimeKey::KeyPrefix(
+        DeepCollection(collection), testutil::Version(version));
+  }
+  return LevelDbRemoteDocumentCompactReadTimeKey::KeyPrefix(
+      collection + 1, testutil::Version(version));
+}
+
+void BM_EncodeReadTimeKey(benchmark::State& state) {
+  auto format = static_cast<Format>(state.range(0));
+  size_t key_bytes = 0;
+  int64_t version = 0;
+  for (auto _ : state) {
+    std::string key = ReadTimeKey(format, 7, ++version, "document-id");
+    key_bytes = key.size();
+    benchmark::DoNotOptimize(key);
+  }
+  state.counters["key_bytes"] = static_cast<double>(key_bytes);
+}
+BENCHMARK(BM_EncodeReadTimeKey)->Arg(kLegacy)->Arg(kCompact);
+
+/**
+ * Fills an index in the given format with `num_docs` documents spread across
+ * `num_collections` deep collections, and then measures a seek to a read time
+ * offset in a collection followed by a scan of the rest of that collection.
+ */
+void BM_SeekReadTimeIndex(benchmark::State& state) {
+  auto format = static_cast<Format>(state.range(0));
+  int num_collections = static_cast<int>(state.range(1));
+  int num_docs = static_cast<int>(state.range(2));
+  int docs_per_collection = num_docs / num_collections;
+
+  std::unique_ptr<LevelDbPersistence> persistence =
+      LevelDbPersistenceForTesting();
+
+  size_t index_bytes = 0;
+  persistence->Run("Fill read time index", [&] {
+    LevelDbTransaction* transaction = persistence->current_transaction();
+    for (int c = 0; c < num_collections; ++c) {
+      for (int d = 0; d < docs_per_collection; ++d) {
+        std::string key = ReadTimeKey(format, c, d + 1, absl::StrCat("doc", d));
+        index_bytes += key.size();
+        transaction->Put(std::move(key), "");
+      }
+    }
+  });
+
+  int collection = 0;
+  for (auto _ : state) {
+    persistence->Run("Seek read time index", [&] {
+      // Start halfway through the collection's read times and decode every
+      // row up to the end of the collection, like a query with an offset.
+      std::string start =
+          ReadTimeKeyPrefix(format, collection, docs_per_collection / 2);
+      auto it = persistence->current_transaction()->NewIterator();
+      it->Seek(util::ImmediateSuccessor(start));
+
+      int64_t rows = 0;
+      if (format == kLegacy) {
+        ResourcePath path = DeepCollection(collection);
+        LevelDbRemoteDocumentReadTimeKey key;
+        for (; it->Valid() && key.Decode(it->key()) &&
+               key.collection_path() == path;
+             it->Next()) {
+          ++rows;
+        }
+      } else {
+        LevelDbRemoteDocumentCompactReadTimeKey key;
+        for (; it->Valid() && key.Decode(it->key()) &&
+               key.collection_path_id() == collection + 1;
+             it->Next()) {
+          ++rows;
+        }
+      }
+      benchmark::DoNotOptimize(rows);
+    });
+    collection = (collection + 1) % num_collections;
+  }
+  state.counters["index_bytes"] = static_cast<double>(index_bytes);
+}
+BENCHMARK(BM_SeekReadTimeIndex)
+    ->Args({kLegacy, 10, 10000})
+    ->Args({kCompact, 10, 10000})
+    ->Args({kLegacy, 1000, 100000})
+    ->Args({kCompact, 1000, 100000});
+
+// What the remote document cache writes: both read time indexes by default,
+// or only the compact one once compact documents are enabled.
+enum Indexes { kBothIndexes = 0, kCompactIndexOnly = 1 };
+
+/** Returns the total size of the keys and values of the rows with `prefix`. */
+size_t TableBytes(LevelDbTransaction* transaction, const std::string& prefix) {
+  size_t bytes = 0;
+  auto it = transaction->NewIterator();
+  for (it->Seek(prefix); it->Valid() && absl::StartsWith(it->key(), prefix);
+       it->Next()) {
+    bytes += it->key().size() + it->value().size();
+  }
+  return bytes;
+}
+
+/**
+ * Measures `AddAll` of `num_docs` documents spread across `num_collections`
+ * deep collections, as a remote event updating all of them would. The
+ * counters describe the database after one such write: `db_bytes` covers
+ * every row, and the index counters cover each read time index.
+ *
+ * With both indexes, the legacy-only layout that older SDKs write would be
+ * smaller by `compact_index_bytes`. In the compact-only case, documents are
+ * also written in the compact format.
+ */
+void BM_AddDocuments(benchmark::State& state) {
+  auto indexes = static_cast<Indexes>(state.range(0));
+  int num_collections = static_cast<int>(state.range(1));
+  int num_docs = static_cast<int>(state.range(2));
+
+  std::unique_ptr<LevelDbPersistence> persistence =
+      LevelDbPersistenceForTesting();
+  LevelDbRemoteDocumentCache* cache = persistence->remote_document_cache();
+  cache->SetIndexManager(
+      persistence->GetIndexManager(credentials::User::Unauthenticated()));
+  cache->SetCompactDocumentsEnabled(indexes == kCompactIndexOnly);
+
+  std::vector<MutableDocument> documents;
+  documents.reserve(num_docs);
+  for (int d = 0; d < num_docs; ++d) {
+    ResourcePath path =
+        DeepCollection(d % num_collections).Append(absl::StrCat("doc", d));
+    documents.push_back(
+        testutil::Doc(path.CanonicalString(), 1, testutil::Map("index", d)));
+  }
+
+  int64_t version = 1;
+  size_t db_bytes = 0;
+  size_t legacy_index_bytes = 0;
+  size_t compact_index_bytes = 0;
+  persistence->Run("Measure database", [&] {
+    cache->AddAll(documents, testutil::Version(version));
+    LevelDbTransaction* transaction = persistence->current_transaction();
+    db_bytes = TableBytes(transaction, "");
+    legacy_index_bytes = TableBytes(
+        transaction, LevelDbRemoteDocumentReadTimeKey::KeyPrefix());
+    compact_index_bytes = TableBytes(
+        transaction, LevelDbRemoteDocumentCompactReadTimeKey::KeyPrefix());
+  });
+
+  for (auto _ : state) {
+    persistence->Run("Add documents", [&] {
+      cache->AddAll(documents, testutil::Version(++version));
+    });
+  }
+  state.counters["db_bytes"] = static_cast<double>(db_bytes);
+  state.counters["legacy_index_bytes"] =
+      static_cast<double>(legacy_index_bytes);
+  state.counters["compact_index_bytes"] =
+      static_cast<double>(compact_index_bytes);
+  state.SetItemsProcessed(state.iterations() * num_docs);
+}
+BENCHMARK(BM_AddDocuments)
+    ->Args({kBothIndexes, 10, 10000})
+    ->Args({kCompactIndexOnly, 10, 10000})
+    ->Args({kBothIndexes, 1000, 10000})
+    ->Args({kCompactIndexOnly, 1000, 10000})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
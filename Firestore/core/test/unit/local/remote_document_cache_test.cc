@@ -153,6 +153,38 @@ TEST_P(RemoteDocumentCacheTest,
       });
 }
 
+TEST_P(RemoteDocumentCacheTest, AddAllDocuments) {
+  persistence_->Run("test_add_all_documents", [&] {
+    SetTestDocument("b/old", /* updateTime= */ 1, /* readTime= */ 11);
+
+    std::vector<MutableDocument> written = {
+        Doc("b/1", kVersion, Map("a", 1)),
+        Doc("b/1/z/1", kVersion, Map("a", 2)),
+        Doc("b/2", kVersion, Map("a", 3)),
+        DeletedDoc("b/3", kVersion),
+        Doc("c/1", kVersion, Map("a", 4)),
+    };
+    cache_->AddAll(written, Version(12));
+
+    MutableDocumentMap read = cache_->GetAll(DocumentKeySet{
+        Key("b/1"), Key("b/1/z/1"), Key("b/2"), Key("b/3"), Key("c/1")});
+    EXPECT_THAT(read, HasExactlyDocs(written));
+
+    MutableDocumentMap results = cache_->GetDocumentsMatchingQuery(
+        Query("b"), model::IndexOffset::CreateSuccessor(Version(11)));
+    std::vector<MutableDocument> docs = {
+        Doc("b/1", kVersion, Map("a", 1)),
+        Doc("b/2", kVersion, Map("a", 3)),
+    };
+    EXPECT_THAT(results, HasExactlyDocs(docs));
+
+    std::vector<model::ResourcePath> parents =
+        index_manager_->GetCollectionParents("z");
+    ASSERT_EQ(parents.size(), 1u);
+    EXPECT_EQ(parents[0].CanonicalString(), "b/1");
+  });
+}
+
 TEST_P(RemoteDocumentCacheTest, SetAndReadADocumentAtDeepPath) {
   SetAndReadTestDocument(kLongDocPath);
 }
@@ -287,6 +319,49 @@ TEST_P(RemoteDocumentCacheTest, DocumentsMatchingRespectsMutatedDocs) {
   });
 }
 
+TEST_P(RemoteDocumentCacheTest, GetAllForCollectionGroupUsesReadTimeOrder) {
+  persistence_->Run("test_get_all_for_collection_group", [&] {
+    SetTestDocument("a/1/c/x", /* update_time= */ 1, /* read_time= */ 3);
+    SetTestDocument("b/1/c/y", /* update_time= */ 1, /* read_time= */ 2);
+    SetTestDocument("b/1/c/z", /* update_time= */ 1, /* read_time= */ 1);
+    SetTestDocument("b/1/d/w", /* update_time= */ 1, /* read_time= */ 1);
+
+    MutableDocumentMap results =
+        cache_->GetAll("c", model::IndexOffset::None(), /* limit= */ 2);
+    std::vector<MutableDocument> docs = {
+        Doc("a/1/c/x", 1, Map("a", 1, "b", 2)),
+        Doc("b/1/c/z", 1, Map("a", 1, "b", 2)),
+    };
+    EXPECT_THAT(results, HasExactlyDocs(docs));
+
+    results = cache_->GetAll(
+        "c", model::IndexOffset::CreateSuccessor(Version(1)), /* limit= */ 5);
+    docs = {
+        Doc("a/1/c/x", 1, Map("a", 1, "b", 2)),
+        Doc("b/1/c/y", 1, Map("a", 1, "b", 2)),
+    };
+    EXPECT_THAT(results, HasExactlyDocs(docs));
+  });
+}
+
+TEST_P(RemoteDocumentCacheTest, DocumentsMatchingSinceReadTimeAfterUpdate) {
+  persistence_->Run(
+      "test_documents_matching_since_read_time_after_update", [&] {
+        SetTestDocument("b/1", /* update_time= */ 1, /* read_time= */ 1);
+        SetTestDocument("b/2", /* update_time= */ 1, /* read_time= */ 2);
+        SetTestDocument("b/1", /* update_time= */ 3, /* read_time= */ 3);
+        cache_->Remove(Key("b/2"));
+
+        core::Query query = Query("b");
+        MutableDocumentMap results = cache_->GetDocumentsMatchingQuery(
+            query, model::IndexOffset::CreateSuccessor(Version(1)));
+        std::vector<MutableDocument> docs = {
+            Doc("b/1", 3, Map("a", 1, "b", 2)),
+        };
+        EXPECT_THAT(results, HasExactlyDocs(docs));
+      });
+}
+
 TEST_P(RemoteDocumentCacheTest, DoesNotApplyDocumentModificationsToCache) {
   // This test verifies that the MemoryMutationCache returns copies of all
   // data to ensure that the documents in the cache cannot be modified.
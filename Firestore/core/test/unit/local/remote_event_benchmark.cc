@@ -0,0 +1,164 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/credentials/user.h"
+#include "Firestore/core/src/local/leveldb_persistence.h"
+#include "Firestore/core/src/local/local_store.h"
+#include "Firestore/core/src/local/query_engine.h"
+#include "Firestore/core/src/local/target_data.h"
+#include "Firestore/core/src/model/document_key_set.h"
+#include "Firestore/core/src/model/mutable_document.h"
+#include "Firestore/core/src/remote/remote_event.h"
+#include "Firestore/core/test/unit/local/persistence_testing.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+namespace {
+
+using credentials::User;
+using model::DocumentKeySet;
+using model::DocumentUpdateMap;
+using model::TargetId;
+using remote::RemoteEvent;
+using remote::TargetChange;
+
+/**
+ * Builds a remote event that resembles a large snapshot recorded from the
+ * watch stream: one target per collection, with `num_docs` documents spread
+ * evenly across them. Every document is updated to `version`.
+ */
+RemoteEvent MakeRemoteEvent(const std::vector<TargetId>& target_ids,
+                            int num_docs,
+                            int64_t version) {
+  RemoteEvent::TargetChangeMap target_changes;
+  DocumentUpdateMap document_updates;
+
+  int docs_per_target = num_docs / static_cast<int>(target_ids.size());
+  for (size_t t = 0; t < target_ids.size(); ++t) {
+    DocumentKeySet keys;
+    for (int i = 0; i < docs_per_target; ++i) {
+      std::string path = absl::StrCat("coll", t, "/doc", i);
+      model::MutableDocument doc = testutil::Doc(
+          path, version, testutil::Map("index", i, "version", version));
+      keys = keys.insert(doc.key());
+      document_updates.emplace(doc.key(), std::move(doc));
+    }
+
+    DocumentKeySet added = version == 1 ? keys : DocumentKeySet{};
+    DocumentKeySet modified = version == 1 ? DocumentKeySet{} : keys;
+    target_changes[target_ids[t]] =
+        TargetChange(testutil::ResumeToken(version), /*current=*/true,
+                     std::move(added), std::move(modified), DocumentKeySet{});
+  }
+
+  return RemoteEvent(testutil::Version(version), std::move(target_changes),
+                     RemoteEvent::TargetMismatchMap{},
+                     std::move(document_updates), DocumentKeySet{});
+}
+
+/**
+ * Replays a sequence of large remote events against a LevelDB-backed
+ * LocalStore. The first event adds every document to its target; each
+ * following event modifies all of them again.
+ */
+void BM_ApplyRemoteEvent(benchmark::State& state) {
+  int num_targets = static_cast<int>(state.range(0));
+  int num_docs = static_cast<int>(state.range(1));
+
+  std::unique_ptr<LevelDbPersistence> persistence =
+      LevelDbPersistenceForTesting();
+  QueryEngine query_engine;
+  LocalStore local_store(persistence.get(), &query_engine,
+                         User::Unauthenticated());
+  local_store.Start();
+
+  std::vector<TargetId> target_ids;
+  for (int t = 0; t < num_targets; ++t) {
+    core::Query query = testutil::Query(absl::StrCat("coll", t));
+    TargetData target_data = local_store.AllocateTarget(query.ToTarget());
+    target_ids.push_back(target_data.target_id());
+  }
+
+  local_store.ApplyRemoteEvent(MakeRemoteEvent(target_ids, num_docs, 1));
+
+  int64_t version = 1;
+  for (auto _ : state) {
+    state.PauseTiming();
+    RemoteEvent event = MakeRemoteEvent(target_ids, num_docs, ++version);
+    state.ResumeTiming();
+
+    benchmark::DoNotOptimize(local_store.ApplyRemoteEvent(event));
+  }
+  state.SetItemsProcessed(state.iterations() * num_docs);
+}
+BENCHMARK(BM_ApplyRemoteEvent)
+    ->Args({1, 1000})
+    ->Args({20, 2000})
+    ->Args({200, 20000})
+    ->Unit(benchmark::kMillisecond);
+
+/**
+ * Measures the initial sync of a single large target: each iteration listens
+ * to a new target in an empty LevelDB-backed LocalStore and applies the remote
+ * event that marks it CURRENT, carrying every one of its documents.
+ */
+void BM_InitialSync(benchmark::State& state) {
+  int num_docs = static_cast<int>(state.range(0));
+
+  QueryEngine query_engine;
+  std::unique_ptr<LevelDbPersistence> persistence;
+  std::unique_ptr<LocalStore> local_store;
+  for (auto _ : state) {
+    state.PauseTiming();
+    local_store.reset();
+    if (persistence) {
+      persistence->Shutdown();
+      persistence.reset();
+    }
+    persistence = LevelDbPersistenceForTesting();
+    local_store = absl::make_unique<LocalStore>(
+        persistence.get(), &query_engine, User::Unauthenticated());
+    local_store->Start();
+
+    core::Query query = testutil::Query("coll0");
+    TargetData target_data = local_store->AllocateTarget(query.ToTarget());
+    RemoteEvent event = MakeRemoteEvent({target_data.target_id()}, num_docs, 1);
+    state.ResumeTiming();
+
+    benchmark::DoNotOptimize(local_store->ApplyRemoteEvent(event));
+  }
+  state.SetItemsProcessed(state.iterations() * num_docs);
+}
+BENCHMARK(BM_InitialSync)
+    ->Arg(10000)
+    ->Arg(100000)
+    ->Unit(benchmark::kMillisecond)
+    ->Iterations(3);
+
+}  // namespace
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,138 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <memory>
+#include <mutex>   // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "Firestore/core/src/core/query.h"
+#include "Firestore/core/src/credentials/user.h"
+#include "Firestore/core/src/local/leveldb_persistence.h"
+#include "Firestore/core/src/local/local_store.h"
+#include "Firestore/core/src/local/query_engine.h"
+#include "Firestore/core/src/local/query_result.h"
+#include "Firestore/core/src/model/mutable_document.h"
+#include "Firestore/core/src/model/mutation.h"
+#include "Firestore/core/test/unit/local/persistence_testing.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+namespace {
+
+using credentials::User;
+using model::Mutation;
+
+constexpr int kNumDocs = 5000;
+
+/** How cache-only queries are run relative to writes. */
+enum ReadMode {
+  // Queries and writes share one lock, like tasks on the worker queue.
+  kOnWorker = 0,
+  // Queries read persistence snapshots without holding the lock.
+  kOnSnapshot = 1,
+};
+
+/**
+ * Measures the latency of local writes while `state.range(1)` threads
+ * continuously run collection queries over `kNumDocs` cached documents. When
+ * the queries run on the worker each write waits for the query ahead of it;
+ * when they run on snapshots writes proceed independently.
+ */
+void BM_WriteLatencyUnderReadLoad(benchmark::State& state) {
+  auto mode = static_cast<ReadMode>(state.range(0));
+  int num_readers = static_cast<int>(state.range(1));
+
+  std::unique_ptr<LevelDbPersistence> persistence =
+      LevelDbPersistenceForTesting();
+  QueryEngine query_engine;
+  LocalStore local_store(persistence.get(), &query_engine,
+                         User::Unauthenticated());
+  local_store.Start();
+
+  persistence->Run("PopulateCache", [&] {
+    for (int i = 0; i < kNumDocs; ++i) {
+      persistence->remote_document_cache()->Add(
+          testutil::Doc(absl::StrCat("coll/doc", i), 1,
+                        testutil::Map("score", i % 100, "name",
+                                      absl::StrCat("user", i))),
+          testutil::Version(1));
+    }
+  });
+
+  core::Query query = testutil::Query("coll").AddingFilter(
+      testutil::Filter("score", ">=", 50));
+
+  // Stands in for the worker queue, which runs one task at a time.
+  std::mutex worker;
+  std::atomic<bool> done{false};
+  std::atomic<int64_t> reads{0};
+  std::vector<std::thread> readers;
+  for (int r = 0; r < num_readers; ++r) {
+    readers.emplace_back([&] {
+      while (!done) {
+        if (mode == kOnWorker) {
+          std::lock_guard<std::mutex> lock(worker);
+          benchmark::DoNotOptimize(local_store.ExecuteQuery(
+              query, /* use_previous_results= */ true));
+        } else {
+          benchmark::DoNotOptimize(local_store.ExecuteQueryOnSnapshot(query));
+        }
+        ++reads;
+      }
+    });
+  }
+
+  int write = 0;
+  for (auto _ : state) {
+    int doc = write++ % kNumDocs;
+    std::vector<Mutation> mutations;
+    mutations.push_back(testutil::SetMutation(
+        absl::StrCat("coll/doc", doc),
+        testutil::Map("score", write % 100, "name", "updated")));
+
+    std::lock_guard<std::mutex> lock(worker);
+    benchmark::DoNotOptimize(local_store.WriteLocally(std::move(mutations)));
+  }
+
+  done = true;
+  for (std::thread& reader : readers) {
+    reader.join();
+  }
+  state.counters["reads"] = benchmark::Counter(
+      static_cast<double>(reads), benchmark::Counter::kIsRate);
+}
+void ReadLoads(benchmark::internal::Benchmark* benchmark) {
+  for (int mode : {kOnWorker, kOnSnapshot}) {
+    for (int readers : {0, 1, 2, 4}) {
+      benchmark->Args({mode, readers});
+    }
+  }
+}
+BENCHMARK(BM_WriteLatencyUnderReadLoad)
+    ->Apply(ReadLoads)
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
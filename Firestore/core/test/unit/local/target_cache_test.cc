@@ -20,6 +20,7 @@
 #include <string>
 #include <unordered_set>
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/src/core/field_filter.h"
 #include "Firestore/core/src/immutable/sorted_set.h"
@@ -304,6 +305,48 @@ TEST_P(TargetCacheTest, MatchingKeysForTargetID) {
   });
 }
 
+TEST_P(TargetCacheTest, ApplyMatchingKeyChanges) {
+  persistence_->Run("test_apply_matching_key_changes", [&] {
+    DocumentKey key1 = Key("foo/bar");
+    DocumentKey key2 = Key("foo/baz");
+    DocumentKey key3 = Key("foo/blah");
+
+    AddMatchingKey(key1, 1);
+    AddMatchingKey(key2, 1);
+
+    // key1 moves from target 1 to target 2 while key2 leaves both.
+    std::vector<TargetKeyChanges> changes;
+    changes.push_back({1, DocumentKeySet{key3}, DocumentKeySet{key1, key2}});
+    changes.push_back({2, DocumentKeySet{key1}, DocumentKeySet{}});
+    cache_->ApplyMatchingKeyChanges(changes);
+
+    ASSERT_EQ(cache_->GetMatchingKeys(1), (DocumentKeySet{key3}));
+    ASSERT_EQ(cache_->GetMatchingKeys(2), (DocumentKeySet{key1}));
+    ASSERT_TRUE(cache_->Contains(key1));
+    ASSERT_FALSE(cache_->Contains(key2));
+    ASSERT_TRUE(cache_->Contains(key3));
+  });
+}
+
+TEST_P(TargetCacheTest, UpdateTargets) {
+  persistence_->Run("test_update_targets", [&] {
+    TargetData rooms = MakeTargetData(query_rooms_);
+    TargetData halls = MakeTargetData(testutil::Query("halls"));
+    cache_->AddTarget(rooms);
+    cache_->AddTarget(halls);
+
+    TargetData updated_rooms =
+        rooms.WithResumeToken(ResumeToken(1000), Version(1000));
+    TargetData updated_halls = halls.WithSequenceNumber(2000);
+    cache_->UpdateTargets({updated_rooms, updated_halls});
+
+    ASSERT_EQ(cache_->GetTarget(rooms.target()), updated_rooms);
+    ASSERT_EQ(cache_->GetTarget(halls.target()), updated_halls);
+    ASSERT_EQ(cache_->highest_listen_sequence_number(), 2000);
+    ASSERT_EQ(cache_->size(), 2);
+  });
+}
+
 TEST_P(TargetCacheTest, HighestListenSequenceNumber) {
   persistence_->Run("test_highest_listen_sequence_number", [&] {
     TargetData query1(testutil::Query("rooms").ToTarget(), 1, 10,
@@ -0,0 +1,170 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "Firestore/core/src/core/query.h"
+#include "Firestore/core/src/credentials/user.h"
+#include "Firestore/core/src/local/local_store.h"
+#include "Firestore/core/src/local/local_vector_search.h"
+#include "Firestore/core/src/local/memory_persistence.h"
+#include "Firestore/core/src/local/query_engine.h"
+#include "Firestore/core/src/model/mutable_document.h"
+#include "Firestore/core/src/model/vector_distance.h"
+#include "Firestore/core/src/nanopb/message.h"
+#include "Firestore/core/src/nanopb/nanopb_util.h"
+#include "Firestore/core/test/unit/local/persistence_testing.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+namespace {
+
+using credentials::User;
+using model::DistanceMeasure;
+using model::DocumentMap;
+using model::MutableDocument;
+
+std::vector<double> RandomVector(std::mt19937* rng, size_t dimension) {
+  std::uniform_real_distribution<double> distribution(-1, 1);
+  std::vector<double> result(dimension);
+  for (double& component : result) {
+    component = distribution(*rng);
+  }
+  return result;
+}
+
+MutableDocument MakeDocument(int index, const std::vector<double>& embedding) {
+  nanopb::Message<google_firestore_v1_ArrayValue> array;
+  array->values_count = nanopb::CheckedSize(embedding.size());
+  array->values =
+      nanopb::MakeArray<google_firestore_v1_Value>(array->values_count);
+  for (pb_size_t i = 0; i < array->values_count; ++i) {
+    array->values[i].which_value_type =
+        google_firestore_v1_Value_double_value_tag;
+    array->values[i].double_value = embedding[i];
+  }
+  return testutil::Doc(
+      absl::StrCat("coll/doc", index), 1,
+      testutil::Map("embedding",
+                    testutil::Map("__type__", "__vector__", "value",
+                                  std::move(array)),
+                    "index", index));
+}
+
+VectorQuery MakeVectorQuery(std::mt19937* rng, size_t dimension) {
+  VectorQuery query;
+  query.field = testutil::Field("embedding");
+  query.query_vector = RandomVector(rng, dimension);
+  query.distance_measure = DistanceMeasure::kCosine;
+  query.limit = 10;
+  return query;
+}
+
+// The embedding dimensions of common text embedding models, each paired with
+// a document count small enough to keep the corpus in memory.
+void EmbeddingSizes(benchmark::internal::Benchmark* benchmark) {
+  benchmark->Args({100000, 256})->Args({10000, 768})->Args({10000, 1536});
+}
+
+void BM_DotProduct(benchmark::State& state) {
+  size_t dimension = static_cast<size_t>(state.range(0));
+  std::mt19937 rng(42);
+  std::vector<double> lhs = RandomVector(&rng, dimension);
+  std::vector<double> rhs = RandomVector(&rng, dimension);
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        model::DotProduct(lhs.data(), rhs.data(), dimension));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_DotProduct)->Arg(256)->Arg(768)->Arg(1536);
+
+void BM_DotProductPortable(benchmark::State& state) {
+  size_t dimension = static_cast<size_t>(state.range(0));
+  std::mt19937 rng(42);
+  std::vector<double> lhs = RandomVector(&rng, dimension);
+  std::vector<double> rhs = RandomVector(&rng, dimension);
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        model::TEST_DotProductPortable(lhs.data(), rhs.data(), dimension));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_DotProductPortable)->Arg(256)->Arg(768)->Arg(1536);
+
+/** Scores every document of an in-memory candidate set. */
+void BM_FindNearest(benchmark::State& state) {
+  int num_docs = static_cast<int>(state.range(0));
+  size_t dimension = static_cast<size_t>(state.range(1));
+  std::mt19937 rng(42);
+
+  DocumentMap documents;
+  for (int i = 0; i < num_docs; ++i) {
+    MutableDocument doc = MakeDocument(i, RandomVector(&rng, dimension));
+    documents = documents.insert(doc.key(), doc);
+  }
+  VectorQuery query = MakeVectorQuery(&rng, dimension);
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(FindNearest(documents, query));
+  }
+  state.SetItemsProcessed(state.iterations() * num_docs);
+}
+BENCHMARK(BM_FindNearest)->Apply(EmbeddingSizes)->Unit(benchmark::kMillisecond);
+
+/** Includes reading the cached documents through LocalStore. */
+void BM_LocalStoreFindNearest(benchmark::State& state) {
+  int num_docs = static_cast<int>(state.range(0));
+  size_t dimension = static_cast<size_t>(state.range(1));
+  std::mt19937 rng(42);
+
+  std::unique_ptr<MemoryPersistence> persistence =
+      MemoryPersistenceWithEagerGcForTesting();
+  QueryEngine query_engine;
+  LocalStore local_store(persistence.get(), &query_engine,
+                         User::Unauthenticated());
+  local_store.Start();
+  persistence->Run("PopulateCache", [&] {
+    for (int i = 0; i < num_docs; ++i) {
+      persistence->remote_document_cache()->Add(
+          MakeDocument(i, RandomVector(&rng, dimension)),
+          testutil::Version(1));
+    }
+  });
+  core::Query query = testutil::Query("coll");
+  VectorQuery vector_query = MakeVectorQuery(&rng, dimension);
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(local_store.FindNearest(query, vector_query));
+  }
+  state.SetItemsProcessed(state.iterations() * num_docs);
+}
+BENCHMARK(BM_LocalStoreFindNearest)
+    ->Apply(EmbeddingSizes)
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,106 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "Firestore/core/src/core/query.h"
+#include "Firestore/core/src/model/document.h"
+#include "Firestore/core/src/model/document_set.h"
+#include "Firestore/core/src/model/mutable_document.h"
+#include "Firestore/core/src/model/value_util.h"
+#include "Firestore/core/src/util/comparison.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace model {
+namespace {
+
+using util::ComparisonResult;
+
+const char* const kSortFields[] = {"map", "ref", "vec"};
+
+/**
+ * Creates `num_docs` documents in random order, each with a map, a reference
+ * and a vector field. Values repeat often enough that comparisons regularly
+ * look past the first map field, reference segment or vector element.
+ */
+std::vector<Document> MakeDocuments(int num_docs) {
+  std::vector<Document> docs;
+  docs.reserve(num_docs);
+  for (int i = 0; i < num_docs; ++i) {
+    docs.push_back(testutil::Doc(
+        absl::StrCat("coll/doc", i), 1,
+        testutil::Map(
+            "map",
+            testutil::Map("tier", i % 10, "name", absl::StrCat("user", i % 97),
+                          "score", i),
+            "ref",
+            RefValue(testutil::DbId("project/db"),
+                     testutil::Key(absl::StrCat("users/user", i % 97,
+                                                "/posts/post", i))),
+            "vec",
+            testutil::VectorType(static_cast<double>(i % 13),
+                                 static_cast<double>(i % 17),
+                                 static_cast<double>(i)))));
+  }
+  std::shuffle(docs.begin(), docs.end(), std::mt19937(42));
+  return docs;
+}
+
+/**
+ * Sorts `state.range(0)` documents by the field selected by `state.range(1)`
+ * using the comparator of a query ordered by that field.
+ */
+void BM_SortDocumentsByField(benchmark::State& state) {
+  int num_docs = static_cast<int>(state.range(0));
+  const char* field = kSortFields[state.range(1)];
+  state.SetLabel(field);
+
+  std::vector<Document> docs = MakeDocuments(num_docs);
+  DocumentComparator comparator =
+      testutil::Query("coll")
+          .AddingOrderBy(testutil::OrderBy(field))
+          .Comparator();
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::vector<Document> sorted = docs;
+    state.ResumeTiming();
+
+    std::sort(sorted.begin(), sorted.end(),
+              [&](const Document& lhs, const Document& rhs) {
+                return comparator.Compare(lhs, rhs) ==
+                       ComparisonResult::Ascending;
+              });
+    benchmark::DoNotOptimize(sorted);
+  }
+  state.SetItemsProcessed(state.iterations() * num_docs);
+}
+BENCHMARK(BM_SortDocumentsByField)
+    ->Args({100000, 0})
+    ->Args({100000, 1})
+    ->Args({100000, 2})
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace
+}  // namespace model
+}  // namespace firestore
+}  // namespace firebase
@@ -20,6 +20,7 @@
 
 #include "Firestore/core/src/model/delete_mutation.h"
 #include "Firestore/core/src/model/mutable_document.h"
+#include "Firestore/core/src/model/mutation_batch.h"
 #include "Firestore/core/src/model/patch_mutation.h"
 #include "Firestore/core/src/model/server_timestamp_util.h"
 #include "Firestore/core/src/model/set_mutation.h"
@@ -871,6 +872,34 @@ TEST(MutationTest, OverlayByCombinationsAndPermutations_Increments) {
   EXPECT_EQ(5871, test_cases);
 }
 
+TEST(MutationTest, BatchAppliesToLocalViewsLikeApplyToLocalView) {
+  MutationBatch batch(
+      1, now, {},
+      {PatchMutation("collection/a", Map("foo", "bar")),
+       SetMutation("collection/b", Map("baz", 1)),
+       PatchMutation("collection/a", Map("qux", 2)),
+       PatchMutation("collection/c", Map("ignored", true))});
+
+  MutableDocument a = Doc("collection/a", 1, Map("foo", 0));
+  MutableDocument b = Doc("collection/b", 1, Map("foo", 0));
+  MutableDocumentPtrMap documents{{a.key(), &a}, {b.key(), &b}};
+  FieldMaskMap mutated_fields;
+  batch.ApplyToLocalViews(documents, mutated_fields);
+
+  MutableDocument expected_a = Doc("collection/a", 1, Map("foo", 0));
+  MutableDocument expected_b = Doc("collection/b", 1, Map("foo", 0));
+  absl::optional<FieldMask> expected_a_fields =
+      batch.ApplyToLocalView(expected_a, FieldMask());
+  absl::optional<FieldMask> expected_b_fields =
+      batch.ApplyToLocalView(expected_b, FieldMask());
+
+  EXPECT_EQ(a, expected_a);
+  EXPECT_EQ(b, expected_b);
+  EXPECT_EQ(mutated_fields.size(), 2u);
+  EXPECT_EQ(mutated_fields[a.key()], expected_a_fields);
+  EXPECT_EQ(mutated_fields[b.key()], expected_b_fields);
+}
+
 }  // namespace
 }  // namespace model
 }  // namespace firestore
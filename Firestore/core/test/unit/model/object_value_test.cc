@@ -335,6 +335,59 @@ TEST_F(ObjectValueTest, DoesNotRequireSortedInserts) {
   EXPECT_EQ(*Value(2), *object_value.Get(Field("nested.nested.c")));
 }
 
+TEST_F(ObjectValueTest, FingerprintMatchesForEqualObjects) {
+  ObjectValue left = WrapObject("a", 1, "b", Map("c", "foo"));
+  ObjectValue right = WrapObject("b", Map("c", "foo"), "a", 1);
+  EXPECT_EQ(left, right);
+  EXPECT_EQ(left.Fingerprint(), right.Fingerprint());
+  EXPECT_EQ(left.Fingerprint(), ObjectValue(left).Fingerprint());
+}
+
+TEST_F(ObjectValueTest, FingerprintChangesWithMutations) {
+  ObjectValue object_value = WrapObject("a", 1);
+  size_t original = object_value.Fingerprint();
+
+  object_value.Set(Field("b.c"), Value(kFooString));
+  size_t after_set = object_value.Fingerprint();
+  EXPECT_NE(original, after_set);
+  EXPECT_EQ(WrapObject("a", 1, "b", Map("c", kFooString)).Fingerprint(),
+            after_set);
+
+  object_value.Delete(Field("b"));
+  EXPECT_EQ(original, object_value.Fingerprint());
+
+  TransformMap data;
+  data.emplace(Field("a"), Value(2));
+  object_value.SetAll(std::move(data));
+  EXPECT_EQ(WrapObject("a", 2).Fingerprint(), object_value.Fingerprint());
+}
+
+TEST_F(ObjectValueTest, CopiesAreIndependentAfterSet) {
+  ObjectValue original = WrapObject("a", Map("b", kFooString));
+  ObjectValue copy(original);
+  EXPECT_EQ(original.Get().map_value.fields, copy.Get().map_value.fields);
+
+  copy.Set(Field("a.b"), Value(kBarString));
+  EXPECT_EQ(WrapObject("a", Map("b", kFooString)), original);
+  EXPECT_EQ(WrapObject("a", Map("b", kBarString)), copy);
+  EXPECT_NE(original.Get().map_value.fields, copy.Get().map_value.fields);
+}
+
+TEST_F(ObjectValueTest, CopiesAreIndependentAfterDelete) {
+  ObjectValue original = WrapObject("a", 1, "b", 2);
+  ObjectValue copy(original);
+
+  copy.Delete(Field("c"));
+  EXPECT_EQ(original.Get().map_value.fields, copy.Get().map_value.fields);
+
+  copy.Delete(Field("a"));
+  TransformMap data;
+  data.emplace(Field("c"), Value(3));
+  original.SetAll(std::move(data));
+  EXPECT_EQ(WrapObject("a", 1, "b", 2, "c", 3), original);
+  EXPECT_EQ(WrapObject("b", 2), copy);
+}
+
 }  // namespace
 
 }  // namespace model
@@ -21,6 +21,7 @@
 #include "Firestore/core/src/model/server_timestamp_util.h"
 #include "Firestore/core/src/model/value_util.h"
 #include "Firestore/core/src/nanopb/message.h"
+#include "Firestore/core/src/nanopb/nanopb_util.h"
 #include "Firestore/core/src/remote/serializer.h"
 #include "Firestore/core/src/util/comparison.h"
 #include "Firestore/core/src/util/defer.h"
@@ -261,6 +262,62 @@ TEST_F(ValueUtilTest, Equality) {
   }
 }
 
+TEST_F(ValueUtilTest, Fingerprint) {
+  // Values within a row compare the same and must share a fingerprint. Values
+  // in different rows are expected to have different fingerprints.
+  std::vector<Message<google_firestore_v1_ArrayValue>> groups;
+
+  Add(groups, nullptr, nullptr);
+  Add(groups, false, false);
+  Add(groups, true);
+  Add(groups, std::numeric_limits<double>::quiet_NaN(),
+      ToDouble(kAlternateNanBits), std::nan("1"));
+  Add(groups, -0.0, 0.0, 0);
+  Add(groups, 1, 1LL, 1.0);
+  Add(groups, 1.1, 1.1);
+  Add(groups, std::numeric_limits<double>::infinity());
+  Add(groups, BlobValue(), BlobValue());
+  Add(groups, BlobValue(0, 1, 1));
+  Add(groups, "string", "string");
+  Add(groups, "strin");
+  Add(groups, kTimestamp1, Timestamp::FromTimePoint(kDate1));
+  Add(groups, kTimestamp2);
+  Add(groups, EncodeServerTimestamp(kTimestamp1, absl::nullopt),
+      EncodeServerTimestamp(kTimestamp1, absl::nullopt));
+  Add(groups, GeoPoint(0, 1), GeoPoint(-0.0, 1));
+  Add(groups, GeoPoint(1, 0));
+  Add(groups, RefValue(DbId(), Key("coll/doc1")),
+      RefValue(DbId(), Key("coll/doc1")));
+  Add(groups, RefValue(DbId(), Key("coll/doc2")));
+  Add(groups, Array("foo", "bar"), Array("foo", "bar"));
+  Add(groups, Array("bar", "foo"));
+  Add(groups, Array(1, 2), Array(1.0, 2.0));
+  Add(groups, Map("bar", 1, "foo", 2), Map("foo", 2, "bar", 1),
+      Map("bar", 1.0, "foo", 2));
+  Add(groups, Map("bar", 2, "foo", 1));
+  Add(groups, Map("bar", Map("baz", 1)), Map("bar", Map("baz", 1.0)));
+  Add(groups, Map("__type__", "__vector__", "value", Array(1.0, 2.0)),
+      Map("value", Array(1.0, 2.0), "__type__", "__vector__"));
+
+  for (size_t i = 0; i < groups.size(); ++i) {
+    for (size_t j = i; j < groups.size(); ++j) {
+      for (pb_size_t k = 0; k < groups[i]->values_count; ++k) {
+        for (pb_size_t l = 0; l < groups[j]->values_count; ++l) {
+          const auto& left = groups[i]->values[k];
+          const auto& right = groups[j]->values[l];
+          if (i == j) {
+            EXPECT_EQ(Fingerprint(left), Fingerprint(right))
+                << CanonicalId(left) << " vs " << CanonicalId(right);
+          } else {
+            EXPECT_NE(Fingerprint(left), Fingerprint(right))
+                << CanonicalId(left) << " vs " << CanonicalId(right);
+          }
+        }
+      }
+    }
+  }
+}
+
 TEST_F(ValueUtilTest, StrictOrdering) {
   // Create a matrix that defines a comparison group. The outer vector has
   // multiple rows and each row can have an arbitrary number of entries.
@@ -559,6 +616,52 @@ TEST_F(ValueUtilTest, CompareMaps) {
   EXPECT_EQ(model::Compare(*left_4, *right_4), ComparisonResult::Ascending);
 }
 
+TEST_F(ValueUtilTest, CompareMapsWithUnsortedNestedFields) {
+  auto sorted = Map("a", 1, "b", Map("c", 2, "d", 3));
+  auto unsorted = Map("b", Map("d", 3, "c", 2), "a", 1);
+  EXPECT_EQ(model::Compare(*sorted, *unsorted), ComparisonResult::Same);
+  EXPECT_TRUE(*sorted == *unsorted);
+
+  auto greater = Map("b", Map("d", 3, "c", 4), "a", 1);
+  EXPECT_EQ(model::Compare(*unsorted, *greater), ComparisonResult::Ascending);
+  EXPECT_EQ(model::Compare(*greater, *sorted), ComparisonResult::Descending);
+}
+
+TEST_F(ValueUtilTest, CompareReferencesBySegment) {
+  auto reference = [](const char* path) {
+    Message<google_firestore_v1_Value> value;
+    value->which_value_type = google_firestore_v1_Value_reference_value_tag;
+    value->reference_value = nanopb::MakeBytesArray(path);
+    return value;
+  };
+
+  auto doc = reference("projects/p/databases/d/documents/c/doc");
+  EXPECT_EQ(model::Compare(*doc, *reference("projects/p/databases/d/"
+                                            "documents//c/doc/")),
+            ComparisonResult::Same);
+  EXPECT_EQ(model::Compare(*doc, *reference("projects/p/databases/d/"
+                                            "documents/c/doc/sub/doc")),
+            ComparisonResult::Ascending);
+  EXPECT_EQ(model::Compare(*doc, *reference("projects/p/databases/d/"
+                                            "documents/c/do")),
+            ComparisonResult::Descending);
+  // Segments compare as a whole, so "c" sorts before "c-1" even though '-'
+  // sorts before '/'.
+  EXPECT_EQ(model::Compare(*doc, *reference("projects/p/databases/d/"
+                                            "documents/c-1/doc")),
+            ComparisonResult::Ascending);
+}
+
+TEST_F(ValueUtilTest, CompareVectorsWithoutValues) {
+  auto empty = Map("__type__", "__vector__", "other", 1);
+  auto vector = Map("__type__", "__vector__", "value", Array(1.0));
+  EXPECT_EQ(model::Compare(*empty, *vector), ComparisonResult::Ascending);
+  EXPECT_EQ(model::Compare(*vector, *empty), ComparisonResult::Descending);
+  EXPECT_EQ(model::Compare(*empty, *Map("__type__", "__vector__", "value",
+                                        Array())),
+            ComparisonResult::Same);
+}
+
 }  // namespace
 
 }  // namespace model
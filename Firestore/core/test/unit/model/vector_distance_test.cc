@@ -0,0 +1,119 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/model/vector_distance.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace model {
+namespace {
+
+using testutil::Array;
+using testutil::Map;
+using testutil::Value;
+using testutil::VectorType;
+
+std::vector<double> RandomVector(std::mt19937* rng, size_t size) {
+  std::uniform_real_distribution<double> distribution(-1, 1);
+  std::vector<double> result(size);
+  for (double& component : result) {
+    component = distribution(*rng);
+  }
+  return result;
+}
+
+TEST(VectorDistanceTest, GetVectorComponents) {
+  std::vector<double> components{42};
+
+  EXPECT_TRUE(GetVectorComponents(*VectorType(1.0, 2, 3.5), &components));
+  EXPECT_EQ(components, (std::vector<double>{1.0, 2.0, 3.5}));
+
+  EXPECT_TRUE(GetVectorComponents(*VectorType(), &components));
+  EXPECT_TRUE(components.empty());
+
+  EXPECT_FALSE(GetVectorComponents(*VectorType(1.0, "a"), &components));
+  EXPECT_FALSE(GetVectorComponents(*Value(Array(1.0, 2.0)), &components));
+  EXPECT_FALSE(GetVectorComponents(*Map("value", Array(1.0)), &components));
+}
+
+TEST(VectorDistanceTest, ComputeDistance) {
+  std::vector<double> a{1, 0};
+  std::vector<double> b{0, 2};
+
+  EXPECT_DOUBLE_EQ(*ComputeDistance(DistanceMeasure::kEuclidean, a, b),
+                   std::sqrt(5.0));
+  EXPECT_DOUBLE_EQ(*ComputeDistance(DistanceMeasure::kCosine, a, b), 1.0);
+  EXPECT_DOUBLE_EQ(*ComputeDistance(DistanceMeasure::kCosine, a, a), 0.0);
+  EXPECT_DOUBLE_EQ(*ComputeDistance(DistanceMeasure::kDotProduct, a, b), 0.0);
+  EXPECT_DOUBLE_EQ(*ComputeDistance(DistanceMeasure::kDotProduct, b, b), 4.0);
+}
+
+TEST(VectorDistanceTest, ComputeDistanceIsUndefined) {
+  std::vector<double> a{1, 2};
+  std::vector<double> b{1, 2, 3};
+  std::vector<double> zero{0, 0};
+
+  EXPECT_FALSE(ComputeDistance(DistanceMeasure::kEuclidean, a, b));
+  EXPECT_FALSE(ComputeDistance(DistanceMeasure::kDotProduct, a, b));
+  EXPECT_FALSE(ComputeDistance(DistanceMeasure::kCosine, a, zero));
+  EXPECT_TRUE(ComputeDistance(DistanceMeasure::kEuclidean, a, zero));
+}
+
+TEST(VectorDistanceTest, IsNearer) {
+  EXPECT_TRUE(IsNearer(DistanceMeasure::kEuclidean, 1, 2));
+  EXPECT_TRUE(IsNearer(DistanceMeasure::kCosine, 0.1, 0.2));
+  EXPECT_TRUE(IsNearer(DistanceMeasure::kDotProduct, 2, 1));
+  EXPECT_FALSE(IsNearer(DistanceMeasure::kEuclidean, 1, 1));
+}
+
+// Covers every combination of the vectorized block sizes and scalar tails.
+TEST(VectorDistanceTest, KernelsMatchPortableVersions) {
+  std::mt19937 rng(42);
+  for (size_t size = 0; size <= 40; ++size) {
+    std::vector<double> lhs = RandomVector(&rng, size);
+    std::vector<double> rhs = RandomVector(&rng, size);
+
+    EXPECT_NEAR(DotProduct(lhs.data(), rhs.data(), size),
+                TEST_DotProductPortable(lhs.data(), rhs.data(), size), 1e-12)
+        << "size: " << size;
+    EXPECT_NEAR(
+        SquaredEuclideanDistance(lhs.data(), rhs.data(), size),
+        TEST_SquaredEuclideanDistancePortable(lhs.data(), rhs.data(), size),
+        1e-12)
+        << "size: " << size;
+  }
+}
+
+TEST(VectorDistanceTest, KernelsHandleUnalignedInput) {
+  std::vector<double> lhs{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+  std::vector<double> rhs{0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1};
+
+  EXPECT_DOUBLE_EQ(DotProduct(lhs.data() + 1, rhs.data() + 1, 10), 55.0);
+  EXPECT_DOUBLE_EQ(
+      SquaredEuclideanDistance(lhs.data() + 1, rhs.data() + 1, 10), 285.0);
+}
+
+}  // namespace
+}  // namespace model
+}  // namespace firestore
+}  // namespace firebase
@@ -16,6 +16,9 @@
 
 #include "Firestore/core/src/nanopb/writer.h"
 
+#include "Firestore/Protos/nanopb/google/firestore/v1/document.nanopb.h"
+#include "Firestore/core/src/nanopb/message.h"
+#include "Firestore/core/src/nanopb/nanopb_util.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
@@ -67,6 +70,18 @@ TEST(BasicStringWriterTest, Releases) {
   EXPECT_EQ(second.get(), nullptr);
 }
 
+TEST(SizingWriterTest, CountsWithoutStoring) {
+  Message<google_firestore_v1_Value> value;
+  value->which_value_type = google_firestore_v1_Value_string_value_tag;
+  value->string_value = MakeBytesArray("some string value");
+
+  SizingWriter writer;
+  EXPECT_EQ(writer.size(), 0);
+  writer.Write(value.fields(), value.get());
+  EXPECT_EQ(writer.size(), MakeByteString(value).size());
+  EXPECT_EQ(EncodedSize(value), MakeByteString(value).size());
+}
+
 }  //  namespace nanopb
 }  //  namespace firestore
 }  //  namespace firebase
@@ -20,6 +20,7 @@
 #include <initializer_list>
 #include <memory>
 #include <string>
+#include <thread>  // NOLINT(build/c++11)
 #include <utility>
 #include <vector>
 
@@ -53,6 +54,16 @@ class Observer : public GrpcStreamObserver {
   void OnStreamStart() override {
     observed_states.push_back("OnStreamStart");
   }
+  PreparedRead PrepareStreamRead(const grpc::ByteBuffer& message) override {
+    if (!prepare_reads) {
+      return {};
+    }
+    prepare_thread = std::this_thread::get_id();
+    std::string str = ByteBufferToString(message);
+    return [this, str] {
+      observed_states.push_back(StringFormat("OnPreparedRead(%s)", str));
+    };
+  }
   void OnStreamRead(const grpc::ByteBuffer& message) override {
     std::string str = ByteBufferToString(message);
     if (str.empty()) {
@@ -67,6 +78,8 @@ class Observer : public GrpcStreamObserver {
   }
 
   std::vector<std::string> observed_states;
+  bool prepare_reads = false;
+  std::thread::id prepare_thread;
 };
 
 class DestroyingObserver : public GrpcStreamObserver {
@@ -202,6 +215,23 @@ TEST_F(GrpcStreamTest, ReadIsAutomaticallyReadded) {
                                        "OnStreamRead(bar)"}));
 }
 
+TEST_F(GrpcStreamTest, PreparesReadsOffWorkerQueue) {
+  observer->prepare_reads = true;
+  worker_queue->EnqueueBlocking([&] { stream->Start(); });
+
+  ForceFinish({{Type::Read, MakeByteBuffer("foo")}});
+  ForceFinish({{Type::Read, MakeByteBuffer("bar")}});
+  EXPECT_EQ(observed_states(),
+            States({"OnStreamStart", "OnPreparedRead(foo)",
+                    "OnPreparedRead(bar)"}));
+
+  std::thread::id worker_thread;
+  worker_queue->EnqueueBlocking(
+      [&] { worker_thread = std::this_thread::get_id(); });
+  EXPECT_NE(observer->prepare_thread, std::thread::id{});
+  EXPECT_NE(observer->prepare_thread, worker_thread);
+}
+
 TEST_F(GrpcStreamTest, CanAddSeveralWrites) {
   worker_queue->EnqueueBlocking([&] { stream->Start(); });
 
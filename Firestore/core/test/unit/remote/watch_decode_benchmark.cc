@@ -0,0 +1,320 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <time.h>
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <functional>
+#include <future>  // NOLINT(build/c++11)
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <vector>
+
+#include "Firestore/Protos/nanopb/google/firestore/v1/firestore.nanopb.h"
+#include "Firestore/core/src/credentials/auth_token.h"
+#include "Firestore/core/src/credentials/user.h"
+#include "Firestore/core/src/model/database_id.h"
+#include "Firestore/core/src/model/object_value.h"
+#include "Firestore/core/src/nanopb/message.h"
+#include "Firestore/core/src/nanopb/nanopb_util.h"
+#include "Firestore/core/src/remote/grpc_completion.h"
+#include "Firestore/core/src/remote/serializer.h"
+#include "Firestore/core/src/remote/watch_change.h"
+#include "Firestore/core/src/remote/watch_stream.h"
+#include "Firestore/core/src/util/async_queue.h"
+#include "Firestore/core/src/util/status.h"
+#include "Firestore/core/test/unit/remote/create_noop_connectivity_monitor.h"
+#include "Firestore/core/test/unit/remote/fake_credentials_provider.h"
+#include "Firestore/core/test/unit/remote/grpc_stream_tester.h"
+#include "Firestore/core/test/unit/testutil/async_testing.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+namespace {
+
+using credentials::AuthToken;
+using credentials::User;
+using model::DatabaseId;
+using model::ObjectValue;
+using model::SnapshotVersion;
+using nanopb::Message;
+using util::AsyncQueue;
+using util::Status;
+
+using Type = GrpcCompletion::Type;
+using FakeAuthCredentialsProvider = FakeCredentialsProvider<AuthToken, User>;
+using FakeAppCheckCredentialsProvider =
+    FakeCredentialsProvider<std::string, std::string>;
+
+// 5000 documents of ten 1KB fields each make for a 50MB initial sync.
+constexpr int kNumDocuments = 5000;
+constexpr int kFieldsPerDocument = 10;
+constexpr size_t kFieldSize = 1000;
+
+/** Where watch responses are decoded. */
+enum DecodeMode {
+  // In `NotifyStreamResponse`, on the worker queue.
+  kOnWorker = 0,
+  // When the read comes off the gRPC completion queue.
+  kOffQueue = 1,
+};
+
+/** CPU time consumed so far by the calling thread. */
+std::chrono::nanoseconds ThreadCpuTime() {
+  timespec time{};
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+  return std::chrono::seconds(time.tv_sec) +
+         std::chrono::nanoseconds(time.tv_nsec);
+}
+
+std::vector<grpc::ByteBuffer> EncodeInitialSync(const Serializer& serializer) {
+  ObjectValue data;
+  for (int i = 0; i < kFieldsPerDocument; ++i) {
+    data.Set(testutil::Field(absl::StrCat("field", i)),
+             testutil::Value(std::string(kFieldSize, 'a' + i)));
+  }
+
+  std::vector<grpc::ByteBuffer> messages;
+  messages.reserve(kNumDocuments);
+  for (int i = 0; i < kNumDocuments; ++i) {
+    Message<google_firestore_v1_ListenResponse> response;
+    response->which_response_type =
+        google_firestore_v1_ListenResponse_document_change_tag;
+    google_firestore_v1_DocumentChange& change = response->document_change;
+    change.document = serializer.EncodeDocument(
+        testutil::Key(absl::StrCat("coll/doc", i)), data);
+    change.document.has_update_time = true;
+    change.document.update_time =
+        Serializer::EncodeVersion(testutil::Version(1));
+    change.target_ids_count = 1;
+    change.target_ids = nanopb::MakeArray<int32_t>(1);
+    change.target_ids[0] = 1;
+    messages.push_back(MakeByteBuffer(nanopb::MakeStdString(response)));
+  }
+  return messages;
+}
+
+/**
+ * Stands in for the backend end of a watch stream: hands out the given
+ * messages, one per read, and holds the read after the last one.
+ */
+class FakeWatchBackend {
+ public:
+  explicit FakeWatchBackend(const std::vector<grpc::ByteBuffer>* messages)
+      : messages_{messages} {
+  }
+
+  void Reset() {
+    std::lock_guard<std::mutex> lock{mutex_};
+    next_message_ = 0;
+    stopped_ = false;
+  }
+
+  /**
+   * Fails the held read so that the stream can be finished. Must be called
+   * before the stream is stopped.
+   */
+  void Stop() {
+    std::lock_guard<std::mutex> lock{mutex_};
+    stopped_ = true;
+    if (held_read_) {
+      held_read_->Complete(false);
+      held_read_ = nullptr;
+    }
+  }
+
+  /**
+   * Handles a completion taken off the gRPC completion queue; returns true
+   * once the call is finished.
+   */
+  bool HandleCompletion(GrpcCompletion* completion) {
+    std::lock_guard<std::mutex> lock{mutex_};
+    switch (completion->type()) {
+      case Type::Read:
+        if (stopped_) {
+          completion->Complete(false);
+        } else if (next_message_ < messages_->size()) {
+          *completion->message() = (*messages_)[next_message_++];
+          completion->Complete(true);
+        } else {
+          held_read_ = completion;
+        }
+        return false;
+
+      case Type::Start:
+      case Type::Write:
+        break;
+
+      case Type::Finish:
+        completion->Complete(true);
+        return true;
+    }
+    completion->Complete(true);
+    return false;
+  }
+
+ private:
+  const std::vector<grpc::ByteBuffer>* messages_ = nullptr;
+
+  std::mutex mutex_;
+  size_t next_message_ = 0;
+  GrpcCompletion* held_read_ = nullptr;
+  bool stopped_ = false;
+};
+
+/** A `WatchStream` whose gRPC calls are completed by a `GrpcStreamTester`. */
+class BenchmarkWatchStream : public WatchStream {
+ public:
+  BenchmarkWatchStream(const std::shared_ptr<AsyncQueue>& worker_queue,
+                       GrpcStreamTester* tester,
+                       WatchStreamCallback* callback)
+      : WatchStream{worker_queue,
+                    std::make_shared<FakeAuthCredentialsProvider>(),
+                    std::make_shared<FakeAppCheckCredentialsProvider>(),
+                    Serializer{DatabaseId{"p", "d"}},
+                    tester->grpc_connection(),
+                    callback},
+        tester_{tester} {
+  }
+
+ private:
+  std::unique_ptr<GrpcStream> CreateGrpcStream(GrpcConnection*,
+                                               const AuthToken&,
+                                               const std::string&) override {
+    std::unique_ptr<GrpcStream> stream = tester_->CreateStream(this);
+    // Makes gRPC hand every operation straight back to the tester.
+    stream->context()->TryCancel();
+    return stream;
+  }
+
+  GrpcStreamTester* tester_ = nullptr;
+};
+
+/** Leaves all decoding to `NotifyStreamResponse`, as before. */
+class WorkerDecodingWatchStream : public BenchmarkWatchStream {
+ public:
+  using BenchmarkWatchStream::BenchmarkWatchStream;
+
+ private:
+  std::function<Status()> PrepareStreamResponse(
+      const grpc::ByteBuffer&) override {
+    return {};
+  }
+};
+
+/** Counts watch changes on the worker queue. */
+class CountingCallback : public WatchStreamCallback {
+ public:
+  std::future<void> Expect(int num_changes) {
+    remaining_ = num_changes;
+    received_ = {};
+    return received_.get_future();
+  }
+
+  void OnWatchStreamOpen() override {
+  }
+
+  void OnWatchStreamChange(const WatchChange&,
+                           const SnapshotVersion&) override {
+    if (--remaining_ == 0) {
+      received_.set_value();
+    }
+  }
+
+  void OnWatchStreamClose(const Status&) override {
+  }
+
+ private:
+  int remaining_ = 0;
+  std::promise<void> received_;
+};
+
+/**
+ * Streams a 50MB initial sync of `kNumDocuments` documents through a watch
+ * stream, decoding responses as selected by `state.range(0)`, and reports how
+ * much CPU time the worker queue spends on it.
+ */
+void BM_WatchInitialSync(benchmark::State& state) {
+  auto mode = static_cast<DecodeMode>(state.range(0));
+  state.SetLabel(mode == kOnWorker ? "on worker" : "off queue");
+
+  std::vector<grpc::ByteBuffer> messages =
+      EncodeInitialSync(Serializer{DatabaseId{"p", "d"}});
+
+  std::shared_ptr<AsyncQueue> worker_queue = testutil::AsyncQueueForTesting();
+  std::unique_ptr<ConnectivityMonitor> connectivity_monitor =
+      CreateNoOpConnectivityMonitor();
+  GrpcStreamTester tester{worker_queue, connectivity_monitor.get()};
+  FakeWatchBackend backend{&messages};
+  CountingCallback callback;
+
+  std::shared_ptr<WatchStream> stream;
+  if (mode == kOnWorker) {
+    stream = std::make_shared<WorkerDecodingWatchStream>(worker_queue, &tester,
+                                                         &callback);
+  } else {
+    stream = std::make_shared<BenchmarkWatchStream>(worker_queue, &tester,
+                                                    &callback);
+  }
+
+  std::chrono::nanoseconds worker_cpu_time{0};
+  for (auto _ : state) {
+    backend.Reset();
+    std::future<void> finished = tester.ForceFinishAsync(
+        [&](GrpcCompletion* completion) {
+          return backend.HandleCompletion(completion);
+        });
+    std::future<void> received = callback.Expect(kNumDocuments);
+
+    std::chrono::nanoseconds start_cpu_time;
+    worker_queue->EnqueueBlocking([&] {
+      start_cpu_time = ThreadCpuTime();
+      stream->Start();
+    });
+    received.wait();
+
+    state.PauseTiming();
+    worker_queue->EnqueueBlocking([&] {
+      worker_cpu_time += ThreadCpuTime() - start_cpu_time;
+      backend.Stop();
+      stream->Stop();
+    });
+    finished.wait();
+    state.ResumeTiming();
+  }
+
+  state.counters["worker_cpu_ms"] = benchmark::Counter(
+      std::chrono::duration<double, std::milli>(worker_cpu_time).count(),
+      benchmark::Counter::kAvgIterations);
+  state.SetBytesProcessed(state.iterations() * kNumDocuments *
+                          kFieldsPerDocument * kFieldSize);
+  tester.Shutdown();
+}
+BENCHMARK(BM_WatchInitialSync)
+    ->Arg(kOnWorker)
+    ->Arg(kOffQueue)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
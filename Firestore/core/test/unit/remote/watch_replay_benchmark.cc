@@ -0,0 +1,780 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sys/resource.h>
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdint>
+#include <future>  // NOLINT(build/c++11)
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Firestore/Protos/nanopb/google/firestore/v1/firestore.nanopb.h"
+#include "Firestore/core/src/core/database_info.h"
+#include "Firestore/core/src/core/event_manager.h"
+#include "Firestore/core/src/core/query_listener.h"
+#include "Firestore/core/src/core/sync_engine.h"
+#include "Firestore/core/src/core/sync_engine_callback.h"
+#include "Firestore/core/src/core/view_snapshot.h"
+#include "Firestore/core/src/credentials/auth_token.h"
+#include "Firestore/core/src/credentials/user.h"
+#include "Firestore/core/src/local/local_store.h"
+#include "Firestore/core/src/local/persistence.h"
+#include "Firestore/core/src/local/query_engine.h"
+#include "Firestore/core/src/model/database_id.h"
+#include "Firestore/core/src/model/object_value.h"
+#include "Firestore/core/src/nanopb/message.h"
+#include "Firestore/core/src/nanopb/nanopb_util.h"
+#include "Firestore/core/src/remote/datastore.h"
+#include "Firestore/core/src/remote/firebase_metadata_provider.h"
+#include "Firestore/core/src/remote/firebase_metadata_provider_noop.h"
+#include "Firestore/core/src/remote/grpc_completion.h"
+#include "Firestore/core/src/remote/remote_event.h"
+#include "Firestore/core/src/remote/remote_store.h"
+#include "Firestore/core/src/remote/serializer.h"
+#include "Firestore/core/src/remote/watch_change.h"
+#include "Firestore/core/src/remote/watch_stream.h"
+#include "Firestore/core/src/util/async_queue.h"
+#include "Firestore/core/src/util/status.h"
+#include "Firestore/core/test/unit/local/persistence_testing.h"
+#include "Firestore/core/test/unit/remote/create_noop_connectivity_monitor.h"
+#include "Firestore/core/test/unit/remote/fake_credentials_provider.h"
+#include "Firestore/core/test/unit/remote/grpc_stream_tester.h"
+#include "Firestore/core/test/unit/testutil/async_testing.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+namespace {
+
+using core::DatabaseInfo;
+using core::EventManager;
+using core::QueryListener;
+using core::SyncEngine;
+using core::SyncEngineCallback;
+using core::ViewSnapshot;
+using credentials::AuthToken;
+using credentials::User;
+using local::LocalStore;
+using local::Persistence;
+using local::QueryEngine;
+using model::BatchId;
+using model::DatabaseId;
+using model::DocumentKey;
+using model::DocumentKeySet;
+using model::MutationBatchResult;
+using model::ObjectValue;
+using model::OnlineState;
+using model::SnapshotVersion;
+using model::TargetId;
+using nanopb::Message;
+using util::AsyncQueue;
+using util::Status;
+using util::StatusOr;
+
+using Clock = std::chrono::steady_clock;
+using Type = GrpcCompletion::Type;
+using FakeAuthCredentialsProvider = FakeCredentialsProvider<AuthToken, User>;
+using FakeAppCheckCredentialsProvider =
+    FakeCredentialsProvider<std::string, std::string>;
+
+/** The persistence layer the replayed client runs on. */
+enum PersistenceKind {
+  kMemory = 0,
+  kLevelDb = 1,
+};
+
+/** The shape of a generated watch stream. */
+struct WatchReplayOptions {
+  /** The number of targets, each listening to a collection of its own. */
+  int num_targets = 1;
+
+  /** The number of documents in the initial snapshot of each target. */
+  int docs_per_target = 1000;
+
+  /** The number of snapshots that follow the initial one. */
+  int num_updates = 10;
+
+  /**
+   * The percentage of each target's documents that changes between
+   * snapshots. Every fourth changed document is deleted and replaced by a new
+   * one; the others are modified.
+   */
+  int churn_percent = 10;
+
+  int fields_per_document = 10;
+  size_t field_size = 100;
+
+  /** Seeds the choice of changed documents. */
+  uint32_t seed = 1;
+};
+
+/** `ListenResponse` messages as they arrive on the watch stream. */
+struct WatchReplay {
+  std::vector<grpc::ByteBuffer> responses;
+
+  /** The number of global snapshots, i.e. remote events, in `responses`. */
+  int num_snapshots = 0;
+
+  size_t num_bytes = 0;
+};
+
+/**
+ * Encodes a watch stream for the given targets. The output only depends on
+ * the options, so that runs can be compared with each other.
+ */
+class WatchReplayBuilder {
+ public:
+  WatchReplayBuilder(const WatchReplayOptions& options,
+                     std::vector<TargetId> target_ids)
+      : options_{options},
+        target_ids_{std::move(target_ids)},
+        serializer_{DatabaseId{"p", "d"}},
+        rng_{options.seed} {
+    for (int i = 0; i < options_.fields_per_document; ++i) {
+      std::string value(options_.field_size, 'a' + i % 26);
+      data_.Set(testutil::Field(absl::StrCat("field", i)),
+                testutil::Value(value));
+    }
+  }
+
+  WatchReplay Build() {
+    int64_t version = 1;
+    live_docs_.assign(target_ids_.size(), {});
+    next_doc_ids_.assign(target_ids_.size(), options_.docs_per_target);
+
+    AddTargetChange(google_firestore_v1_TargetChange_TargetChangeType_ADD,
+                    target_ids_, version);
+    for (size_t t = 0; t < target_ids_.size(); ++t) {
+      for (int d = 0; d < options_.docs_per_target; ++d) {
+        live_docs_[t].push_back(d);
+        AddDocument(t, d, version);
+      }
+    }
+    AddTargetChange(google_firestore_v1_TargetChange_TargetChangeType_CURRENT,
+                    target_ids_, version);
+    AddSnapshot(version);
+
+    size_t num_changes = static_cast<size_t>(options_.docs_per_target) *
+                         options_.churn_percent / 100;
+    for (int u = 0; u < options_.num_updates; ++u) {
+      ++version;
+      for (size_t t = 0; t < target_ids_.size(); ++t) {
+        std::vector<int>& docs = live_docs_[t];
+        // Moves a random selection of documents to the front, using the
+        // generator directly since distributions vary between platforms.
+        for (size_t i = 0; i < num_changes && i < docs.size(); ++i) {
+          size_t j = i + rng_() % (docs.size() - i);
+          std::swap(docs[i], docs[j]);
+
+          if (i % 4 == 3) {
+            AddDelete(t, docs[i], version);
+            docs[i] = next_doc_ids_[t]++;
+          }
+          AddDocument(t, docs[i], version);
+        }
+      }
+      AddSnapshot(version);
+    }
+
+    return std::move(replay_);
+  }
+
+ private:
+  DocumentKey Key(size_t target, int doc_id) const {
+    return testutil::Key(absl::StrCat("coll", target, "/doc", doc_id));
+  }
+
+  void AddDocument(size_t target, int doc_id, int64_t version) {
+    ObjectValue data = data_;
+    data.Set(testutil::Field("version"), testutil::Value(version));
+
+    Message<google_firestore_v1_ListenResponse> response;
+    response->which_response_type =
+        google_firestore_v1_ListenResponse_document_change_tag;
+    google_firestore_v1_DocumentChange& change = response->document_change;
+    change.document = serializer_.EncodeDocument(Key(target, doc_id), data);
+    change.document.has_update_time = true;
+    change.document.update_time =
+        Serializer::EncodeVersion(testutil::Version(version));
+    change.target_ids_count = 1;
+    change.target_ids = nanopb::MakeArray<int32_t>(1);
+    change.target_ids[0] = target_ids_[target];
+    Add(response);
+  }
+
+  void AddDelete(size_t target, int doc_id, int64_t version) {
+    Message<google_firestore_v1_ListenResponse> response;
+    response->which_response_type =
+        google_firestore_v1_ListenResponse_document_delete_tag;
+    google_firestore_v1_DocumentDelete& change = response->document_delete;
+    change.document = serializer_.EncodeKey(Key(target, doc_id));
+    change.has_read_time = true;
+    change.read_time = Serializer::EncodeVersion(testutil::Version(version));
+    change.removed_target_ids_count = 1;
+    change.removed_target_ids = nanopb::MakeArray<int32_t>(1);
+    change.removed_target_ids[0] = target_ids_[target];
+    Add(response);
+  }
+
+  void AddTargetChange(google_firestore_v1_TargetChange_TargetChangeType type,
+                       const std::vector<TargetId>& target_ids,
+                       int64_t version) {
+    Message<google_firestore_v1_ListenResponse> response;
+    response->which_response_type =
+        google_firestore_v1_ListenResponse_target_change_tag;
+    google_firestore_v1_TargetChange& change = response->target_change;
+    change.target_change_type = type;
+    change.target_ids_count = static_cast<pb_size_t>(target_ids.size());
+    change.target_ids = nanopb::MakeArray<int32_t>(change.target_ids_count);
+    for (size_t i = 0; i < target_ids.size(); ++i) {
+      change.target_ids[i] = target_ids[i];
+    }
+    change.resume_token =
+        nanopb::MakeBytesArray(absl::StrCat("resume-token-", version));
+    if (target_ids.empty()) {
+      change.read_time = Serializer::EncodeVersion(testutil::Version(version));
+    }
+    Add(response);
+  }
+
+  /** Ends a snapshot: a change without targets raises a remote event. */
+  void AddSnapshot(int64_t version) {
+    AddTargetChange(google_firestore_v1_TargetChange_TargetChangeType_NO_CHANGE,
+                    {}, version);
+    ++replay_.num_snapshots;
+  }
+
+  void Add(const Message<google_firestore_v1_ListenResponse>& response) {
+    std::string bytes = nanopb::MakeStdString(response);
+    replay_.num_bytes += bytes.size();
+    replay_.responses.push_back(MakeByteBuffer(bytes));
+  }
+
+  WatchReplayOptions options_;
+  std::vector<TargetId> target_ids_;
+  Serializer serializer_;
+  std::mt19937 rng_;
+  ObjectValue data_;
+
+  std::vector<std::vector<int>> live_docs_;
+  std::vector<int> next_doc_ids_;
+  WatchReplay replay_;
+};
+
+/**
+ * Stands in for the backend end of the watch stream: acknowledges listen
+ * requests, hands out the loaded responses one per read and holds the read
+ * after the last one.
+ *
+ * Completing a read runs the decoding step of the watch stream on the calling
+ * thread, which makes it possible to measure the time spent decoding.
+ */
+class ReplayBackend {
+ public:
+  /** Starts serving `responses`, which must outlive the replay. */
+  void Load(const std::vector<grpc::ByteBuffer>* responses) {
+    std::lock_guard<std::mutex> lock{mutex_};
+    responses_ = responses;
+    next_response_ = 0;
+    decode_time_ = {};
+    stopped_ = false;
+    if (held_read_) {
+      GrpcCompletion* read = held_read_;
+      held_read_ = nullptr;
+      ServeRead(read);
+    }
+  }
+
+  /**
+   * Fails the held read so that the stream can be finished. Must be called
+   * before the stream is stopped.
+   */
+  void Stop() {
+    std::lock_guard<std::mutex> lock{mutex_};
+    stopped_ = true;
+    responses_ = nullptr;
+    if (held_read_) {
+      held_read_->Complete(false);
+      held_read_ = nullptr;
+    }
+  }
+
+  Clock::duration decode_time() {
+    std::lock_guard<std::mutex> lock{mutex_};
+    return decode_time_;
+  }
+
+  /**
+   * Handles a completion taken off the gRPC completion queue; returns true
+   * once the call is finished.
+   */
+  bool HandleCompletion(GrpcCompletion* completion) {
+    std::lock_guard<std::mutex> lock{mutex_};
+    switch (completion->type()) {
+      case Type::Read:
+        if (stopped_) {
+          completion->Complete(false);
+        } else {
+          ServeRead(completion);
+        }
+        return false;
+
+      case Type::Start:
+      case Type::Write:
+        break;
+
+      case Type::Finish:
+        completion->Complete(true);
+        return true;
+    }
+    completion->Complete(true);
+    return false;
+  }
+
+ private:
+  void ServeRead(GrpcCompletion* read) {
+    if (!responses_ || next_response_ == responses_->size()) {
+      held_read_ = read;
+      return;
+    }
+
+    *read->message() = (*responses_)[next_response_++];
+    Clock::time_point start = Clock::now();
+    read->Complete(true);
+    decode_time_ += Clock::now() - start;
+  }
+
+  std::mutex mutex_;
+  const std::vector<grpc::ByteBuffer>* responses_ = nullptr;
+  size_t next_response_ = 0;
+  GrpcCompletion* held_read_ = nullptr;
+  bool stopped_ = false;
+  Clock::duration decode_time_{};
+};
+
+/**
+ * Wall time spent in the nested callbacks that carry a watch change from the
+ * watch stream to the query listeners, all of which run on the worker queue.
+ */
+struct StageTimes {
+  /** `RemoteStore` handling watch changes, including all of the below. */
+  Clock::duration watch_change{};
+
+  /** `SyncEngine` applying remote events, including all of the below. */
+  Clock::duration remote_event{};
+
+  /** `EventManager` dispatching view snapshots to listeners. */
+  Clock::duration view_snapshots{};
+};
+
+template <typename F>
+void AddTime(Clock::duration* total, F&& block) {
+  Clock::time_point start = Clock::now();
+  block();
+  *total += Clock::now() - start;
+}
+
+class TimedWatchStreamCallback : public WatchStreamCallback {
+ public:
+  TimedWatchStreamCallback(WatchStreamCallback* delegate, StageTimes* times)
+      : delegate_{delegate}, times_{times} {
+  }
+
+  void OnWatchStreamOpen() override {
+    delegate_->OnWatchStreamOpen();
+  }
+
+  void OnWatchStreamChange(const WatchChange& change,
+                           const SnapshotVersion& snapshot_version) override {
+    AddTime(&times_->watch_change, [&] {
+      delegate_->OnWatchStreamChange(change, snapshot_version);
+    });
+  }
+
+  void OnWatchStreamClose(const Status& status) override {
+    delegate_->OnWatchStreamClose(status);
+  }
+
+ private:
+  WatchStreamCallback* delegate_ = nullptr;
+  StageTimes* times_ = nullptr;
+};
+
+/** Times remote events and signals once the expected number was applied. */
+class TimedRemoteStoreCallback : public RemoteStoreCallback {
+ public:
+  TimedRemoteStoreCallback(RemoteStoreCallback* delegate, StageTimes* times)
+      : delegate_{delegate}, times_{times} {
+  }
+
+  std::future<void> Expect(int num_events) {
+    remaining_ = num_events;
+    applied_ = {};
+    return applied_.get_future();
+  }
+
+  void ApplyRemoteEvent(const RemoteEvent& remote_event) override {
+    AddTime(&times_->remote_event,
+            [&] { delegate_->ApplyRemoteEvent(remote_event); });
+    if (remaining_ > 0 && --remaining_ == 0) {
+      applied_.set_value();
+    }
+  }
+
+  void HandleRejectedListen(TargetId target_id, Status error) override {
+    delegate_->HandleRejectedListen(target_id, std::move(error));
+  }
+
+  void HandleSuccessfulWrite(MutationBatchResult batch_result) override {
+    delegate_->HandleSuccessfulWrite(std::move(batch_result));
+  }
+
+  void HandleRejectedWrite(BatchId batch_id, Status error) override {
+    delegate_->HandleRejectedWrite(batch_id, std::move(error));
+  }
+
+  void HandleOnlineStateChange(OnlineState online_state) override {
+    delegate_->HandleOnlineStateChange(online_state);
+  }
+
+  DocumentKeySet GetRemoteKeys(TargetId target_id) const override {
+    return delegate_->GetRemoteKeys(target_id);
+  }
+
+ private:
+  RemoteStoreCallback* delegate_ = nullptr;
+  StageTimes* times_ = nullptr;
+  int remaining_ = 0;
+  std::promise<void> applied_;
+};
+
+class TimedSyncEngineCallback : public SyncEngineCallback {
+ public:
+  TimedSyncEngineCallback(SyncEngineCallback* delegate, StageTimes* times)
+      : delegate_{delegate}, times_{times} {
+  }
+
+  void HandleOnlineStateChange(OnlineState online_state) override {
+    delegate_->HandleOnlineStateChange(online_state);
+  }
+
+  void OnViewSnapshots(std::vector<ViewSnapshot>&& snapshots) override {
+    AddTime(&times_->view_snapshots,
+            [&] { delegate_->OnViewSnapshots(std::move(snapshots)); });
+  }
+
+  void OnError(const core::Query& query, const Status& error) override {
+    delegate_->OnError(query, error);
+  }
+
+ private:
+  SyncEngineCallback* delegate_ = nullptr;
+  StageTimes* times_ = nullptr;
+};
+
+/** A `WatchStream` whose gRPC calls are completed by a `GrpcStreamTester`. */
+class ReplayWatchStream : public WatchStream {
+ public:
+  ReplayWatchStream(const std::shared_ptr<AsyncQueue>& worker_queue,
+                    GrpcStreamTester* tester,
+                    WatchStreamCallback* callback)
+      : WatchStream{worker_queue,
+                    std::make_shared<FakeAuthCredentialsProvider>(),
+                    std::make_shared<FakeAppCheckCredentialsProvider>(),
+                    Serializer{DatabaseId{"p", "d"}},
+                    tester->grpc_connection(),
+                    callback},
+        tester_{tester} {
+  }
+
+ private:
+  std::unique_ptr<GrpcStream> CreateGrpcStream(GrpcConnection*,
+                                               const AuthToken&,
+                                               const std::string&) override {
+    std::unique_ptr<GrpcStream> stream = tester_->CreateStream(this);
+    // Makes gRPC hand every operation straight back to the tester.
+    stream->context()->TryCancel();
+    return stream;
+  }
+
+  GrpcStreamTester* tester_ = nullptr;
+};
+
+/** A `Datastore` whose watch streams are served by a `ReplayBackend`. */
+class ReplayDatastore : public Datastore {
+ public:
+  ReplayDatastore(const DatabaseInfo& database_info,
+                  const std::shared_ptr<AsyncQueue>& worker_queue,
+                  ConnectivityMonitor* connectivity_monitor,
+                  FirebaseMetadataProvider* firebase_metadata_provider,
+                  GrpcStreamTester* tester,
+                  StageTimes* times)
+      : Datastore{database_info,
+                  worker_queue,
+                  std::make_shared<FakeAuthCredentialsProvider>(),
+                  std::make_shared<FakeAppCheckCredentialsProvider>(),
+                  connectivity_monitor,
+                  firebase_metadata_provider},
+        worker_queue_{worker_queue},
+        tester_{tester},
+        times_{times} {
+  }
+
+  std::shared_ptr<WatchStream> CreateWatchStream(
+      WatchStreamCallback* callback) override {
+    watch_callback_ =
+        absl::make_unique<TimedWatchStreamCallback>(callback, times_);
+    return std::make_shared<ReplayWatchStream>(worker_queue_, tester_,
+                                               watch_callback_.get());
+  }
+
+ private:
+  std::shared_ptr<AsyncQueue> worker_queue_;
+  GrpcStreamTester* tester_ = nullptr;
+  StageTimes* times_ = nullptr;
+  std::unique_ptr<TimedWatchStreamCallback> watch_callback_;
+};
+
+/**
+ * The components of a `FirestoreClient` that process watch changes, wired up
+ * the same way but with timing callbacks between them. Must be created, used
+ * and destroyed on the worker queue.
+ */
+class ReplayClient {
+ public:
+  ReplayClient(PersistenceKind kind,
+               const std::shared_ptr<AsyncQueue>& worker_queue,
+               ConnectivityMonitor* connectivity_monitor,
+               GrpcStreamTester* tester)
+      : database_info_{DatabaseId{"p", "d"}, "", "localhost", false},
+        firebase_metadata_provider_{CreateFirebaseMetadataProviderNoOp()} {
+    if (kind == kMemory) {
+      persistence_ = local::MemoryPersistenceWithLruGcForTesting();
+    } else {
+      persistence_ = local::LevelDbPersistenceForTesting();
+    }
+    local_store_ = absl::make_unique<LocalStore>(
+        persistence_.get(), &query_engine_, User::Unauthenticated());
+    local_store_->Start();
+
+    auto datastore = std::make_shared<ReplayDatastore>(
+        database_info_, worker_queue, connectivity_monitor,
+        firebase_metadata_provider_.get(), tester, &times_);
+    remote_store_ = absl::make_unique<RemoteStore>(
+        local_store_.get(), std::move(datastore), worker_queue,
+        connectivity_monitor, [this](OnlineState online_state) {
+          sync_engine_->HandleOnlineStateChange(online_state);
+        });
+    sync_engine_ = absl::make_unique<SyncEngine>(
+        local_store_.get(), remote_store_.get(), User::Unauthenticated(),
+        /*max_concurrent_limbo_resolutions=*/100);
+    event_manager_ = absl::make_unique<EventManager>(sync_engine_.get());
+
+    remote_store_callback_ = absl::make_unique<TimedRemoteStoreCallback>(
+        sync_engine_.get(), &times_);
+    sync_engine_callback_ = absl::make_unique<TimedSyncEngineCallback>(
+        event_manager_.get(), &times_);
+    remote_store_->set_sync_engine(remote_store_callback_.get());
+    sync_engine_->SetCallback(sync_engine_callback_.get());
+
+    remote_store_->Start();
+  }
+
+  /**
+   * Listens to one collection per target, which starts the watch stream, and
+   * returns the target IDs in order.
+   */
+  std::vector<TargetId> Listen(int num_targets) {
+    std::vector<TargetId> target_ids;
+    for (int t = 0; t < num_targets; ++t) {
+      auto listener = QueryListener::Create(
+          testutil::Query(absl::StrCat("coll", t)),
+          [](const StatusOr<ViewSnapshot>&) {});
+      target_ids.push_back(event_manager_->AddQueryListener(listener));
+      listeners_.push_back(std::move(listener));
+    }
+    return target_ids;
+  }
+
+  /** Returns a future that is ready once `num_events` were applied. */
+  std::future<void> Expect(int num_events) {
+    times_ = {};
+    return remote_store_callback_->Expect(num_events);
+  }
+
+  const StageTimes& times() const {
+    return times_;
+  }
+
+  void Shutdown() {
+    remote_store_->Shutdown();
+    persistence_->Shutdown();
+  }
+
+ private:
+  DatabaseInfo database_info_;
+  std::unique_ptr<FirebaseMetadataProvider> firebase_metadata_provider_;
+  StageTimes times_;
+
+  std::unique_ptr<Persistence> persistence_;
+  QueryEngine query_engine_;
+  std::unique_ptr<LocalStore> local_store_;
+  std::unique_ptr<RemoteStore> remote_store_;
+  std::unique_ptr<SyncEngine> sync_engine_;
+  std::unique_ptr<EventManager> event_manager_;
+  std::unique_ptr<TimedRemoteStoreCallback> remote_store_callback_;
+  std::unique_ptr<TimedSyncEngineCallback> sync_engine_callback_;
+  std::vector<std::shared_ptr<QueryListener>> listeners_;
+};
+
+/** The high-water mark of the resident set size of the process. */
+double PeakResidentSetMegabytes() {
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+  return static_cast<double>(usage.ru_maxrss) / (1024 * 1024);
+#else
+  return static_cast<double>(usage.ru_maxrss) / 1024;
+#endif
+}
+
+double Milliseconds(Clock::duration duration) {
+  return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+/**
+ * Runs the persistence layer selected by `range(0)` with `range(1)` targets
+ * of `range(2)` documents each, changing `range(3)` percent of them per
+ * update.
+ */
+void ReplayConfigurations(benchmark::internal::Benchmark* b) {
+  for (int kind : {kMemory, kLevelDb}) {
+    b->Args({kind, 1, 1000, 10});
+    b->Args({kind, 1, 10000, 1});
+    b->Args({kind, 10, 1000, 10});
+    b->Args({kind, 10, 1000, 50});
+  }
+}
+
+/**
+ * Replays a generated watch stream (an initial sync followed by
+ * `num_updates` snapshots) through the watch stream, `RemoteStore`,
+ * `LocalStore`, `SyncEngine` and `EventManager`, as `FirestoreClient` wires
+ * them up, and reports the time spent in each stage:
+ *
+ *   - decode_ms: parsing and decoding responses, off the worker queue;
+ *   - aggregate_ms: `WatchChangeAggregator` building remote events;
+ *   - local_store_and_views_ms: `LocalStore::ApplyRemoteEvent` and computing
+ *     views in the `SyncEngine`;
+ *   - dispatch_ms: raising view snapshots to query listeners.
+ *
+ * Items are remote events, so items_per_second is the event rate.
+ * peak_rss_mb is the high-water mark of the whole process; run one
+ * configuration at a time (--benchmark_filter) to attribute it.
+ */
+void BM_WatchReplay(benchmark::State& state) {
+  auto kind = static_cast<PersistenceKind>(state.range(0));
+  state.SetLabel(kind == kMemory ? "memory" : "leveldb");
+
+  WatchReplayOptions options;
+  options.num_targets = static_cast<int>(state.range(1));
+  options.docs_per_target = static_cast<int>(state.range(2));
+  options.churn_percent = static_cast<int>(state.range(3));
+
+  std::shared_ptr<AsyncQueue> worker_queue = testutil::AsyncQueueForTesting();
+  std::unique_ptr<ConnectivityMonitor> connectivity_monitor =
+      CreateNoOpConnectivityMonitor();
+  GrpcStreamTester tester{worker_queue, connectivity_monitor.get()};
+  ReplayBackend backend;
+
+  Clock::duration decode_time{};
+  StageTimes times;
+  int64_t num_events = 0;
+  int64_t num_bytes = 0;
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::future<void> finished =
+        tester.ForceFinishAsync([&](GrpcCompletion* completion) {
+          return backend.HandleCompletion(completion);
+        });
+
+    std::unique_ptr<ReplayClient> client;
+    std::vector<TargetId> target_ids;
+    worker_queue->EnqueueBlocking([&] {
+      client = absl::make_unique<ReplayClient>(
+          kind, worker_queue, connectivity_monitor.get(), &tester);
+      target_ids = client->Listen(options.num_targets);
+    });
+
+    WatchReplay replay = WatchReplayBuilder(options, target_ids).Build();
+    std::future<void> applied;
+    worker_queue->EnqueueBlocking(
+        [&] { applied = client->Expect(replay.num_snapshots); });
+    state.ResumeTiming();
+
+    backend.Load(&replay.responses);
+    applied.wait();
+
+    state.PauseTiming();
+    decode_time += backend.decode_time();
+    num_events += replay.num_snapshots;
+    num_bytes += static_cast<int64_t>(replay.num_bytes);
+    worker_queue->EnqueueBlocking([&] {
+      times.watch_change += client->times().watch_change;
+      times.remote_event += client->times().remote_event;
+      times.view_snapshots += client->times().view_snapshots;
+      backend.Stop();
+      client->Shutdown();
+    });
+    finished.wait();
+    worker_queue->EnqueueBlocking([&] { client.reset(); });
+    state.ResumeTiming();
+  }
+
+  auto per_iteration = [](Clock::duration duration) {
+    return benchmark::Counter(Milliseconds(duration),
+                              benchmark::Counter::kAvgIterations);
+  };
+  state.counters["decode_ms"] = per_iteration(decode_time);
+  state.counters["aggregate_ms"] =
+      per_iteration(times.watch_change - times.remote_event);
+  state.counters["local_store_and_views_ms"] =
+      per_iteration(times.remote_event - times.view_snapshots);
+  state.counters["dispatch_ms"] = per_iteration(times.view_snapshots);
+  state.counters["peak_rss_mb"] = PeakResidentSetMegabytes();
+  state.SetItemsProcessed(num_events);
+  state.SetBytesProcessed(num_bytes);
+  tester.Shutdown();
+}
+BENCHMARK(BM_WatchReplay)
+    ->Apply(ReplayConfigurations)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,392 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>              // NOLINT(build/c++11)
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <deque>
+#include <future>  // NOLINT(build/c++11)
+#include <memory>
+#include <mutex>   // NOLINT(build/c++11)
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
+
+#include "Firestore/Protos/nanopb/google/firestore/v1/firestore.nanopb.h"
+#include "Firestore/core/include/firebase/firestore/timestamp.h"
+#include "Firestore/core/src/credentials/auth_token.h"
+#include "Firestore/core/src/credentials/user.h"
+#include "Firestore/core/src/model/database_id.h"
+#include "Firestore/core/src/model/mutation.h"
+#include "Firestore/core/src/model/mutation_batch.h"
+#include "Firestore/core/src/model/mutation_batch_result.h"
+#include "Firestore/core/src/nanopb/message.h"
+#include "Firestore/core/src/nanopb/nanopb_util.h"
+#include "Firestore/core/src/remote/grpc_completion.h"
+#include "Firestore/core/src/remote/serializer.h"
+#include "Firestore/core/src/remote/write_pipeline.h"
+#include "Firestore/core/src/remote/write_stream.h"
+#include "Firestore/core/src/util/async_queue.h"
+#include "Firestore/core/src/util/status.h"
+#include "Firestore/core/test/unit/remote/create_noop_connectivity_monitor.h"
+#include "Firestore/core/test/unit/remote/fake_credentials_provider.h"
+#include "Firestore/core/test/unit/remote/grpc_stream_tester.h"
+#include "Firestore/core/test/unit/testutil/async_testing.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+namespace {
+
+using credentials::AuthToken;
+using credentials::User;
+using model::DatabaseId;
+using model::Mutation;
+using model::MutationBatch;
+using model::MutationResult;
+using model::SnapshotVersion;
+using nanopb::Message;
+using util::AsyncQueue;
+using util::Status;
+
+using Clock = std::chrono::steady_clock;
+using Type = GrpcCompletion::Type;
+using FakeAuthCredentialsProvider = FakeCredentialsProvider<AuthToken, User>;
+using FakeAppCheckCredentialsProvider =
+    FakeCredentialsProvider<std::string, std::string>;
+
+constexpr int kNumBatches = 1000;
+
+/** How the pipeline under test is configured. */
+enum PipelineMode {
+  // One batch per request and a fixed depth of 10.
+  kFixed = 0,
+  // `WritePipelineSettings::Adaptive()`.
+  kAdaptive = 1,
+};
+
+/**
+ * Stands in for the backend end of a write stream: completes every write as
+ * soon as gRPC hands it over and answers each request with a `WriteResponse`
+ * once `latency` has passed, one response per pending read.
+ */
+class FakeWriteBackend {
+ public:
+  explicit FakeWriteBackend(Clock::duration latency)
+      : latency_{latency}, responder_{[this] { Respond(); }} {
+  }
+
+  ~FakeWriteBackend() {
+    Stop();
+    responder_.join();
+  }
+
+  /**
+   * Announces that the next request written to the stream carries
+   * `mutation_count` mutations; the handshake carries none.
+   */
+  void ExpectRequest(size_t mutation_count) {
+    std::lock_guard<std::mutex> lock{mutex_};
+    expected_requests_.push_back(mutation_count);
+  }
+
+  /**
+   * Fails the outstanding read so that the stream can be finished. Must be
+   * called before the stream is stopped.
+   */
+  void Stop() {
+    std::lock_guard<std::mutex> lock{mutex_};
+    stopped_ = true;
+    cv_.notify_all();
+  }
+
+  /**
+   * Handles a completion taken off the gRPC completion queue; returns true
+   * once the call is finished.
+   */
+  bool HandleCompletion(GrpcCompletion* completion) {
+    std::lock_guard<std::mutex> lock{mutex_};
+    switch (completion->type()) {
+      case Type::Read:
+        if (stopped_) {
+          completion->Complete(false);
+        } else {
+          pending_read_ = completion;
+          cv_.notify_all();
+        }
+        return false;
+
+      case Type::Write:
+        // The empty request sent when the stream is torn down is not
+        // expected and gets no response.
+        if (!expected_requests_.empty()) {
+          responses_.push_back(
+              {Clock::now() + latency_,
+               MakeResponse(expected_requests_.front())});
+          expected_requests_.pop_front();
+          cv_.notify_all();
+        }
+        completion->Complete(true);
+        return false;
+
+      case Type::Start:
+        break;
+
+      case Type::Finish:
+        completion->Complete(true);
+        return true;
+    }
+    completion->Complete(true);
+    return false;
+  }
+
+ private:
+  struct Response {
+    Clock::time_point due;
+    grpc::ByteBuffer message;
+  };
+
+  static grpc::ByteBuffer MakeResponse(size_t mutation_count) {
+    Message<google_firestore_v1_WriteResponse> response;
+    response->stream_token = nanopb::MakeBytesArray("token");
+    response->commit_time.seconds = 1;
+    if (mutation_count > 0) {
+      response->write_results_count = nanopb::CheckedSize(mutation_count);
+      response->write_results =
+          nanopb::MakeArray<google_firestore_v1_WriteResult>(
+              response->write_results_count);
+    }
+    return MakeByteBuffer(nanopb::MakeStdString(response));
+  }
+
+  /** Delivers each response to the pending read once it is due. */
+  void Respond() {
+    std::unique_lock<std::mutex> lock{mutex_};
+    while (true) {
+      cv_.wait(lock, [&] {
+        return stopped_ || (pending_read_ && !responses_.empty());
+      });
+
+      if (stopped_) {
+        if (pending_read_) {
+          pending_read_->Complete(false);
+          pending_read_ = nullptr;
+        }
+        return;
+      }
+
+      Clock::time_point due = responses_.front().due;
+      if (Clock::now() < due) {
+        cv_.wait_until(lock, due);
+        continue;
+      }
+
+      *pending_read_->message() = std::move(responses_.front().message);
+      responses_.pop_front();
+      pending_read_->Complete(true);
+      pending_read_ = nullptr;
+    }
+  }
+
+  Clock::duration latency_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<size_t> expected_requests_;
+  std::deque<Response> responses_;
+  GrpcCompletion* pending_read_ = nullptr;
+  bool stopped_ = false;
+
+  std::thread responder_;
+};
+
+/** A `WriteStream` whose gRPC calls are completed by a `GrpcStreamTester`. */
+class BenchmarkWriteStream : public WriteStream {
+ public:
+  BenchmarkWriteStream(const std::shared_ptr<AsyncQueue>& worker_queue,
+                       GrpcStreamTester* tester,
+                       WriteStreamCallback* callback)
+      : WriteStream{worker_queue,
+                    std::make_shared<FakeAuthCredentialsProvider>(),
+                    std::make_shared<FakeAppCheckCredentialsProvider>(),
+                    Serializer{DatabaseId{"p", "d"}},
+                    tester->grpc_connection(),
+                    callback},
+        tester_{tester} {
+  }
+
+ private:
+  std::unique_ptr<GrpcStream> CreateGrpcStream(GrpcConnection*,
+                                               const AuthToken&,
+                                               const std::string&) override {
+    std::unique_ptr<GrpcStream> stream = tester_->CreateStream(this);
+    // Makes gRPC hand every operation straight back to the tester.
+    stream->context()->TryCancel();
+    return stream;
+  }
+
+  GrpcStreamTester* tester_ = nullptr;
+};
+
+/**
+ * Feeds batches through a `WritePipeline` onto a write stream, the way
+ * `RemoteStore` does, and reports when all of them are acknowledged. Runs on
+ * the worker queue.
+ */
+class PipelineDriver : public WriteStreamCallback {
+ public:
+  PipelineDriver(WritePipelineSettings settings, FakeWriteBackend* backend)
+      : pipeline_{settings}, backend_{backend} {
+  }
+
+  void set_stream(WriteStream* stream) {
+    stream_ = stream;
+  }
+
+  std::future<void> Drain(std::deque<MutationBatch> batches) {
+    unsent_ = std::move(batches);
+    drained_ = {};
+    std::future<void> result = drained_.get_future();
+    if (stream_->IsStarted()) {
+      Fill();
+    } else {
+      stream_->Start();
+    }
+    return result;
+  }
+
+  void OnWriteStreamOpen() override {
+    pipeline_.ResetStream();
+    backend_->ExpectRequest(0);
+    stream_->WriteHandshake();
+  }
+
+  void OnWriteStreamHandshakeComplete() override {
+    Fill();
+  }
+
+  void OnWriteStreamMutationResult(
+      SnapshotVersion commit_version,
+      std::vector<MutationResult> mutation_results) override {
+    pipeline_.Acknowledge(commit_version, std::move(mutation_results),
+                          stream_->last_stream_token());
+    Fill();
+    if (pipeline_.empty() && unsent_.empty()) {
+      drained_.set_value();
+    }
+  }
+
+  void OnWriteStreamClose(const Status&) override {
+  }
+
+ private:
+  void Fill() {
+    while (!pipeline_.full() && !unsent_.empty()) {
+      pipeline_.Add(std::move(unsent_.front()));
+      unsent_.pop_front();
+    }
+    if (stream_->IsOpen() && stream_->handshake_complete()) {
+      pipeline_.SendPending([&](const std::vector<Mutation>& mutations) {
+        backend_->ExpectRequest(mutations.size());
+        stream_->WriteMutations(mutations);
+      });
+    }
+  }
+
+  WritePipeline pipeline_;
+  FakeWriteBackend* backend_ = nullptr;
+  WriteStream* stream_ = nullptr;
+
+  std::deque<MutationBatch> unsent_;
+  std::promise<void> drained_;
+};
+
+std::deque<MutationBatch> MakeBatches(int first_batch_id) {
+  std::deque<MutationBatch> batches;
+  for (int i = 0; i < kNumBatches; ++i) {
+    int batch_id = first_batch_id + i;
+    batches.emplace_back(
+        batch_id, Timestamp::Now(), std::vector<Mutation>{},
+        std::vector<Mutation>{testutil::SetMutation(
+            absl::StrCat("coll/doc", batch_id), testutil::Map("n", i))});
+  }
+  return batches;
+}
+
+/**
+ * Measures how long it takes to drain `kNumBatches` single-write batches
+ * through a write stream to a backend that answers after `state.range(1)`
+ * milliseconds, with the pipeline configured by `state.range(0)`.
+ */
+void BM_DrainWritePipeline(benchmark::State& state) {
+  auto mode = static_cast<PipelineMode>(state.range(0));
+  std::chrono::milliseconds latency{state.range(1)};
+  state.SetLabel(mode == kFixed ? "fixed" : "adaptive");
+
+  std::shared_ptr<AsyncQueue> worker_queue = testutil::AsyncQueueForTesting();
+  std::unique_ptr<ConnectivityMonitor> connectivity_monitor =
+      CreateNoOpConnectivityMonitor();
+  GrpcStreamTester tester{worker_queue, connectivity_monitor.get()};
+  FakeWriteBackend backend{latency};
+
+  PipelineDriver driver{mode == kFixed ? WritePipelineSettings{}
+                                       : WritePipelineSettings::Adaptive(),
+                        &backend};
+  auto stream =
+      std::make_shared<BenchmarkWriteStream>(worker_queue, &tester, &driver);
+  driver.set_stream(stream.get());
+
+  std::future<void> finished = tester.ForceFinishAsync(
+      [&](GrpcCompletion* completion) {
+        return backend.HandleCompletion(completion);
+      });
+
+  int next_batch_id = 1;
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::deque<MutationBatch> batches = MakeBatches(next_batch_id);
+    next_batch_id += kNumBatches;
+    state.ResumeTiming();
+
+    std::future<void> drained;
+    worker_queue->EnqueueBlocking(
+        [&] { drained = driver.Drain(std::move(batches)); });
+    drained.wait();
+  }
+  state.SetItemsProcessed(state.iterations() * kNumBatches);
+
+  worker_queue->EnqueueBlocking([&] {
+    backend.Stop();
+    stream->Stop();
+  });
+  finished.wait();
+  tester.Shutdown();
+}
+BENCHMARK(BM_DrainWritePipeline)
+    ->Args({kFixed, 1})
+    ->Args({kAdaptive, 1})
+    ->Args({kFixed, 5})
+    ->Args({kAdaptive, 5})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
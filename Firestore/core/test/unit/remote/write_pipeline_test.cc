@@ -0,0 +1,222 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/remote/write_pipeline.h"
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "Firestore/core/include/firebase/firestore/timestamp.h"
+#include "Firestore/core/src/model/mutation.h"
+#include "Firestore/core/src/model/mutation_batch.h"
+#include "Firestore/core/src/model/mutation_batch_result.h"
+#include "Firestore/core/test/unit/testutil/testutil.h"
+#include "absl/strings/str_cat.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+using model::BatchId;
+using model::Mutation;
+using model::MutationBatch;
+using model::MutationBatchResult;
+using model::MutationResult;
+using testutil::Map;
+using testutil::SetMutation;
+using testutil::Version;
+
+namespace {
+
+MutationBatch Batch(BatchId batch_id, int num_mutations = 1) {
+  std::vector<Mutation> mutations;
+  for (int i = 0; i < num_mutations; ++i) {
+    mutations.push_back(
+        SetMutation(absl::StrCat("coll/doc", batch_id, "_", i), Map()));
+  }
+  return MutationBatch(batch_id, Timestamp::Now(), {}, std::move(mutations));
+}
+
+std::vector<MutationResult> Results(size_t count) {
+  std::vector<MutationResult> results;
+  for (size_t i = 0; i < count; ++i) {
+    results.push_back(testutil::MutationResult(5));
+  }
+  return results;
+}
+
+WritePipelineSettings PackingSettings() {
+  WritePipelineSettings settings;
+  settings.max_batches_per_request = 3;
+  settings.max_mutations_per_request = 4;
+  return settings;
+}
+
+}  // namespace
+
+class WritePipelineTest : public testing::Test {
+ public:
+  WritePipeline::Clock::time_point Now() const {
+    return now_;
+  }
+
+  void Advance(std::chrono::milliseconds duration) {
+    now_ += duration;
+  }
+
+  WritePipeline MakePipeline(WritePipelineSettings settings) {
+    return WritePipeline(settings, [this] { return Now(); });
+  }
+
+  /** Sends the pending batches and returns the size of each request. */
+  std::vector<size_t> Send(WritePipeline& pipeline) {
+    std::vector<size_t> request_sizes;
+    pipeline.SendPending([&](const std::vector<Mutation>& mutations) {
+      request_sizes.push_back(mutations.size());
+    });
+    return request_sizes;
+  }
+
+ private:
+  WritePipeline::Clock::time_point now_;
+};
+
+TEST_F(WritePipelineTest, SendsOneBatchPerRequestByDefault) {
+  WritePipeline pipeline = MakePipeline({});
+  pipeline.Add(Batch(1));
+  pipeline.Add(Batch(2, 2));
+
+  EXPECT_EQ(Send(pipeline), (std::vector<size_t>{1, 2}));
+  EXPECT_TRUE(Send(pipeline).empty());
+
+  std::vector<MutationBatchResult> results =
+      pipeline.Acknowledge(Version(5), Results(1), {});
+  ASSERT_EQ(results.size(), 1u);
+  EXPECT_EQ(results[0].batch().batch_id(), 1);
+  EXPECT_EQ(pipeline.size(), 1u);
+}
+
+TEST_F(WritePipelineTest, PacksBatchesWithinLimits) {
+  WritePipeline pipeline = MakePipeline(PackingSettings());
+  for (BatchId batch_id = 1; batch_id <= 5; ++batch_id) {
+    pipeline.Add(Batch(batch_id));
+  }
+  pipeline.Add(Batch(6, 3));
+  pipeline.Add(Batch(7, 5));
+
+  // Batches 1-3 hit the batch limit; 4-5 can't take the three mutations of 6
+  // without exceeding the mutation limit; 7 is too large to share a request.
+  EXPECT_EQ(Send(pipeline), (std::vector<size_t>{3, 2, 3, 5}));
+}
+
+TEST_F(WritePipelineTest, SplitsResultsOfPackedRequest) {
+  WritePipeline pipeline = MakePipeline(PackingSettings());
+  pipeline.Add(Batch(1, 1));
+  pipeline.Add(Batch(2, 3));
+  ASSERT_EQ(Send(pipeline), (std::vector<size_t>{4}));
+
+  std::vector<MutationBatchResult> results =
+      pipeline.Acknowledge(Version(5), Results(4), {});
+  ASSERT_EQ(results.size(), 2u);
+  EXPECT_EQ(results[0].batch().batch_id(), 1);
+  EXPECT_EQ(results[0].mutation_results().size(), 1u);
+  EXPECT_EQ(results[1].batch().batch_id(), 2);
+  EXPECT_EQ(results[1].mutation_results().size(), 3u);
+  EXPECT_EQ(results[1].commit_version(), Version(5));
+  EXPECT_TRUE(pipeline.empty());
+}
+
+TEST_F(WritePipelineTest, ResendsAfterStreamReset) {
+  WritePipeline pipeline = MakePipeline(PackingSettings());
+  pipeline.Add(Batch(1));
+  pipeline.Add(Batch(2));
+  ASSERT_EQ(Send(pipeline), (std::vector<size_t>{2}));
+
+  pipeline.ResetStream();
+  pipeline.Add(Batch(3));
+  EXPECT_EQ(Send(pipeline), (std::vector<size_t>{3}));
+}
+
+TEST_F(WritePipelineTest, UnpacksRequestThatFailed) {
+  WritePipeline pipeline = MakePipeline(PackingSettings());
+  pipeline.Add(Batch(1));
+  pipeline.Add(Batch(2));
+  pipeline.Add(Batch(3));
+  ASSERT_EQ(Send(pipeline), (std::vector<size_t>{3}));
+
+  // The failing batch is unknown, so nothing is rejected yet.
+  EXPECT_FALSE(pipeline.Reject());
+  EXPECT_EQ(pipeline.size(), 3u);
+
+  pipeline.ResetStream();
+  pipeline.Add(Batch(4));
+  pipeline.Add(Batch(5));
+  EXPECT_EQ(Send(pipeline), (std::vector<size_t>{1, 1, 1, 2}));
+
+  pipeline.Acknowledge(Version(5), Results(1), {});
+  absl::optional<MutationBatch> rejected = pipeline.Reject();
+  ASSERT_TRUE(rejected);
+  EXPECT_EQ(rejected->batch_id(), 2);
+  EXPECT_EQ(pipeline.last_batch_id(), 5);
+}
+
+TEST_F(WritePipelineTest, KeepsFixedDepth) {
+  WritePipeline pipeline = MakePipeline({});
+  for (BatchId batch_id = 1; batch_id <= 10; ++batch_id) {
+    pipeline.Add(Batch(batch_id));
+  }
+  EXPECT_TRUE(pipeline.full());
+
+  Send(pipeline);
+  Advance(std::chrono::milliseconds(10));
+  pipeline.Acknowledge(Version(5), Results(1), {});
+  EXPECT_EQ(pipeline.depth(), 10u);
+}
+
+TEST_F(WritePipelineTest, AdaptsDepthToLatency) {
+  WritePipelineSettings settings;
+  settings.min_depth = 2;
+  settings.max_depth = 4;
+  WritePipeline pipeline = MakePipeline(settings);
+  EXPECT_EQ(pipeline.depth(), 2u);
+
+  BatchId batch_id = 0;
+  auto round_trip = [&](std::chrono::milliseconds latency) {
+    pipeline.Add(Batch(++batch_id));
+    Send(pipeline);
+    Advance(latency);
+    pipeline.Acknowledge(Version(5), Results(1), {});
+  };
+
+  // Steady round trips let the pipeline grow up to its maximum.
+  for (int i = 0; i < 5; ++i) {
+    round_trip(std::chrono::milliseconds(10));
+  }
+  EXPECT_EQ(pipeline.depth(), 4u);
+
+  // A moderately slower response leaves the depth unchanged...
+  round_trip(std::chrono::milliseconds(30));
+  EXPECT_EQ(pipeline.depth(), 4u);
+
+  // ...while queueing delays shrink it.
+  round_trip(std::chrono::milliseconds(50));
+  EXPECT_EQ(pipeline.depth(), 2u);
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
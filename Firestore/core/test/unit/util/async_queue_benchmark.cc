@@ -0,0 +1,136 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdint>
+#include <future>  // NOLINT(build/c++11)
+#include <memory>
+#include <vector>
+
+#include "Firestore/core/src/util/async_queue.h"
+#include "Firestore/core/src/util/executor.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using Priority = AsyncQueue::Priority;
+
+// Each round enqueues a backlog like that of a large remote event arriving
+// while GC runs: many short sync operations, a few long background ones, and
+// user operations sprinkled in between.
+constexpr int kSyncOperationsPerRound = 400;
+constexpr int kBackgroundEvery = 40;
+constexpr int kInteractiveEvery = 20;
+constexpr auto kSyncCost = std::chrono::microseconds(50);
+constexpr auto kBackgroundCost = std::chrono::microseconds(2000);
+
+/** How the operations of a round are enqueued. */
+enum Scheduling {
+  // Everything at the default priority, i.e. strictly FIFO.
+  kFifo = 0,
+  // Each operation in its own priority class.
+  kPriorities = 1,
+};
+
+void Spin(Clock::duration duration) {
+  auto end = Clock::now() + duration;
+  while (Clock::now() < end) {
+  }
+}
+
+int64_t PercentileMicros(std::vector<Clock::duration>* latencies,
+                         double percentile) {
+  if (latencies->empty()) {
+    return 0;
+  }
+  auto index = static_cast<size_t>(percentile / 100 * (latencies->size() - 1));
+  std::nth_element(latencies->begin(), latencies->begin() + index,
+                   latencies->end());
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             (*latencies)[index])
+      .count();
+}
+
+/**
+ * Measures how long user operations wait on a worker queue that is busy with
+ * a mixed sync and background workload, with and without priority classes as
+ * selected by `state.range(0)`.
+ */
+void BM_InteractiveTailLatency(benchmark::State& state) {
+  auto scheduling = static_cast<Scheduling>(state.range(0));
+  state.SetLabel(scheduling == kFifo ? "fifo" : "priorities");
+
+  auto priority = [scheduling](Priority preferred) {
+    return scheduling == kFifo ? Priority::kSync : preferred;
+  };
+
+  std::shared_ptr<AsyncQueue> queue =
+      AsyncQueue::Create(Executor::CreateSerial("benchmark"));
+
+  // Only accessed on the queue until the round is done.
+  std::vector<Clock::duration> latencies;
+  std::vector<Clock::duration> sync_latencies;
+
+  for (auto _ : state) {
+    for (int i = 0; i < kSyncOperationsPerRound; ++i) {
+      Clock::time_point enqueued = Clock::now();
+      queue->Enqueue(priority(Priority::kSync), [&, enqueued] {
+        sync_latencies.push_back(Clock::now() - enqueued);
+        Spin(kSyncCost);
+      });
+
+      if (i % kBackgroundEvery == 0) {
+        queue->Enqueue(priority(Priority::kBackground),
+                       [] { Spin(kBackgroundCost); });
+      }
+
+      if (i % kInteractiveEvery == 0) {
+        queue->Enqueue(priority(Priority::kInteractive), [&, enqueued] {
+          latencies.push_back(Clock::now() - enqueued);
+        });
+      }
+    }
+
+    // The least urgent operation of the round runs last.
+    std::promise<void> done;
+    queue->Enqueue(priority(Priority::kBackground),
+                   [&] { done.set_value(); });
+    done.get_future().wait();
+  }
+
+  state.counters["interactive_ops"] = static_cast<double>(latencies.size());
+  state.counters["interactive_p50_us"] = PercentileMicros(&latencies, 50);
+  state.counters["interactive_p99_us"] = PercentileMicros(&latencies, 99);
+  state.counters["interactive_max_us"] = PercentileMicros(&latencies, 100);
+  state.counters["sync_p99_us"] = PercentileMicros(&sync_latencies, 99);
+
+  queue->Dispose();
+}
+BENCHMARK(BM_InteractiveTailLatency)
+    ->Arg(kFifo)
+    ->Arg(kPriorities)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
@@ -31,6 +31,8 @@ namespace {
 
 using testutil::Expectation;
 
+using Priority = AsyncQueue::Priority;
+
 // In these generic tests the specific timer ids don't matter.
 const TimerId kTimerId1 = TimerId::ListenStreamConnectionBackoff;
 const TimerId kTimerId2 = TimerId::ListenStreamIdle;
@@ -224,6 +226,85 @@ TEST_P(AsyncQueueTest, CanScheduleOprationsWithRespectsToShutdownState) {
   EXPECT_EQ(steps, "124");
 }
 
+TEST_P(AsyncQueueTest, RunsMoreUrgentOperationsFirst) {
+  Expectation blocking_started;
+  Expectation blocking_complete;
+  Expectation ran;
+  std::string steps;
+
+  queue->Enqueue([&] {
+    blocking_started.Fulfill();
+    Await(blocking_complete);
+  });
+  Await(blocking_started);
+
+  queue->Enqueue(Priority::kBackground, [&] { steps += 'b'; });
+  queue->Enqueue([&] { steps += 's'; });
+  queue->Enqueue(Priority::kInteractive, [&] { steps += 'i'; });
+  queue->Enqueue(Priority::kSync, [&] { steps += 'S'; });
+  queue->Enqueue(Priority::kInteractive, [&] { steps += 'I'; });
+  queue->Enqueue(Priority::kBackground, [&] {
+    steps += 'B';
+    ran.Fulfill();
+  });
+
+  blocking_complete.Fulfill();
+  Await(ran);
+  EXPECT_EQ(steps, "iIsSbB");
+}
+
+TEST_P(AsyncQueueTest, ShouldYieldWhileMoreUrgentOperationsWait) {
+  Expectation blocking_started;
+  Expectation blocking_complete;
+  Expectation ran;
+
+  queue->Enqueue(Priority::kBackground, [&] {
+    blocking_started.Fulfill();
+    Await(blocking_complete);
+  });
+  Await(blocking_started);
+  EXPECT_FALSE(queue->ShouldYield());
+
+  queue->Enqueue(Priority::kBackground, [] {});
+  EXPECT_FALSE(queue->ShouldYield());
+
+  queue->Enqueue(Priority::kInteractive, [] {});
+  EXPECT_TRUE(queue->ShouldYield());
+
+  queue->Enqueue(Priority::kBackground, [&] {
+    EXPECT_FALSE(queue->ShouldYield());
+    ran.Fulfill();
+  });
+
+  blocking_complete.Fulfill();
+  Await(ran);
+}
+
+TEST_P(AsyncQueueTest, RestrictedOperationsRunAfterEarlierOperations) {
+  Expectation blocking_started;
+  Expectation blocking_complete;
+  Expectation ran;
+  std::string steps;
+
+  queue->Enqueue([&] {
+    blocking_started.Fulfill();
+    Await(blocking_complete);
+  });
+  Await(blocking_started);
+
+  queue->Enqueue(Priority::kBackground, [&] { steps += 'b'; });
+  queue->Enqueue(Priority::kInteractive, [&] { steps += 'i'; });
+  queue->EnterRestrictedMode();
+  queue->EnqueueEvenWhileRestricted([&] {
+    steps += 'r';
+    ran.Fulfill();
+  });
+
+  blocking_complete.Fulfill();
+  Await(ran);
+  EXPECT_EQ(steps, "ibr");
+}
+
 TEST_P(AsyncQueueTest, RestrictedModePreventsEnqueue) {
   ASSERT_TRUE(queue->Enqueue([&] {}));
   ASSERT_TRUE(queue->EnqueueEvenWhileRestricted([&] {}));
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/util/metrics.h"
+
+#include <chrono>  // NOLINT(build/c++11)
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+TEST(MetricsTest, CounterIncrementsAndResets) {
+  MetricCounter counter;
+  EXPECT_EQ(counter.value(), 0);
+
+  counter.Increment();
+  counter.Increment(41);
+  EXPECT_EQ(counter.value(), 42);
+
+  counter.Reset();
+  EXPECT_EQ(counter.value(), 0);
+}
+
+TEST(MetricsTest, HistogramBucketsByPowersOfTwo) {
+  MetricHistogram histogram;
+  histogram.Record(0);
+  histogram.Record(1);
+  histogram.Record(2);
+  histogram.Record(3);
+  histogram.Record(4);
+  histogram.Record(1000);
+
+  HistogramSnapshot snapshot = histogram.Snapshot();
+  ASSERT_EQ(snapshot.buckets.size(),
+            static_cast<size_t>(MetricHistogram::kNumBuckets));
+  EXPECT_EQ(snapshot.buckets[0], 1);   // 0
+  EXPECT_EQ(snapshot.buckets[1], 1);   // 1
+  EXPECT_EQ(snapshot.buckets[2], 2);   // 2, 3
+  EXPECT_EQ(snapshot.buckets[3], 1);   // 4
+  EXPECT_EQ(snapshot.buckets[10], 1);  // 1000
+
+  EXPECT_EQ(snapshot.count, 6);
+  EXPECT_EQ(snapshot.sum, 1010);
+  EXPECT_EQ(snapshot.max, 1000);
+}
+
+TEST(MetricsTest, HistogramPercentiles) {
+  MetricHistogram histogram;
+  EXPECT_EQ(histogram.Snapshot().Percentile(50), 0);
+
+  for (int i = 1; i <= 100; ++i) {
+    histogram.Record(i);
+  }
+
+  HistogramSnapshot snapshot = histogram.Snapshot();
+  EXPECT_DOUBLE_EQ(snapshot.mean(), 50.5);
+  // The 50th value is in [32, 64).
+  EXPECT_EQ(snapshot.Percentile(50), 63);
+  // The 99th value is in [64, 128), which is capped at the maximum.
+  EXPECT_EQ(snapshot.Percentile(99), 100);
+  EXPECT_EQ(snapshot.Percentile(0), 1);
+}
+
+TEST(MetricsTest, HistogramRecordsElapsedTime) {
+  MetricHistogram histogram;
+  auto now = std::chrono::steady_clock::now();
+  histogram.RecordMicrosSince(now - std::chrono::milliseconds(5));
+  histogram.RecordMicrosSince(now + std::chrono::hours(1));
+
+  HistogramSnapshot snapshot = histogram.Snapshot();
+  EXPECT_EQ(snapshot.count, 2);
+  EXPECT_GE(snapshot.max, 5000);
+  EXPECT_EQ(snapshot.buckets[0], 1);
+}
+
+TEST(MetricsTest, RegistryReturnsTheSameMetricForTheSameName) {
+  MetricsRegistry& registry = MetricsRegistry::GetInstance();
+  MetricCounter& counter = registry.GetCounter("metrics_test.same");
+  EXPECT_EQ(&counter, &registry.GetCounter("metrics_test.same"));
+  EXPECT_NE(&counter, &registry.GetCounter("metrics_test.same", "label"));
+  EXPECT_NE(&counter, &registry.GetCounter("metrics_test.other"));
+}
+
+TEST(MetricsTest, SnapshotIncludesLabels) {
+  MetricsRegistry& registry = MetricsRegistry::GetInstance();
+  registry.GetCounter("metrics_test.counter").Increment(3);
+  registry.GetCounter("metrics_test.counter", "a").Increment(4);
+  registry.GetHistogram("metrics_test.histogram", "b").Record(7);
+
+  MetricsSnapshot snapshot = registry.Snapshot();
+  EXPECT_EQ(snapshot.counters.at("metrics_test.counter"), 3);
+  EXPECT_EQ(snapshot.counters.at("metrics_test.counter[a]"), 4);
+  EXPECT_EQ(snapshot.histograms.at("metrics_test.histogram[b]").count, 1);
+
+  registry.Reset();
+  snapshot = registry.Snapshot();
+  EXPECT_EQ(snapshot.counters.at("metrics_test.counter"), 0);
+  EXPECT_EQ(snapshot.histograms.at("metrics_test.histogram[b]").count, 0);
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
@@ -14,6 +14,11 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+#include <iterator>
+#include <string>
+#include <vector>
+
 #include "Firestore/core/src/util/ordered_code.h"
 #include "Firestore/core/src/util/secure_random.h"
 #include "benchmark/benchmark.h"
@@ -21,7 +26,9 @@
 using firebase::firestore::util::OrderedCode;
 using firebase::firestore::util::SecureRandom;
 
-static void BM_SkipToNextSpecialByte(benchmark::State& state) {
+using SkipFunction = const char* (*)(const char*, const char*);
+
+static void SkipToNextSpecialByte(benchmark::State& state, SkipFunction skip) {
   // Use enough distinct values to confuse the branch predictor
   SecureRandom rnd;
   const int kValues = 8192;
@@ -47,11 +54,15 @@ static void BM_SkipToNextSpecialByte(benchmark::State& state) {
   for (auto _ : state) {
     absl::string_view sp(values[index++ % kValues]);
     const char* p = sp.data();
-    const char* q = OrderedCode::TEST_SkipToNextSpecialByte(p, p + sp.size());
+    const char* q = skip(p, p + sp.size());
     total_bytes += (q - p);
   }
   state.SetBytesProcessed(total_bytes);
 }
+
+static void BM_SkipToNextSpecialByte(benchmark::State& state) {
+  SkipToNextSpecialByte(state, OrderedCode::TEST_SkipToNextSpecialByte);
+}
 BENCHMARK(BM_SkipToNextSpecialByte)
     ->Arg(1 << 4)
     ->Arg(1 << 5)
@@ -61,3 +72,149 @@ BENCHMARK(BM_SkipToNextSpecialByte)
     ->Arg(1 << 9)
     ->Arg(1 << 10)
     ->Arg(1 << 15);
+
+// The same workload using only the portable 8-bytes-at-a-time scan, as a
+// baseline for the vectorized one.
+static void BM_SkipToNextSpecialBytePortable(benchmark::State& state) {
+  SkipToNextSpecialByte(state, OrderedCode::TEST_SkipToNextSpecialBytePortable);
+}
+BENCHMARK(BM_SkipToNextSpecialBytePortable)
+    ->Arg(1 << 4)
+    ->Arg(1 << 5)
+    ->Arg(1 << 6)
+    ->Arg(1 << 7)
+    ->Arg(1 << 8)
+    ->Arg(1 << 9)
+    ->Arg(1 << 10)
+    ->Arg(1 << 15);
+
+// Shapes of strings that commonly end up in LevelDB keys.
+enum KeyShape {
+  // A 20-character auto-generated document ID.
+  kAutoId = 0,
+  // A short collection ID.
+  kCollectionId = 1,
+  // A 256-byte text field value, as found in index entries.
+  kLongText = 2,
+  // 256 bytes of binary data, which contain bytes that need escaping.
+  kBinary = 3,
+};
+
+static std::string MakeKeyString(KeyShape shape, SecureRandom* rnd) {
+  static const char kAlphabet[] =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789";
+  std::string s;
+  switch (shape) {
+    case kAutoId:
+      std::generate_n(std::back_inserter(s), 20,
+                      [&] { return kAlphabet[rnd->Uniform(62)]; });
+      break;
+    case kCollectionId:
+      s = "messages";
+      break;
+    case kLongText:
+      std::generate_n(std::back_inserter(s), 256, [&] {
+        return static_cast<char>(' ' + rnd->Uniform(95));
+      });
+      break;
+    case kBinary:
+      std::generate_n(std::back_inserter(s), 256,
+                      [&] { return static_cast<char>(rnd->Uniform(256)); });
+      break;
+  }
+  return s;
+}
+
+static void BM_WriteString(benchmark::State& state) {
+  SecureRandom rnd;
+  const int kValues = 1024;
+  auto shape = static_cast<KeyShape>(state.range(0));
+  std::vector<std::string> values(kValues);
+  for (std::string& value : values) {
+    value = MakeKeyString(shape, &rnd);
+  }
+
+  int index = 0;
+  int64_t total_bytes = 0;
+  std::string dest;
+  for (auto _ : state) {
+    const std::string& value = values[index++ % kValues];
+    dest.clear();
+    OrderedCode::WriteString(&dest, value);
+    benchmark::DoNotOptimize(dest);
+    total_bytes += static_cast<int64_t>(value.size());
+  }
+  state.SetBytesProcessed(total_bytes);
+}
+BENCHMARK(BM_WriteString)
+    ->Arg(kAutoId)
+    ->Arg(kCollectionId)
+    ->Arg(kLongText)
+    ->Arg(kBinary);
+
+static void BM_ReadString(benchmark::State& state) {
+  SecureRandom rnd;
+  const int kValues = 1024;
+  auto shape = static_cast<KeyShape>(state.range(0));
+  std::vector<std::string> encoded(kValues);
+  for (std::string& value : encoded) {
+    OrderedCode::WriteString(&value, MakeKeyString(shape, &rnd));
+  }
+
+  int index = 0;
+  int64_t total_bytes = 0;
+  std::string result;
+  for (auto _ : state) {
+    absl::string_view src(encoded[index++ % kValues]);
+    result.clear();
+    OrderedCode::ReadString(&src, &result);
+    benchmark::DoNotOptimize(result);
+    total_bytes += static_cast<int64_t>(result.size());
+  }
+  state.SetBytesProcessed(total_bytes);
+}
+BENCHMARK(BM_ReadString)
+    ->Arg(kAutoId)
+    ->Arg(kCollectionId)
+    ->Arg(kLongText)
+    ->Arg(kBinary);
+
+// Encodes and decodes a key shaped like a remote document key for
+// "users/<auto-id>/messages/<auto-id>": a table name followed by labelled
+// path segments and a terminator.
+static void BM_DocumentKeyRoundTrip(benchmark::State& state) {
+  SecureRandom rnd;
+  const int kValues = 1024;
+  const int64_t kPathSegmentLabel = 62;
+  const int64_t kTerminatorLabel = 1;
+  std::vector<std::vector<std::string>> paths(kValues);
+  for (std::vector<std::string>& path : paths) {
+    path = {"users", MakeKeyString(kAutoId, &rnd), "messages",
+            MakeKeyString(kAutoId, &rnd)};
+  }
+
+  int index = 0;
+  std::string key;
+  std::string segment;
+  for (auto _ : state) {
+    key.clear();
+    OrderedCode::WriteString(&key, "remote_document");
+    for (const std::string& path_segment : paths[index++ % kValues]) {
+      OrderedCode::WriteSignedNumIncreasing(&key, kPathSegmentLabel);
+      OrderedCode::WriteString(&key, path_segment);
+    }
+    OrderedCode::WriteSignedNumIncreasing(&key, kTerminatorLabel);
+
+    absl::string_view src(key);
+    int64_t label = 0;
+    OrderedCode::ReadString(&src, &segment);
+    while (OrderedCode::ReadSignedNumIncreasing(&src, &label) &&
+           label == kPathSegmentLabel) {
+      segment.clear();
+      OrderedCode::ReadString(&src, &segment);
+      benchmark::DoNotOptimize(segment);
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_DocumentKeyRoundTrip);
@@ -412,6 +412,42 @@ TEST(OrderedCode, ExhaustiveFindSpecial) {
   EXPECT_EQ(count, 256 * 256 * 256 * 2);
 }
 
+TEST(OrderedCode, FindSpecialAtEveryAlignment) {
+  // The vectorized scan reads 16 or 32 bytes at a time, so check every
+  // position of the special byte relative to the block boundaries, starting
+  // from every alignment.
+  char buf[128];
+  for (size_t start_offset = 0; start_offset < 32; start_offset++) {
+    for (size_t len = 0; start_offset + len <= sizeof(buf); len++) {
+      for (char& c : buf) {
+        c = 'a';
+      }
+      const char* start = buf + start_offset;
+      const char* limit = start + len;
+      ASSERT_EQ(limit, OrderedCode::TEST_SkipToNextSpecialByte(start, limit));
+      ASSERT_EQ(limit,
+                OrderedCode::TEST_SkipToNextSpecialBytePortable(start, limit));
+
+      for (size_t special_pos = 0; special_pos < len; special_pos++) {
+        buf[start_offset + special_pos] = special_pos % 2 == 0 ? 0 : '\xff';
+        // A later special byte in the same block must not be reported.
+        if (special_pos + 1 < len) {
+          buf[start_offset + special_pos + 1] = 0;
+        }
+        ASSERT_EQ(start + special_pos,
+                  OrderedCode::TEST_SkipToNextSpecialByte(start, limit));
+        ASSERT_EQ(start + special_pos,
+                  OrderedCode::TEST_SkipToNextSpecialBytePortable(start,
+                                                                  limit));
+        buf[start_offset + special_pos] = 'a';
+        if (special_pos + 1 < len) {
+          buf[start_offset + special_pos + 1] = 'a';
+        }
+      }
+    }
+  }
+}
+
 TEST(OrderedCodeUint64, EncodeDecode) {
   TestNumbers<uint64_t>(1);
 }
@@ -0,0 +1,108 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/util/tracing.h"
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+class TracingTest : public testing::Test {
+ protected:
+  ~TracingTest() override {
+    tracer_.Disable();
+  }
+
+  Tracer& tracer_ = Tracer::GetInstance();
+};
+
+TEST_F(TracingTest, RecordsNothingWhileDisabled) {
+  tracer_.Enable();
+  tracer_.Disable();
+
+  { TraceSpan span("test", "ignored"); }
+  TraceOperation("test", "ignored", [] {})();
+
+  EXPECT_TRUE(tracer_.Events().empty());
+}
+
+TEST_F(TracingTest, RecordsNestedSpans) {
+  tracer_.Enable();
+  {
+    TraceSpan outer("test", "outer");
+    TraceSpan inner("test", "inner");
+  }
+
+  std::vector<TraceEvent> events = tracer_.Events();
+  ASSERT_EQ(events.size(), 2u);
+  // Spans are recorded as they end, so the inner one comes first.
+  EXPECT_EQ(events[0].name, "inner");
+  EXPECT_EQ(events[1].name, "outer");
+  EXPECT_EQ(events[0].thread_id, events[1].thread_id);
+  EXPECT_LE(events[1].start, events[0].start);
+  EXPECT_GE(events[1].end, events[0].end);
+}
+
+TEST_F(TracingTest, OperationsRecordTheTimeTheyWereQueued) {
+  tracer_.Enable();
+  std::function<void()> operation = TraceOperation("test", "operation", [] {});
+  std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  std::thread(operation).join();
+
+  std::vector<TraceEvent> events = tracer_.Events();
+  ASSERT_EQ(events.size(), 1u);
+  EXPECT_EQ(events[0].name, "operation");
+  EXPECT_GE(events[0].start - events[0].enqueued,
+            std::chrono::milliseconds(2));
+}
+
+TEST_F(TracingTest, KeepsTheMostRecentEvents) {
+  tracer_.Enable(3);
+  for (int i = 0; i < 5; ++i) {
+    TraceSpan span("test", absl::StrCat("span", i));
+  }
+
+  std::vector<TraceEvent> events = tracer_.Events();
+  ASSERT_EQ(events.size(), 3u);
+  EXPECT_EQ(events[0].name, "span2");
+  EXPECT_EQ(events[1].name, "span3");
+  EXPECT_EQ(events[2].name, "span4");
+}
+
+TEST_F(TracingTest, ExportsChromeTraceJson) {
+  tracer_.Enable();
+  { TraceSpan span("test", "quoted \"name\""); }
+
+  std::string json = tracer_.ExportChromeTrace();
+  EXPECT_EQ(json.find(R"({"displayTimeUnit":"ms","traceEvents":[{"ph":"X",)"),
+            0u);
+  EXPECT_NE(json.find(R"("name":"quoted \"name\"","cat":"test")"),
+            std::string::npos);
+  EXPECT_NE(json.find(R"("args":{"queued_us":0}})"), std::string::npos);
+  EXPECT_EQ(json.substr(json.size() - 2), "]}");
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase